@@ -35,11 +35,18 @@ static void NotifyResToParent(struct AppSpawnContent *content, AppSpawnClient *c
     if (content->notifyResToParent != NULL) {
         content->notifyResToParent(content, client, result);
     }
+#if defined(APPSPAWN_LOG_RING) && !defined(OHOS_LITE)
+    // 回复父进程后再输出子进程缓存的日志，不影响孵化耗时
+    (void)AppSpawnLogRingFlush();
+#endif
 }
 
 void ProcessExit(int code)
 {
     APPSPAWN_LOGI("App exit code: %{public}d", code);
+#if defined(APPSPAWN_LOG_RING) && !defined(OHOS_LITE)
+    (void)AppSpawnLogRingFlush();
+#endif
 #ifdef OHOS_LITE
     _exit(0x7f); // 0x7f user exit
 #else
@@ -89,6 +96,10 @@ static void SetEncapsFlag(int fdEncaps, uint32_t flag)
 int AppSpawnChild(AppSpawnContent *content, AppSpawnClient *client)
 {
     APPSPAWN_CHECK(content != NULL && client != NULL, return -1, "Invalid arg for appspawn child");
+#if defined(APPSPAWN_LOG_RING) && !defined(OHOS_LITE)
+    // 子进程中没有刷新线程，丢弃继承自父进程的日志，由父进程输出
+    AppSpawnLogRingAfterFork();
+#endif
     APPSPAWN_LOGI("AppSpawnChild id %{public}u flags: 0x%{public}x", client->id, client->flags);
     StartAppspawnTrace("AppSpawnExecuteClearEnvHook");
     int ret = AppSpawnExecuteClearEnvHook(content, client);
@@ -132,6 +143,9 @@ int AppSpawnChild(AppSpawnContent *content, AppSpawnClient *client)
     (void)AppSpawnExecutePostReplyHook(content, client);
     FinishAppspawnTrace();
 
+#if defined(APPSPAWN_LOG_RING) && !defined(OHOS_LITE)
+    (void)AppSpawnLogRingFlush();
+#endif
     if (content->runChildProcessor != NULL) {
         ret = content->runChildProcessor(content, client);
     }
@@ -177,6 +191,9 @@ int AppSpawnProcessMsg(AppSpawnContent *content, AppSpawnClient *client, pid_t *
 #else
         pid = clone(CloneAppSpawn, NULL, content->sandboxNsFlags | SIGCHLD, (void *)&arg);
 #endif
+    } else if (content->forkChild != NULL) {
+        int ret = content->forkChild(content, client, &pid);
+        APPSPAWN_CHECK(ret == 0, return ret, "fork child process by plugin error: %{public}d", ret);
     } else {
 #else
     {
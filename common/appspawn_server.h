@@ -70,6 +70,9 @@ typedef struct AppSpawnContent {
     char *propertyBuffer;
     pid_t reservedPid;
     int enablePerfork;
+    // fork the app process by plugin, such as the fork helper in pid namespace
+    int (*forkChild)(struct AppSpawnContent *content, AppSpawnClient *client, pid_t *childPid);
+    int forkChildInSelf;  // forkChild forks in appspawn itself, children inherit its result slots
 #endif
     // system
     void (*runAppSpawn)(struct AppSpawnContent *content, int argc, char *const argv[]);
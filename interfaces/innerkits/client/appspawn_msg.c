@@ -436,6 +436,129 @@ int AppSpawnReqMsgAddStringInfo(AppSpawnReqMsgHandle reqHandle, const char *name
     return AddAppDataEx(reqNode, name, data);  // 2 max count
 }
 
+typedef struct {
+    uint8_t *buffer;
+    uint32_t bufferLen;
+    uint32_t offset;
+} ExtListWriter;
+
+static inline uint32_t GetExtListStringSize(const char *str)
+{
+    return sizeof(uint16_t) + (str == NULL ? 0 : strlen(str)) + 1;
+}
+
+static int ExtListWriterInit(ExtListWriter *writer, uint32_t listType, uint32_t count, uint32_t dataLen)
+{
+    APPSPAWN_CHECK(dataLen <= EXTRAINFO_TOTAL_LENGTH_MAX - sizeof(AppSpawnExtListHeader),
+        return APPSPAWN_ARG_INVALID, "Ext list too long %{public}u", dataLen);
+    writer->bufferLen = sizeof(AppSpawnExtListHeader) + dataLen;
+    writer->buffer = (uint8_t *)calloc(1, writer->bufferLen);
+    APPSPAWN_CHECK(writer->buffer != NULL, return APPSPAWN_SYSTEM_ERROR, "Failed to alloc ext list");
+    AppSpawnExtListHeader header = {APPSPAWN_EXT_LIST_MAGIC, APPSPAWN_EXT_LIST_VERSION, (uint16_t)listType, count};
+    (void)memcpy_s(writer->buffer, writer->bufferLen, &header, sizeof(header));
+    writer->offset = sizeof(AppSpawnExtListHeader);
+    return 0;
+}
+
+static int WriteExtListString(ExtListWriter *writer, const char *str)
+{
+    size_t len = str == NULL ? 0 : strlen(str);
+    APPSPAWN_CHECK(len <= UINT16_MAX && writer->offset + GetExtListStringSize(str) <= writer->bufferLen,
+        return APPSPAWN_ARG_INVALID, "Invalid ext list string");
+    uint16_t strLen = (uint16_t)len;
+    (void)memcpy_s(writer->buffer + writer->offset, writer->bufferLen - writer->offset, &strLen, sizeof(strLen));
+    writer->offset += sizeof(strLen);
+    if (len > 0) {
+        (void)memcpy_s(writer->buffer + writer->offset, writer->bufferLen - writer->offset, str, len);
+    }
+    writer->offset += len;
+    writer->buffer[writer->offset++] = '\0';
+    return 0;
+}
+
+static int WriteExtListUint32(ExtListWriter *writer, uint32_t value)
+{
+    APPSPAWN_CHECK(writer->offset + sizeof(value) <= writer->bufferLen,
+        return APPSPAWN_ARG_INVALID, "Invalid ext list value");
+    (void)memcpy_s(writer->buffer + writer->offset, writer->bufferLen - writer->offset, &value, sizeof(value));
+    writer->offset += sizeof(value);
+    return 0;
+}
+
+static int AddExtListToMsg(AppSpawnReqMsgHandle reqHandle, const char *name, ExtListWriter *writer, int ret)
+{
+    if (ret == 0) {
+        ret = AppSpawnReqMsgAddExtInfo(reqHandle, name, writer->buffer, writer->offset);
+    }
+    free(writer->buffer);
+    writer->buffer = NULL;
+    return ret;
+}
+
+int AppSpawnReqMsgAddHspList(AppSpawnReqMsgHandle reqHandle, const AppSpawnHspInfo *hspList, uint32_t count)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(reqHandle != NULL, return APPSPAWN_ARG_INVALID);
+    APPSPAWN_CHECK(hspList != NULL && count > 0, return APPSPAWN_ARG_INVALID, "Invalid hsp list");
+    uint64_t dataLen = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        dataLen += GetExtListStringSize(hspList[i].bundleName) +
+            GetExtListStringSize(hspList[i].moduleName) + GetExtListStringSize(hspList[i].version);
+    }
+    APPSPAWN_CHECK(dataLen <= EXTRAINFO_TOTAL_LENGTH_MAX, return APPSPAWN_ARG_INVALID, "Hsp list too long");
+
+    ExtListWriter writer = {};
+    int ret = ExtListWriterInit(&writer, EXT_LIST_HSP, count, (uint32_t)dataLen);
+    APPSPAWN_CHECK_ONLY_EXPER(ret == 0, return ret);
+    for (uint32_t i = 0; i < count && ret == 0; i++) {
+        ret = WriteExtListString(&writer, hspList[i].bundleName);
+        ret = (ret == 0) ? WriteExtListString(&writer, hspList[i].moduleName) : ret;
+        ret = (ret == 0) ? WriteExtListString(&writer, hspList[i].version) : ret;
+    }
+    return AddExtListToMsg(reqHandle, MSG_EXT_NAME_HSP_LIST, &writer, ret);
+}
+
+int AppSpawnReqMsgAddDataGroupList(AppSpawnReqMsgHandle reqHandle,
+    const AppSpawnDataGroupInfo *groupList, uint32_t count)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(reqHandle != NULL, return APPSPAWN_ARG_INVALID);
+    APPSPAWN_CHECK(groupList != NULL && count > 0, return APPSPAWN_ARG_INVALID, "Invalid data group list");
+    uint64_t dataLen = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        dataLen += GetExtListStringSize(groupList[i].dataGroupId) +
+            sizeof(uint32_t) + GetExtListStringSize(groupList[i].dir);
+    }
+    APPSPAWN_CHECK(dataLen <= EXTRAINFO_TOTAL_LENGTH_MAX, return APPSPAWN_ARG_INVALID, "Data group list too long");
+
+    ExtListWriter writer = {};
+    int ret = ExtListWriterInit(&writer, EXT_LIST_DATA_GROUP, count, (uint32_t)dataLen);
+    APPSPAWN_CHECK_ONLY_EXPER(ret == 0, return ret);
+    for (uint32_t i = 0; i < count && ret == 0; i++) {
+        ret = WriteExtListString(&writer, groupList[i].dataGroupId);
+        ret = (ret == 0) ? WriteExtListUint32(&writer, groupList[i].gid) : ret;
+        ret = (ret == 0) ? WriteExtListString(&writer, groupList[i].dir) : ret;
+    }
+    return AddExtListToMsg(reqHandle, MSG_EXT_NAME_DATA_GROUP, &writer, ret);
+}
+
+int AppSpawnReqMsgAddOverlayList(AppSpawnReqMsgHandle reqHandle, const char *const *hapPaths, uint32_t count)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(reqHandle != NULL, return APPSPAWN_ARG_INVALID);
+    APPSPAWN_CHECK(hapPaths != NULL && count > 0, return APPSPAWN_ARG_INVALID, "Invalid overlay list");
+    uint64_t dataLen = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        dataLen += GetExtListStringSize(hapPaths[i]);
+    }
+    APPSPAWN_CHECK(dataLen <= EXTRAINFO_TOTAL_LENGTH_MAX, return APPSPAWN_ARG_INVALID, "Overlay list too long");
+
+    ExtListWriter writer = {};
+    int ret = ExtListWriterInit(&writer, EXT_LIST_OVERLAY, count, (uint32_t)dataLen);
+    APPSPAWN_CHECK_ONLY_EXPER(ret == 0, return ret);
+    for (uint32_t i = 0; i < count && ret == 0; i++) {
+        ret = WriteExtListString(&writer, hapPaths[i]);
+    }
+    return AddExtListToMsg(reqHandle, MSG_EXT_NAME_OVERLAY, &writer, ret);
+}
+
 int AppSpawnReqMsgAddPermission(AppSpawnReqMsgHandle reqHandle, const char *permission)
 {
     AppSpawnReqMsgNode *reqNode = (AppSpawnReqMsgNode *)reqHandle;
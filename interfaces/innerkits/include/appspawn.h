@@ -288,6 +288,49 @@ int AppSpawnReqMsgAddExtInfo(AppSpawnReqMsgHandle reqHandle, const char *name, c
  */
 int AppSpawnReqMsgAddStringInfo(AppSpawnReqMsgHandle reqHandle, const char *name, const char *value);
 
+typedef struct {
+    const char *bundleName;
+    const char *moduleName;
+    const char *version;
+} AppSpawnHspInfo;
+
+typedef struct {
+    const char *dataGroupId;
+    const char *dir;
+    uint32_t gid;
+} AppSpawnDataGroupInfo;
+
+/**
+ * @brief add HspList to message with binary encoding, replace json string of MSG_EXT_NAME_HSP_LIST
+ *
+ * @param reqHandle handle for request message
+ * @param hspList hsp info list
+ * @param count count of hsp info
+ * @return if succeed return 0,else return other value
+ */
+int AppSpawnReqMsgAddHspList(AppSpawnReqMsgHandle reqHandle, const AppSpawnHspInfo *hspList, uint32_t count);
+
+/**
+ * @brief add DataGroup to message with binary encoding, replace json string of MSG_EXT_NAME_DATA_GROUP
+ *
+ * @param reqHandle handle for request message
+ * @param groupList data group info list
+ * @param count count of data group info
+ * @return if succeed return 0,else return other value
+ */
+int AppSpawnReqMsgAddDataGroupList(AppSpawnReqMsgHandle reqHandle,
+    const AppSpawnDataGroupInfo *groupList, uint32_t count);
+
+/**
+ * @brief add Overlay to message with binary encoding, replace '|' separated string of MSG_EXT_NAME_OVERLAY
+ *
+ * @param reqHandle handle for request message
+ * @param hapPaths overlay hap path list
+ * @param count count of hap path
+ * @return if succeed return 0,else return other value
+ */
+int AppSpawnReqMsgAddOverlayList(AppSpawnReqMsgHandle reqHandle, const char *const *hapPaths, uint32_t count);
+
 /**
  * @brief add fd info to message
  *
@@ -34,11 +34,19 @@ static const size_t MAX_BUNDLE_NAME_LEN = 127;
 static const size_t MIN_BUNDLE_NAME_LEN = 7;
 static const size_t MAX_IDENTITY_ID_LEN = 24;
 static const size_t MIN_IDENTITY_ID_LEN = 1;
-static const size_t MAX_CAPABILITY_COUNT = 10;
+static const size_t MAX_CAPABILITY_COUNT = APPSPAWN_MSG_BIN_CAPS_MAX;
 
 void FreeMessageSt(MessageSt *targetSt)
 {
     if (targetSt != NULL) {
+        if (targetSt->inPlace != 0) {
+            // parsed from binary message, fields are not owned by targetSt
+            targetSt->bundleName = NULL;
+            targetSt->identityID = NULL;
+            targetSt->caps = NULL;
+            targetSt->inPlace = 0;
+        }
+
         if (targetSt->bundleName != NULL) {
             free(targetSt->bundleName);
             targetSt->bundleName = NULL;
@@ -204,3 +212,97 @@ int SplitMessage(const char *msg, unsigned int msgLen, MessageSt *msgSt)
     }
     return EC_SUCCESS;
 }
+
+int PackMessageSt(const MessageSt *msgSt, MessageBinSt *bin)
+{
+    if (msgSt == NULL || bin == NULL || msgSt->bundleName == NULL || msgSt->identityID == NULL) {
+        return EC_INVALID;
+    }
+    if (msgSt->capsCnt > MAX_CAPABILITY_COUNT || (msgSt->capsCnt > 0 && msgSt->caps == NULL)) {
+        return EC_INVALID;
+    }
+
+    (void)memset_s(bin, sizeof(MessageBinSt), 0, sizeof(MessageBinSt));
+    bin->version = APPSPAWN_MSG_BIN_VERSION;
+    bin->uID = msgSt->uID;
+    bin->gID = msgSt->gID;
+    bin->capsCnt = msgSt->capsCnt;
+    for (unsigned int i = 0; i < msgSt->capsCnt; ++i) {
+        bin->caps[i] = msgSt->caps[i];
+    }
+    if (strcpy_s(bin->bundleName, sizeof(bin->bundleName), msgSt->bundleName) != EOK ||
+        strcpy_s(bin->identityID, sizeof(bin->identityID), msgSt->identityID) != EOK) {
+        return EC_INVALID;
+    }
+    return EC_SUCCESS;
+}
+
+static int CheckBinString(const char *str, size_t size, size_t maxLen, size_t minLen)
+{
+    // not '\0' terminated when strnlen reaches size
+    size_t strLength = strnlen(str, size);
+    if (strLength >= size || strLength > maxLen || strLength < minLen) {
+        return EC_PROTOCOL;
+    }
+    return EC_SUCCESS;
+}
+
+static int CheckBinMessage(const MessageBinSt *bin)
+{
+    if (bin->version != APPSPAWN_MSG_BIN_VERSION) {
+        APPSPAWN_LOGE("[appspawn] ParseMessageBin, unsupported version %u.", bin->version);
+        return EC_PROTOCOL;
+    }
+    int ret = CheckBinString(bin->bundleName, sizeof(bin->bundleName), MAX_BUNDLE_NAME_LEN, MIN_BUNDLE_NAME_LEN);
+    if (ret != EC_SUCCESS) {
+        return ret;
+    }
+    ret = CheckBinString(bin->identityID, sizeof(bin->identityID), MAX_IDENTITY_ID_LEN, MIN_IDENTITY_ID_LEN);
+    if (ret != EC_SUCCESS) {
+        return ret;
+    }
+    if (bin->capsCnt > MAX_CAPABILITY_COUNT) {
+        APPSPAWN_LOGE("[appspawn] ParseMessageBin, too many caps[cnt %u], max %d", bin->capsCnt, MAX_CAPABILITY_COUNT);
+        return EC_INVALID;
+    }
+    for (uint32_t i = 0; i < bin->capsCnt; ++i) {
+        if (bin->caps[i] > CAP_LAST_CAP) {
+            APPSPAWN_LOGE("[appspawn] ParseMessageBin, invalid cap value %u detected!", bin->caps[i]);
+            return EC_INVALID;
+        }
+    }
+    if (bin->uID <= 0 || bin->gID <= 0 || bin->uID == INT_MAX || bin->gID == INT_MAX) {
+        return EC_PROTOCOL;
+    }
+    return EC_SUCCESS;
+}
+
+int ParseMessageBin(const void *buf, unsigned int bufLen, MessageSt *msgSt)
+{
+    if (msgSt == NULL) {
+        return EC_INVALID;
+    }
+
+    // ipc buffer is 8 bytes aligned, caps can be used in place
+    if (buf == NULL || bufLen != sizeof(MessageBinSt) || ((uintptr_t)buf % sizeof(uint32_t)) != 0) {
+        FreeMessageSt(msgSt);
+        return EC_INVALID;
+    }
+
+    MessageBinSt *bin = (MessageBinSt *)buf;
+    int ret = CheckBinMessage(bin);
+    if (ret != EC_SUCCESS) {
+        FreeMessageSt(msgSt);
+        return ret;
+    }
+
+    // no copy, msgSt is valid as long as buf
+    msgSt->bundleName = bin->bundleName;
+    msgSt->identityID = bin->identityID;
+    msgSt->uID = bin->uID;
+    msgSt->gID = bin->gID;
+    msgSt->caps = (bin->capsCnt > 0) ? (unsigned int *)bin->caps : NULL;
+    msgSt->capsCnt = bin->capsCnt;
+    msgSt->inPlace = 1;
+    return EC_SUCCESS;
+}
@@ -33,8 +33,30 @@ typedef struct {
     int gID;
     unsigned int *caps;
     unsigned int capsCnt;
+    unsigned int inPlace;  // fields point into the message buffer, do not free
 } MessageSt;
 
+#define APPSPAWN_MSG_BIN_VERSION 1
+#define APPSPAWN_MSG_BIN_CAPS_MAX 10
+#define APPSPAWN_MSG_BIN_NAME_LEN 128
+#define APPSPAWN_MSG_BIN_ID_LEN 32
+
+/*
+ * binary message for ID_CALL_CREATE_SERVICE_BIN, written by client as:
+ *   WriteUint32(io, sizeof(MessageBinSt));
+ *   WriteBuffer(io, &bin, sizeof(MessageBinSt));
+ * names are '\0' terminated inside the fixed length fields
+ */
+typedef struct {
+    uint32_t version;
+    int32_t uID;
+    int32_t gID;
+    uint32_t capsCnt;
+    uint32_t caps[APPSPAWN_MSG_BIN_CAPS_MAX];
+    char bundleName[APPSPAWN_MSG_BIN_NAME_LEN];
+    char identityID[APPSPAWN_MSG_BIN_ID_LEN];
+} MessageBinSt;
+
 typedef struct {
     AppSpawnClient client;
     MessageSt message;
@@ -44,9 +66,23 @@ typedef struct {
     AppSpawnContent content;
 } AppSpawnContentLite;
 
+#define APPSPAWN_PREFORK_MAX 2
+#ifndef APPSPAWN_PREFORK_COUNT
+#define APPSPAWN_PREFORK_COUNT 0
+#endif
+
 void SetContentFunction(AppSpawnContent *content);
 int SplitMessage(const char *msg, unsigned int msgLen, MessageSt *msgSt);
 void FreeMessageSt(MessageSt *targetSt);
+int PackMessageSt(const MessageSt *msgSt, MessageBinSt *bin);
+int ParseMessageBin(const void *buf, unsigned int bufLen, MessageSt *msgSt);
+
+// keep standby children forked in advance, message is handed over by pipe
+int AppSpawnPreforkInit(AppSpawnContent *content, unsigned int count);
+void AppSpawnPreforkExit(void);
+int AppSpawnPreforkSpawn(const AppSpawnClientLite *client, pid_t *childPid);
+unsigned int AppSpawnPreforkReadyCount(void);
+void AppSpawnClosePreforkFds(void);
 
 #ifdef __cplusplus
 #if __cplusplus
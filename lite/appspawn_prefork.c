@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "appspawn_message.h"
+#include "appspawn_server.h"
+#include "ohos_errno.h"
+#include "securec.h"
+
+#define PREFORK_SLOT_FREE 0
+#define PREFORK_SLOT_FORKING 1
+#define PREFORK_SLOT_READY 2
+#define PREFORK_RETRY_TIME 1  // s, wait after fork failed
+
+typedef struct {
+    int state;
+    pid_t pid;
+    int readFd;
+    int writeFd;
+} PreforkSlot;
+
+// message sent to the standby child over a socketpair
+typedef struct {
+    AppSpawnClient client;
+    MessageBinSt bin;
+} PreforkMsg;
+
+static struct {
+    PreforkSlot slots[APPSPAWN_PREFORK_MAX];
+    unsigned int count;
+    unsigned int ready;
+    int running;
+    AppSpawnContent *content;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} g_prefork = {
+    .count = 0,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+static void ClearPreforkSlot(PreforkSlot *slot)
+{
+    slot->state = PREFORK_SLOT_FREE;
+    slot->pid = 0;
+    slot->readFd = -1;
+    slot->writeFd = -1;
+}
+
+void AppSpawnClosePreforkFds(void)
+{
+    // called in child process only, no other thread here
+    for (unsigned int i = 0; i < APPSPAWN_PREFORK_MAX; ++i) {
+        PreforkSlot *slot = &g_prefork.slots[i];
+        if (slot->state == PREFORK_SLOT_FREE) {
+            continue;
+        }
+        if (slot->readFd >= 0) {
+            (void)close(slot->readFd);
+        }
+        if (slot->writeFd >= 0) {
+            (void)close(slot->writeFd);
+        }
+        ClearPreforkSlot(slot);
+    }
+    g_prefork.count = 0;
+    g_prefork.ready = 0;
+    g_prefork.running = 0;
+}
+
+static void RunStandbyChild(AppSpawnContent *content, int fd, pid_t parent)
+{
+#ifdef __LINUX__
+    // standby child exits with the server, reset after message received
+    (void)prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+    if (getppid() != parent) {
+        _exit(0);
+    }
+    (void)prctl(PR_SET_NAME, "apppool");
+    AppSpawnClosePreforkFds();
+
+    PreforkMsg msg = {};
+    size_t total = 0;
+    while (total < sizeof(msg)) {
+        ssize_t len = read(fd, (char *)&msg + total, sizeof(msg) - total);
+        if (len < 0 && errno == EINTR) {
+            continue;
+        }
+        if (len <= 0) {
+            break;
+        }
+        total += (size_t)len;
+    }
+    (void)close(fd);
+    if (total != sizeof(msg)) {
+        // pool closed by server
+        _exit(0);
+    }
+#ifdef __LINUX__
+    (void)prctl(PR_SET_PDEATHSIG, 0);
+#endif
+
+    AppSpawnClientLite client = {};
+    client.client = msg.client;
+    if (ParseMessageBin(&msg.bin, sizeof(msg.bin), &client.message) != EC_SUCCESS) {
+        APPSPAWN_LOGE("[appspawn] prefork child, parse message failed.");
+        _exit(0x7f);  // 0x7f: user specified
+    }
+    ProcessExit(AppSpawnChild(content, &client.client));
+}
+
+static int FindFreeSlot(void)
+{
+    unsigned int used = 0;
+    int index = -1;
+    for (unsigned int i = 0; i < APPSPAWN_PREFORK_MAX; ++i) {
+        if (g_prefork.slots[i].state != PREFORK_SLOT_FREE) {
+            used++;
+        } else if (index < 0) {
+            index = (int)i;
+        }
+    }
+    return (used < g_prefork.count) ? index : -1;
+}
+
+static int ForkStandbyChild(PreforkSlot *slot)
+{
+    int fds[2] = {-1, -1};  // 2 socket fds
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        APPSPAWN_LOGE("[appspawn] prefork, socketpair failed, err %d.", errno);
+        return -1;
+    }
+    slot->state = PREFORK_SLOT_FORKING;
+    slot->readFd = fds[0];
+    slot->writeFd = fds[1];
+    pid_t parent = getpid();
+    pthread_mutex_unlock(&g_prefork.mutex);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        slot->readFd = -1;
+        RunStandbyChild(g_prefork.content, fds[0], parent);
+        _exit(0);
+    }
+    (void)close(fds[0]);
+
+    pthread_mutex_lock(&g_prefork.mutex);
+    slot->readFd = -1;
+    if (pid < 0 || !g_prefork.running) {
+        APPSPAWN_CHECK_ONLY_LOG(pid > 0, "[appspawn] prefork, fork failed, err %d.", errno);
+        (void)close(fds[1]);
+        ClearPreforkSlot(slot);
+        return -1;
+    }
+    slot->pid = pid;
+    slot->state = PREFORK_SLOT_READY;
+    g_prefork.ready++;
+    APPSPAWN_LOGI("[appspawn] prefork, standby child %d ready %u.", pid, g_prefork.ready);
+    return 0;
+}
+
+static void *PreforkRefillThread(void *arg)
+{
+    UNUSED(arg);
+    pthread_mutex_lock(&g_prefork.mutex);
+    while (g_prefork.running) {
+        int index = FindFreeSlot();
+        if (index < 0) {
+            pthread_cond_wait(&g_prefork.cond, &g_prefork.mutex);
+            continue;
+        }
+        if (ForkStandbyChild(&g_prefork.slots[index]) != 0 && g_prefork.running) {
+            pthread_mutex_unlock(&g_prefork.mutex);
+            sleep(PREFORK_RETRY_TIME);
+            pthread_mutex_lock(&g_prefork.mutex);
+        }
+    }
+    pthread_mutex_unlock(&g_prefork.mutex);
+    return NULL;
+}
+
+int AppSpawnPreforkInit(AppSpawnContent *content, unsigned int count)
+{
+    if (content == NULL || count == 0) {
+        return EC_INVALID;
+    }
+    if (g_prefork.running) {
+        return EC_SUCCESS;
+    }
+
+    for (unsigned int i = 0; i < APPSPAWN_PREFORK_MAX; ++i) {
+        ClearPreforkSlot(&g_prefork.slots[i]);
+    }
+    g_prefork.content = content;
+    g_prefork.count = (count < APPSPAWN_PREFORK_MAX) ? count : APPSPAWN_PREFORK_MAX;
+    g_prefork.ready = 0;
+    g_prefork.running = 1;
+    if (pthread_create(&g_prefork.thread, NULL, PreforkRefillThread, NULL) != 0) {
+        APPSPAWN_LOGE("[appspawn] prefork, create refill thread failed, err %d.", errno);
+        g_prefork.running = 0;
+        g_prefork.count = 0;
+        return EC_FAILURE;
+    }
+    APPSPAWN_LOGI("[appspawn] prefork, init with %u standby child.", g_prefork.count);
+    return EC_SUCCESS;
+}
+
+void AppSpawnPreforkExit(void)
+{
+    pthread_mutex_lock(&g_prefork.mutex);
+    if (!g_prefork.running) {
+        pthread_mutex_unlock(&g_prefork.mutex);
+        return;
+    }
+    g_prefork.running = 0;
+    pthread_cond_signal(&g_prefork.cond);
+    pthread_mutex_unlock(&g_prefork.mutex);
+    (void)pthread_join(g_prefork.thread, NULL);
+
+    // standby children exit when socket closed
+    for (unsigned int i = 0; i < APPSPAWN_PREFORK_MAX; ++i) {
+        PreforkSlot *slot = &g_prefork.slots[i];
+        if (slot->writeFd >= 0) {
+            (void)close(slot->writeFd);
+        }
+        ClearPreforkSlot(slot);
+    }
+    g_prefork.count = 0;
+    g_prefork.ready = 0;
+}
+
+static bool IsStandbyChildAlive(const PreforkSlot *slot)
+{
+    // peer end closed when the standby child exits
+    struct pollfd pfd = {slot->writeFd, 0, 0};
+    if (poll(&pfd, 1, 0) <= 0) {
+        return true;
+    }
+    return (pfd.revents & (POLLHUP | POLLERR | POLLNVAL)) == 0;
+}
+
+static void ReleaseDeadStandbyChild(void)
+{
+    // called with mutex locked, the dead child is reaped by SIGCHLD handler
+    bool released = false;
+    for (unsigned int i = 0; i < APPSPAWN_PREFORK_MAX; ++i) {
+        PreforkSlot *slot = &g_prefork.slots[i];
+        if (slot->state != PREFORK_SLOT_READY || IsStandbyChildAlive(slot)) {
+            continue;
+        }
+        APPSPAWN_LOGW("[appspawn] prefork, standby child %d died.", slot->pid);
+        (void)close(slot->writeFd);
+        ClearPreforkSlot(slot);
+        g_prefork.ready--;
+        released = true;
+    }
+    if (released) {
+        pthread_cond_signal(&g_prefork.cond);
+    }
+}
+
+unsigned int AppSpawnPreforkReadyCount(void)
+{
+    pthread_mutex_lock(&g_prefork.mutex);
+    ReleaseDeadStandbyChild();
+    unsigned int ready = g_prefork.ready;
+    pthread_mutex_unlock(&g_prefork.mutex);
+    return ready;
+}
+
+static int TakeStandbyChild(pid_t *pid, int *fd)
+{
+    int ret = -1;
+    pthread_mutex_lock(&g_prefork.mutex);
+    ReleaseDeadStandbyChild();
+    for (unsigned int i = 0; i < APPSPAWN_PREFORK_MAX; ++i) {
+        PreforkSlot *slot = &g_prefork.slots[i];
+        if (slot->state != PREFORK_SLOT_READY) {
+            continue;
+        }
+        *pid = slot->pid;
+        *fd = slot->writeFd;
+        ClearPreforkSlot(slot);
+        g_prefork.ready--;
+        ret = 0;
+        break;
+    }
+    // refill the pool in refill thread
+    pthread_cond_signal(&g_prefork.cond);
+    pthread_mutex_unlock(&g_prefork.mutex);
+    return ret;
+}
+
+int AppSpawnPreforkSpawn(const AppSpawnClientLite *client, pid_t *childPid)
+{
+    if (client == NULL || childPid == NULL || !g_prefork.running) {
+        return EC_INVALID;
+    }
+
+    PreforkMsg msg = {};
+    msg.client = client->client;
+    if (PackMessageSt(&client->message, &msg.bin) != EC_SUCCESS) {
+        return EC_INVALID;
+    }
+
+    pid_t pid = 0;
+    int fd = -1;
+    while (TakeStandbyChild(&pid, &fd) == 0) {
+        ssize_t len = 0;
+        do {
+            len = send(fd, &msg, sizeof(msg), MSG_NOSIGNAL);
+        } while (len < 0 && errno == EINTR);
+        (void)close(fd);
+        if (len == (ssize_t)sizeof(msg)) {
+            *childPid = pid;
+            return EC_SUCCESS;
+        }
+        // standby child died, try next one
+        // the child exits itself once the socket is closed, and is reaped by SIGCHLD handler
+        APPSPAWN_LOGE("[appspawn] prefork, send to child %d failed, err %d.", pid, errno);
+    }
+    return EC_FAILURE;
+}
@@ -207,6 +207,8 @@ int AppSpawnExecuteSpawningHook(AppSpawnContent *content, AppSpawnClient *client
 
 int AppSpawnExecuteClearEnvHook(AppSpawnContent *content, AppSpawnClient *client)
 {
+    // app process does not hold the pipes of standby children
+    AppSpawnClosePreforkFds();
     return 0;
 }
 
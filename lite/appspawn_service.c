@@ -108,6 +108,27 @@ static int GetMessageSt(MessageSt *msgSt, IpcIo *req)
     return ret;
 }
 
+static int GetMessageBin(MessageSt *msgSt, IpcIo *req)
+{
+    if (msgSt == NULL || req == NULL) {
+        return EC_FAILURE;
+    }
+
+    uint32_t len = 0;
+    if (!ReadUint32(req, &len) || len != sizeof(MessageBinSt)) {
+        APPSPAWN_LOGE("[appspawn] invoke, invalid binary message len %u.", len);
+        return EC_FAILURE;
+    }
+
+    // msgSt points into the ipc buffer, valid until invoke returns
+    const void *buf = ReadBuffer(req, len);
+    if (buf == NULL) {
+        APPSPAWN_LOGE("[appspawn] invoke, get binary data failed.");
+        return EC_FAILURE;
+    }
+    return ParseMessageBin(buf, len, msgSt);
+}
+
 static AppSpawnContentLite *g_appSpawnContentLite = NULL;
 AppSpawnContent *AppSpawnCreateContent(const char *socketName, char *longProcName, uint32_t longProcNameLen, int cold)
 {
@@ -135,7 +156,7 @@ static int Invoke(IServerProxy *iProxy, int funcId, void *origin, IpcIo *req, Ip
     UNUSED(iProxy);
     UNUSED(origin);
 
-    if (reply == NULL || funcId != ID_CALL_CREATE_SERVICE || req == NULL) {
+    if (reply == NULL || (funcId != ID_CALL_CREATE_SERVICE && funcId != ID_CALL_CREATE_SERVICE_BIN) || req == NULL) {
         APPSPAWN_LOGE("[appspawn] invoke, funcId %d invalid, reply %d.", funcId, INVALID_PID);
         WriteInt64(reply, INVALID_PID);
         return EC_BADPTR;
@@ -144,7 +165,10 @@ static int Invoke(IServerProxy *iProxy, int funcId, void *origin, IpcIo *req, Ip
     AppSpawnClientLite client = {};
     client.client.id = CLIENT_ID;
     client.client.flags = 0;
-    if (GetMessageSt(&client.message, req) != EC_SUCCESS) {
+    // binary message is preferred, json is kept for old clients
+    int ret = (funcId == ID_CALL_CREATE_SERVICE_BIN) ?
+        GetMessageBin(&client.message, req) : GetMessageSt(&client.message, req);
+    if (ret != EC_SUCCESS) {
         APPSPAWN_LOGE("[appspawn] invoke, parse failed! reply %d.", INVALID_PID);
         WriteInt64(reply, INVALID_PID);
         return EC_FAILURE;
@@ -153,7 +177,11 @@ static int Invoke(IServerProxy *iProxy, int funcId, void *origin, IpcIo *req, Ip
     APPSPAWN_LOGI("[appspawn] invoke, msg<%s,%s,%d,%d %d>", client.message.bundleName, client.message.identityID,
         client.message.uID, client.message.gID, client.message.capsCnt);
     pid_t newPid = 0;
-    int ret = AppSpawnProcessMsg(&g_appSpawnContentLite->content, &client.client, &newPid);
+    // hand over to a standby child, fork here only if none is ready
+    ret = AppSpawnPreforkSpawn(&client, &newPid);
+    if (ret != EC_SUCCESS) {
+        ret = AppSpawnProcessMsg(&g_appSpawnContentLite->content, &client.client, &newPid);
+    }
     if (ret != 0) {
         newPid = -1;
     }
@@ -25,6 +25,7 @@ extern "C" {
 
 enum APPSPAWN_FUNCID {
     ID_CALL_CREATE_SERVICE = 0,
+    ID_CALL_CREATE_SERVICE_BIN,
     ID_CALL_BUT
 };
 
@@ -19,6 +19,7 @@
 #include <unistd.h>
 
 #include "samgr_lite.h"
+#include "appspawn_message.h"
 #include "appspawn_server.h"
 #include "appspawn_service.h"
 
@@ -79,7 +80,12 @@ int main(int argc, char * const argv[])
     // 2. register signal for SIGCHLD
     SignalRegist();
 
-    // 3. keep process alive
+    // 3. fork standby children, fork cost is not in the launch path
+    if (APPSPAWN_PREFORK_COUNT > 0) {
+        (void)AppSpawnPreforkInit(content, APPSPAWN_PREFORK_COUNT);
+    }
+
+    // 4. keep process alive
     APPSPAWN_LOGI("[appspawn] main, entering wait.");
     while (1) {
         // pause only returns when a signal was caught and the signal-catching function returned.
@@ -13,11 +13,17 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <cctype>
 #include <cerrno>
+#include <csignal>
 #include <cstring>
 #include <dlfcn.h>
+#include <fcntl.h>
 #include <set>
 #include <string>
+#include <sys/stat.h>
+#include <thread>
 #include <unistd.h>
 #include <utility>
 #include <vector>
@@ -33,6 +39,8 @@
 #include "js_runtime.h"
 #include "json_utils.h"
 #include "parameters.h"
+#include "preload_report.h"
+#include "preload_usage.h"
 #include "resource_manager.h"
 #ifndef APPSPAWN_TEST
 #include "ace_forward_compatibility.h"
@@ -49,6 +57,12 @@ static const bool DEFAULT_PRELOAD_VALUE = false;
 static const bool DEFAULT_PRELOAD_VALUE = true;
 #endif
 static const std::string PRELOAD_JSON_CONFIG("/appspawn_preload.json");
+static const uint32_t PRELOAD_PREFETCH_THREAD_COUNT = 4;
+#if defined(__aarch64__) || defined(__x86_64__) || (defined(__riscv) && __riscv_xlen == 64)
+static const std::string NAPI_MODULE_LIB_PATH("/system/lib64/module/");
+#else
+static const std::string NAPI_MODULE_LIB_PATH("/system/lib/module/");
+#endif
 
 typedef struct TagParseJsonContext {
     std::set<std::string> modules;
@@ -81,7 +95,48 @@ static int GetModuleSet(const cJSON *root, ParseJsonContext *context)
     return 0;
 }
 
-static void PreloadModule(void)
+// napi模块名转换为so路径，与napi加载模块时的规则一致：a.B -> a/libb.z.so、a/libb_napi.z.so、a/libb_module.z.so
+static std::vector<std::string> GetModuleLibPaths(const std::string &moduleName)
+{
+    std::string name = moduleName;
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+    std::replace(name.begin(), name.end(), '.', '/');
+    std::string dir = NAPI_MODULE_LIB_PATH;
+    size_t pos = name.rfind('/');
+    if (pos != std::string::npos) {
+        dir += name.substr(0, pos + 1);
+        name = name.substr(pos + 1);
+    }
+    return {dir + "lib" + name + ".z.so", dir + "lib" + name + "_napi.z.so", dir + "lib" + name + "_module.z.so"};
+}
+
+static void PrefetchModuleLib(const std::string &moduleName)
+{
+    for (const auto &path : GetModuleLibPaths(moduleName)) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        struct stat st = {};
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            (void)posix_fadvise(fd, 0, st.st_size, POSIX_FADV_WILLNEED);
+        }
+        close(fd);
+    }
+}
+
+static void PrefetchModuleGroup(const std::vector<std::string> &modules, uint32_t group)
+{
+    // 信号统一由主线程处理
+    sigset_t mask;
+    sigfillset(&mask);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+    for (size_t i = group; i < modules.size(); i += PRELOAD_PREFETCH_THREAD_COUNT) {
+        PrefetchModuleLib(modules[i]);
+    }
+}
+
+static void PreloadModule(AppSpawnMgr *content)
 {
     OHOS::AbilityRuntime::Runtime::Options options;
     options.lang = OHOS::AbilityRuntime::Runtime::Language::JS;
@@ -96,15 +151,31 @@ static void PreloadModule(void)
 
     ParseJsonContext context = {};
     (void)ParseJsonConfig("etc/appspawn", PRELOAD_JSON_CONFIG.c_str(), GetModuleSet, &context);
-    for (std::string moduleName : context.modules) {
+    std::vector<std::string> modules(context.modules.begin(), context.modules.end());
+    // runtime不支持多线程加载模块，并行模式下由辅助线程按组提前读取模块的so，与主线程加载重叠
+    std::vector<std::thread> prefetchThreads;
+    if (OHOS::system::GetBoolParameter("persist.appspawn.preload.parallel", false)) {
+        for (uint32_t i = 0; i < PRELOAD_PREFETCH_THREAD_COUNT && i < modules.size(); i++) {
+            prefetchThreads.emplace_back(PrefetchModuleGroup, std::cref(modules), i);
+        }
+    }
+    PreloadProfiler profiler(OHOS::system::GetBoolParameter("persist.appspawn.preload.profile", false));
+    for (const std::string &moduleName : modules) {
         APPSPAWN_LOGI("moduleName %{public}s", moduleName.c_str());
+        profiler.Start(moduleName);
         runtime->PreloadSystemModule(moduleName);
+        profiler.Stop();
+    }
+    for (auto &thread : prefetchThreads) {
+        thread.join();
     }
+    profiler.Report(content);
+    PreloadUsageInit(content, NAPI_MODULE_LIB_PATH, profiler.GetCostRate());
     // Save preloaded runtime
     OHOS::AbilityRuntime::Runtime::SavePreloaded(std::move(runtime));
 }
 
-static void LoadExtendLib(void)
+static void LoadExtendLib(AppSpawnMgr *content)
 {
     const char *acelibdir = OHOS::Ace::AceForwardCompatibility::GetAceLibName();
     APPSPAWN_LOGI("LoadExtendLib: Start calling dlopen acelibdir.");
@@ -113,15 +184,16 @@ static void LoadExtendLib(void)
     APPSPAWN_LOGI("LoadExtendLib: Success to dlopen %{public}s", acelibdir);
 
     OHOS::AppExecFwk::MainThread::PreloadExtensionPlugin();
+    // 冷启动进程不会再fork，预加载JS VM只增加启动耗时
     bool preload = OHOS::system::GetBoolParameter("persist.appspawn.preload", DEFAULT_PRELOAD_VALUE);
-    if (!preload) {
+    if (!preload || IsColdRunMode(content)) {
         APPSPAWN_LOGI("LoadExtendLib: Do not preload JS VM");
         return;
     }
 
     APPSPAWN_LOGI("LoadExtendLib: Start preload JS VM");
     SetTraceDisabled(true);
-    PreloadModule();
+    PreloadModule(content);
     SetTraceDisabled(false);
 
     OHOS::Ace::AceForwardCompatibility::ReclaimFileCache(getpid());
@@ -263,7 +335,12 @@ APPSPAWN_STATIC int PreLoadAppSpawn(AppSpawnMgr *content)
         LoadExtendCJLib();
         return 0;
     }
-    LoadExtendLib();
+    LoadExtendLib(content);
+    if (IsColdRunMode(content)) {
+        return 0;
+    }
+    // 未预加载JS VM时同样可以记录应用使用的模块
+    PreloadUsageInit(content, NAPI_MODULE_LIB_PATH, 0);
     return 0;
 }
 
@@ -271,4 +348,6 @@ MODULE_CONSTRUCTOR(void)
 {
     APPSPAWN_LOGV("Load ace module ...");
     AddPreloadHook(HOOK_PRIO_HIGHEST, PreLoadAppSpawn);
+    AddProcessMgrHook(STAGE_SERVER_APP_ADD, 0, PreloadUsageAddApp);
+    AddProcessMgrHook(STAGE_SERVER_APP_DIED, 0, PreloadUsageRemoveApp);
 }
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "preload_report.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "appspawn_hook.h"
+#include "appspawn_utils.h"
+#include "securec.h"
+
+namespace OHOS {
+namespace AppSpawn {
+namespace {
+constexpr const char *SELF_SMAPS_ROLLUP = "/proc/self/smaps_rollup";
+constexpr uint32_t PRELOAD_NAME_MAX = 128;
+constexpr uint32_t PRELOAD_REPORT_LOG_TOP = 10;
+constexpr uint64_t KB_PER_MB = 1024;
+}
+
+typedef struct {
+    char name[PRELOAD_NAME_MAX];
+    uint64_t cost;
+    int64_t rssDelta;
+    int64_t pssDelta;
+} PreloadReportItem;
+
+typedef struct {
+    AppSpawnExtData extData;
+    uint32_t memEnable;
+    uint32_t count;
+    uint64_t totalCost;
+    PreloadMemInfo endMem;
+    PreloadReportItem *items;
+} PreloadReport;
+
+static int PreloadReportCompareDataId(ListNode *node, void *data)
+{
+    AppSpawnExtData *extData = reinterpret_cast<AppSpawnExtData *>(ListEntry(node, AppSpawnExtData, node));
+    return extData->dataId - *reinterpret_cast<uint32_t *>(data);
+}
+
+static void FreePreloadReport(struct TagAppSpawnExtData *data)
+{
+    PreloadReport *report = reinterpret_cast<PreloadReport *>(data);
+    OH_ListRemove(&report->extData.node);
+    OH_ListInit(&report->extData.node);
+    free(report->items);
+    free(report);
+}
+
+static void DumpPreloadReport(struct TagAppSpawnExtData *data)
+{
+    PreloadReport *report = reinterpret_cast<PreloadReport *>(data);
+    APPSPAPWN_DUMP("Preload module count: %{public}u total: %{public}" PRIu64 " us", report->count, report->totalCost);
+    if (report->memEnable) {
+        APPSPAPWN_DUMP("Preload end rss: %{public}" PRId64 " KB pss: %{public}" PRId64 " KB",
+            report->endMem.rss, report->endMem.pss);
+    }
+    for (uint32_t i = 0; i < report->count; i++) {
+        const PreloadReportItem &item = report->items[i];
+        APPSPAPWN_DUMP("    %{public}s cost: %{public}" PRIu64 " us rss: %{public}" PRId64 " KB pss: %{public}"
+            PRId64 " KB", item.name, item.cost, item.rssDelta, item.pssDelta);
+    }
+}
+
+bool PreloadProfiler::ReadMemInfo(const char *path, PreloadMemInfo &info)
+{
+    FILE *fp = fopen(path, "r");
+    APPSPAWN_CHECK(fp != nullptr, return false, "Failed to open %{public}s errno: %{public}d", path, errno);
+    uint32_t found = 0;
+    char line[128] = {0};  // 128 max line of smaps_rollup
+    while (fgets(line, sizeof(line), fp) != nullptr && found < 2) {  // 2: Rss and Pss
+        if (strncmp(line, "Rss:", strlen("Rss:")) == 0) {
+            info.rss = strtoll(line + strlen("Rss:"), nullptr, 10);  // 10 decimal
+            found++;
+        } else if (strncmp(line, "Pss:", strlen("Pss:")) == 0) {
+            info.pss = strtoll(line + strlen("Pss:"), nullptr, 10);  // 10 decimal
+            found++;
+        }
+    }
+    (void)fclose(fp);
+    return found == 2;  // 2: Rss and Pss
+}
+
+void PreloadProfiler::Start(const std::string &name)
+{
+    current_ = name;
+    if (memEnable_ && !ReadMemInfo(SELF_SMAPS_ROLLUP, startMem_)) {
+        memEnable_ = false;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &startTime_);
+}
+
+void PreloadProfiler::Stop()
+{
+    struct timespec endTime = {};
+    clock_gettime(CLOCK_MONOTONIC, &endTime);
+    PreloadModuleStat stat;
+    stat.name = std::move(current_);
+    stat.cost = DiffTime(&startTime_, &endTime);
+    PreloadMemInfo endMem;
+    if (memEnable_ && ReadMemInfo(SELF_SMAPS_ROLLUP, endMem)) {
+        stat.rssDelta = endMem.rss - startMem_.rss;
+        stat.pssDelta = endMem.pss - startMem_.pss;
+    }
+    stats_.push_back(std::move(stat));
+    current_.clear();
+}
+
+uint64_t PreloadProfiler::GetCostRate() const
+{
+    if (!memEnable_) {
+        return 0;
+    }
+    uint64_t totalCost = 0;
+    int64_t totalRss = 0;
+    for (const auto &stat : stats_) {
+        totalCost += stat.cost;
+        totalRss += stat.rssDelta;
+    }
+    return totalRss > 0 ? totalCost * KB_PER_MB / static_cast<uint64_t>(totalRss) : 0;
+}
+
+void PreloadProfiler::Report(AppSpawnMgr *content)
+{
+    std::vector<PreloadModuleStat> stats = stats_;
+    std::sort(stats.begin(), stats.end(),
+        [](const PreloadModuleStat &a, const PreloadModuleStat &b) { return a.cost > b.cost; });
+    uint64_t totalCost = 0;
+    for (const auto &stat : stats) {
+        totalCost += stat.cost;
+    }
+    APPSPAWN_LOGI("Preload module count: %{public}zu total: %{public}" PRIu64 " us", stats.size(), totalCost);
+    for (size_t i = 0; i < stats.size() && i < PRELOAD_REPORT_LOG_TOP; i++) {
+        APPSPAWN_LOGI("Preload %{public}s cost: %{public}" PRIu64 " us rss: %{public}" PRId64 " KB pss: %{public}"
+            PRId64 " KB", stats[i].name.c_str(), stats[i].cost, stats[i].rssDelta, stats[i].pssDelta);
+    }
+    APPSPAWN_CHECK_ONLY_EXPER(content != nullptr, return);
+
+    uint32_t dataId = EXT_DATA_PRELOAD_REPORT;
+    ListNode *node = OH_ListFind(&content->extData, reinterpret_cast<void *>(&dataId), PreloadReportCompareDataId);
+    if (node != nullptr) {
+        FreePreloadReport(ListEntry(node, AppSpawnExtData, node));
+    }
+    PreloadReport *report = reinterpret_cast<PreloadReport *>(calloc(1, sizeof(PreloadReport)));
+    APPSPAWN_CHECK(report != nullptr, return, "Failed to create preload report");
+    if (!stats.empty()) {
+        report->items = reinterpret_cast<PreloadReportItem *>(calloc(stats.size(), sizeof(PreloadReportItem)));
+        APPSPAWN_CHECK(report->items != nullptr, free(report);
+            return, "Failed to create preload report items %{public}zu", stats.size());
+    }
+    for (const auto &stat : stats) {
+        PreloadReportItem &item = report->items[report->count++];
+        (void)strncpy_s(item.name, sizeof(item.name), stat.name.c_str(), sizeof(item.name) - 1);
+        item.cost = stat.cost;
+        item.rssDelta = stat.rssDelta;
+        item.pssDelta = stat.pssDelta;
+    }
+    report->totalCost = totalCost;
+    report->memEnable = memEnable_ ? 1 : 0;
+    if (memEnable_) {
+        (void)ReadMemInfo(SELF_SMAPS_ROLLUP, report->endMem);
+    }
+    OH_ListInit(&report->extData.node);
+    report->extData.dataId = EXT_DATA_PRELOAD_REPORT;
+    report->extData.freeNode = FreePreloadReport;
+    report->extData.dumpNode = DumpPreloadReport;
+    OH_ListAddTail(&content->extData, &report->extData.node);
+}
+
+} // namespace AppSpawn
+} // namespace OHOS
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PRELOAD_REPORT_H
+#define PRELOAD_REPORT_H
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "appspawn_manager.h"
+
+namespace OHOS {
+namespace AppSpawn {
+
+struct PreloadMemInfo {
+    int64_t rss = 0;  // KB
+    int64_t pss = 0;  // KB
+};
+
+struct PreloadModuleStat {
+    std::string name;
+    uint64_t cost = 0;  // us
+    int64_t rssDelta = 0;
+    int64_t pssDelta = 0;
+};
+
+class PreloadProfiler {
+public:
+    // memEnable: record RSS/PSS of appspawn before and after each module, read from smaps_rollup
+    explicit PreloadProfiler(bool memEnable) : memEnable_(memEnable) {}
+    PreloadProfiler(const PreloadProfiler &other) = delete;
+    PreloadProfiler &operator=(const PreloadProfiler &other) = delete;
+
+    void Start(const std::string &name);
+    void Stop();
+    // Log the report and save it to content, it is shown by the dump message.
+    void Report(AppSpawnMgr *content);
+    const std::vector<PreloadModuleStat> &GetStats() const
+    {
+        return stats_;
+    }
+    // Preload cost in us per MB of rss, 0 if memory is not recorded
+    uint64_t GetCostRate() const;
+
+    static bool ReadMemInfo(const char *path, PreloadMemInfo &info);
+
+private:
+    bool memEnable_;
+    std::string current_;
+    struct timespec startTime_ {};
+    PreloadMemInfo startMem_ {};
+    std::vector<PreloadModuleStat> stats_;
+};
+
+} // namespace AppSpawn
+} // namespace OHOS
+
+#endif // PRELOAD_REPORT_H
@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "preload_usage.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <unistd.h>
+
+#include "appspawn_hook.h"
+#include "appspawn_timer.h"
+#include "appspawn_utils.h"
+#include "parameters.h"
+#include "securec.h"
+
+namespace OHOS {
+namespace AppSpawn {
+namespace {
+constexpr const char *LIB_PREFIX = "lib";
+constexpr const char *LIB_SUFFIX = ".z.so";
+constexpr const char *LIB_SUFFIX_NAPI = "_napi";
+constexpr const char *LIB_SUFFIX_MODULE = "_module";
+constexpr const char *RSS_KEY = "Rss:";
+constexpr uint32_t PRELOAD_USAGE_MAX_TIME = 600;      // 600s
+constexpr uint32_t PRELOAD_USAGE_MAX_PENDING = 64;    // apps waiting for sample
+constexpr uint64_t MS_PER_SECOND = 1000;
+constexpr uint64_t NS_PER_MS = 1000000;
+constexpr uint32_t KB_PER_MB = 1024;
+constexpr uint32_t SMAPS_LINE_MAX = 512;
+}
+
+typedef struct {
+    ListNode node;
+    pid_t pid;
+    struct timespec spawnTime;
+} PreloadUsageSample;
+
+typedef struct {
+    AppSpawnExtData extData;
+    PreloadUsageAggregator *aggregator;
+    uint32_t sampleTime;  // second after spawn
+    uint32_t pendingCount;
+    ListNode pending;
+    AppSpawnTimer timer;  // 最早一个采样到期时触发，没有待采样应用时停止
+    pid_t ownerPid;  // appspawn pid which owns the timer
+} PreloadUsage;
+
+// smaps在工作线程中解析，不阻塞事件循环
+struct PreloadUsageWork {
+    pid_t pid;
+    std::string moduleDir;
+    std::map<std::string, uint64_t> modules;
+};
+
+static int PreloadUsageCompareDataId(ListNode *node, void *data)
+{
+    AppSpawnExtData *extData = reinterpret_cast<AppSpawnExtData *>(ListEntry(node, AppSpawnExtData, node));
+    return extData->dataId - *reinterpret_cast<uint32_t *>(data);
+}
+
+static PreloadUsage *GetPreloadUsage(const AppSpawnMgr *content)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(content != nullptr, return nullptr);
+    uint32_t dataId = EXT_DATA_PRELOAD_USAGE;
+    ListNode *node = OH_ListFind(&content->extData, reinterpret_cast<void *>(&dataId), PreloadUsageCompareDataId);
+    if (node == nullptr) {
+        return nullptr;
+    }
+    return reinterpret_cast<PreloadUsage *>(ListEntry(node, AppSpawnExtData, node));
+}
+
+static bool EndWith(const std::string &str, const std::string &suffix)
+{
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::string PreloadUsageAggregator::GetModuleName(const std::string &moduleDir, const std::string &path)
+{
+    if (path.compare(0, moduleDir.size(), moduleDir) != 0) {
+        return path;
+    }
+    // a/libb_napi.z.so -> a.b, 模块名大小写信息已丢失
+    std::string name = path.substr(moduleDir.size());
+    size_t pos = name.rfind('/');
+    size_t base = pos == std::string::npos ? 0 : pos + 1;
+    if (name.compare(base, strlen(LIB_PREFIX), LIB_PREFIX) == 0) {
+        name.erase(base, strlen(LIB_PREFIX));
+    }
+    for (const char *suffix : {LIB_SUFFIX, LIB_SUFFIX_NAPI, LIB_SUFFIX_MODULE}) {
+        if (EndWith(name, suffix)) {
+            name.erase(name.size() - strlen(suffix));
+        }
+    }
+    std::replace(name.begin(), name.end(), '/', '.');
+    return name;
+}
+
+bool PreloadUsageAggregator::ParseSmaps(const char *path, const std::string &moduleDir,
+    std::map<std::string, uint64_t> &usage)
+{
+    FILE *fp = fopen(path, "r");
+    APPSPAWN_CHECK(fp != nullptr, return false, "Failed to open %{public}s errno: %{public}d", path, errno);
+    std::string current;
+    bool inModule = false;
+    char line[SMAPS_LINE_MAX] = {0};
+    while (fgets(line, sizeof(line), fp) != nullptr) {
+        // 映射行以地址开始，其余为"Key: value kB"
+        size_t keyLen = strcspn(line, " ");
+        if (keyLen == 0 || line[keyLen - 1] != ':') {
+            line[strcspn(line, "\n")] = '\0';
+            char *file = strchr(line, '/');
+            inModule = file != nullptr && strncmp(file, moduleDir.c_str(), moduleDir.size()) == 0;
+            if (inModule) {
+                current = file;
+            }
+            continue;
+        }
+        if (inModule && strncmp(line, RSS_KEY, strlen(RSS_KEY)) == 0) {
+            usage[current] += strtoull(line + strlen(RSS_KEY), nullptr, 10);  // 10 decimal
+        }
+    }
+    (void)fclose(fp);
+    return true;
+}
+
+void PreloadUsageAggregator::AddApp(const std::map<std::string, uint64_t> &usage)
+{
+    appCount_++;
+    for (const auto &item : usage) {
+        UsageStat &stat = stats_[item.first];
+        stat.appCount++;
+        stat.totalRss += item.second;
+    }
+}
+
+std::vector<PreloadCandidate> PreloadUsageAggregator::GetCandidates() const
+{
+    std::vector<PreloadCandidate> candidates;
+    for (const auto &item : stats_) {
+        // 已预加载的模块被所有应用继承，无法区分是否被使用
+        if (preloaded_.count(item.first) != 0 || item.second.appCount == 0) {
+            continue;
+        }
+        PreloadCandidate candidate;
+        candidate.path = item.first;
+        candidate.module = GetModuleName(moduleDir_, item.first);
+        candidate.appCount = item.second.appCount;
+        candidate.avgRss = item.second.totalRss / item.second.appCount;
+        // 预加载后各应用共享同一份，节省除一份外的内存及每个应用的加载时间
+        candidate.memSaving = candidate.avgRss * (candidate.appCount - 1);
+        candidate.timeSaving = costRate_ * candidate.avgRss * candidate.appCount / KB_PER_MB;
+        candidates.push_back(std::move(candidate));
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const PreloadCandidate &a, const PreloadCandidate &b) {
+        return a.appCount != b.appCount ? a.appCount > b.appCount : a.memSaving > b.memSaving;
+    });
+    return candidates;
+}
+
+static void DumpPreloadUsage(struct TagAppSpawnExtData *data)
+{
+    PreloadUsage *usage = reinterpret_cast<PreloadUsage *>(data);
+    std::vector<PreloadCandidate> candidates = usage->aggregator->GetCandidates();
+    APPSPAPWN_DUMP("Preload usage sample time: %{public}u s apps: %{public}u pending: %{public}u "
+        "candidates: %{public}zu", usage->sampleTime, usage->aggregator->GetAppCount(), usage->pendingCount,
+        candidates.size());
+    for (size_t i = 0; i < candidates.size(); i++) {
+        const PreloadCandidate &candidate = candidates[i];
+        APPSPAPWN_DUMP("    %{public}zu %{public}s apps: %{public}u rss: %{public}" PRIu64 " KB saving mem: %{public}"
+            PRIu64 " KB time: %{public}" PRIu64 " us path: %{public}s", i + 1, candidate.module.c_str(),
+            candidate.appCount, candidate.avgRss, candidate.memSaving, candidate.timeSaving, candidate.path.c_str());
+    }
+}
+
+static void RemovePendingSample(PreloadUsage *usage, PreloadUsageSample *sample)
+{
+    OH_ListRemove(&sample->node);
+    free(sample);
+    usage->pendingCount--;
+}
+
+static int ProcessSampleWork(void *data)
+{
+    PreloadUsageWork *work = reinterpret_cast<PreloadUsageWork *>(data);
+    char path[32] = {0};  // 32 max of /proc/<pid>/smaps
+    int ret = snprintf_s(path, sizeof(path), sizeof(path) - 1, "/proc/%d/smaps", work->pid);
+    APPSPAWN_CHECK_ONLY_EXPER(ret > 0, return -1);
+    return PreloadUsageAggregator::ParseSmaps(path, work->moduleDir, work->modules) ? 0 : -1;
+}
+
+static void SampleWorkComplete(void *data, int result)
+{
+    PreloadUsageWork *work = reinterpret_cast<PreloadUsageWork *>(data);
+    PreloadUsage *usage = GetPreloadUsage(GetAppSpawnMgr());
+    // 解析期间应用退出时，pid可能已被复用，丢弃结果
+    AppSpawnedProcess *appInfo = GetSpawnedProcess(work->pid);
+    if (result == 0 && usage != nullptr && appInfo != nullptr) {
+        usage->aggregator->AddApp(work->modules);
+        APPSPAWN_LOGV("Preload usage app %{public}s pid: %{public}d modules: %{public}zu",
+            appInfo->name, work->pid, work->modules.size());
+    }
+    delete work;
+}
+
+static void SampleModuleUsage(PreloadUsage *usage, pid_t pid)
+{
+    // pid已退出或被复用时不再采样
+    APPSPAWN_CHECK_ONLY_EXPER(GetSpawnedProcess(pid) != nullptr, return);
+    PreloadUsageWork *work = new (std::nothrow) PreloadUsageWork();
+    APPSPAWN_CHECK(work != nullptr, return, "Failed to create preload usage work");
+    work->pid = pid;
+    work->moduleDir = usage->aggregator->GetModuleDir();
+    char key[32] = {0};  // 32 max of preload-usage-<pid>
+    int ret = snprintf_s(key, sizeof(key), sizeof(key) - 1, "preload-usage-%d", pid);
+    APPSPAWN_CHECK(ret > 0, delete work;
+        return, "Failed to format preload usage key %{public}d", pid);
+    ret = AppSpawnPostWork(key, ProcessSampleWork, SampleWorkComplete, work);
+    APPSPAWN_CHECK(ret == 0, delete work;
+        return, "Failed to post preload usage work %{public}d", pid);
+}
+
+static int64_t GetSampleRemainTime(const PreloadUsage *usage, const PreloadUsageSample *sample,
+    const struct timespec &now)
+{
+    int64_t elapsed = (now.tv_sec - sample->spawnTime.tv_sec) * static_cast<int64_t>(MS_PER_SECOND) +
+        (now.tv_nsec - sample->spawnTime.tv_nsec) / static_cast<int64_t>(NS_PER_MS);
+    return static_cast<int64_t>(usage->sampleTime * MS_PER_SECOND) - elapsed;
+}
+
+static void ProcessPreloadUsageTimer(AppSpawnTimer *timer, void *context);
+
+static void StartPreloadUsageTimer(PreloadUsage *usage)
+{
+    if (ListEmpty(usage->pending) || AppSpawnTimerActive(&usage->timer)) {
+        return;
+    }
+    // 按孵化时间排序，只需等待第一个采样到期
+    PreloadUsageSample *sample = ListEntry(usage->pending.next, PreloadUsageSample, node);
+    struct timespec now = {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t timeout = GetSampleRemainTime(usage, sample, now);
+    int ret = AppSpawnStartTimer(&usage->timer, timeout > 0 ? static_cast<uint64_t>(timeout) : 0,
+        ProcessPreloadUsageTimer, usage);
+    APPSPAWN_CHECK_ONLY_LOG(ret == 0, "Failed to start preload usage timer %{public}d", ret);
+}
+
+static void ProcessPreloadUsageTimer(AppSpawnTimer *timer, void *context)
+{
+    PreloadUsage *usage = reinterpret_cast<PreloadUsage *>(context);
+    struct timespec now = {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ListNode *node = usage->pending.next;
+    while (node != &usage->pending) {
+        PreloadUsageSample *sample = ListEntry(node, PreloadUsageSample, node);
+        node = node->next;
+        if (GetSampleRemainTime(usage, sample, now) > 0) {
+            break;  // 按孵化时间排序
+        }
+        SampleModuleUsage(usage, sample->pid);
+        RemovePendingSample(usage, sample);
+    }
+    StartPreloadUsageTimer(usage);
+}
+
+static void FreePreloadUsage(struct TagAppSpawnExtData *data)
+{
+    PreloadUsage *usage = reinterpret_cast<PreloadUsage *>(data);
+    OH_ListRemove(&usage->extData.node);
+    OH_ListInit(&usage->extData.node);
+    while (!ListEmpty(usage->pending)) {
+        PreloadUsageSample *sample = ListEntry(usage->pending.next, PreloadUsageSample, node);
+        OH_ListRemove(&sample->node);
+        free(sample);
+    }
+    if (usage->ownerPid == getpid()) {
+        AppSpawnStopTimer(&usage->timer);
+    }
+    delete usage->aggregator;
+    free(usage);
+}
+
+static std::set<std::string> GetPreloadedModules(const std::string &moduleDir)
+{
+    std::set<std::string> preloaded;
+    FILE *fp = fopen("/proc/self/maps", "r");
+    APPSPAWN_CHECK(fp != nullptr, return preloaded, "Failed to open maps errno: %{public}d", errno);
+    char line[SMAPS_LINE_MAX] = {0};
+    while (fgets(line, sizeof(line), fp) != nullptr) {
+        line[strcspn(line, "\n")] = '\0';
+        char *file = strchr(line, '/');
+        if (file != nullptr && strncmp(file, moduleDir.c_str(), moduleDir.size()) == 0) {
+            preloaded.insert(file);
+        }
+    }
+    (void)fclose(fp);
+    return preloaded;
+}
+
+void PreloadUsageInit(AppSpawnMgr *content, const std::string &moduleDir, uint64_t costRate)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(content != nullptr, return);
+    uint32_t sampleTime = OHOS::system::GetUintParameter<uint32_t>("persist.appspawn.preload.usage.time", 0);
+    if (sampleTime == 0 || GetPreloadUsage(content) != nullptr) {
+        return;
+    }
+    sampleTime = std::min(sampleTime, PRELOAD_USAGE_MAX_TIME);
+    PreloadUsage *usage = reinterpret_cast<PreloadUsage *>(calloc(1, sizeof(PreloadUsage)));
+    APPSPAWN_CHECK(usage != nullptr, return, "Failed to create preload usage");
+    usage->aggregator = new (std::nothrow) PreloadUsageAggregator(moduleDir, GetPreloadedModules(moduleDir), costRate);
+    APPSPAWN_CHECK(usage->aggregator != nullptr, free(usage);
+        return, "Failed to create preload usage aggregator");
+    usage->sampleTime = sampleTime;
+    usage->ownerPid = getpid();
+    AppSpawnInitTimer(&usage->timer);
+    OH_ListInit(&usage->pending);
+    OH_ListInit(&usage->extData.node);
+    usage->extData.dataId = EXT_DATA_PRELOAD_USAGE;
+    usage->extData.freeNode = FreePreloadUsage;
+    usage->extData.dumpNode = DumpPreloadUsage;
+    OH_ListAddTail(&content->extData, &usage->extData.node);
+    APPSPAWN_LOGI("Preload usage record enable sample time: %{public}u s", sampleTime);
+}
+
+int PreloadUsageAddApp(const AppSpawnMgr *content, const AppSpawnedProcessInfo *appInfo)
+{
+    PreloadUsage *usage = GetPreloadUsage(content);
+    if (usage == nullptr || appInfo == nullptr || usage->pendingCount >= PRELOAD_USAGE_MAX_PENDING) {
+        return 0;
+    }
+    PreloadUsageSample *sample = reinterpret_cast<PreloadUsageSample *>(calloc(1, sizeof(PreloadUsageSample)));
+    APPSPAWN_CHECK_ONLY_EXPER(sample != nullptr, return 0);
+    sample->pid = appInfo->pid;
+    clock_gettime(CLOCK_MONOTONIC, &sample->spawnTime);
+    OH_ListAddTail(&usage->pending, &sample->node);
+    usage->pendingCount++;
+    StartPreloadUsageTimer(usage);
+    return 0;
+}
+
+int PreloadUsageRemoveApp(const AppSpawnMgr *content, const AppSpawnedProcessInfo *appInfo)
+{
+    PreloadUsage *usage = GetPreloadUsage(content);
+    if (usage == nullptr || appInfo == nullptr) {
+        return 0;
+    }
+    ListNode *node = usage->pending.next;
+    while (node != &usage->pending) {
+        PreloadUsageSample *sample = ListEntry(node, PreloadUsageSample, node);
+        if (sample->pid == appInfo->pid) {
+            RemovePendingSample(usage, sample);
+            break;
+        }
+        node = node->next;
+    }
+    if (ListEmpty(usage->pending)) {
+        AppSpawnStopTimer(&usage->timer);
+    }
+    return 0;
+}
+
+} // namespace AppSpawn
+} // namespace OHOS
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PRELOAD_USAGE_H
+#define PRELOAD_USAGE_H
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "appspawn_manager.h"
+
+namespace OHOS {
+namespace AppSpawn {
+
+struct PreloadCandidate {
+    std::string module;
+    std::string path;
+    uint32_t appCount = 0;
+    uint64_t avgRss = 0;      // KB
+    uint64_t memSaving = 0;   // KB, estimated
+    uint64_t timeSaving = 0;  // us, estimated
+};
+
+// Aggregate the napi module libraries loaded by apps after fork, and rank the modules not preloaded by appspawn
+class PreloadUsageAggregator {
+public:
+    PreloadUsageAggregator(const std::string &moduleDir, const std::set<std::string> &preloaded, uint64_t costRate)
+        : moduleDir_(moduleDir), preloaded_(preloaded), costRate_(costRate) {}
+    PreloadUsageAggregator(const PreloadUsageAggregator &other) = delete;
+    PreloadUsageAggregator &operator=(const PreloadUsageAggregator &other) = delete;
+
+    // usage: module library path -> rss(KB) of one app
+    void AddApp(const std::map<std::string, uint64_t> &usage);
+    std::vector<PreloadCandidate> GetCandidates() const;
+    uint32_t GetAppCount() const
+    {
+        return appCount_;
+    }
+    const std::string &GetModuleDir() const
+    {
+        return moduleDir_;
+    }
+
+    // Sum rss of the libraries in moduleDir from smaps of a process
+    static bool ParseSmaps(const char *path, const std::string &moduleDir, std::map<std::string, uint64_t> &usage);
+    static std::string GetModuleName(const std::string &moduleDir, const std::string &path);
+
+private:
+    struct UsageStat {
+        uint32_t appCount = 0;
+        uint64_t totalRss = 0;
+    };
+    std::string moduleDir_;
+    std::set<std::string> preloaded_;
+    uint64_t costRate_;  // preload cost us per MB of rss, 0 if unknown
+    uint32_t appCount_ = 0;
+    std::map<std::string, UsageStat> stats_;
+};
+
+// Record module usage of apps after fork, enabled by persist.appspawn.preload.usage.time(second)
+void PreloadUsageInit(AppSpawnMgr *content, const std::string &moduleDir, uint64_t costRate);
+int PreloadUsageAddApp(const AppSpawnMgr *content, const AppSpawnedProcessInfo *appInfo);
+int PreloadUsageRemoveApp(const AppSpawnMgr *content, const AppSpawnedProcessInfo *appInfo);
+
+} // namespace AppSpawn
+} // namespace OHOS
+
+#endif // PRELOAD_USAGE_H
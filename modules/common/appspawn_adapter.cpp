@@ -15,6 +15,15 @@
 
 #include "appspawn_adapter.h"
 
+#include <csignal>
+#include <fcntl.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <sys/prctl.h>
+#include <sys/ptrace.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
 #include "access_token.h"
 #include "appspawn_hook.h"
 #include "appspawn_manager.h"
@@ -30,17 +39,38 @@
 #endif
 #ifdef WITH_SECCOMP
 #include "seccomp_policy.h"
-#include <sys/prctl.h>
 #ifdef SECCOMP_PRIVILEGE
 #include <dlfcn.h>
 #define GET_ALL_PROCESSES "ohos.permission.GET_ALL_PROCESSES"
 #define GET_PERMISSION_INDEX "GetPermissionIndex"
 using GetPermissionFunc = int32_t (*)(void *, const char *);
+static GetPermissionFunc g_getPermissionFunc = nullptr;
 #endif
 #endif
 #define MSG_EXT_NAME_PROCESS_TYPE "ProcessType"
 #define NWEBSPAWN_SERVER_NAME "nwebspawn"
 #define MAX_USERID_LEN  32
+#define SECCOMP_FILTER_CACHE_MAX 4
+#define SECCOMP_FILTER_NAME_LEN 64
+// 与内核ptrace接口一致，libc未必提供
+#define APPSPAWN_PTRACE_SECCOMP_GET_FILTER 0x420c
+#define APPSPAWN_PTRACE_GET_SECCOMP_METADATA 0x420d
+
+typedef struct {
+    uint64_t filterOff;
+    uint64_t flags;
+} SeccompMetadata;
+
+typedef struct {
+    int type;
+    char name[SECCOMP_FILTER_NAME_LEN];
+    struct sock_fprog prog;
+    unsigned int flags;
+    bool noNewPrivs;
+} SeccompFilterCache;
+
+static SeccompFilterCache g_seccompFilterCache[SECCOMP_FILTER_CACHE_MAX];
+static uint32_t g_seccompFilterCount = 0;
 using namespace OHOS::Security::AccessToken;
 
 int SetAppAccessToken(const AppSpawnMgr *content, const AppSpawningCtx *property)
@@ -157,6 +187,165 @@ int SetUidGidFilter(const AppSpawnMgr *content)
     return 0;
 }
 
+int ReadSeccompFilter(pid_t pid, struct sock_fprog *prog, unsigned int *flags)
+{
+    APPSPAWN_CHECK(prog != nullptr && flags != nullptr, return APPSPAWN_ARG_INVALID, "Invalid arg");
+    long count = syscall(__NR_ptrace, APPSPAWN_PTRACE_SECCOMP_GET_FILTER, pid, 0, nullptr);
+    APPSPAWN_CHECK(count > 0 && count <= BPF_MAXINSNS, return APPSPAWN_SYSTEM_ERROR,
+        "Failed to get seccomp filter of %{public}d errno: %{public}d", pid, errno);
+    // 只缓存单个过滤器，多个过滤器时仍按名称安装
+    errno = 0;
+    long next = syscall(__NR_ptrace, APPSPAWN_PTRACE_SECCOMP_GET_FILTER, pid, 1, nullptr);
+    APPSPAWN_CHECK(next < 0 && errno == ENOENT, return APPSPAWN_SYSTEM_ERROR,
+        "More than one seccomp filter in %{public}d", pid);
+
+    SeccompMetadata metadata = {0, 0};
+    long ret = syscall(__NR_ptrace, APPSPAWN_PTRACE_GET_SECCOMP_METADATA, pid, sizeof(metadata), &metadata);
+    APPSPAWN_CHECK(ret > 0, return APPSPAWN_SYSTEM_ERROR,
+        "Failed to get seccomp metadata of %{public}d errno: %{public}d", pid, errno);
+
+    struct sock_filter *filter = static_cast<struct sock_filter *>(calloc(count, sizeof(struct sock_filter)));
+    APPSPAWN_CHECK(filter != nullptr, return APPSPAWN_SYSTEM_ERROR, "Failed to alloc seccomp filter");
+    ret = syscall(__NR_ptrace, APPSPAWN_PTRACE_SECCOMP_GET_FILTER, pid, 0, filter);
+    APPSPAWN_CHECK(ret == count, free(filter);
+        return APPSPAWN_SYSTEM_ERROR, "Failed to read seccomp filter of %{public}d errno: %{public}d", pid, errno);
+    prog->len = static_cast<unsigned short>(count);
+    prog->filter = filter;
+    *flags = static_cast<unsigned int>(metadata.flags);
+    return 0;
+}
+
+static SeccompFilterCache *FindSeccompFilterCache(int type, const char *name)
+{
+    for (uint32_t i = 0; i < g_seccompFilterCount; i++) {
+        if (g_seccompFilterCache[i].type == type && strcmp(g_seccompFilterCache[i].name, name) == 0) {
+            return &g_seccompFilterCache[i];
+        }
+    }
+    return nullptr;
+}
+
+static int CaptureSeccompFilter(int type, const char *name, SeccompPolicyInstaller installer,
+    SeccompFilterCache *cache)
+{
+    int fds[2] = {-1, -1};  // 2 pipe fds
+    APPSPAWN_CHECK(pipe2(fds, O_CLOEXEC) == 0, return APPSPAWN_SYSTEM_ERROR, "Failed to create pipe");
+    pid_t pid = fork();
+    if (pid == 0) {
+        // 探测进程按名称安装过滤器后停住，由父进程读出内核中的过滤器
+        close(fds[0]);
+        int result[2] = {-1, 0};  // 2 install result and no_new_privs
+        if (ptrace(PTRACE_TRACEME, 0, nullptr, nullptr) == 0 && installer(type, name)) {
+            result[0] = 0;
+        }
+        result[1] = prctl(PR_GET_NO_NEW_PRIVS, 0, 0, 0, 0);
+        (void)write(fds[1], result, sizeof(result));
+        (void)raise(SIGSTOP);
+        _exit(0);
+    }
+    close(fds[1]);
+    if (pid < 0) {
+        close(fds[0]);
+        APPSPAWN_LOGE("Failed to fork seccomp probe errno: %{public}d", errno);
+        return APPSPAWN_SYSTEM_ERROR;
+    }
+    int result[2] = {-1, 0};  // 2 install result and no_new_privs
+    ssize_t len = TEMP_FAILURE_RETRY(read(fds[0], result, sizeof(result)));
+    close(fds[0]);
+
+    int ret = APPSPAWN_SYSTEM_ERROR;
+    int status = 0;
+    if (len == static_cast<ssize_t>(sizeof(result)) && result[0] == 0 &&
+        TEMP_FAILURE_RETRY(waitpid(pid, &status, 0)) == pid && WIFSTOPPED(status)) {
+        ret = ReadSeccompFilter(pid, &cache->prog, &cache->flags);
+        cache->noNewPrivs = result[1] == 1;
+    }
+    (void)kill(pid, SIGKILL);
+    (void)TEMP_FAILURE_RETRY(waitpid(pid, &status, 0));
+    return ret;
+}
+
+int AddSeccompFilterCache(int type, const char *name, SeccompPolicyInstaller installer)
+{
+    APPSPAWN_CHECK(name != nullptr && installer != nullptr, return APPSPAWN_ARG_INVALID, "Invalid arg");
+    APPSPAWN_CHECK(FindSeccompFilterCache(type, name) == nullptr, return 0, "Seccomp filter %{public}s exist", name);
+    APPSPAWN_CHECK(g_seccompFilterCount < SECCOMP_FILTER_CACHE_MAX, return APPSPAWN_SYSTEM_ERROR,
+        "Too many seccomp filters");
+    SeccompFilterCache *cache = &g_seccompFilterCache[g_seccompFilterCount];
+    (void)memset_s(cache, sizeof(SeccompFilterCache), 0, sizeof(SeccompFilterCache));
+    int ret = strcpy_s(cache->name, sizeof(cache->name), name);
+    APPSPAWN_CHECK(ret == EOK, return APPSPAWN_SYSTEM_ERROR, "Invalid seccomp filter name %{public}s", name);
+    cache->type = type;
+    ret = CaptureSeccompFilter(type, name, installer, cache);
+    APPSPAWN_CHECK(ret == 0, return ret, "Failed to capture seccomp filter %{public}s", name);
+    g_seccompFilterCount++;
+    APPSPAWN_LOGI("Preload seccomp filter %{public}s len %{public}u flags %{public}u",
+        name, cache->prog.len, cache->flags);
+    return 0;
+}
+
+const struct sock_fprog *GetSeccompFilterCache(int type, const char *name, unsigned int *flags)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(name != nullptr, return nullptr);
+    const SeccompFilterCache *cache = FindSeccompFilterCache(type, name);
+    APPSPAWN_CHECK_ONLY_EXPER(cache != nullptr, return nullptr);
+    if (flags != nullptr) {
+        *flags = cache->flags;
+    }
+    return &cache->prog;
+}
+
+int InstallSeccompFilterCache(int type, const char *name)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(name != nullptr, return APPSPAWN_ARG_INVALID);
+    const SeccompFilterCache *cache = FindSeccompFilterCache(type, name);
+    APPSPAWN_CHECK_ONLY_EXPER(cache != nullptr, return APPSPAWN_SYSTEM_ERROR);
+    if (cache->noNewPrivs && prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) != 0) {
+        return APPSPAWN_SYSTEM_ERROR;
+    }
+    if (syscall(__NR_seccomp, SECCOMP_SET_MODE_FILTER, cache->flags, &cache->prog) != 0) {
+        return APPSPAWN_SYSTEM_ERROR;
+    }
+    return 0;
+}
+
+void ClearSeccompFilterCache(void)
+{
+    for (uint32_t i = 0; i < g_seccompFilterCount; i++) {
+        free(g_seccompFilterCache[i].prog.filter);
+        g_seccompFilterCache[i].prog.filter = nullptr;
+    }
+    g_seccompFilterCount = 0;
+}
+
+#ifdef WITH_SECCOMP
+static bool SetSeccompPolicyByType(int type, const char *name)
+{
+    return SetSeccompPolicyWithName(static_cast<SeccompFilterType>(type), name);
+}
+#endif
+
+int PreloadSeccompFilter(const AppSpawnMgr *content)
+{
+#ifdef WITH_SECCOMP
+    if (!IsEnableSeccomp()) {
+        return 0;
+    }
+    // 在探测进程中按名称安装一次，缓存内核中实际生效的过滤器，子进程一次系统调用安装
+    (void)AddSeccompFilterCache(APP, APP_NAME, SetSeccompPolicyByType);
+    if (IsNWebSpawnMode(content)) {
+        return 0;
+    }
+    (void)AddSeccompFilterCache(APP, IMF_EXTENTOIN_NAME, SetSeccompPolicyByType);
+#ifdef SECCOMP_PRIVILEGE
+    (void)AddSeccompFilterCache(APP, APP_PRIVILEGE, SetSeccompPolicyByType);
+    g_getPermissionFunc = reinterpret_cast<GetPermissionFunc>(dlsym(nullptr, GET_PERMISSION_INDEX));
+    APPSPAWN_CHECK_ONLY_LOG(g_getPermissionFunc != nullptr, "Failed to dlsym get permission errno is %{public}d", errno);
+#endif
+#endif
+    return 0;
+}
+
 int SetSeccompFilter(const AppSpawnMgr *content, const AppSpawningCtx *property)
 {
 #ifdef WITH_SECCOMP
@@ -175,15 +364,14 @@ int SetSeccompFilter(const AppSpawnMgr *content, const AppSpawningCtx *property)
 
 #ifdef SECCOMP_PRIVILEGE
     if (IsDeveloperModeOpen()) {
-        static GetPermissionFunc getPermissionFuncPtr = nullptr;
-        if (getPermissionFuncPtr == nullptr) {
-            getPermissionFuncPtr = reinterpret_cast<GetPermissionFunc>(dlsym(nullptr, GET_PERMISSION_INDEX));
-            if (getPermissionFuncPtr == nullptr) {
+        if (g_getPermissionFunc == nullptr) {
+            g_getPermissionFunc = reinterpret_cast<GetPermissionFunc>(dlsym(nullptr, GET_PERMISSION_INDEX));
+            if (g_getPermissionFunc == nullptr) {
                 APPSPAWN_LOGE("Failed to dlsym get permission errno is %{public}d", errno);
                 return -EINVAL;
             }
         }
-        int32_t index = getPermissionFuncPtr(nullptr, GET_ALL_PROCESSES);
+        int32_t index = g_getPermissionFunc(nullptr, GET_ALL_PROCESSES);
         if (CheckAppPermissionFlagSet(property, static_cast<uint32_t>(index)) != 0) {
             appName = APP_PRIVILEGE;
         }
@@ -194,6 +382,10 @@ int SetSeccompFilter(const AppSpawnMgr *content, const AppSpawningCtx *property)
         appName = IMF_EXTENTOIN_NAME;
     }
 
+    if (InstallSeccompFilterCache(type, appName) == 0) {
+        APPSPAWN_LOGV("SetSeccompFilter from cache for %{public}s", GetProcessName(property));
+        return 0;
+    }
     if (!SetSeccompPolicyWithName(type, appName)) {
         APPSPAWN_LOGE("Failed to set %{public}s seccomp filter and exit %{public}d", appName, errno);
         return -EINVAL;
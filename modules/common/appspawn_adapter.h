@@ -27,12 +27,24 @@ int SetSelinuxCon(const AppSpawnMgr *content, const AppSpawningCtx *property);
 
 int SetUidGidFilter(const AppSpawnMgr *content);
 int SetSeccompFilter(const AppSpawnMgr *content, const AppSpawningCtx *property);
+int PreloadSeccompFilter(const AppSpawnMgr *content);
+
+// 预加载的应用seccomp过滤器，由探测进程按名称安装后从内核读出
+struct sock_fprog;
+typedef bool (*SeccompPolicyInstaller)(int type, const char *name);
+int ReadSeccompFilter(pid_t pid, struct sock_fprog *prog, unsigned int *flags);
+int AddSeccompFilterCache(int type, const char *name, SeccompPolicyInstaller installer);
+const struct sock_fprog *GetSeccompFilterCache(int type, const char *name, unsigned int *flags);
+int InstallSeccompFilterCache(int type, const char *name);
+void ClearSeccompFilterCache(void);
 int SetInternetPermission(const AppSpawningCtx *property);
 int32_t SetEnvInfo(const AppSpawnMgr *content, const AppSpawningCtx *property);
 
 // stub for extend func
 void DisallowInternet(void);
 void DumpSpawnStack(pid_t pid);
+// 后台抓栈，完成后杀掉进程；返回非0时未抓栈，由调用者杀掉进程
+int DumpSpawnStackAsync(pid_t pid, const char *name);
 
 #ifdef __cplusplus
 }
@@ -428,6 +428,8 @@ static int SpawnSetProperties(AppSpawnMgr *content, AppSpawningCtx *property)
 
 static int PreLoadSetSeccompFilter(AppSpawnMgr *content)
 {
+    // 先加载应用的过滤器，再限制appspawn自身
+    (void)PreloadSeccompFilter(content);
     // set uid gid filetr
     int ret = SetUidGidFilter(content);
     APPSPAWN_CHECK_ONLY_EXPER(ret == 0, return ret);
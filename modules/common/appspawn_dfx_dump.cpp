@@ -15,9 +15,41 @@
 
 #include "appspawn_adapter.h"
 
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <ctime>
+#include <map>
+#include <string>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "appspawn_hook.h"
+#include "appspawn_timer.h"
 #include "appspawn_utils.h"
 #include "dfx_dump_catcher.h"
 
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#ifndef SYS_pidfd_send_signal
+#define SYS_pidfd_send_signal 424
+#endif
+#define DUMP_STACK_WORK_KEY "dump-stack"
+#define DUMP_STACK_INTERVAL (60 * 1000 * 1000)  // 60s, 同一应用反复超时时只抓一次栈
+#define DUMP_STACK_RECORD_MAX 64
+#define DUMP_STACK_KILL_TIMEOUT 3000  // 3000ms, 后台任务排队时也按时杀掉超时的子进程
+
+typedef struct {
+    pid_t pid;
+    int pidFd;
+    bool killed;
+    AppSpawnTimer timer;
+} DumpStackWork;
+
+static std::map<std::string, struct timespec> g_dumpRecords;
+static bool g_dumpPending = false;
+
 void DumpSpawnStack(pid_t pid)
 {
 #ifndef APPSPAWN_TEST
@@ -31,3 +63,87 @@ void DumpSpawnStack(pid_t pid)
     }
 #endif
 }
+
+static bool CheckDumpInterval(const char *name)
+{
+    struct timespec now = {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    auto iter = g_dumpRecords.find(name);
+    if (iter != g_dumpRecords.end() && DiffTime(&iter->second, &now) < DUMP_STACK_INTERVAL) {
+        return false;
+    }
+    if (iter == g_dumpRecords.end() && g_dumpRecords.size() >= DUMP_STACK_RECORD_MAX) {
+        for (iter = g_dumpRecords.begin(); iter != g_dumpRecords.end();) {
+            iter = DiffTime(&iter->second, &now) < DUMP_STACK_INTERVAL ? std::next(iter) : g_dumpRecords.erase(iter);
+        }
+        APPSPAWN_CHECK_ONLY_EXPER(g_dumpRecords.size() < DUMP_STACK_RECORD_MAX, return false);
+    }
+    g_dumpRecords[name] = now;
+    return true;
+}
+
+static void KillDumpStackTarget(DumpStackWork *work, const char *reason)
+{
+    if (__atomic_exchange_n(&work->killed, true, __ATOMIC_ACQ_REL)) {
+        return;
+    }
+    // 通过pidfd发送信号，子进程已被回收时不会误杀复用pid的进程
+    int ret = syscall(SYS_pidfd_send_signal, work->pidFd, SIGKILL, nullptr, 0);
+    APPSPAWN_LOGI("Dump stack of pid %{public}d %{public}s, kill result %{public}d", work->pid, reason, ret);
+}
+
+// 在事件循环中执行，抓栈任务排在其他后台任务之后时不再等待
+static void DumpStackKillTimeout(AppSpawnTimer *timer, void *context)
+{
+    KillDumpStackTarget(reinterpret_cast<DumpStackWork *>(context), "timeout");
+}
+
+// 在后台工作线程中执行，不阻塞孵化器的事件循环
+static int ProcessDumpStackWork(void *data)
+{
+    DumpStackWork *work = reinterpret_cast<DumpStackWork *>(data);
+    if (!__atomic_load_n(&work->killed, __ATOMIC_ACQUIRE)) {
+        DumpSpawnStack(work->pid);
+    }
+    return 0;
+}
+
+static void DumpStackWorkComplete(void *data, int result)
+{
+    DumpStackWork *work = reinterpret_cast<DumpStackWork *>(data);
+    AppSpawnStopTimer(&work->timer);
+    KillDumpStackTarget(work, "finished");
+    close(work->pidFd);
+    free(work);
+    g_dumpPending = false;
+}
+
+int DumpSpawnStackAsync(pid_t pid, const char *name)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(pid > 0 && name != nullptr, return APPSPAWN_ARG_INVALID);
+    // 同时只抓一个进程的栈，且按应用限频，避免超时风暴时堆积
+    if (g_dumpPending || !CheckDumpInterval(name)) {
+        APPSPAWN_LOGW("Skip dump stack of %{public}s pid %{public}d", name, pid);
+        return APPSPAWN_SYSTEM_ERROR;
+    }
+    DumpStackWork *work = reinterpret_cast<DumpStackWork *>(calloc(1, sizeof(DumpStackWork)));
+    APPSPAWN_CHECK(work != nullptr, return APPSPAWN_SYSTEM_ERROR, "Failed to create dump stack work");
+    work->pid = pid;
+    work->pidFd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+    APPSPAWN_CHECK(work->pidFd >= 0, free(work);
+        return APPSPAWN_SYSTEM_ERROR, "Failed to open pidfd %{public}d errno: %{public}d", pid, errno);
+    // 子进程保持运行直到抓栈完成或超时，抓栈依赖目标进程响应dump信号，不能先冻结
+    AppSpawnInitTimer(&work->timer);
+    int ret = AppSpawnStartTimer(&work->timer, DUMP_STACK_KILL_TIMEOUT, DumpStackKillTimeout, work);
+    APPSPAWN_CHECK(ret == 0, close(work->pidFd);
+        free(work);
+        return ret, "Failed to start dump stack timer %{public}d", pid);
+    g_dumpPending = true;
+    ret = AppSpawnPostWork(DUMP_STACK_WORK_KEY, ProcessDumpStackWork, DumpStackWorkComplete, work);
+    APPSPAWN_CHECK(ret == 0, AppSpawnStopTimer(&work->timer);
+        close(work->pidFd);
+        free(work);
+        g_dumpPending = false;
+        return ret, "Failed to post dump stack work %{public}d", pid);
+    return 0;
+}
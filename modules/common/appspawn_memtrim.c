@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "appspawn_hook.h"
+#include "appspawn_manager.h"
+#include "appspawn_utils.h"
+#include "parameter.h"
+
+#define SELF_MAPS_PATH "/proc/self/maps"
+#define SELF_STATM_PATH "/proc/self/statm"
+#define MAPS_LINE_MAX 512
+#define PRELOAD_TRIM_STACK_RESERVE (64 * 1024)  // 当前栈顶以下保留的空间，避免释放正在使用的栈
+
+typedef struct {
+    uintptr_t stackStart;
+    uintptr_t stackEnd;
+    uint32_t prefaultCount;
+    uint64_t prefaultSize;
+} PreloadTrimInfo;
+
+static bool CheckTrimEnabled(const char *param, const char *defaultValue)
+{
+    char buffer[32] = {0};  // 32 max
+    int ret = GetParameter(param, defaultValue, buffer, sizeof(buffer));
+    return ret > 0 && strcmp(buffer, "true") == 0;
+}
+
+static int64_t GetSelfRss(void)
+{
+    FILE *fp = fopen(SELF_STATM_PATH, "r");
+    APPSPAWN_CHECK_ONLY_EXPER(fp != NULL, return 0);
+    long size = 0;
+    long resident = 0;
+    int ret = fscanf(fp, "%ld %ld", &size, &resident);
+    (void)fclose(fp);
+    APPSPAWN_CHECK_ONLY_EXPER(ret == 2, return 0);  // 2: size and resident
+    return (int64_t)resident * getpagesize() / 1024;  // 1024 KB
+}
+
+static void TrimMallocArenas(void)
+{
+#ifdef M_PURGE
+    (void)mallopt(M_PURGE, 0);
+#elif defined(__GLIBC__)
+    (void)malloc_trim(0);
+#endif
+}
+
+static bool IsReadOnlyLibrary(const char *perms, const char *path)
+{
+    // 只读的私有文件映射(.rodata/.text)，子进程只会读取
+    if (perms[0] != 'r' || perms[1] != '-' || perms[3] != 'p') {  // 3: private flag
+        return false;
+    }
+    return path[0] == '/' && strstr(path, ".so") != NULL;
+}
+
+APPSPAWN_STATIC int ScanSelfMaps(const char *mapsPath, PreloadTrimInfo *info, bool prefault)
+{
+    FILE *fp = fopen(mapsPath, "r");
+    APPSPAWN_CHECK(fp != NULL, return -1, "Failed to open %{public}s errno: %{public}d", mapsPath, errno);
+    char line[MAPS_LINE_MAX] = {0};
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        unsigned long start = 0;
+        unsigned long end = 0;
+        char perms[8] = {0};  // 8 max of perms
+        int pathOffset = 0;
+        if (sscanf(line, "%lx-%lx %7s %*s %*s %*s %n", &start, &end, perms, &pathOffset) < 3) {  // 3: item count
+            continue;
+        }
+        char *path = line + pathOffset;
+        path[strcspn(path, "\n")] = '\0';
+        if (strcmp(path, "[stack]") == 0) {
+            info->stackStart = start;
+            info->stackEnd = end;
+            continue;
+        }
+        if (!prefault || !IsReadOnlyLibrary(perms, path)) {
+            continue;
+        }
+        // 预读到page cache，子进程首次访问时不再触发读盘
+        if (madvise((void *)start, end - start, MADV_WILLNEED) == 0) {
+            info->prefaultCount++;
+            info->prefaultSize += end - start;
+        }
+    }
+    (void)fclose(fp);
+    return 0;
+}
+
+APPSPAWN_STATIC size_t ReleaseDeadStack(const PreloadTrimInfo *info)
+{
+    // 预加载时调用栈较深，当前栈顶以下的页已无效，释放后子进程写栈时直接分配零页而不是拷贝
+    uintptr_t sp = (uintptr_t)__builtin_frame_address(0);
+    if (sp <= info->stackStart || sp > info->stackEnd || sp - info->stackStart <= PRELOAD_TRIM_STACK_RESERVE) {
+        return 0;
+    }
+    uintptr_t end = (sp - PRELOAD_TRIM_STACK_RESERVE) & ~((uintptr_t)getpagesize() - 1);
+    if (end <= info->stackStart) {
+        return 0;
+    }
+    size_t size = end - info->stackStart;
+    int ret = madvise((void *)info->stackStart, size, MADV_DONTNEED);
+    APPSPAWN_CHECK(ret == 0, return 0, "Failed to release stack errno: %{public}d", errno);
+    return size;
+}
+
+APPSPAWN_STATIC int PreLoadTrimMemory(AppSpawnMgr *content)
+{
+    if (IsColdRunMode(content)) {
+        return 0;
+    }
+    if (!CheckTrimEnabled("persist.appspawn.preload.trim.enable", "true")) {
+        return 0;
+    }
+    struct timespec startTime = {0};
+    struct timespec endTime = {0};
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    int64_t rssBefore = GetSelfRss();
+
+    TrimMallocArenas();
+    PreloadTrimInfo info = {0};
+    (void)ScanSelfMaps(SELF_MAPS_PATH, &info,
+        CheckTrimEnabled("persist.appspawn.preload.prefault.enable", "false"));
+    size_t stackSize = ReleaseDeadStack(&info);
+
+    int64_t rssAfter = GetSelfRss();
+    clock_gettime(CLOCK_MONOTONIC, &endTime);
+    APPSPAWN_LOGI("Preload trim rss: %{public}" PRId64 " -> %{public}" PRId64 " KB stack: %{public}zu KB "
+        "prefault: %{public}u %{public}" PRIu64 " KB cost: %{public}" PRIu64 " us",
+        rssBefore, rssAfter, stackSize / 1024, info.prefaultCount, info.prefaultSize / 1024,  // 1024 KB
+        DiffTime(&startTime, &endTime));
+    return 0;
+}
+
+MODULE_CONSTRUCTOR(void)
+{
+    // 在fork pid_ns_init及辅助进程之前执行，使其也继承整理后的内存
+    AddPreloadHook(HOOK_PRIO_LOWEST - 1, PreLoadTrimMemory);
+}
@@ -13,17 +13,27 @@
  * limitations under the License.
  */
 
-#include <dirent.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <sched.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/prctl.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
 
 #include "appspawn_hook.h"
 #include "appspawn_manager.h"
+#include "appspawn_service.h"
 #include "appspawn_utils.h"
+#include "parameter.h"
 #include "securec.h"
 #ifdef WITH_SELINUX
 #include "selinux/selinux.h"
@@ -31,14 +41,75 @@
 
 #define PID_NS_INIT_UID 100000  // reserved for pid_ns_init process, avoid app, render proc, etc.
 #define PID_NS_INIT_GID 100000
+#define PID_NS_INIT_RETRY_INTERVAL 1000000  // 1s, avoid restarting pid_ns_init in a busy loop
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#ifndef PIDFD_GET_PID_NAMESPACE
+#define PIDFD_GET_PID_NAMESPACE _IO(0xFF, 5)  // linux/pidfd.h, since 6.11
+#endif
+
+#define NS_HELPER_FORK_FD_COUNT 2  // fork ctx pipe of the spawning app
+#define NS_HELPER_MAX_FD_COUNT (NS_HELPER_FORK_FD_COUNT + APP_MAX_FD_COUNT)
+#define NS_HELPER_REPLY_TIMEOUT 1000  // 1000ms, reset on every reply
+#define NS_HELPER_EVENT_INIT_NUM 16
+#define NS_HELPER_POLL_FD_COUNT 3
 
 typedef struct TagAppSpawnNamespace {
     AppSpawnExtData extData;
     int nsSelfPidFd;  // ns pid fd of appspawn
     int nsInitPidFd;  // ns pid fd of pid_ns_init
+    // pid_ns_init is started by appspawn and supervised by its pidfd
+    pid_t nsInitPid;
+    int nsInitProcFd;
+    WatcherHandle nsInitWatcher;
+    struct timespec nsInitStartTime;
+    AppSpawnTimer nsInitTimer;  // restart pid_ns_init after it exits
+    // fork helper: long-lived child of appspawn whose children are created in pid namespace of pid_ns_init
+    uint32_t helperEnable : 1;
+    pid_t helperPid;
+    pid_t ownerPid;      // appspawn pid which owns helper sockets and pid_ns_init watcher
+    int helperReqFd;     // fork request and reply
+    int helperEventFd;   // exit event of the apps forked by helper
+    WatcherHandle helperWatcher;
+    WatcherHandle helperReplyWatcher;
+    AppSpawnTimer helperTimer;
+    uint32_t *helperPending;  // client id of the requests waiting for reply
+    uint32_t helperPendingCount;
+    uint32_t helperPendingCapacity;
 } AppSpawnNamespace;
 
-APPSPAWN_STATIC pid_t GetPidByName(const char *name);
+typedef struct {
+    uint32_t clientId;
+    uint32_t clientFlags;
+    uint32_t msgLen;
+    uint32_t fdCount;  // fork ctx pipe + app fds, sent by SCM_RIGHTS
+} NsHelperRequest;
+
+typedef struct {
+    uint32_t clientId;
+    pid_t pid;
+    int result;
+} NsHelperReply;
+
+typedef struct {
+    pid_t pid;
+    uid_t uid;
+    int status;
+} NsHelperExitEvent;
+
+typedef struct {
+    NsHelperExitEvent *events;
+    uint32_t count;
+    uint32_t capacity;
+} NsHelperEventQueue;
+
+static void NsHelperStop(AppSpawnNamespace *namespace);
+static void StopPidNsInit(AppSpawnNamespace *namespace);
+
+APPSPAWN_STATIC int NsHelperForkChild(AppSpawnContent *content, AppSpawnClient *client, pid_t *childPid);
+APPSPAWN_STATIC int PidNsForkChild(AppSpawnContent *content, AppSpawnClient *client, pid_t *childPid);
 static int AppSpawnExtDataCompareDataId(ListNode *node, void *data)
 {
     AppSpawnExtData *extData = (AppSpawnExtData *)ListEntry(node, AppSpawnExtData, node);
@@ -63,10 +134,13 @@ APPSPAWN_STATIC void DeleteAppSpawnNamespace(AppSpawnNamespace *namespace)
     OH_ListRemove(&namespace->extData.node);
     OH_ListInit(&namespace->extData.node);
 
-    if (namespace->nsInitPidFd > 0) {
-        close(namespace->nsInitPidFd);
-        namespace->nsInitPidFd = -1;
+    NsHelperStop(namespace);
+    free(namespace->helperPending);
+    namespace->helperPending = NULL;
+    if (namespace->ownerPid == getpid()) {
+        AppSpawnStopTimer(&namespace->nsInitTimer);
     }
+    StopPidNsInit(namespace);
     if (namespace->nsSelfPidFd > 0) {
         close(namespace->nsSelfPidFd);
         namespace->nsSelfPidFd = -1;
@@ -87,7 +161,12 @@ APPSPAWN_STATIC AppSpawnNamespace *CreateAppSpawnNamespace(void)
     AppSpawnNamespace *namespace = (AppSpawnNamespace *)calloc(1, sizeof(AppSpawnNamespace));
     APPSPAWN_CHECK(namespace != NULL, return NULL, "Failed to create sandbox");
     namespace->nsInitPidFd = -1;
+    namespace->nsInitProcFd = -1;
     namespace->nsSelfPidFd = -1;
+    namespace->helperReqFd = -1;
+    namespace->helperEventFd = -1;
+    AppSpawnInitTimer(&namespace->helperTimer);
+    AppSpawnInitTimer(&namespace->nsInitTimer);
     // ext data init
     OH_ListInit(&namespace->extData.node);
     namespace->extData.dataId = EXT_DATA_NAMESPACE;
@@ -96,57 +175,11 @@ APPSPAWN_STATIC AppSpawnNamespace *CreateAppSpawnNamespace(void)
     return namespace;
 }
 
-APPSPAWN_STATIC pid_t GetPidByName(const char *name)
-{
-    int pid = -1;  // initial pid set to -1
-    DIR *dir = opendir("/proc");
-    if (dir == NULL) {
-        return -1;
-    }
-
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL) {
-        if (entry->d_type != DT_DIR) {
-            continue;
-        }
-        long pidNum = strtol(entry->d_name, NULL, 10);  // pid will not exceed a 10-digit decimal number
-        if (pidNum <= 0) {
-            continue;
-        }
-
-        char path[32];  // path that contains the process name
-        if (snprintf_s(path, sizeof(path), sizeof(path) - 1, "/proc/%s/comm", entry->d_name) < 0) {
-            continue;
-        }
-        FILE *file = fopen(path, "r");
-        if (file == NULL) {
-            continue;
-        }
-        char buffer[32];  // read the process name
-        if (fgets(buffer, sizeof(buffer), file) == NULL) {
-            (void)fclose(file);
-            continue;
-        }
-        buffer[strcspn(buffer, "\n")] = 0;
-        if (strcmp(buffer, name) != 0) {
-            (void)fclose(file);
-            continue;
-        }
-
-        APPSPAWN_LOGI("get pid of %{public}s success", name);
-        pid = (int)pidNum;
-        (void)fclose(file);
-        break;
-    }
-
-    closedir(dir);
-    return pid;
-}
-
 APPSPAWN_STATIC int NsInitFunc()
 {
-    setuid(PID_NS_INIT_UID);
+    // 先设置gid，设置uid后不再有权限
     setgid(PID_NS_INIT_GID);
+    setuid(PID_NS_INIT_UID);
 #ifdef WITH_SELINUX
     setcon("u:r:pid_ns_init:s0");
 #endif
@@ -174,6 +207,132 @@ APPSPAWN_STATIC int GetNsPidFd(pid_t pid)
     return nsFd;
 }
 
+static int GetNsPidFdByPidFd(int pidFd, pid_t pid)
+{
+    int nsFd = ioctl(pidFd, PIDFD_GET_PID_NAMESPACE, 0);
+    if (nsFd >= 0 || (errno != ENOTTY && errno != EINVAL)) {
+        APPSPAWN_CHECK_ONLY_LOG(nsFd >= 0, "Failed to get ns pid of %{public}d errno: %{public}d", pid, errno);
+        return nsFd;
+    }
+    // 内核不支持通过pidfd获取namespace；pid属于未回收的子进程，不会被复用
+    return GetNsPidFd(pid);
+}
+
+static void KillPidNsInit(pid_t pid, int pidFd)
+{
+    // 子进程尚未回收，pid不会被复用
+    (void)kill(pid, SIGKILL);
+    (void)waitpid(pid, NULL, 0);
+    if (pidFd >= 0) {
+        close(pidFd);
+    }
+}
+
+static void StopPidNsInit(AppSpawnNamespace *namespace)
+{
+    if (namespace->ownerPid == getpid() && namespace->nsInitWatcher != NULL) {
+        LE_RemoveWatcher(LE_GetDefaultLoop(), namespace->nsInitWatcher);
+    }
+    namespace->nsInitWatcher = NULL;
+    if (namespace->nsInitProcFd >= 0) {
+        close(namespace->nsInitProcFd);
+        namespace->nsInitProcFd = -1;
+    }
+    if (namespace->nsInitPidFd >= 0) {
+        close(namespace->nsInitPidFd);
+        namespace->nsInitPidFd = -1;
+    }
+    namespace->nsInitPid = 0;
+}
+
+static int EnsurePidNsInit(AppSpawnMgr *content, AppSpawnNamespace *namespace);
+
+static void RetryPidNsInit(AppSpawnTimer *timer, void *context);
+
+static void StartPidNsInitRetryTimer(AppSpawnNamespace *namespace)
+{
+    int ret = AppSpawnStartTimer(&namespace->nsInitTimer, PID_NS_INIT_RETRY_INTERVAL / 1000,  // 1000 us to ms
+        RetryPidNsInit, namespace);
+    APPSPAWN_CHECK_ONLY_LOG(ret == 0, "Failed to start retry timer of pid_ns_init");
+}
+
+static void RetryPidNsInit(AppSpawnTimer *timer, void *context)
+{
+    AppSpawnNamespace *namespace = (AppSpawnNamespace *)context;
+    // 重试间隔内pid_ns_init不可用，期间的孵化请求直接失败
+    if (EnsurePidNsInit(GetAppSpawnMgr(), namespace) != 0) {
+        StartPidNsInitRetryTimer(namespace);
+    }
+}
+
+static void ProcessPidNsInitExit(const WatcherHandle taskHandle, int fd, uint32_t *events, const void *context)
+{
+    AppSpawnMgr *content = GetAppSpawnMgr();
+    AppSpawnNamespace *namespace = GetAppSpawnNamespace(content);
+    APPSPAWN_CHECK_ONLY_EXPER(namespace != NULL && namespace->nsInitProcFd == fd, return);
+    APPSPAWN_LOGE("pid_ns_init %{public}d exit, restart it", namespace->nsInitPid);
+    StopPidNsInit(namespace);
+    // helper所在的pid namespace已失效
+    NsHelperStop(namespace);
+    if (EnsurePidNsInit(content, namespace) != 0) {
+        StartPidNsInitRetryTimer(namespace);
+    }
+}
+
+static int StartPidNsInit(AppSpawnNamespace *namespace)
+{
+    (void)clock_gettime(CLOCK_MONOTONIC, &namespace->nsInitStartTime);
+    pid_t pid = clone(NsInitFunc, NULL, CLONE_NEWPID | SIGCHLD, NULL);
+    APPSPAWN_CHECK(pid > 0, return -1, "clone pid ns init failed errno: %{public}d", errno);
+    // 子进程由事件循环回收，此前pid不会被复用，pidfd一定指向pid_ns_init
+    int pidFd = (int)syscall(SYS_pidfd_open, pid, 0);
+    APPSPAWN_CHECK(pidFd >= 0, KillPidNsInit(pid, -1);
+        return -1, "Failed to get pidfd of pid_ns_init errno: %{public}d", errno);
+    namespace->nsInitPidFd = GetNsPidFdByPidFd(pidFd, pid);
+    APPSPAWN_CHECK(namespace->nsInitPidFd >= 0, KillPidNsInit(pid, pidFd);
+        return -1, "open ns pid of pid_ns_init fail");
+    namespace->nsInitPid = pid;
+    namespace->nsInitProcFd = pidFd;
+    namespace->ownerPid = getpid();
+
+    LE_WatchInfo watchInfo = {};
+    watchInfo.fd = pidFd;
+    watchInfo.flags = 0;
+    watchInfo.events = EVENT_READ;
+    watchInfo.processEvent = ProcessPidNsInitExit;
+    LE_STATUS status = LE_StartWatcher(LE_GetDefaultLoop(), &namespace->nsInitWatcher, &watchInfo, NULL);
+    if (status != LE_SUCCESS) {
+        APPSPAWN_LOGW("Failed to watch pid_ns_init %{public}d", pid);
+        namespace->nsInitWatcher = NULL;
+    }
+    APPSPAWN_LOGI("Start pid_ns_init %{public}d success", pid);
+    return 0;
+}
+
+static int EnsurePidNsInit(AppSpawnMgr *content, AppSpawnNamespace *namespace)
+{
+    if (namespace->nsInitPidFd >= 0) {
+        return 0;
+    }
+    struct timespec now = {};
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    if (DiffTime(&namespace->nsInitStartTime, &now) < PID_NS_INIT_RETRY_INTERVAL) {
+        return -1;
+    }
+    int ret = StartPidNsInit(namespace);
+    if (ret != 0) {
+        StopPidNsInit(namespace);
+    }
+    return ret;
+}
+
+static bool IsPidNsHelperEnabled(void)
+{
+    char buffer[32] = {0};  // 32 max
+    int ret = GetParameter("persist.appspawn.pidns.helper.enable", "false", buffer, sizeof(buffer));
+    return ret > 0 && strcmp(buffer, "true") == 0;
+}
+
 APPSPAWN_STATIC int PreLoadEnablePidNs(AppSpawnMgr *content)
 {
     APPSPAWN_LOGI("Enable pid namespace flags: 0x%{public}x", content->content.sandboxNsFlags);
@@ -190,20 +349,6 @@ APPSPAWN_STATIC int PreLoadEnablePidNs(AppSpawnMgr *content)
     APPSPAWN_CHECK(namespace != NULL, return -1, "Failed to create namespace");
 
     int ret = -1;
-    // check if process pid_ns_init exists, this is the init process for pid namespace
-    pid_t pid = GetPidByName("pid_ns_init");
-    if (pid == -1) {
-        APPSPAWN_LOGI("Start Create pid_ns_init %{public}d", pid);
-        pid = clone(NsInitFunc, NULL, CLONE_NEWPID, NULL);
-        if (pid < 0) {
-            APPSPAWN_LOGE("clone pid ns init failed");
-            DeleteAppSpawnNamespace(namespace);
-            return ret;
-        }
-    } else {
-        APPSPAWN_LOGI("pid_ns_init exists, no need to create");
-    }
-
     namespace->nsSelfPidFd = GetNsPidFd(getpid());
     if (namespace->nsSelfPidFd < 0) {
         APPSPAWN_LOGE("open ns pid of appspawn fail");
@@ -211,14 +356,28 @@ APPSPAWN_STATIC int PreLoadEnablePidNs(AppSpawnMgr *content)
         return ret;
     }
 
-    namespace->nsInitPidFd = GetNsPidFd(pid);
-    if (namespace->nsInitPidFd < 0) {
-        APPSPAWN_LOGE("open ns pid of pid_ns_init fail");
-        DeleteAppSpawnNamespace(namespace);
-        return ret;
+    // pid_ns_init is the init process for pid namespace, started and supervised by appspawn
+    ret = StartPidNsInit(namespace);
+    if (ret != 0) {
+        // 启动失败时定时重试，期间的孵化请求失败，不能退回到appspawn的pid namespace
+        StopPidNsInit(namespace);
+        namespace->ownerPid = getpid();
+        StartPidNsInitRetryTimer(namespace);
     }
     OH_ListAddTail(&content->extData, &namespace->extData.node);
-    APPSPAWN_LOGI("Enable pid namespace success.");
+    // 应用统一由forkChild在pid_ns_init的pid namespace中创建，pid_ns_init不可用时孵化失败
+    content->content.forkChild = PidNsForkChild;
+    content->content.forkChildInSelf = 1;
+    if (IsPidNsHelperEnabled()) {
+        // 由pid namespace中的helper进程fork应用，预孵化进程不在该pid namespace中，不再使用
+        namespace->helperEnable = 1;
+        // helper异常退出时，其孵化的应用由appspawn收养，退出状态由SIGCHLD处理，需在fork helper前设置
+        (void)prctl(PR_SET_CHILD_SUBREAPER, 1);
+        content->content.forkChild = NsHelperForkChild;
+        content->content.forkChildInSelf = 0;
+        content->content.enablePerfork = 0;
+    }
+    APPSPAWN_LOGI("Enable pid namespace result: %{public}d helper: %{public}d", ret, namespace->helperEnable);
     return 0;
 }
 
@@ -235,34 +394,569 @@ static int SetPidNamespace(int nsPidFd, int nsType)
     return 0;
 }
 
-APPSPAWN_STATIC int PreForkSetPidNamespace(AppSpawnMgr *content, AppSpawningCtx *property)
+static int NsHelperWriteAll(int fd, const void *data, size_t len)
 {
-    AppSpawnNamespace *namespace = GetAppSpawnNamespace(content);
-    if (namespace == NULL) {
-        return 0;
+    size_t written = 0;
+    while (written < len) {
+        ssize_t ret = send(fd, (const uint8_t *)data + written, len - written, MSG_NOSIGNAL);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        APPSPAWN_CHECK(ret > 0, return -1, "Failed to write helper socket errno: %{public}d", errno);
+        written += (size_t)ret;
+    }
+    return 0;
+}
+
+static int NsHelperReadAll(int fd, void *data, size_t len)
+{
+    size_t readLen = 0;
+    while (readLen < len) {
+        ssize_t ret = recv(fd, (uint8_t *)data + readLen, len - readLen, MSG_WAITALL);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        APPSPAWN_CHECK(ret > 0, return -1, "Failed to read helper socket errno: %{public}d", errno);
+        readLen += (size_t)ret;
     }
-    if (content->content.sandboxNsFlags & CLONE_NEWPID) {
-        SetPidNamespace(namespace->nsInitPidFd, CLONE_NEWPID);  // pid_ns_init is the init process
+    return 0;
+}
+
+static void NsHelperCloseFds(const int *fds, uint32_t fdCount)
+{
+    for (uint32_t i = 0; i < fdCount; i++) {
+        if (fds[i] >= 0) {
+            close(fds[i]);
+        }
     }
+}
+
+static int NsHelperSendWithFds(int fd, const void *data, size_t len, const int *fds, uint32_t fdCount)
+{
+    char ctrl[CMSG_SPACE(sizeof(int) * NS_HELPER_MAX_FD_COUNT)] = {0};
+    struct iovec iov = {(void *)data, len};
+    struct msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * fdCount);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fdCount);
+    int ret = memcpy_s(CMSG_DATA(cmsg), sizeof(int) * NS_HELPER_MAX_FD_COUNT, fds, sizeof(int) * fdCount);
+    APPSPAWN_CHECK(ret == 0, return -1, "Failed to copy fds");
+    ssize_t sendLen = 0;
+    do {
+        sendLen = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    } while (sendLen < 0 && errno == EINTR);
+    APPSPAWN_CHECK(sendLen >= 0, return -1, "Failed to send to helper errno: %{public}d", errno);
+    // 描述符随第一个字节送达，剩余部分按普通数据发送
+    return NsHelperWriteAll(fd, (const uint8_t *)data + sendLen, len - (size_t)sendLen);
+}
+
+static int NsHelperRecvWithFds(int fd, void *data, size_t len, int *fds, uint32_t *fdCount)
+{
+    char ctrl[CMSG_SPACE(sizeof(int) * NS_HELPER_MAX_FD_COUNT)] = {0};
+    struct iovec iov = {data, len};
+    struct msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+    ssize_t recvLen = 0;
+    do {
+        recvLen = recvmsg(fd, &msg, MSG_WAITALL);
+    } while (recvLen < 0 && errno == EINTR);
+    APPSPAWN_CHECK(recvLen > 0, return -1, "Failed to recv from appspawn errno: %{public}d", errno);
+
+    *fdCount = 0;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+        uint32_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        int ret = memcpy_s(fds + *fdCount, sizeof(int) * (NS_HELPER_MAX_FD_COUNT - *fdCount),
+            CMSG_DATA(cmsg), sizeof(int) * count);
+        APPSPAWN_CHECK(ret == 0, NsHelperCloseFds((int *)CMSG_DATA(cmsg), count);
+            return -1, "Too many fds %{public}u", count);
+        *fdCount += count;
+    }
+    APPSPAWN_CHECK((msg.msg_flags & MSG_CTRUNC) == 0, NsHelperCloseFds(fds, *fdCount);
+        return -1, "Fds truncated from appspawn");
+    return NsHelperReadAll(fd, (uint8_t *)data + recvLen, len - (size_t)recvLen);
+}
+
+APPSPAWN_STATIC int NsHelperSendRequest(int fd, const AppSpawningCtx *property)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(property != NULL && property->message != NULL, return APPSPAWN_ARG_INVALID);
+    const AppSpawnMsgNode *message = property->message;
+    int fds[NS_HELPER_MAX_FD_COUNT] = {property->forkCtx.fd[0], property->forkCtx.fd[1]};
+    uint32_t fdCount = NS_HELPER_FORK_FD_COUNT;
+    if (message->connection != NULL) {
+        const AppSpawnMsgReceiverCtx *recvCtx = &message->connection->receiverCtx;
+        for (int i = 0; i < recvCtx->fdCount && i < APP_MAX_FD_COUNT; i++) {
+            fds[fdCount++] = recvCtx->fds[i];
+        }
+    }
+    NsHelperRequest request = {property->client.id, property->client.flags, message->msgHeader.msgLen, fdCount};
+    int ret = NsHelperSendWithFds(fd, &request, sizeof(request), fds, fdCount);
+    APPSPAWN_CHECK(ret == 0, return APPSPAWN_SYSTEM_ERROR, "Failed to send request %{public}u", request.clientId);
+    ret = NsHelperWriteAll(fd, &message->msgHeader, sizeof(AppSpawnMsg));
+    if (ret == 0 && message->msgHeader.msgLen > sizeof(AppSpawnMsg)) {
+        ret = NsHelperWriteAll(fd, message->buffer, message->msgHeader.msgLen - sizeof(AppSpawnMsg));
+    }
+    APPSPAWN_CHECK(ret == 0, return APPSPAWN_SYSTEM_ERROR, "Failed to send msg %{public}u", request.clientId);
     return 0;
 }
 
-APPSPAWN_STATIC int PostForkSetPidNamespace(AppSpawnMgr *content, AppSpawningCtx *property)
+static AppSpawnMsgNode *NsHelperRecvMsg(int fd, uint32_t msgLen)
 {
-    AppSpawnNamespace *namespace = GetAppSpawnNamespace(content);
-    if (namespace == NULL) {
+    APPSPAWN_CHECK(msgLen >= sizeof(AppSpawnMsg) && msgLen < MAX_MSG_TOTAL_LENGTH,
+        return NULL, "Invalid msg len %{public}u", msgLen);
+    uint8_t *buffer = (uint8_t *)malloc(msgLen);
+    APPSPAWN_CHECK(buffer != NULL, return NULL, "Failed to alloc msg buffer %{public}u", msgLen);
+    AppSpawnMsgNode *message = NULL;
+    uint32_t msgRecvLen = 0;
+    uint32_t remainLen = 0;
+    int ret = NsHelperReadAll(fd, buffer, msgLen);
+    if (ret == 0) {
+        ret = GetAppSpawnMsgFromBuffer(buffer, msgLen, &message, &msgRecvLen, &remainLen);
+    }
+    if (ret == 0) {
+        ret = DecodeAppSpawnMsg(message);
+    }
+    free(buffer);
+    if (ret != 0) {
+        DeleteAppSpawnMsg(message);
+        return NULL;
+    }
+    return message;
+}
+
+APPSPAWN_STATIC AppSpawningCtx *NsHelperRecvRequest(int fd)
+{
+    NsHelperRequest request = {};
+    int fds[NS_HELPER_MAX_FD_COUNT] = {0};
+    uint32_t fdCount = 0;
+    int ret = NsHelperRecvWithFds(fd, &request, sizeof(request), fds, &fdCount);
+    APPSPAWN_CHECK(ret == 0, return NULL, "Failed to recv request");
+    AppSpawnMsgNode *message = NsHelperRecvMsg(fd, request.msgLen);
+    AppSpawnConnection *connection = (AppSpawnConnection *)calloc(1, sizeof(AppSpawnConnection));
+    AppSpawningCtx *property = (message != NULL && connection != NULL) ? CreateAppSpawningCtx() : NULL;
+    if (property == NULL || fdCount != request.fdCount || fdCount < NS_HELPER_FORK_FD_COUNT) {
+        APPSPAWN_LOGE("Invalid request %{public}u fd count %{public}u", request.clientId, fdCount);
+        NsHelperCloseFds(fds, fdCount);
+        DeleteAppSpawningCtx(property);
+        DeleteAppSpawnMsg(message);
+        free(connection);
+        return NULL;
+    }
+    property->client.id = request.clientId;
+    property->client.flags = request.clientFlags;
+    property->state = APP_STATE_SPAWNING;
+    property->forkCtx.fd[0] = fds[0];
+    property->forkCtx.fd[1] = fds[1];
+    // 子进程通过连接信息获取应用的fd
+    connection->receiverCtx.fdCount = (int)(fdCount - NS_HELPER_FORK_FD_COUNT);
+    for (int i = 0; i < connection->receiverCtx.fdCount; i++) {
+        connection->receiverCtx.fds[i] = fds[i + NS_HELPER_FORK_FD_COUNT];
+    }
+    message->connection = connection;
+    property->message = message;
+    return property;
+}
+
+APPSPAWN_STATIC void NsHelperFreeRequest(AppSpawningCtx *property)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(property != NULL, return);
+    if (property->message != NULL && property->message->connection != NULL) {
+        AppSpawnConnection *connection = property->message->connection;
+        NsHelperCloseFds(connection->receiverCtx.fds, (uint32_t)connection->receiverCtx.fdCount);
+        free(connection);
+        property->message->connection = NULL;
+    }
+    DeleteAppSpawningCtx(property);
+}
+
+static int NsHelperExitStatus(const siginfo_t *info)
+{
+    const uint32_t exitCodeShift = 8;  // same as W_EXITCODE
+    const uint32_t coreFlag = 0x80;
+    if (info->si_code == CLD_EXITED) {
+        return (int)(((uint32_t)info->si_status & 0xff) << exitCodeShift);  // 0xff exit code mask
+    }
+    uint32_t status = (uint32_t)info->si_status & 0x7f;  // 0x7f signal mask
+    return (int)(info->si_code == CLD_DUMPED ? (status | coreFlag) : status);
+}
+
+static void NsHelperQueueEvent(NsHelperEventQueue *queue, const NsHelperExitEvent *event)
+{
+    if (queue->count >= queue->capacity) {
+        uint32_t capacity = queue->capacity == 0 ? NS_HELPER_EVENT_INIT_NUM : queue->capacity * 2;  // 2 double
+        NsHelperExitEvent *events = (NsHelperExitEvent *)realloc(queue->events, sizeof(NsHelperExitEvent) * capacity);
+        APPSPAWN_CHECK(events != NULL, return, "Failed to queue exit event of %{public}d", event->pid);
+        queue->events = events;
+        queue->capacity = capacity;
+    }
+    queue->events[queue->count++] = *event;
+}
+
+static void NsHelperReapChildren(int sigFd, NsHelperEventQueue *queue)
+{
+    struct signalfd_siginfo siginfo = {};
+    while (read(sigFd, &siginfo, sizeof(siginfo)) == sizeof(siginfo)) {
+    }
+    while (1) {
+        siginfo_t info = {};
+        if (waitid(P_ALL, 0, &info, WEXITED | WNOHANG) != 0 || info.si_pid == 0) {
+            break;
+        }
+        NsHelperExitEvent event = {info.si_pid, info.si_uid, NsHelperExitStatus(&info)};
+        NsHelperQueueEvent(queue, &event);
+    }
+}
+
+static int NsHelperFlushEvents(int eventFd, NsHelperEventQueue *queue)
+{
+    uint32_t sent = 0;
+    while (sent < queue->count) {
+        ssize_t len = send(eventFd, &queue->events[sent], sizeof(NsHelperExitEvent), MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (len == (ssize_t)sizeof(NsHelperExitEvent)) {
+            sent++;
+            continue;
+        }
+        if (len < 0 && (errno == EAGAIN || errno == EINTR)) {
+            break;  // appspawn繁忙，等待可写后继续发送
+        }
+        APPSPAWN_LOGE("Failed to send exit event errno: %{public}d", errno);
+        return -1;
+    }
+    if (sent > 0 && sent < queue->count) {
+        (void)memmove_s(queue->events, sizeof(NsHelperExitEvent) * queue->capacity,
+            queue->events + sent, sizeof(NsHelperExitEvent) * (queue->count - sent));
+    }
+    queue->count -= sent;
+    return 0;
+}
+
+static int NsHelperProcessRequest(AppSpawnMgr *content, int reqFd, int eventFd, int sigFd)
+{
+    AppSpawningCtx *property = NsHelperRecvRequest(reqFd);
+    APPSPAWN_CHECK_ONLY_EXPER(property != NULL, return -1);  // appspawn已退出或消息异常
+    NsHelperReply reply = {property->client.id, 0, 0};
+    reply.pid = fork();
+    if (reply.pid == 0) {
+        (void)close(reqFd);
+        (void)close(eventFd);
+        (void)close(sigFd);
+        ProcessExit(AppSpawnChild(&content->content, &property->client));
+    }
+    reply.result = reply.pid < 0 ? errno : 0;
+    APPSPAWN_LOGI("Helper fork app %{public}u pid %{public}d result %{public}d",
+        property->client.id, reply.pid, reply.result);
+    NsHelperFreeRequest(property);
+    return NsHelperWriteAll(reqFd, &reply, sizeof(reply));
+}
+
+static int NsHelperRun(AppSpawnMgr *content, const AppSpawnNamespace *namespace, int reqFd, int eventFd)
+{
+    (void)prctl(PR_SET_NAME, "pidns_helper");
+    (void)prctl(PR_SET_PDEATHSIG, SIGKILL);
+    // 只修改本进程子进程的pid namespace，helper自身仍在appspawn的pid namespace中
+    int ret = SetPidNamespace(namespace->nsInitPidFd, CLONE_NEWPID);
+    APPSPAWN_CHECK(ret == 0, return -1, "Failed to enter pid namespace of pid_ns_init");
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    (void)sigprocmask(SIG_BLOCK, &mask, NULL);
+    int sigFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    APPSPAWN_CHECK(sigFd >= 0, return -1, "Failed to create signalfd errno: %{public}d", errno);
+
+    NsHelperEventQueue queue = {NULL, 0, 0};
+    while (ret == 0) {
+        struct pollfd pfds[NS_HELPER_POLL_FD_COUNT] = {
+            {reqFd, POLLIN, 0}, {sigFd, POLLIN, 0}, {eventFd, queue.count > 0 ? POLLOUT : 0, 0}
+        };
+        if (poll(pfds, NS_HELPER_POLL_FD_COUNT, -1) < 0) {
+            ret = errno == EINTR ? 0 : -1;
+            continue;
+        }
+        if ((pfds[1].revents & POLLIN) != 0) {
+            NsHelperReapChildren(sigFd, &queue);
+        }
+        if (queue.count > 0) {
+            ret = NsHelperFlushEvents(eventFd, &queue);
+        }
+        if (ret == 0 && pfds[0].revents != 0) {
+            ret = NsHelperProcessRequest(content, reqFd, eventFd, sigFd);
+        }
+    }
+    APPSPAWN_LOGI("Pid namespace helper exit");
+    (void)close(sigFd);
+    free(queue.events);
+    return ret;
+}
+
+static void NsHelperStartTimer(AppSpawnNamespace *namespace);
+
+static int NsHelperAddPending(AppSpawnNamespace *namespace, uint32_t clientId)
+{
+    if (namespace->helperPendingCount >= namespace->helperPendingCapacity) {
+        uint32_t capacity = namespace->helperPendingCapacity == 0 ?
+            NS_HELPER_EVENT_INIT_NUM : namespace->helperPendingCapacity * 2;  // 2 double
+        uint32_t *pending = (uint32_t *)realloc(namespace->helperPending, sizeof(uint32_t) * capacity);
+        APPSPAWN_CHECK(pending != NULL, return -1, "Failed to alloc pending request of pid namespace helper");
+        namespace->helperPending = pending;
+        namespace->helperPendingCapacity = capacity;
+    }
+    namespace->helperPending[namespace->helperPendingCount++] = clientId;
+    if (namespace->helperPendingCount == 1) {
+        NsHelperStartTimer(namespace);
+    }
+    return 0;
+}
+
+static bool NsHelperRemovePending(AppSpawnNamespace *namespace, uint32_t clientId)
+{
+    for (uint32_t i = 0; i < namespace->helperPendingCount; i++) {
+        if (namespace->helperPending[i] != clientId) {
+            continue;
+        }
+        namespace->helperPendingCount--;
+        if (i < namespace->helperPendingCount) {
+            (void)memmove_s(namespace->helperPending + i, sizeof(uint32_t) * (namespace->helperPendingCapacity - i),
+                namespace->helperPending + i + 1, sizeof(uint32_t) * (namespace->helperPendingCount - i));
+        }
+        return true;
+    }
+    return false;
+}
+
+static void NsHelperFailPending(AppSpawnNamespace *namespace, int result)
+{
+    // 先清空队列，上报结果时可能再次进入helper相关流程
+    uint32_t *pending = namespace->helperPending;
+    uint32_t count = namespace->helperPendingCount;
+    namespace->helperPending = NULL;
+    namespace->helperPendingCount = 0;
+    namespace->helperPendingCapacity = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        AppSpawningCtx *property = GetAppSpawningCtxByClientId(pending[i]);
+        if (property != NULL && property->pid == 0) {
+            APPSPAWN_LOGW("Pid namespace helper fail to fork app %{public}u", pending[i]);
+            AppSpawnProcessForkResult(property, 0, result);
+        }
+    }
+    free(pending);
+}
+
+static void NsHelperProcessReply(AppSpawnNamespace *namespace, const NsHelperReply *reply)
+{
+    APPSPAWN_CHECK(NsHelperRemovePending(namespace, reply->clientId), return,
+        "Invalid reply of pid namespace helper %{public}u", reply->clientId);
+    if (namespace->helperPendingCount > 0) {
+        NsHelperStartTimer(namespace);
+    } else {
+        AppSpawnStopTimer(&namespace->helperTimer);
+    }
+    AppSpawningCtx *property = GetAppSpawningCtxByClientId(reply->clientId);
+    if (property == NULL || property->pid != 0) {
+        // 请求已被回收，如连接断开
+        APPSPAWN_LOGW("App %{public}u not spawning, kill pid %{public}d", reply->clientId, reply->pid);
+        if (reply->pid > 0) {
+            (void)kill(reply->pid, SIGKILL);
+        }
+        return;
+    }
+    if (reply->pid <= 0) {
+        APPSPAWN_LOGE("fork child process error: %{public}d", reply->result);
+        AppSpawnProcessForkResult(property, 0, APPSPAWN_FORK_FAIL);
+        return;
+    }
+    AppSpawnProcessForkResult(property, reply->pid, 0);
+}
+
+static int NsHelperRecvReplies(AppSpawnNamespace *namespace, int fd)
+{
+    NsHelperReply reply = {};
+    ssize_t len = 0;
+    while ((len = recv(fd, &reply, sizeof(reply), MSG_DONTWAIT)) == (ssize_t)sizeof(reply)) {
+        NsHelperProcessReply(namespace, &reply);
+    }
+    if (len < 0 && (errno == EAGAIN || errno == EINTR)) {
         return 0;
     }
-    if (content->content.sandboxNsFlags & CLONE_NEWPID) {
-        SetPidNamespace(namespace->nsSelfPidFd, 0);  // go back to original pid namespace
+    APPSPAWN_LOGW("Pid namespace helper %{public}d reply len: %{public}zd errno: %{public}d",
+        namespace->helperPid, len, errno);
+    return -1;
+}
+
+static void NsHelperReplyEvent(const WatcherHandle taskHandle, int fd, uint32_t *events, const void *context)
+{
+    AppSpawnNamespace *namespace = (AppSpawnNamespace *)context;
+    if (NsHelperRecvReplies(namespace, fd) != 0) {
+        NsHelperStop(namespace);
+    }
+}
+
+static void NsHelperReplyTimeout(AppSpawnTimer *timer, void *context)
+{
+    AppSpawnNamespace *namespace = (AppSpawnNamespace *)context;
+    APPSPAWN_LOGE("Wait pid namespace helper %{public}d timeout", namespace->helperPid);
+    if (namespace->helperPid > 0) {
+        (void)kill(namespace->helperPid, SIGKILL);
+    }
+    NsHelperStop(namespace);
+}
+
+static void NsHelperStartTimer(AppSpawnNamespace *namespace)
+{
+    int ret = AppSpawnStartTimer(&namespace->helperTimer, NS_HELPER_REPLY_TIMEOUT, NsHelperReplyTimeout, namespace);
+    APPSPAWN_CHECK_ONLY_LOG(ret == 0, "Failed to start timer of pid namespace helper");
+}
+
+static void NsHelperProcessEvent(const WatcherHandle taskHandle, int fd, uint32_t *events, const void *context)
+{
+    AppSpawnNamespace *namespace = (AppSpawnNamespace *)context;
+    // helper先回复pid再回收子进程，先处理回复，保证退出事件能找到对应的应用
+    if (NsHelperRecvReplies(namespace, namespace->helperReqFd) != 0) {
+        NsHelperStop(namespace);
+        return;
+    }
+    NsHelperExitEvent event = {};
+    ssize_t len = 0;
+    while ((len = recv(fd, &event, sizeof(event), MSG_DONTWAIT)) == (ssize_t)sizeof(event)) {
+        AppSpawnProcessChildExit(event.pid, event.uid, event.status);
+    }
+    if (len == 0 || (len < 0 && errno != EAGAIN && errno != EINTR)) {
+        // helper退出后，下次孵化时重新创建
+        APPSPAWN_LOGW("Pid namespace helper %{public}d exit errno: %{public}d", namespace->helperPid, errno);
+        NsHelperStop(namespace);
+    }
+}
+
+static void NsHelperStop(AppSpawnNamespace *namespace)
+{
+    bool owner = namespace->ownerPid == getpid();
+    if (owner && namespace->helperWatcher != NULL) {
+        LE_RemoveWatcher(LE_GetDefaultLoop(), namespace->helperWatcher);
+    }
+    if (owner && namespace->helperReplyWatcher != NULL) {
+        LE_RemoveWatcher(LE_GetDefaultLoop(), namespace->helperReplyWatcher);
+    }
+    namespace->helperWatcher = NULL;
+    namespace->helperReplyWatcher = NULL;
+    if (namespace->helperReqFd >= 0) {
+        close(namespace->helperReqFd);
+        namespace->helperReqFd = -1;
+    }
+    if (namespace->helperEventFd >= 0) {
+        close(namespace->helperEventFd);
+        namespace->helperEventFd = -1;
+    }
+    namespace->helperPid = 0;
+    if (owner) {
+        AppSpawnStopTimer(&namespace->helperTimer);
+        NsHelperFailPending(namespace, APPSPAWN_FORK_FAIL);
+    }
+}
+
+static int NsHelperStart(AppSpawnMgr *content, AppSpawnNamespace *namespace)
+{
+    int reqFds[2] = {-1, -1};  // 2 socket pair
+    int eventFds[2] = {-1, -1};  // 2 socket pair
+    int ret = socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, reqFds);
+    APPSPAWN_CHECK(ret == 0, return APPSPAWN_SYSTEM_ERROR, "Failed to create helper socket errno: %{public}d", errno);
+    ret = socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, eventFds);
+    APPSPAWN_CHECK(ret == 0, NsHelperCloseFds(reqFds, 2);  // 2 socket pair
+        return APPSPAWN_SYSTEM_ERROR, "Failed to create helper event socket errno: %{public}d", errno);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        (void)close(reqFds[0]);
+        (void)close(eventFds[0]);
+        _exit(NsHelperRun(content, namespace, reqFds[1], eventFds[1]) == 0 ? 0 : 1);
     }
+    (void)close(reqFds[1]);
+    (void)close(eventFds[1]);
+    APPSPAWN_CHECK(pid > 0, close(reqFds[0]);
+        close(eventFds[0]);
+        return APPSPAWN_FORK_FAIL, "Failed to fork pid namespace helper errno: %{public}d", errno);
 
+    namespace->helperPid = pid;
+    namespace->ownerPid = getpid();
+    namespace->helperReqFd = reqFds[0];
+    namespace->helperEventFd = eventFds[0];
+    LE_WatchInfo watchInfo = {};
+    watchInfo.fd = namespace->helperEventFd;
+    watchInfo.flags = 0;
+    watchInfo.events = EVENT_READ;
+    watchInfo.processEvent = NsHelperProcessEvent;
+    LE_STATUS status = LE_StartWatcher(LE_GetDefaultLoop(), &namespace->helperWatcher, &watchInfo, namespace);
+    APPSPAWN_CHECK(status == LE_SUCCESS, NsHelperStop(namespace);
+        return APPSPAWN_SYSTEM_ERROR, "Failed to watch pid namespace helper");
+    watchInfo.fd = namespace->helperReqFd;
+    watchInfo.processEvent = NsHelperReplyEvent;
+    status = LE_StartWatcher(LE_GetDefaultLoop(), &namespace->helperReplyWatcher, &watchInfo, namespace);
+    APPSPAWN_CHECK(status == LE_SUCCESS, NsHelperStop(namespace);
+        return APPSPAWN_SYSTEM_ERROR, "Failed to watch reply of pid namespace helper");
+    APPSPAWN_LOGI("Pid namespace helper %{public}d started", pid);
+    return 0;
+}
+
+static int ForkChildInPidNamespace(AppSpawnContent *content, AppSpawnClient *client,
+    const AppSpawnNamespace *namespace, pid_t *childPid)
+{
+    // 进入pid_ns_init的pid namespace失败时不fork，避免应用运行在appspawn的pid namespace中
+    APPSPAWN_CHECK(namespace->nsInitPidFd >= 0, return APPSPAWN_SYSTEM_ERROR, "pid_ns_init not ready");
+    int ret = SetPidNamespace(namespace->nsInitPidFd, CLONE_NEWPID);
+    APPSPAWN_CHECK(ret == 0, return APPSPAWN_SYSTEM_ERROR, "Failed to enter pid namespace of pid_ns_init");
+    pid_t pid = fork();
+    if (pid == 0) {
+        ProcessExit(AppSpawnChild(content, client));
+    }
+    SetPidNamespace(namespace->nsSelfPidFd, 0);  // go back to original pid namespace
+    APPSPAWN_CHECK(pid > 0, return APPSPAWN_FORK_FAIL, "fork child process error: %{public}d", errno);
+    *childPid = pid;
+    return 0;
+}
+
+APPSPAWN_STATIC int PidNsForkChild(AppSpawnContent *content, AppSpawnClient *client, pid_t *childPid)
+{
+    AppSpawnNamespace *namespace = GetAppSpawnNamespace((AppSpawnMgr *)content);
+    APPSPAWN_CHECK(namespace != NULL, return APPSPAWN_SYSTEM_ERROR, "Invalid pid namespace");
+    APPSPAWN_CHECK(EnsurePidNsInit((AppSpawnMgr *)content, namespace) == 0, return APPSPAWN_SYSTEM_ERROR,
+        "pid_ns_init not ready, fail to spawn app %{public}u", client->id);
+    return ForkChildInPidNamespace(content, client, namespace, childPid);
+}
+
+APPSPAWN_STATIC int NsHelperForkChild(AppSpawnContent *content, AppSpawnClient *client, pid_t *childPid)
+{
+    AppSpawnNamespace *namespace = GetAppSpawnNamespace((AppSpawnMgr *)content);
+    APPSPAWN_CHECK(namespace != NULL, return APPSPAWN_SYSTEM_ERROR, "Invalid pid namespace");
+    APPSPAWN_CHECK(EnsurePidNsInit((AppSpawnMgr *)content, namespace) == 0, return APPSPAWN_SYSTEM_ERROR,
+        "pid_ns_init not ready, fail to spawn app %{public}u", client->id);
+    if (namespace->helperPid <= 0 && NsHelperStart((AppSpawnMgr *)content, namespace) != 0) {
+        return ForkChildInPidNamespace(content, client, namespace, childPid);
+    }
+    if (NsHelperAddPending(namespace, client->id) != 0) {
+        return ForkChildInPidNamespace(content, client, namespace, childPid);
+    }
+    int ret = NsHelperSendRequest(namespace->helperReqFd, (AppSpawningCtx *)client);
+    if (ret != 0) {
+        // helper异常退出，请求未送达，本次在appspawn中fork
+        (void)NsHelperRemovePending(namespace, client->id);
+        NsHelperStop(namespace);
+        return ForkChildInPidNamespace(content, client, namespace, childPid);
+    }
+    // 不等待helper回复，pid为0表示子进程pid由NsHelperProcessReply异步上报
+    *childPid = 0;
     return 0;
 }
 
 MODULE_CONSTRUCTOR(void)
 {
     AddPreloadHook(HOOK_PRIO_LOWEST, PreLoadEnablePidNs);
-    AddAppSpawnHook(STAGE_PARENT_PRE_FORK, HOOK_PRIO_LOWEST, PreForkSetPidNamespace);
-    AddAppSpawnHook(STAGE_PARENT_POST_FORK, HOOK_PRIO_HIGHEST, PostForkSetPidNamespace);
 }
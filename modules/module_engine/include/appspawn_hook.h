@@ -15,6 +15,7 @@
 
 #ifndef APPSPAWN_HOOK_H
 #define APPSPAWN_HOOK_H
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -41,6 +42,9 @@ typedef enum {
     EXT_DATA_SANDBOX,
     EXT_DATA_NAMESPACE,
     EXT_DATA_ISOLATED_SANDBOX,
+    EXT_DATA_NS_CACHE,
+    EXT_DATA_PRELOAD_REPORT,
+    EXT_DATA_PRELOAD_USAGE,
 } ExtDataType;
 
 struct TagAppSpawnExtData;
@@ -65,6 +69,7 @@ typedef enum TagAppSpawnHookStage {
     STAGE_PARENT_POST_FORK = 21,
     STAGE_PARENT_PRE_RELY = 22,
     STAGE_PARENT_POST_RELY = 23,
+    STAGE_PARENT_CHECK_DEFER = 24,  // 孵化前检查，返回APPSPAWN_SPAWN_DEFERRED时延后孵化
 
     // run in child process
     STAGE_CHILD_PRE_COLDBOOT = 30, // clear env, set token before cold boot
@@ -202,6 +207,58 @@ typedef int (*ProcessExpandSandboxCfg)(const SandboxContext *context,
  */
 int RegisterExpandSandboxCfgHandler(const char *name, int prio, ProcessExpandSandboxCfg handleExpandCfg);
 
+/**
+ * @brief 后台任务处理函数，在appspawn常驻的工作线程中逐个执行，与appspawn共享挂载命名空间
+ *
+ * @param data 任务数据
+ * @return int 0表示成功，非0在完成函数中统一为APPSPAWN_SYSTEM_ERROR
+ */
+typedef int (*AppSpawnWorkProcess)(void *data);
+
+/**
+ * @brief 后台任务完成函数，在事件循环中执行，负责释放任务数据
+ *
+ * @param data 任务数据
+ * @param result 处理函数的结果
+ */
+typedef void (*AppSpawnWorkComplete)(void *data, int result);
+
+/**
+ * @brief 提交后台任务，避免耗时操作阻塞孵化
+ *   相同key的任务尚未开始执行时，由新任务取代已有任务，按新任务的数据执行一次，所有任务的完成函数都会调用
+ *   无法创建工作线程时同步执行
+ *
+ * @param key 任务标识
+ * @param process 处理函数
+ * @param complete 完成函数，可以为NULL
+ * @param data 任务数据
+ * @return int 返回0时完成函数一定会被调用，否则不会调用，由调用者释放任务数据
+ */
+int AppSpawnPostWork(const char *key, AppSpawnWorkProcess process, AppSpawnWorkComplete complete, void *data);
+
+/**
+ * @brief 提交处理指定路径的后台任务，排在其他后台任务之前执行
+ *   任务完成前，使用这些路径的孵化请求由STAGE_PARENT_CHECK_DEFER阶段检查后延后处理，不阻塞事件循环
+ *
+ * @param key 任务标识
+ * @param paths 任务处理的路径，复制到任务中
+ * @param count 路径个数
+ * @param process 处理函数
+ * @param complete 完成函数，可以为NULL
+ * @param data 任务数据
+ * @return int 同AppSpawnPostWork
+ */
+int AppSpawnPostPathWork(const char *key, const char *const *paths, uint32_t count,
+    AppSpawnWorkProcess process, AppSpawnWorkComplete complete, void *data);
+
+/**
+ * @brief 路径是否与未完成的路径任务重叠，即相同或者一个是另一个的父目录
+ *
+ * @param path 路径
+ * @return bool
+ */
+bool AppSpawnIsPathBusy(const char *path);
+
 #ifndef MODULE_DESTRUCTOR
 #define MODULE_CONSTRUCTOR(void) static void _init(void) __attribute__((constructor)); static void _init(void)
 #define MODULE_DESTRUCTOR(void) static void _destroy(void) __attribute__((destructor)); static void _destroy(void)
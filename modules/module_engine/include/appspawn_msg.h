@@ -118,6 +118,32 @@ typedef struct {
     char bundleName[0];  // process name
 } AppSpawnMsgBundleInfo;
 
+/**
+ * @brief HspList/DataGroup/Overlay 扩展信息的二进制编码
+ *
+ * 头部之后为 count 个记录，字符串字段编码为 uint16_t 长度 + 内容 + '\0'，数值字段为 uint32_t，
+ * 均为主机字节序且不做对齐；记录字段顺序：
+ *   HspList:   bundleName, moduleName, version
+ *   DataGroup: dataGroupId, gid, dir
+ *   Overlay:   hapPath
+ * 服务端根据 magic 区分二进制与JSON格式
+ */
+#define APPSPAWN_EXT_LIST_MAGIC 0x4C545845  // "EXTL"
+#define APPSPAWN_EXT_LIST_VERSION 1
+
+typedef enum {
+    EXT_LIST_HSP = 1,
+    EXT_LIST_DATA_GROUP,
+    EXT_LIST_OVERLAY,
+} AppSpawnExtListType;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t listType;
+    uint32_t count;
+} AppSpawnExtListHeader;
+
 typedef struct TagAppSpawnMsg {
     uint32_t magic;
     uint32_t msgType;
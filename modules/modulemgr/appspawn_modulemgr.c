@@ -15,11 +15,14 @@
 
 #include "appspawn_modulemgr.h"
 
+#include <dirent.h>
+
 #include "appspawn_hook.h"
 #include "appspawn_manager.h"
 #include "appspawn_utils.h"
 #include "hookmgr.h"
 #include "modulemgr.h"
+#include "securec.h"
 
 typedef struct {
     const AppSpawnContent *content;
@@ -38,6 +41,12 @@ static struct {
     {NULL, MODULE_NATIVESPAWN, "appspawn/nativespawn"},
 };
 static HOOK_MGR *g_appspawnHookMgr = NULL;
+#define MODULE_LIB_PREFIX "lib"
+#define MODULE_LIB_SUFFIX ".z.so"
+// 冷启动进程不安装只在服务端使用的模块，common目录下其他模块全部安装
+static const char *g_coldRunSkipModules[] = {
+    "event_reporter",
+};
 
 int AppSpawnModuleMgrInstall(const char *moduleName)
 {
@@ -87,6 +96,56 @@ int AppSpawnLoadAutoRunModules(int type)
 #endif
 }
 
+APPSPAWN_STATIC int GetColdRunModuleName(const char *fileName, char *name, uint32_t size)
+{
+    size_t prefixLen = strlen(MODULE_LIB_PREFIX);
+    size_t suffixLen = strlen(MODULE_LIB_SUFFIX);
+    size_t len = strlen(fileName);
+    if (len <= prefixLen + suffixLen || strncmp(fileName, MODULE_LIB_PREFIX, prefixLen) != 0 ||
+        strcmp(fileName + len - suffixLen, MODULE_LIB_SUFFIX) != 0) {
+        return -1;
+    }
+    int ret = strncpy_s(name, size, fileName + prefixLen, len - prefixLen - suffixLen);
+    APPSPAWN_CHECK(ret == EOK, return -1, "Invalid module file %{public}s", fileName);
+    for (size_t i = 0; i < ARRAY_LENGTH(g_coldRunSkipModules); i++) {
+        if (strcmp(name, g_coldRunSkipModules[i]) == 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int AppSpawnLoadColdRunModules(int type)
+{
+    if (type != MODULE_COMMON) {
+        return AppSpawnLoadAutoRunModules(type);
+    }
+    if (g_moduleMgr[type].moduleMgr != NULL) {
+        return 0;
+    }
+    APPSPAWN_LOGI("AppSpawnLoadColdRunModules: %{public}d moduleName: %{public}s", type, g_moduleMgr[type].moduleName);
+#ifndef APPSPAWN_TEST
+    g_moduleMgr[type].moduleMgr = ModuleMgrCreate(g_moduleMgr[type].moduleName);
+    APPSPAWN_CHECK(g_moduleMgr[type].moduleMgr != NULL, return -1, "Failed to create module mgr");
+    DIR *dir = opendir(COMMON_MODULE_PATH);
+    APPSPAWN_CHECK(dir != NULL, return -1, "Failed to open %{public}s errno: %{public}d", COMMON_MODULE_PATH, errno);
+    struct dirent *entry = NULL;
+    while ((entry = readdir(dir)) != NULL) {
+        char name[PATH_MAX] = {0};
+        char path[PATH_MAX] = {0};
+        if (entry->d_type != DT_REG || GetColdRunModuleName(entry->d_name, name, sizeof(name)) != 0) {
+            continue;
+        }
+        int len = sprintf_s(path, sizeof(path), "%s/" MODULE_LIB_PREFIX "%s", COMMON_MODULE_PATH, name);
+        APPSPAWN_CHECK(len > 0, continue, "Failed to format module %{public}s", name);
+        int ret = ModuleMgrInstall(g_moduleMgr[type].moduleMgr, path, 0, NULL);
+        APPSPAWN_CHECK_ONLY_LOG(ret == 0, "Failed to install module %{public}s", name);
+    }
+    closedir(dir);
+#endif
+    return 0;
+}
+
 HOOK_MGR *GetAppSpawnHookMgr(void)
 {
     if (g_appspawnHookMgr != NULL) {
@@ -185,11 +244,33 @@ static void PreAppSpawnHookExec(const HOOK_INFO *hookInfo, void *executionContex
     APPSPAWN_LOGV("Hook stage: %{public}d prio: %{public}d start", hookInfo->stage, hookInfo->prio);
 }
 
+APPSPAWN_STATIC void AddSpawnTimelineItem(AppSpawnTimeline *timeline, int stage, int prio,
+    const struct timespec *start, const struct timespec *end)
+{
+    if (timeline->count == 0) {
+        timeline->base = *start;
+    }
+    if (timeline->count >= APP_SPAWN_TIMELINE_MAX) {
+        return;
+    }
+    AppSpawnTimelineItem *item = &timeline->items[timeline->count++];
+    item->stage = (uint16_t)stage;
+    item->prio = (uint16_t)prio;
+    item->start = (uint32_t)DiffTime(&timeline->base, start);
+    item->end = (uint32_t)DiffTime(&timeline->base, end);
+}
+
 static void PostAppSpawnHookExec(const HOOK_INFO *hookInfo, void *executionContext, int executionRetVal)
 {
     AppSpawnHookArg *arg = (AppSpawnHookArg *)executionContext;
     clock_gettime(CLOCK_MONOTONIC, &arg->tmEnd);
     uint64_t diff = DiffTime(&arg->tmStart, &arg->tmEnd);
+    if (hookInfo->stage >= STAGE_CHILD_PRE_COLDBOOT) {
+        // 子进程记录每个hook的起止时间，随结果回复给父进程
+        AppSpawningCtx *property = (AppSpawningCtx *)arg->client;
+        AddSpawnTimelineItem(&property->forkCtx.timeline, hookInfo->stage, hookInfo->prio,
+            &arg->tmStart, &arg->tmEnd);
+    }
     APPSPAWN_LOGV("Hook stage: %{public}d prio: %{public}d end time %{public}" PRId64 " ns result: %{public}d",
         hookInfo->stage, hookInfo->prio, diff, executionRetVal);
 }
@@ -31,8 +31,10 @@ extern "C" {
 #define HOOK_STOP_WHEN_ERROR 0x2
 #if defined(__aarch64__) || defined(__x86_64__)
 #define ASAN_MODULE_PATH "/system/lib64/appspawn/libappspawn_asan"
+#define COMMON_MODULE_PATH "/system/lib64/appspawn/common"
 #else
 #define ASAN_MODULE_PATH "/system/lib/appspawn/libappspawn_asan"
+#define COMMON_MODULE_PATH "/system/lib/appspawn/common"
 #endif
 
 typedef enum {
@@ -53,6 +55,7 @@ typedef struct {
 
 int AppSpawnModuleMgrInstall(const char *moduleName);
 int AppSpawnLoadAutoRunModules(int type);
+int AppSpawnLoadColdRunModules(int type);
 void AppSpawnModuleMgrUnInstall(int type);
 void DeleteAppSpawnHookMgr(void);
 int ServerStageHookExecute(AppSpawnHookStage stage, AppSpawnContent *content);
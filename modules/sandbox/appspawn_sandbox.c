@@ -38,6 +38,7 @@
 
 #define USER_ID_SIZE 16
 #define DIR_MODE     0711
+#define SANDBOX_UNMOUNT_KEY_SEPARATOR "|"  // 卸载任务key: 沙盒根目录|配置段名
 
 static inline void SetMountPathOperation(uint32_t *operation, uint32_t index)
 {
@@ -90,6 +91,15 @@ int SandboxMountPath(const MountArg *arg)
         arg->fsType, arg->mountSharedFlag == MS_SHARED ? "MS_SHARED" : "MS_SLAVE",
         (uint32_t)arg->mountFlags, arg->options, arg->originPath, arg->destinationPath);
 
+    bool inherited = IsSandboxMountPropagationInherited(arg);
+    // 递归bind且带挂载属性时使用 open_tree/mount_setattr/move_mount，整棵树的属性一次设置
+    if (!inherited && IsSandboxMountApiPreferred(arg) && SandboxBindMountByApi(arg) == 0) {
+        if ((arg->mountSharedFlag & MS_SHARED) == MS_SHARED) {
+            SandboxMountBatchAddShared(arg->destinationPath);
+        }
+        return 0;
+    }
+
     int ret = mount(arg->originPath, arg->destinationPath, arg->fsType, arg->mountFlags, arg->options);
     if (ret != 0) {
         if (arg->originPath != NULL && strstr(arg->originPath, "/data/app/el2/") != NULL) {
@@ -99,12 +109,19 @@ int SandboxMountPath(const MountArg *arg)
             errno, arg->originPath, arg->destinationPath);
         return errno;
     }
+    // 沙盒根已递归设置为slave时，bind出来的挂载点直接继承传播属性
+    if (inherited) {
+        return 0;
+    }
     ret = mount(NULL, arg->destinationPath, NULL, arg->mountSharedFlag, NULL);
     if (ret != 0) {
         APPSPAWN_LOGW("errno is: %{public}d, bind mount %{public}s => %{public}s",
             errno, arg->originPath, arg->destinationPath);
         return errno;
     }
+    if ((arg->mountSharedFlag & MS_SHARED) == MS_SHARED) {
+        SandboxMountBatchAddShared(arg->destinationPath);
+    }
     return 0;
 }
 
@@ -860,9 +877,10 @@ static int SandboxRootFolderCreateNoShare(
     const SandboxContext *context, const AppSpawnSandboxCfg *sandbox, bool remountProc)
 {
     APPSPAWN_LOGV("SandboxRootFolderCreateNoShare %{public}s ", context->rootPath);
-    int ret = mount(NULL, "/", NULL, MS_REC | MS_SLAVE, NULL);
+    int ret = SandboxSetSubtreeAttr("/", 0, MS_SLAVE);
     APPSPAWN_CHECK(ret == 0, return ret,
-        "set propagation slave failed, app: %{public}s errno: %{public}d", context->rootPath, errno);
+        "set propagation slave failed, app: %{public}s errno: %{public}d", context->rootPath, ret);
+    SandboxMountBatchBegin(context->rootPath, MS_SLAVE);
 
     MountArg arg = {context->rootPath, context->rootPath, NULL, BASIC_MOUNT_FLAGS, NULL, MS_SLAVE};
     ret = SandboxMountPath(&arg);
@@ -878,14 +896,15 @@ static int SandboxRootFolderCreate(const SandboxContext *context, const AppSpawn
 
     int ret = 0;
     if (sandbox->topSandboxSwitch == 0 || context->sandboxSwitch == 0) {
-        ret = mount(NULL, "/", NULL, MS_REC | MS_SLAVE, NULL);
+        ret = SandboxSetSubtreeAttr("/", 0, MS_SLAVE);
         APPSPAWN_CHECK(ret == 0, return ret,
-            "set propagation slave failed, app: %{public}s errno: %{public}d", context->rootPath, errno);
+            "set propagation slave failed, app: %{public}s errno: %{public}d", context->rootPath, ret);
         // bind mount "/" to /mnt/sandbox/<packageName> path
         // rootfs: to do more resources bind mount here to get more strict resources constraints
         ret = mount("/", context->rootPath, NULL, BASIC_MOUNT_FLAGS, NULL);
         APPSPAWN_CHECK(ret == 0, return ret,
             "mount bind / failed, app: %{public}s errno: %{public}d", context->rootPath, errno);
+        SandboxMountBatchBegin(context->rootPath, MS_SLAVE);
     } else if (!context->sandboxShared) {
         bool remountProc = !context->nwebspawn && ((sandbox->sandboxNsFlags & CLONE_NEWPID) == CLONE_NEWPID);
         ret = SandboxRootFolderCreateNoShare(context, sandbox, remountProc);
@@ -895,44 +914,147 @@ static int SandboxRootFolderCreate(const SandboxContext *context, const AppSpawn
 
 static bool IsSandboxMounted(const AppSpawnSandboxCfg *sandbox, const char *name, const char *rootPath)
 {
-    char path[PATH_MAX] = {};
-    int len = sprintf_s(path, sizeof(path), "%s%s", rootPath, SANDBOX_STAMP_FILE_SUFFIX);
-    APPSPAWN_CHECK(len > 0, return false, "Failed to format path");
-
-    FILE *f = fopen(path, "rb");
-    if (f != NULL) {
-        fclose(f);
-#ifndef APPSPAWN_TEST
-        return true;
-#endif
+    // 以配置段第一个挂载点作为启动时判断是否已挂载的依据
+    const char *target = NULL;
+    SandboxMountNode *node = GetFirstSandboxMountNode(GetSandboxSection(&sandbox->requiredQueue, name));
+    if (node != NULL && (node->type == SANDBOX_TAG_MOUNT_PATH || node->type == SANDBOX_TAG_MOUNT_FILE)) {
+        target = ((PathMountNode *)node)->target;
     }
+    bool mounted = IsSandboxPathMounted(name, rootPath, target);
+#ifndef APPSPAWN_TEST
+    return mounted;
+#else
     return false;
+#endif
 }
 
 static int SetSandboxMounted(const AppSpawnSandboxCfg *sandbox, const char *name, char *rootPath)
 {
     APPSPAWN_LOGW("SetSystemConstMounted %{public}s ", rootPath);
-    char path[PATH_MAX] = {};
-    int len = sprintf_s(path, sizeof(path), "%s%s", rootPath, SANDBOX_STAMP_FILE_SUFFIX);
-    APPSPAWN_CHECK(len > 0, return 0, "Failed to format path");
+    SetSandboxPathMounted(name, rootPath, true);
+    return 0;
+}
+
+typedef struct {
+    char *rootPath;  // 非NULL时优先整体分离沙盒根目录
+    uint32_t count;
+    uint32_t capacity;
+    char *paths[0];
+} SandboxUnmountWork;
+
+static SandboxUnmountWork *CreateSandboxUnmountWork(uint32_t capacity)
+{
+    SandboxUnmountWork *work = (SandboxUnmountWork *)calloc(1, sizeof(SandboxUnmountWork) + sizeof(char *) * capacity);
+    APPSPAWN_CHECK(work != NULL, return NULL, "Failed to create unmount work");
+    work->capacity = capacity;
+    return work;
+}
+
+static void FreeSandboxUnmountWork(void *data, int result)
+{
+    SandboxUnmountWork *work = (SandboxUnmountWork *)data;
+    APPSPAWN_LOGV("Unmount sandbox paths count %{public}u result %{public}d", work->count, result);
+    for (uint32_t i = 0; i < work->count; i++) {
+        free(work->paths[i]);
+    }
+    free(work->rootPath);
+    free(work);
+}
+
+static void AddUnmountPath(SandboxUnmountWork *work, const char *rootPath, const SandboxMountNode *sandboxNode)
+{
+    if (sandboxNode->type != SANDBOX_TAG_MOUNT_PATH || work->count >= work->capacity) {
+        return;
+    }
+    PathMountNode *pathNode = (PathMountNode *)sandboxNode;
+    APPSPAWN_CHECK_ONLY_EXPER(pathNode->target != NULL, return);
+    size_t len = strlen(rootPath) + strlen(pathNode->target) + 1;
+    char *path = (char *)malloc(len);
+    APPSPAWN_CHECK(path != NULL, return, "Failed to alloc unmount path");
+    int ret = sprintf_s(path, len, "%s%s", rootPath, pathNode->target);
+    APPSPAWN_CHECK(ret > 0, free(path);
+        return, "Failed to format unmount path");
+    work->paths[work->count++] = path;
+}
 
-    FILE *f = fopen(path, "wb");
-    if (f != NULL) {
-        fclose(f);
+static int ComparePath(const void *path1, const void *path2)
+{
+    return strcmp(*(const char **)path1, *(const char **)path2);
+}
+
+static bool IsUnderDetachedPath(char *const *detached, uint32_t count, const char *path)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        size_t len = strlen(detached[i]);
+        if (strncmp(path, detached[i], len) == 0 && path[len] == '/') {
+            return true;
+        }
     }
+    return false;
+}
+
+APPSPAWN_STATIC int ProcessSandboxUnmountWork(void *data)
+{
+    SandboxUnmountWork *work = (SandboxUnmountWork *)data;
+    // 沙盒根目录上只剩当前配置段时，一次分离整个根目录
+    if (work->rootPath != NULL && umount2(work->rootPath, MNT_DETACH) == 0) {
+        APPSPAWN_LOGI("Unmount sandbox root %{public}s", work->rootPath);
+        return 0;
+    }
+    /*
+     * MNT_DETACH 会同时卸载挂载点下的所有子挂载，按路径排序后父目录在前，
+     * 已卸载目录下的路径不需要再单独卸载；已卸载的路径依次交换到数组前部
+     */
+    qsort(work->paths, work->count, sizeof(char *), ComparePath);
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < work->count; i++) {
+        if (IsUnderDetachedPath(work->paths, count, work->paths[i])) {
+            continue;
+        }
+        APPSPAWN_LOGV("Unmount sandbox config sandbox path %{public}s ", work->paths[i]);
+        int ret = umount2(work->paths[i], MNT_DETACH);
+        if (ret != 0) {
+            APPSPAWN_LOGV("Failed to umount2 %{public}s errno: %{public}d", work->paths[i], errno);
+            continue;
+        }
+        char *detached = work->paths[i];
+        work->paths[i] = work->paths[count];
+        work->paths[count++] = detached;
+    }
+    APPSPAWN_LOGI("Unmount sandbox paths %{public}u/%{public}u", count, work->count);
     return 0;
 }
 
-static void UnmountPath(char *rootPath, uint32_t len, const SandboxMountNode *sandboxNode)
+static int PostSandboxUnmountWork(const char *rootPath, const char *name, SandboxUnmountWork *work)
 {
-    if (sandboxNode->type == SANDBOX_TAG_MOUNT_PATH) {
-        PathMountNode *pathNode = (PathMountNode *)sandboxNode;
-        int ret = strcat_s(rootPath, len, pathNode->target);
-        APPSPAWN_CHECK(ret == 0, return, "Failed to format");
-        APPSPAWN_LOGV("Unmount sandbox config sandbox path %{public}s ", rootPath);
-        ret = umount2(rootPath, MNT_DETACH);
-        APPSPAWN_CHECK_ONLY_LOG(ret == 0, "Failed to umount2 %{public}s errno: %{public}d", rootPath, errno);
+    if (work->count == 0) {
+        FreeSandboxUnmountWork(work, 0);
+        return 0;
     }
+    char key[PATH_MAX] = {};
+    int ret = sprintf_s(key, sizeof(key), "%s" SANDBOX_UNMOUNT_KEY_SEPARATOR "%s", rootPath, name);
+    APPSPAWN_CHECK(ret > 0, FreeSandboxUnmountWork(work, -1);
+        return -1, "Failed to format unmount key");
+    // 卸载完成前使用这些路径的孵化请求延后处理，避免挂载被后台卸载掉；整体分离时占用沙盒根目录
+    const char *const *paths = (const char *const *)work->paths;
+    uint32_t count = work->count;
+    if (work->rootPath != NULL) {
+        paths = (const char *const *)&work->rootPath;
+        count = 1;
+    }
+    ret = AppSpawnPostPathWork(key, paths, count, ProcessSandboxUnmountWork, FreeSandboxUnmountWork, work);
+    APPSPAWN_CHECK(ret == 0, FreeSandboxUnmountWork(work, ret);
+        return ret, "Failed to post unmount work %{public}s", key);
+    return 0;
+}
+
+bool IsSandboxRootBusy(const AppSpawnSandboxCfg *sandbox, uid_t uid)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(sandbox != NULL, return false);
+    char path[PATH_MAX] = {};
+    int ret = BuildRootPath(path, sizeof(path), sandbox, uid / UID_BASE);
+    APPSPAWN_CHECK_ONLY_EXPER(ret == 0, return false);
+    return AppSpawnIsPathBusy(path);
 }
 
 int UnmountDepPaths(const AppSpawnSandboxCfg *sandbox, uid_t uid)
@@ -942,17 +1064,17 @@ int UnmountDepPaths(const AppSpawnSandboxCfg *sandbox, uid_t uid)
     char path[PATH_MAX] = {};
     int ret = BuildRootPath(path, sizeof(path), sandbox, uid / UID_BASE);
     APPSPAWN_CHECK_ONLY_EXPER(ret == 0, return -1);
-    uint32_t rootLen = strlen(path);
+    SandboxUnmountWork *work = CreateSandboxUnmountWork(sandbox->depNodeCount);
+    APPSPAWN_CHECK_ONLY_EXPER(work != NULL, return -1);
     for (uint32_t i = 0; i < sandbox->depNodeCount; i++) {
         SandboxNameGroupNode *groupNode = sandbox->depGroupNodes[i];
         if (groupNode == NULL || groupNode->depNode == NULL) {
             continue;
         }
         // unmount this deps
-        UnmountPath(path, sizeof(path), &groupNode->depNode->sandboxNode);
-        path[rootLen] = '\0';
+        AddUnmountPath(work, path, &groupNode->depNode->sandboxNode);
     }
-    return 0;
+    return PostSandboxUnmountWork(path, "mount-paths-deps", work);
 }
 
 int UnmountSandboxConfigs(const AppSpawnSandboxCfg *sandbox, uid_t uid, const char *name)
@@ -962,7 +1084,6 @@ int UnmountSandboxConfigs(const AppSpawnSandboxCfg *sandbox, uid_t uid, const ch
     char path[PATH_MAX] = {};
     int ret = BuildRootPath(path, sizeof(path), sandbox, uid / UID_BASE);
     APPSPAWN_CHECK_ONLY_EXPER(ret == 0, return -1);
-    uint32_t rootLen = strlen(path);
     APPSPAWN_LOGI("Unmount sandbox %{public}s root: %{public}s", name, path);
 
     if (!IsSandboxMounted(sandbox, name, path)) {
@@ -973,21 +1094,34 @@ int UnmountSandboxConfigs(const AppSpawnSandboxCfg *sandbox, uid_t uid, const ch
     if (section == NULL) {
         return 0;
     }
+    uint32_t count = 0;
     ListNode *node = section->front.next;
+    while (node != &section->front) {
+        count++;
+        node = node->next;
+    }
+    SandboxUnmountWork *work = CreateSandboxUnmountWork(count);
+    APPSPAWN_CHECK_ONLY_EXPER(work != NULL, return -1);
+    node = section->front.next;
     while (node != &section->front) {
         SandboxMountNode *sandboxNode = (SandboxMountNode *)ListEntry(node, SandboxMountNode, node);
-        UnmountPath(path, sizeof(path), sandboxNode);
-        path[rootLen] = '\0';
+        AddUnmountPath(work, path, sandboxNode);
         // get next
         node = node->next;
     }
 
-    // delete stamp file
-    ret = strcat_s(path, sizeof(path), SANDBOX_STAMP_FILE_SUFFIX);
-    APPSPAWN_CHECK_ONLY_EXPER(ret == 0, return 0);
+    // 卸载在工作线程中完成，使用这些路径的孵化在卸载完成前延后处理，这里直接更新挂载状态
     APPSPAWN_LOGI("Unmount sandbox %{public}s ", path);
-    unlink(path);
-    return 0;
+    SetSandboxPathMounted(name, path, false);
+    if (IsSandboxRootDetachable(path)) {
+        work->rootPath = strdup(path);
+    }
+    // 已缓存的沙盒命名空间中仍是卸载前的挂载，需要失效
+    AppSpawnMgr *content = GetAppSpawnMgr();
+    if (content != NULL) {
+        content->sandboxGeneration++;
+    }
+    return PostSandboxUnmountWork(path, name, work);
 }
 
 // Check whether the process incubation contains the ohos.permission.ACCESS_DLP_FILE permission
@@ -1283,6 +1417,46 @@ int StagedMountPostUnshare(const SandboxContext *context, const AppSpawnSandboxC
     return ret;
 }
 
+static int JoinCachedSandboxNs(const SandboxContext *context, int nsFd, uint64_t mountDigest, bool *joined)
+{
+    *joined = false;
+    int selfFd = open("/proc/self/ns/mnt", O_RDONLY | O_CLOEXEC);
+    APPSPAWN_CHECK(selfFd >= 0, return 0,
+        "Failed to open self ns, app: %{public}s errno: %{public}d", context->bundleName, errno);
+    int ret = setns(nsFd, CLONE_NEWNS);
+    APPSPAWN_CHECK(ret == 0, close(selfFd);
+        return 0, "setns failed, app: %{public}s errno: %{public}d", context->bundleName, errno);
+    // 缓存后命名空间中的挂载有变化时，先回到原命名空间再重新创建沙盒
+    uint64_t digest = 0;
+    uint32_t count = GetSandboxNsMountInfo(0, &digest);
+    if (count == 0 || digest != mountDigest) {
+        APPSPAWN_LOGW("Cached sandbox changed, app: %{public}s mount: %{public}u", context->bundleName, count);
+        ret = setns(selfFd, CLONE_NEWNS);
+        close(selfFd);
+        APPSPAWN_CHECK(ret == 0, return APPSPAWN_SANDBOX_MOUNT_FAIL,
+            "setns back failed, app: %{public}s errno: %{public}d", context->bundleName, errno);
+        return 0;
+    }
+    close(selfFd);
+    *joined = true;
+    return 0;
+}
+
+static int EnterCachedSandboxNs(const SandboxContext *context)
+{
+    int ret = 0;
+    uint32_t nsFlags = context->sandboxNsFlags & ~CLONE_NEWNS;
+    if (nsFlags != 0) {
+        ret = unshare(nsFlags);
+        APPSPAWN_CHECK(ret == 0, return errno,
+            "unshare failed, app: %{public}s errno: %{public}d", context->bundleName, errno);
+    }
+    if ((nsFlags & CLONE_NEWNET) == CLONE_NEWNET) {
+        ret = EnableNewNetNamespace();
+    }
+    return ret;
+}
+
 int MountSandboxConfigs(AppSpawnSandboxCfg *sandbox, const AppSpawningCtx *property, int nwebspawn)
 {
     APPSPAWN_CHECK_ONLY_EXPER(property != NULL, return -1);
@@ -1295,10 +1469,24 @@ int MountSandboxConfigs(AppSpawnSandboxCfg *sandbox, const AppSpawningCtx *prope
 
     APPSPAWN_LOGV("Set sandbox config %{public}s sandboxNsFlags 0x%{public}x",
         context->rootPath, context->sandboxNsFlags);
+    // chroot 方式的共享沙盒无法通过setns恢复根目录
+    uint64_t mountDigest = 0;
+    int nsFd = context->sandboxShared ? -1 : GetSandboxNsCacheFd(GetAppSpawnMgr(), property, &mountDigest);
     do {
         ret = StagedMountPreUnShare(context, sandbox);
         APPSPAWN_CHECK_ONLY_EXPER(ret == 0, break);
 
+        bool joined = false;
+        if (nsFd >= 0) {
+            ret = JoinCachedSandboxNs(context, nsFd, mountDigest, &joined);
+            APPSPAWN_CHECK_ONLY_EXPER(ret == 0, break);
+        }
+        if (joined) {
+            // 已进入缓存的命名空间，失败时不能在其中重新创建沙盒
+            ret = EnterCachedSandboxNs(context);
+            APPSPAWN_LOGV("Enter cached sandbox %{public}s result %{public}d", context->rootPath, ret);
+            break;
+        }
         CreateSandboxDir(context->rootPath, FILE_MODE);
         // add pid to a new mnt namespace
         ret = unshare(context->sandboxNsFlags);
@@ -1324,6 +1512,7 @@ int MountSandboxConfigs(AppSpawnSandboxCfg *sandbox, const AppSpawningCtx *prope
         APPSPAWN_CHECK_ONLY_EXPER(ret == 0, break);
         APPSPAWN_LOGV("Change root dir success %{public}s ", context->rootPath);
     } while (0);
+    SandboxMountBatchEnd();
     DeleteSandboxContext(context);
     return ret;
 }
@@ -26,7 +26,6 @@
 extern "C" {
 #endif
 
-#define SANDBOX_STAMP_FILE_SUFFIX ".stamp"
 #define JSON_FLAGS_INTERNAL "__internal__"
 #define SANDBOX_NWEBSPAWN_ROOT_PATH APPSPAWN_BASE_DIR "/mnt/sandbox/com.ohos.render/"
 #define OHOS_RENDER "__internal__.com.ohos.render"
@@ -271,6 +270,8 @@ int StagedMountPostUnshare(const SandboxContext *context, const AppSpawnSandboxC
 // 在子进程退出时，由父进程发起unmount操作
 int UnmountDepPaths(const AppSpawnSandboxCfg *sandbox, uid_t uid);
 int UnmountSandboxConfigs(const AppSpawnSandboxCfg *sandbox, uid_t uid, const char *name);
+// 沙盒根目录下的路径是否正在后台卸载
+bool IsSandboxRootBusy(const AppSpawnSandboxCfg *sandbox, uid_t uid);
 
 /**
  * @brief Variable op
@@ -374,6 +375,36 @@ typedef struct TagMountArg {
 
 int SandboxMountPath(const MountArg *arg);
 
+/**
+ * @brief 新挂载API（open_tree/mount_setattr/move_mount），内核不支持时回退到mount(2)
+ */
+int SandboxMountApiInit(void);
+int IsSandboxMountApiSupport(void);
+bool IsSandboxMountApiPreferred(const MountArg *arg);
+int SandboxBindMountByApi(const MountArg *arg);
+int SandboxSetSubtreeAttr(const char *path, unsigned long attrFlags, mode_t propagation);
+// 批量挂载期间，目标在root下且传播属性与root一致的bind挂载不再单独设置传播属性
+void SandboxMountBatchBegin(const char *root, mode_t propagation);
+void SandboxMountBatchEnd(void);
+void SandboxMountBatchAddShared(const char *path);
+bool IsSandboxMountPropagationInherited(const MountArg *arg);
+
+/**
+ * @brief 按 (bundle, uid, 权限hash) 缓存沙盒挂载命名空间，重启时直接setns进入
+ */
+int GetSandboxNsCacheFd(const AppSpawnMgr *content, const AppSpawningCtx *property, uint64_t *mountDigest);
+uint32_t GetSandboxNsMountInfo(pid_t pid, uint64_t *digest);
+void CloseSandboxNsCache(const AppSpawnMgr *content);
+
+/**
+ * @brief 沙盒挂载状态表，启动时从mountinfo初始化，替代stamp文件
+ */
+int LoadSandboxMountState(const char *mountInfo, const char *rootPath);
+bool IsSandboxPathMounted(const char *name, const char *rootPath, const char *target);
+void SetSandboxPathMounted(const char *name, const char *rootPath, bool mounted);
+bool IsSandboxRootDetachable(const char *rootPath);
+void ClearSandboxMountState(void);
+
 __attribute__((always_inline)) inline int IsPathEmpty(const char *path)
 {
     if (path == NULL || path[0] == '\0') {
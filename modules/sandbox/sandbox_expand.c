@@ -22,6 +22,7 @@
 #include "appspawn_sandbox.h"
 #include "appspawn_utils.h"
 #include "json_utils.h"
+#include "sandbox_ext_list.h"
 #include "securec.h"
 
 #define SANDBOX_GROUP_PATH "/data/storage/el2/group/"
@@ -33,6 +34,30 @@ static inline bool CheckPath(const char *name)
     return name != NULL && strcmp(name, ".") != 0 && strcmp(name, "..") != 0 && strstr(name, "/") == NULL;
 }
 
+static int MountHsp(const SandboxContext *context,
+    const char *libBundleName, const char *libModuleName, const char *libVersion)
+{
+    APPSPAWN_CHECK(CheckPath(libBundleName) && CheckPath(libModuleName) && CheckPath(libVersion),
+        return -1, "MountAllHsp: path error");
+
+    // src path
+    int len = sprintf_s(context->buffer[0].buffer, context->buffer[0].bufferLen, "%s%s/%s/%s",
+        PHYSICAL_APP_INSTALL_PATH, libBundleName, libVersion, libModuleName);
+    APPSPAWN_CHECK(len > 0, return -1, "Failed to format install path");
+    // sandbox path
+    len = sprintf_s(context->buffer[1].buffer, context->buffer[1].bufferLen, "%s%s%s/%s",
+        context->rootPath, SANDBOX_INSTALL_PATH, libBundleName, libModuleName);
+    APPSPAWN_CHECK(len > 0, return -1, "Failed to format install path");
+
+    CreateSandboxDir(context->buffer[1].buffer, FILE_MODE);
+    MountArg mountArg = {
+        context->buffer[0].buffer, context->buffer[1].buffer, NULL, MS_REC | MS_BIND, NULL, MS_SLAVE
+    };
+    int ret = SandboxMountPath(&mountArg);
+    APPSPAWN_CHECK(ret == 0, return ret, "mount library failed %{public}d", ret);
+    return 0;
+}
+
 APPSPAWN_STATIC int MountAllHsp(const SandboxContext *context, const cJSON *hsps)
 {
     APPSPAWN_CHECK(context != NULL && hsps != NULL, return -1, "Invalid context or hsps");
@@ -53,24 +78,8 @@ APPSPAWN_STATIC int MountAllHsp(const SandboxContext *context, const cJSON *hsps
         char *libBundleName = cJSON_GetStringValue(cJSON_GetArrayItem(bundles, i));
         char *libModuleName = cJSON_GetStringValue(cJSON_GetArrayItem(modules, i));
         char *libVersion = cJSON_GetStringValue(cJSON_GetArrayItem(versions, i));
-        APPSPAWN_CHECK(CheckPath(libBundleName) && CheckPath(libModuleName) && CheckPath(libVersion),
-            return -1, "MountAllHsp: path error");
-
-        // src path
-        int len = sprintf_s(context->buffer[0].buffer, context->buffer[0].bufferLen, "%s%s/%s/%s",
-            PHYSICAL_APP_INSTALL_PATH, libBundleName, libVersion, libModuleName);
-        APPSPAWN_CHECK(len > 0, return -1, "Failed to format install path");
-        // sandbox path
-        len = sprintf_s(context->buffer[1].buffer, context->buffer[1].bufferLen, "%s%s%s/%s",
-            context->rootPath, SANDBOX_INSTALL_PATH, libBundleName, libModuleName);
-        APPSPAWN_CHECK(len > 0, return -1, "Failed to format install path");
-
-        CreateSandboxDir(context->buffer[1].buffer, FILE_MODE);
-        MountArg mountArg = {
-            context->buffer[0].buffer, context->buffer[1].buffer, NULL, MS_REC | MS_BIND, NULL, MS_SLAVE
-        };
-        ret = SandboxMountPath(&mountArg);
-        APPSPAWN_CHECK(ret == 0, return ret, "mount library failed %{public}d", ret);
+        ret = MountHsp(context, libBundleName, libModuleName, libVersion);
+        APPSPAWN_CHECK_ONLY_EXPER(ret == 0, return ret);
     }
     return ret;
 }
@@ -81,15 +90,37 @@ static inline char *GetLastPath(const char *libPhysicalPath)
     return tmp + 1;
 }
 
-APPSPAWN_STATIC int MountAllGroup(const SandboxContext *context, const cJSON *groups)
+static inline mode_t GetGroupMountSharedFlag(const SandboxContext *context)
 {
-    APPSPAWN_CHECK(context != NULL && groups != NULL, return -1, "Invalid context or group");
-    mode_t mountFlags = MS_REC | MS_BIND;
     mode_t mountSharedFlag = MS_SLAVE;
     if (CheckAppSpawnMsgFlag(context->message, TLV_MSG_FLAGS, APP_FLAGS_ISOLATED_SANDBOX)) {
         APPSPAWN_LOGV("MountAllGroup falsg is isolated");
         mountSharedFlag |= MS_REMOUNT | MS_NODEV | MS_RDONLY | MS_BIND;
     }
+    return mountSharedFlag;
+}
+
+static int MountGroup(const SandboxContext *context, const char *libPhysicalPath, mode_t mountSharedFlag)
+{
+    APPSPAWN_CHECK(!CheckPath(libPhysicalPath), return -1, "MountAllGroup: path error");
+
+    char *dataGroupUuid = GetLastPath(libPhysicalPath);
+    int len = sprintf_s(context->buffer[0].buffer, context->buffer[0].bufferLen, "%s%s%s",
+        context->rootPath, SANDBOX_GROUP_PATH, dataGroupUuid);
+    APPSPAWN_CHECK(len > 0, return -1, "Failed to format install path");
+    APPSPAWN_LOGV("MountAllGroup src: '%{public}s' =>'%{public}s'", libPhysicalPath, context->buffer[0].buffer);
+
+    CreateSandboxDir(context->buffer[0].buffer, FILE_MODE);
+    MountArg mountArg = {libPhysicalPath, context->buffer[0].buffer, NULL, MS_REC | MS_BIND, NULL, mountSharedFlag};
+    int ret = SandboxMountPath(&mountArg);
+    APPSPAWN_CHECK(ret == 0, return ret, "mount library failed %{public}d", ret);
+    return 0;
+}
+
+APPSPAWN_STATIC int MountAllGroup(const SandboxContext *context, const cJSON *groups)
+{
+    APPSPAWN_CHECK(context != NULL && groups != NULL, return -1, "Invalid context or group");
+    mode_t mountSharedFlag = GetGroupMountSharedFlag(context);
     int ret = 0;
     cJSON *dataGroupIds = cJSON_GetObjectItemCaseSensitive(groups, "dataGroupId");
     cJSON *gids = cJSON_GetObjectItemCaseSensitive(groups, "gid");
@@ -106,19 +137,8 @@ APPSPAWN_STATIC int MountAllGroup(const SandboxContext *context, const cJSON *gr
     for (int i = 0; i < count; i++) {
         cJSON *dirJson = cJSON_GetArrayItem(dirs, i);
         APPSPAWN_CHECK(dirJson != NULL && cJSON_IsString(dirJson), return -1, "MountAllGroup: invalid dirJson");
-        const char *libPhysicalPath = cJSON_GetStringValue(dirJson);
-        APPSPAWN_CHECK(!CheckPath(libPhysicalPath), return -1, "MountAllGroup: path error");
-
-        char *dataGroupUuid = GetLastPath(libPhysicalPath);
-        int len = sprintf_s(context->buffer[0].buffer, context->buffer[0].bufferLen, "%s%s%s",
-            context->rootPath, SANDBOX_GROUP_PATH, dataGroupUuid);
-        APPSPAWN_CHECK(len > 0, return -1, "Failed to format install path");
-        APPSPAWN_LOGV("MountAllGroup src: '%{public}s' =>'%{public}s'", libPhysicalPath, context->buffer[0].buffer);
-
-        CreateSandboxDir(context->buffer[0].buffer, FILE_MODE);
-        MountArg mountArg = {libPhysicalPath, context->buffer[0].buffer, NULL, mountFlags, NULL, mountSharedFlag};
-        ret = SandboxMountPath(&mountArg);
-        APPSPAWN_CHECK(ret == 0, return ret, "mount library failed %{public}d", ret);
+        ret = MountGroup(context, cJSON_GetStringValue(dirJson), mountSharedFlag);
+        APPSPAWN_CHECK_ONLY_EXPER(ret == 0, return ret);
     }
     return ret;
 }
@@ -193,6 +213,40 @@ static int SetOverlayAppSandboxConfig(const SandboxContext *context, const char
     return ret;
 }
 
+APPSPAWN_STATIC int MountAllHspFromList(const SandboxContext *context, ExtListReader *reader)
+{
+    uint32_t count = reader->count;
+    APPSPAWN_LOGI("MountAllHsp app: %{public}s, count: %{public}u", context->bundleName, count);
+    for (uint32_t i = 0; i < count; i++) {
+        const char *libBundleName = ReadExtListString(reader);
+        const char *libModuleName = ReadExtListString(reader);
+        const char *libVersion = ReadExtListString(reader);
+        APPSPAWN_CHECK(libVersion != NULL && libModuleName != NULL && libBundleName != NULL,
+            return APPSPAWN_MSG_INVALID, "MountAllHsp: invalid hsp list at %{public}u", i);
+        int ret = MountHsp(context, libBundleName, libModuleName, libVersion);
+        APPSPAWN_CHECK_ONLY_EXPER(ret == 0, return ret);
+    }
+    return 0;
+}
+
+APPSPAWN_STATIC int MountAllGroupFromList(const SandboxContext *context, ExtListReader *reader)
+{
+    uint32_t count = reader->count;
+    mode_t mountSharedFlag = GetGroupMountSharedFlag(context);
+    APPSPAWN_LOGI("MountAllGroup: app: %{public}s, count: %{public}u", context->bundleName, count);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t gid = 0;
+        const char *dataGroupId = ReadExtListString(reader);
+        int ret = ReadExtListUint32(reader, &gid);
+        const char *libPhysicalPath = ReadExtListString(reader);
+        APPSPAWN_CHECK(dataGroupId != NULL && ret == 0 && libPhysicalPath != NULL,
+            return APPSPAWN_MSG_INVALID, "MountAllGroup: invalid data group list at %{public}u", i);
+        ret = MountGroup(context, libPhysicalPath, mountSharedFlag);
+        APPSPAWN_CHECK_ONLY_EXPER(ret == 0, return ret);
+    }
+    return 0;
+}
+
 static inline cJSON *GetJsonObjFromProperty(const SandboxContext *context, const char *name)
 {
     uint32_t size = 0;
@@ -208,22 +262,60 @@ static inline cJSON *GetJsonObjFromProperty(const SandboxContext *context, const
 
 static int ProcessHSPListConfig(const SandboxContext *context, const AppSpawnSandboxCfg *appSandBox, const char *name)
 {
+    uint32_t size = 0;
+    ExtListReader reader = {};
+    const uint8_t *extInfo = (const uint8_t *)GetAppSpawnMsgExtInfo(context->message, name, &size);
+    int ret = GetExtListReader(extInfo, size, EXT_LIST_HSP, &reader);
+    if (ret == 0) {
+        return MountAllHspFromList(context, &reader);
+    }
+    APPSPAWN_CHECK_ONLY_EXPER(ret == EXT_LIST_NOT_BINARY, return ret);
     cJSON *root = GetJsonObjFromProperty(context, name);
     APPSPAWN_CHECK_ONLY_EXPER(root != NULL, return 0);
-    int ret = MountAllHsp(context, root);
+    ret = MountAllHsp(context, root);
     cJSON_Delete(root);
     return ret;
 }
 
 static int ProcessDataGroupConfig(const SandboxContext *context, const AppSpawnSandboxCfg *appSandBox, const char *name)
 {
+    uint32_t size = 0;
+    ExtListReader reader = {};
+    const uint8_t *extInfo = (const uint8_t *)GetAppSpawnMsgExtInfo(context->message, name, &size);
+    int ret = GetExtListReader(extInfo, size, EXT_LIST_DATA_GROUP, &reader);
+    if (ret == 0) {
+        return MountAllGroupFromList(context, &reader);
+    }
+    APPSPAWN_CHECK_ONLY_EXPER(ret == EXT_LIST_NOT_BINARY, return ret);
     cJSON *root = GetJsonObjFromProperty(context, name);
     APPSPAWN_CHECK_ONLY_EXPER(root != NULL, return 0);
-    int ret = MountAllGroup(context, root);
+    ret = MountAllGroup(context, root);
     cJSON_Delete(root);
     return ret;
 }
 
+static int SetOverlayAppSandboxConfigFromList(const SandboxContext *context, ExtListReader *reader)
+{
+    uint32_t count = reader->count;
+    // 记录已挂载的源路径，长度不超过所有hap路径长度之和
+    OverlayContext overlayContext;
+    overlayContext.sandboxContext = context;
+    overlayContext.srcSetLen = reader->dataLen;
+    overlayContext.mountedSrcSet = (char *)calloc(1, overlayContext.srcSetLen + 1);
+    APPSPAWN_CHECK(overlayContext.mountedSrcSet != NULL, return -1, "Failed to create mountedSrcSet");
+    int ret = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const char *hapPath = ReadExtListString(reader);
+        APPSPAWN_CHECK(hapPath != NULL, ret = APPSPAWN_MSG_INVALID;
+            break, "Invalid overlay list at %{public}u", i);
+        ret = SetOverlayAppPath(hapPath, (void *)&overlayContext);
+        APPSPAWN_CHECK_ONLY_EXPER(ret == 0, break);
+    }
+    APPSPAWN_LOGV("overlayContext->mountedSrcSet: '%{public}s'", overlayContext.mountedSrcSet);
+    free(overlayContext.mountedSrcSet);
+    return ret;
+}
+
 static int ProcessOverlayAppConfig(const SandboxContext *context,
     const AppSpawnSandboxCfg *appSandBox, const char *name)
 {
@@ -232,6 +324,12 @@ static int ProcessOverlayAppConfig(const SandboxContext *context,
     if (size == 0 || extInfo == NULL) {
         return 0;
     }
+    ExtListReader reader = {};
+    int ret = GetExtListReader((const uint8_t *)extInfo, size, EXT_LIST_OVERLAY, &reader);
+    if (ret == 0) {
+        return SetOverlayAppSandboxConfigFromList(context, &reader);
+    }
+    APPSPAWN_CHECK_ONLY_EXPER(ret == EXT_LIST_NOT_BINARY, return ret);
     APPSPAWN_LOGV("ProcessOverlayAppConfig name %{public}s value %{public}s", name, extInfo);
     return SetOverlayAppSandboxConfig(context, extInfo);
 }
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sandbox_ext_list.h"
+
+#include <string.h>
+
+#include "appspawn_msg.h"
+#include "appspawn_utils.h"
+#include "securec.h"
+
+#define EXT_LIST_STRING_MIN_SIZE (sizeof(uint16_t) + 1)
+
+// 每种记录的最小编码长度，用于校验头部中的记录个数
+static uint32_t GetExtListRecordMinSize(uint32_t listType)
+{
+    switch (listType) {
+        case EXT_LIST_HSP:
+            return EXT_LIST_STRING_MIN_SIZE * 3;  // 3 bundleName, moduleName, version
+        case EXT_LIST_DATA_GROUP:
+            return EXT_LIST_STRING_MIN_SIZE * 2 + sizeof(uint32_t);  // 2 dataGroupId, dir
+        case EXT_LIST_OVERLAY:
+            return EXT_LIST_STRING_MIN_SIZE;
+        default:
+            return 0;
+    }
+}
+
+int GetExtListReader(const uint8_t *data, uint32_t dataLen, uint32_t listType, ExtListReader *reader)
+{
+    AppSpawnExtListHeader header = {};
+    if (data == NULL || reader == NULL || dataLen < sizeof(header)) {
+        return EXT_LIST_NOT_BINARY;
+    }
+    (void)memcpy_s(&header, sizeof(header), data, sizeof(header));
+    if (header.magic != APPSPAWN_EXT_LIST_MAGIC) {
+        return EXT_LIST_NOT_BINARY;
+    }
+    uint32_t minSize = GetExtListRecordMinSize(listType);
+    APPSPAWN_CHECK(header.version == APPSPAWN_EXT_LIST_VERSION && header.listType == listType && minSize > 0,
+        return APPSPAWN_MSG_INVALID, "Invalid ext list version %{public}u type %{public}u",
+        header.version, header.listType);
+    APPSPAWN_CHECK(header.count <= (dataLen - sizeof(header)) / minSize,
+        return APPSPAWN_MSG_INVALID, "Invalid ext list count %{public}u len %{public}u", header.count, dataLen);
+    reader->data = data;
+    reader->dataLen = dataLen;
+    reader->offset = sizeof(header);
+    reader->count = header.count;
+    return 0;
+}
+
+const char *ReadExtListString(ExtListReader *reader)
+{
+    uint16_t len = 0;
+    APPSPAWN_CHECK_ONLY_EXPER(reader->dataLen - reader->offset >= sizeof(len), return NULL);
+    (void)memcpy_s(&len, sizeof(len), reader->data + reader->offset, sizeof(len));
+    APPSPAWN_CHECK_ONLY_EXPER(reader->dataLen - reader->offset - sizeof(len) > len, return NULL);
+    const char *str = (const char *)(reader->data + reader->offset + sizeof(len));
+    APPSPAWN_CHECK_ONLY_EXPER(str[len] == '\0' && strlen(str) == len, return NULL);
+    reader->offset += sizeof(len) + len + 1;
+    return str;
+}
+
+int ReadExtListUint32(ExtListReader *reader, uint32_t *value)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(reader->dataLen - reader->offset >= sizeof(uint32_t), return -1);
+    (void)memcpy_s(value, sizeof(uint32_t), reader->data + reader->offset, sizeof(uint32_t));
+    reader->offset += sizeof(uint32_t);
+    return 0;
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SANDBOX_EXT_LIST_H
+#define SANDBOX_EXT_LIST_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EXT_LIST_NOT_BINARY (-1)
+
+typedef struct {
+    const uint8_t *data;
+    uint32_t dataLen;
+    uint32_t offset;
+    uint32_t count;
+} ExtListReader;
+
+/**
+ * @brief 检查扩展信息是否为二进制编码的列表，是则初始化reader
+ *
+ * @param data 扩展信息
+ * @param dataLen 扩展信息长度
+ * @param listType 列表类型 AppSpawnExtListType
+ * @param reader 返回记录个数及读取位置
+ * @return 0 二进制列表；EXT_LIST_NOT_BINARY 非二进制编码；其他 格式错误
+ */
+int GetExtListReader(const uint8_t *data, uint32_t dataLen, uint32_t listType, ExtListReader *reader);
+const char *ReadExtListString(ExtListReader *reader);
+int ReadExtListUint32(ExtListReader *reader, uint32_t *value);
+
+#ifdef __cplusplus
+}
+#endif
+#endif  // SANDBOX_EXT_LIST_H
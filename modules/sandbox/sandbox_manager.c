@@ -498,6 +498,10 @@ APPSPAWN_STATIC int PreLoadIsoLatedSandboxCfg(AppSpawnMgr *content)
     // load app sandbox config
     LoadAppSandboxConfig(sandbox, MODE_FOR_NATIVE_SPAWN);
     sandbox->maxPermissionIndex = PermissionRenumber(&sandbox->permissionQueue);
+    SandboxMountApiInit();
+    if (sandbox->rootPath != NULL) {
+        LoadSandboxMountState("/proc/self/mountinfo", sandbox->rootPath);
+    }
 
     content->content.sandboxNsFlags = 0;
     if (sandbox->pidNamespaceSupport) {
@@ -518,6 +522,10 @@ APPSPAWN_STATIC int PreLoadSandboxCfg(AppSpawnMgr *content)
     // load app sandbox config
     LoadAppSandboxConfig(sandbox, content->content.mode);
     sandbox->maxPermissionIndex = PermissionRenumber(&sandbox->permissionQueue);
+    SandboxMountApiInit();
+    if (sandbox->rootPath != NULL) {
+        LoadSandboxMountState("/proc/self/mountinfo", sandbox->rootPath);
+    }
 
     content->content.sandboxNsFlags = 0;
     if (IsNWebSpawnMode(content) || sandbox->pidNamespaceSupport) {
@@ -538,7 +546,7 @@ APPSPAWN_STATIC int SandboxHandleServerExit(AppSpawnMgr *content)
 {
     AppSpawnSandboxCfg *sandbox = GetAppSpawnSandbox(content, EXT_DATA_SANDBOX);
     APPSPAWN_CHECK(sandbox != NULL, return 0, "Sandbox not load");
-
+    ClearSandboxMountState();
     return 0;
 }
 
@@ -562,6 +570,7 @@ int SpawnBuildSandboxEnv(AppSpawnMgr *content, AppSpawningCtx *property)
     }
     int ret = MountSandboxConfigs(appSandbox, property, IsNWebSpawnMode(content));
     appSandbox->mounted = 1;
+    CloseSandboxNsCache(content);
     // for module test do not create sandbox, use APP_FLAGS_IGNORE_SANDBOX to ignore sandbox result
     if (CheckAppMsgFlagsSet(property, APP_FLAGS_IGNORE_SANDBOX)) {
         APPSPAWN_LOGW("Do not care sandbox result %{public}d", ret);
@@ -676,6 +685,19 @@ int SpawnPrepareSandboxCfg(AppSpawnMgr *content, AppSpawningCtx *property)
     return 0;
 }
 
+APPSPAWN_STATIC int SpawnCheckSandboxDefer(AppSpawnMgr *content, AppSpawningCtx *property)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(content != NULL, return -1);
+    APPSPAWN_CHECK_ONLY_EXPER(property != NULL, return -1);
+    ExtDataType type = CheckAppMsgFlagsSet(property, APP_FLAGS_ISOLATED_SANDBOX_TYPE) ? EXT_DATA_ISOLATED_SANDBOX :
+        EXT_DATA_SANDBOX;
+    AppSpawnSandboxCfg *sandbox = GetAppSpawnSandbox(content, type);
+    AppSpawnMsgDacInfo *info = (AppSpawnMsgDacInfo *)GetAppProperty(property, TLV_DAC_INFO);
+    APPSPAWN_CHECK_ONLY_EXPER(sandbox != NULL && info != NULL, return 0);
+    // 只有本次孵化的沙盒根目录下有路径正在卸载时才延后
+    return IsSandboxRootBusy(sandbox, info->uid) ? APPSPAWN_SPAWN_DEFERRED : 0;
+}
+
 APPSPAWN_STATIC int SandboxUnmountPath(const AppSpawnMgr *content, const AppSpawnedProcessInfo *appInfo)
 {
     APPSPAWN_CHECK_ONLY_EXPER(content != NULL, return -1);
@@ -698,6 +720,7 @@ MODULE_CONSTRUCTOR(void)
     (void)AddServerStageHook(STAGE_SERVER_PRELOAD, HOOK_PRIO_SANDBOX, PreLoadIsoLatedSandboxCfg);
     (void)AddServerStageHook(STAGE_SERVER_EXIT, HOOK_PRIO_SANDBOX, SandboxHandleServerExit);
     (void)AddServerStageHook(STAGE_SERVER_EXIT, HOOK_PRIO_SANDBOX, IsolatedSandboxHandleServerExit);
+    (void)AddAppSpawnHook(STAGE_PARENT_CHECK_DEFER, HOOK_PRIO_SANDBOX, SpawnCheckSandboxDefer);
     (void)AddAppSpawnHook(STAGE_PARENT_PRE_FORK, HOOK_PRIO_SANDBOX, SpawnPrepareSandboxCfg);
     (void)AddAppSpawnHook(STAGE_CHILD_EXECUTE, HOOK_PRIO_SANDBOX, SpawnBuildSandboxEnv);
     (void)AddProcessMgrHook(STAGE_SERVER_APP_DIED, 0, SandboxUnmountPath);
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef _GNU_SOURCE
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/mount.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+
+#include "appspawn_sandbox.h"
+#include "appspawn_utils.h"
+#include "securec.h"
+
+/*
+ * open_tree/move_mount/mount_setattr 系统调用号在所有架构上统一，
+ * 老的libc头文件中可能没有定义，这里补齐
+ */
+#ifndef SYS_open_tree
+#define SYS_open_tree 428
+#endif
+#ifndef SYS_move_mount
+#define SYS_move_mount 429
+#endif
+#ifndef SYS_mount_setattr
+#define SYS_mount_setattr 442
+#endif
+
+#ifndef OPEN_TREE_CLONE
+#define OPEN_TREE_CLONE 1
+#endif
+#ifndef OPEN_TREE_CLOEXEC
+#define OPEN_TREE_CLOEXEC O_CLOEXEC
+#endif
+#ifndef AT_RECURSIVE
+#define AT_RECURSIVE 0x8000
+#endif
+#ifndef MOVE_MOUNT_F_EMPTY_PATH
+#define MOVE_MOUNT_F_EMPTY_PATH 0x00000004
+#endif
+#ifndef MOUNT_ATTR_RDONLY
+#define MOUNT_ATTR_RDONLY 0x00000001
+#endif
+#ifndef MOUNT_ATTR_NOSUID
+#define MOUNT_ATTR_NOSUID 0x00000002
+#endif
+#ifndef MOUNT_ATTR_NODEV
+#define MOUNT_ATTR_NODEV 0x00000004
+#endif
+#ifndef MOUNT_ATTR_NOEXEC
+#define MOUNT_ATTR_NOEXEC 0x00000008
+#endif
+#ifndef MOUNT_ATTR_NOATIME
+#define MOUNT_ATTR_NOATIME 0x00000010
+#endif
+
+#define MOUNT_PROPAGATION_FLAGS (MS_SHARED | MS_SLAVE | MS_PRIVATE | MS_UNBINDABLE)
+#define MOUNT_BATCH_SHARED_MAX 32
+
+// 与内核 struct mount_attr 布局一致，避免与新版本libc中的定义冲突
+typedef struct {
+    uint64_t attrSet;
+    uint64_t attrClr;
+    uint64_t propagation;
+    uint64_t usernsFd;
+} SandboxMountAttr;
+
+typedef enum {
+    MOUNT_API_UNKNOWN,
+    MOUNT_API_UNSUPPORTED,
+    MOUNT_API_SUPPORTED,
+} MountApiState;
+
+typedef struct {
+    char root[PATH_MAX];
+    uint32_t rootLen;
+    mode_t propagation;
+    uint32_t active : 1;
+    uint32_t sharedOverflow : 1;
+    uint32_t sharedCount;
+    char *sharedPaths[MOUNT_BATCH_SHARED_MAX];  // 批量挂载期间设置为shared的挂载点
+} SandboxMountBatch;
+
+static MountApiState g_mountApiState = MOUNT_API_UNKNOWN;
+static SandboxMountBatch g_mountBatch = {};
+
+static inline int OpenTree(int dirfd, const char *path, unsigned int flags)
+{
+    return (int)syscall(SYS_open_tree, dirfd, path, flags);
+}
+
+static inline int MoveMount(int fromDirfd, const char *fromPath, int toDirfd, const char *toPath, unsigned int flags)
+{
+    return (int)syscall(SYS_move_mount, fromDirfd, fromPath, toDirfd, toPath, flags);
+}
+
+static inline int MountSetAttr(int dirfd, const char *path, unsigned int flags, SandboxMountAttr *attr)
+{
+    return (int)syscall(SYS_mount_setattr, dirfd, path, flags, attr, sizeof(SandboxMountAttr));
+}
+
+static uint64_t GetMountAttrFromFlags(unsigned long flags)
+{
+    uint64_t attr = 0;
+    attr |= ((flags & MS_RDONLY) == MS_RDONLY) ? MOUNT_ATTR_RDONLY : 0;
+    attr |= ((flags & MS_NOSUID) == MS_NOSUID) ? MOUNT_ATTR_NOSUID : 0;
+    attr |= ((flags & MS_NODEV) == MS_NODEV) ? MOUNT_ATTR_NODEV : 0;
+    attr |= ((flags & MS_NOEXEC) == MS_NOEXEC) ? MOUNT_ATTR_NOEXEC : 0;
+    attr |= ((flags & MS_NOATIME) == MS_NOATIME) ? MOUNT_ATTR_NOATIME : 0;
+    return attr;
+}
+
+int SandboxMountApiInit(void)
+{
+    if (g_mountApiState != MOUNT_API_UNKNOWN) {
+        return g_mountApiState == MOUNT_API_SUPPORTED;
+    }
+    /*
+     * mount_setattr 最晚合入（5.12），能识别它即可认为 open_tree/move_mount 均可用。
+     * 用非法fd探测：支持时返回 EBADF/EINVAL，不支持时返回 ENOSYS
+     */
+    errno = 0;
+    int ret = MountSetAttr(-1, NULL, 0, NULL);
+    g_mountApiState = (ret == -1 && errno != ENOSYS) ? MOUNT_API_SUPPORTED : MOUNT_API_UNSUPPORTED;
+    APPSPAWN_LOGI("Sandbox mount api %{public}s errno: %{public}d",
+        g_mountApiState == MOUNT_API_SUPPORTED ? "open_tree" : "mount", errno);
+    return g_mountApiState == MOUNT_API_SUPPORTED;
+}
+
+int IsSandboxMountApiSupport(void)
+{
+    return g_mountApiState == MOUNT_API_SUPPORTED;
+}
+
+static bool IsPathUnderBatchShared(const char *path);
+
+static inline bool IsBatchParentNotShared(const char *path)
+{
+    return g_mountBatch.active && !g_mountBatch.sharedOverflow && !IsPathUnderBatchShared(path);
+}
+
+bool IsSandboxMountApiPreferred(const MountArg *arg)
+{
+    if (!IsSandboxMountApiSupport() || arg == NULL || !IsPathEmpty(arg->fsType)) {
+        return false;
+    }
+    // 递归bind且需要设置挂载属性时，mount(2)需要bind、设置传播属性并逐个子挂载remount，新API调用更少
+    return (arg->mountFlags & (MS_BIND | MS_REC)) == (MS_BIND | MS_REC) &&
+        (arg->mountSharedFlag & MS_REMOUNT) == MS_REMOUNT && GetMountAttrFromFlags(arg->mountSharedFlag) != 0;
+}
+
+int SandboxBindMountByApi(const MountArg *arg)
+{
+    unsigned int recursive = ((arg->mountFlags & MS_REC) == MS_REC) ? AT_RECURSIVE : 0;
+    int fd = OpenTree(AT_FDCWD, arg->originPath, OPEN_TREE_CLONE | OPEN_TREE_CLOEXEC | recursive);
+    APPSPAWN_CHECK(fd >= 0, return errno, "open_tree %{public}s failed errno: %{public}d", arg->originPath, errno);
+
+    // 挂载属性在树挂入沙盒前设置
+    // 父挂载点可能为shared时，挂入后会加入其peer group，传播属性需挂入后再设置
+    SandboxMountAttr attr = {};
+    attr.attrSet = GetMountAttrFromFlags(arg->mountSharedFlag);
+    mode_t propagation = arg->mountSharedFlag & MOUNT_PROPAGATION_FLAGS;
+    bool setBefore = IsBatchParentNotShared(arg->destinationPath);
+    attr.propagation = setBefore ? propagation : 0;
+    int ret = 0;
+    if (attr.propagation != 0 || attr.attrSet != 0) {
+        ret = MountSetAttr(fd, "", AT_EMPTY_PATH | recursive, &attr);
+        APPSPAWN_CHECK(ret == 0, ret = errno; close(fd);
+            return ret, "mount_setattr %{public}s failed errno: %{public}d", arg->destinationPath, errno);
+    }
+    ret = MoveMount(fd, "", AT_FDCWD, arg->destinationPath, MOVE_MOUNT_F_EMPTY_PATH);
+    APPSPAWN_CHECK(ret == 0, ret = errno; close(fd);
+        return ret, "move_mount %{public}s failed errno: %{public}d", arg->destinationPath, errno);
+    if (!setBefore && propagation != 0) {
+        SandboxMountAttr propagationAttr = {};
+        propagationAttr.propagation = propagation;
+        ret = MountSetAttr(fd, "", AT_EMPTY_PATH | recursive, &propagationAttr);
+        APPSPAWN_CHECK(ret == 0, ret = errno; close(fd);
+            return ret, "mount_setattr propagation %{public}s failed errno: %{public}d", arg->destinationPath, errno);
+    }
+    close(fd);
+    return 0;
+}
+
+void SandboxMountBatchBegin(const char *root, mode_t propagation)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(root != NULL, return);
+    SandboxMountBatchEnd();
+    int ret = strcpy_s(g_mountBatch.root, sizeof(g_mountBatch.root), root);
+    APPSPAWN_CHECK(ret == 0, g_mountBatch.active = 0;
+        return, "Failed to copy batch root %{public}s", root);
+    g_mountBatch.rootLen = strlen(g_mountBatch.root);
+    g_mountBatch.propagation = propagation;
+    g_mountBatch.active = 1;
+    APPSPAWN_LOGV("Sandbox mount batch begin %{public}s", root);
+}
+
+void SandboxMountBatchEnd(void)
+{
+    for (uint32_t i = 0; i < g_mountBatch.sharedCount; i++) {
+        free(g_mountBatch.sharedPaths[i]);
+        g_mountBatch.sharedPaths[i] = NULL;
+    }
+    g_mountBatch.sharedCount = 0;
+    g_mountBatch.sharedOverflow = 0;
+    g_mountBatch.active = 0;
+    g_mountBatch.rootLen = 0;
+    g_mountBatch.root[0] = '\0';
+}
+
+static inline bool IsPathUnder(const char *path, const char *parent, uint32_t parentLen)
+{
+    return path != NULL && parentLen > 0 && strncmp(path, parent, parentLen) == 0 &&
+        (path[parentLen] == '\0' || path[parentLen] == '/' || parent[parentLen - 1] == '/');
+}
+
+static inline bool IsPathInBatchRoot(const char *path)
+{
+    return IsPathUnder(path, g_mountBatch.root, g_mountBatch.rootLen);
+}
+
+static bool IsPathUnderBatchShared(const char *path)
+{
+    for (uint32_t i = 0; i < g_mountBatch.sharedCount; i++) {
+        if (IsPathUnder(path, g_mountBatch.sharedPaths[i], strlen(g_mountBatch.sharedPaths[i]))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SandboxMountBatchAddShared(const char *path)
+{
+    if (!g_mountBatch.active || path == NULL || IsPathUnderBatchShared(path)) {
+        return;
+    }
+    // 记录不下时不再跳过任何传播属性设置
+    if (g_mountBatch.sharedCount >= MOUNT_BATCH_SHARED_MAX) {
+        g_mountBatch.sharedOverflow = 1;
+        return;
+    }
+    char *sharedPath = strdup(path);
+    APPSPAWN_CHECK(sharedPath != NULL, g_mountBatch.sharedOverflow = 1;
+        return, "Failed to record shared mount %{public}s", path);
+    g_mountBatch.sharedPaths[g_mountBatch.sharedCount++] = sharedPath;
+}
+
+bool IsSandboxMountPropagationInherited(const MountArg *arg)
+{
+    if (!g_mountBatch.active || arg == NULL || !IsPathEmpty(arg->fsType)) {
+        return false;
+    }
+    if ((arg->mountFlags & MS_BIND) != MS_BIND || arg->mountSharedFlag != g_mountBatch.propagation) {
+        return false;
+    }
+    // 源路径位于沙盒内时可能是刚设置为shared的挂载点，不能依赖继承
+    if (!IsPathInBatchRoot(arg->destinationPath) || IsPathInBatchRoot(arg->originPath)) {
+        return false;
+    }
+    // 父挂载点为shared时，新挂载点会加入shared组，需要显式设置为slave
+    return !g_mountBatch.sharedOverflow && !IsPathUnderBatchShared(arg->destinationPath);
+}
+
+int SandboxSetSubtreeAttr(const char *path, unsigned long attrFlags, mode_t propagation)
+{
+    APPSPAWN_CHECK(path != NULL, return APPSPAWN_ARG_INVALID, "Invalid path");
+    int ret = 0;
+    if (IsSandboxMountApiSupport()) {
+        SandboxMountAttr attr = {};
+        attr.attrSet = GetMountAttrFromFlags(attrFlags);
+        attr.propagation = propagation & MOUNT_PROPAGATION_FLAGS;
+        ret = MountSetAttr(AT_FDCWD, path, AT_RECURSIVE, &attr);
+        APPSPAWN_CHECK(ret == 0, return errno,
+            "mount_setattr subtree %{public}s failed errno: %{public}d", path, errno);
+        return 0;
+    }
+    if (propagation != 0) {
+        ret = mount(NULL, path, NULL, MS_REC | propagation, NULL);
+        APPSPAWN_CHECK(ret == 0, return errno,
+            "Set propagation subtree %{public}s failed errno: %{public}d", path, errno);
+    }
+    if (GetMountAttrFromFlags(attrFlags) != 0) {
+        ret = mount(NULL, path, NULL, MS_REMOUNT | MS_BIND | MS_REC | attrFlags, NULL);
+        APPSPAWN_CHECK(ret == 0, return errno,
+            "Remount subtree %{public}s failed errno: %{public}d", path, errno);
+    }
+    return 0;
+}
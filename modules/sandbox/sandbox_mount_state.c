@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "appspawn_sandbox.h"
+#include "appspawn_utils.h"
+#include "securec.h"
+
+#define MOUNT_STATE_BUCKET_COUNT 256
+#define MOUNT_STATE_KEY_SEPARATOR '|'
+#define MOUNTINFO_MOUNT_POINT_INDEX 4  // mountinfo 第5列为挂载点
+
+typedef enum {
+    MOUNT_STATE_SECTION,     // 配置段（如system-const）在某个沙盒根目录下的挂载状态
+    MOUNT_STATE_MOUNTPOINT,  // 启动时从mountinfo中读取到的挂载点
+} MountStateType;
+
+typedef struct TagSandboxMountState {
+    struct TagSandboxMountState *next;
+    uint32_t hash;
+    uint32_t type : 2;
+    uint32_t mounted : 1;
+    char key[0];
+} SandboxMountState;
+
+typedef struct {
+    SandboxMountState *buckets[MOUNT_STATE_BUCKET_COUNT];
+    uint32_t count;
+} SandboxMountStateTable;
+
+static SandboxMountStateTable g_mountStateTable = {};
+
+static uint32_t MountStateHash(uint32_t type, const char *name, const char *path)
+{
+    uint32_t hash = 2166136261U;  // FNV-1a offset basis
+    hash = (hash ^ type) * 16777619U;  // FNV-1a prime
+    for (const char *p = name; p != NULL && *p != '\0'; p++) {
+        hash = (hash ^ (uint8_t)*p) * 16777619U;  // FNV-1a prime
+    }
+    hash = (hash ^ MOUNT_STATE_KEY_SEPARATOR) * 16777619U;  // FNV-1a prime
+    for (const char *p = path; *p != '\0'; p++) {
+        hash = (hash ^ (uint8_t)*p) * 16777619U;  // FNV-1a prime
+    }
+    return hash;
+}
+
+static bool MountStateKeyEqual(const SandboxMountState *state, const char *name, const char *path)
+{
+    size_t nameLen = name == NULL ? 0 : strlen(name);
+    if (nameLen > 0 && strncmp(state->key, name, nameLen) != 0) {
+        return false;
+    }
+    return state->key[nameLen] == MOUNT_STATE_KEY_SEPARATOR && strcmp(state->key + nameLen + 1, path) == 0;
+}
+
+static SandboxMountState *FindMountState(uint32_t type, const char *name, const char *path)
+{
+    uint32_t hash = MountStateHash(type, name, path);
+    SandboxMountState *state = g_mountStateTable.buckets[hash % MOUNT_STATE_BUCKET_COUNT];
+    while (state != NULL) {
+        if (state->hash == hash && state->type == type && MountStateKeyEqual(state, name, path)) {
+            return state;
+        }
+        state = state->next;
+    }
+    return NULL;
+}
+
+static SandboxMountState *AddMountState(uint32_t type, const char *name, const char *path)
+{
+    SandboxMountState *state = FindMountState(type, name, path);
+    if (state != NULL) {
+        return state;
+    }
+    size_t len = (name == NULL ? 0 : strlen(name)) + 1 + strlen(path) + 1;
+    state = (SandboxMountState *)calloc(1, sizeof(SandboxMountState) + len);
+    APPSPAWN_CHECK(state != NULL, return NULL, "Failed to create mount state %{public}s", path);
+    int ret = sprintf_s(state->key, len, "%s%c%s", name == NULL ? "" : name, MOUNT_STATE_KEY_SEPARATOR, path);
+    APPSPAWN_CHECK(ret > 0, free(state);
+        return NULL, "Failed to format mount state %{public}s", path);
+    state->hash = MountStateHash(type, name, path);
+    state->type = type;
+    uint32_t index = state->hash % MOUNT_STATE_BUCKET_COUNT;
+    state->next = g_mountStateTable.buckets[index];
+    g_mountStateTable.buckets[index] = state;
+    g_mountStateTable.count++;
+    return state;
+}
+
+static char *GetMountPointFromMountInfo(char *line)
+{
+    char *savePtr = NULL;
+    char *field = strtok_r(line, " ", &savePtr);
+    for (uint32_t i = 0; field != NULL && i < MOUNTINFO_MOUNT_POINT_INDEX; i++) {
+        field = strtok_r(NULL, " ", &savePtr);
+    }
+    return field;
+}
+
+int LoadSandboxMountState(const char *mountInfo, const char *rootPath)
+{
+    APPSPAWN_CHECK(mountInfo != NULL && rootPath != NULL, return APPSPAWN_ARG_INVALID, "Invalid mount info");
+    // 只关心沙盒根目录下的挂载点，根目录中的变量部分不参与匹配
+    size_t prefixLen = strcspn(rootPath, "<");
+    APPSPAWN_CHECK(prefixLen > 0, return APPSPAWN_ARG_INVALID, "Invalid root path %{public}s", rootPath);
+
+    FILE *fp = fopen(mountInfo, "r");
+    APPSPAWN_CHECK(fp != NULL, return errno, "Failed to open %{public}s errno: %{public}d", mountInfo, errno);
+    uint32_t count = 0;
+    char line[PATH_MAX + PATH_MAX] = {0};
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        char *mountPoint = GetMountPointFromMountInfo(line);
+        if (mountPoint == NULL || strncmp(mountPoint, rootPath, prefixLen) != 0) {
+            continue;
+        }
+        SandboxMountState *state = AddMountState(MOUNT_STATE_MOUNTPOINT, NULL, mountPoint);
+        if (state != NULL) {
+            state->mounted = 1;
+            count++;
+        }
+    }
+    (void)fclose(fp);
+    APPSPAWN_LOGI("Load sandbox mount state %{public}s count: %{public}u", rootPath, count);
+    return 0;
+}
+
+bool IsSandboxPathMounted(const char *name, const char *rootPath, const char *target)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(name != NULL && rootPath != NULL, return false);
+    SandboxMountState *state = FindMountState(MOUNT_STATE_SECTION, name, rootPath);
+    if (state != NULL) {
+        return state->mounted;
+    }
+    // 首次查询时根据启动时的挂载点确定状态，之后以内存中的状态为准
+    bool mounted = false;
+    if (target != NULL) {
+        char path[PATH_MAX] = {};
+        int len = sprintf_s(path, sizeof(path), "%s%s", rootPath, target);
+        APPSPAWN_CHECK(len > 0, return false, "Failed to format path");
+        SandboxMountState *mountPoint = FindMountState(MOUNT_STATE_MOUNTPOINT, NULL, path);
+        mounted = mountPoint != NULL && mountPoint->mounted;
+    }
+    state = AddMountState(MOUNT_STATE_SECTION, name, rootPath);
+    if (state != NULL) {
+        state->mounted = mounted;
+    }
+    return mounted;
+}
+
+void SetSandboxPathMounted(const char *name, const char *rootPath, bool mounted)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(name != NULL && rootPath != NULL, return);
+    SandboxMountState *state = AddMountState(MOUNT_STATE_SECTION, name, rootPath);
+    if (state != NULL) {
+        state->mounted = mounted;
+    }
+}
+
+bool IsSandboxRootDetachable(const char *rootPath)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(rootPath != NULL, return false);
+    // 启动前已存在的挂载点不是appspawn创建的，不能整体分离
+    SandboxMountState *mountPoint = FindMountState(MOUNT_STATE_MOUNTPOINT, NULL, rootPath);
+    if (mountPoint != NULL && mountPoint->mounted) {
+        return false;
+    }
+    // 根目录下还有其他已挂载的配置段时只能逐个卸载
+    for (uint32_t i = 0; i < MOUNT_STATE_BUCKET_COUNT; i++) {
+        for (SandboxMountState *state = g_mountStateTable.buckets[i]; state != NULL; state = state->next) {
+            if (state->type != MOUNT_STATE_SECTION || !state->mounted) {
+                continue;
+            }
+            const char *path = strchr(state->key, MOUNT_STATE_KEY_SEPARATOR);
+            if (path != NULL && strcmp(path + 1, rootPath) == 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void ClearSandboxMountState(void)
+{
+    for (uint32_t i = 0; i < MOUNT_STATE_BUCKET_COUNT; i++) {
+        SandboxMountState *state = g_mountStateTable.buckets[i];
+        while (state != NULL) {
+            SandboxMountState *next = state->next;
+            free(state);
+            state = next;
+        }
+        g_mountStateTable.buckets[i] = NULL;
+    }
+    g_mountStateTable.count = 0;
+}
@@ -0,0 +1,473 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef _GNU_SOURCE
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "appspawn_manager.h"
+#include "appspawn_sandbox.h"
+#include "appspawn_utils.h"
+#include "modulemgr.h"
+#include "parameter.h"
+#include "securec.h"
+
+#define NS_CACHE_ENABLE_PARAM "persist.appspawn.sandbox.nscache.enable"
+#define NS_CACHE_MAX_ENTRY_PARAM "persist.appspawn.sandbox.nscache.max_entry"
+#define NS_CACHE_MAX_MOUNT_PARAM "persist.appspawn.sandbox.nscache.max_mount"
+#define NS_CACHE_DEFAULT_MAX_ENTRY 8
+#define NS_CACHE_DEFAULT_MAX_MOUNT 4096
+#define NS_CACHE_PARAM_LEN 32
+#define NS_CACHE_PATH_LEN 64
+#define NS_CACHE_UNLOCK_PATH_LEN 256
+#define MOUNTINFO_ID_INDEX 0
+#define MOUNTINFO_ROOT_INDEX 3
+#define MOUNTINFO_TARGET_INDEX 4
+#define MOUNTINFO_SOURCE_INDEX 2  // 分隔符"-"之后的第2个字段
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+typedef struct {
+    ListNode node;
+    uid_t uid;
+    int nsFd;
+    uint64_t keyHash;      // 进程名、消息标志、权限位、包信息、域信息、el2解锁状态
+    uint64_t contentHash;  // HspList/DataGroup/Overlay
+    uint64_t mountDigest;  // 挂载id、挂载源和挂载点的摘要
+    pid_t holderPid;       // 最近一个使用该命名空间的应用进程
+    uint32_t generation;   // 创建时的沙盒挂载点更新计数
+    uint32_t mountCount;
+    uint32_t hits;
+    char bundleName[0];
+} SandboxNsCacheNode;
+
+typedef struct {
+    AppSpawnExtData extData;
+    ListNode lruQueue;  // 尾部为最近使用
+    uint32_t count;
+    uint32_t maxCount;
+    uint32_t mountCount;
+    uint32_t maxMountCount;
+    uint32_t lookups;
+    uint32_t hits;
+    uint32_t invalidations;
+    uint32_t evictions;
+} SandboxNsCache;
+
+static uint64_t NsCacheHash(uint64_t hash, const void *data, uint32_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    for (uint32_t i = 0; p != NULL && i < len; i++) {
+        hash ^= p[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static uint64_t NsCacheHashTlv(uint64_t hash, const AppSpawningCtx *property, uint32_t type)
+{
+    AppSpawnMsgFlags *flags = (AppSpawnMsgFlags *)GetAppProperty(property, type);
+    if (flags == NULL) {
+        return hash;
+    }
+    return NsCacheHash(hash, flags->flags, flags->count * sizeof(uint32_t));
+}
+
+static uint64_t NsCacheHashExt(uint64_t hash, const AppSpawningCtx *property, const char *name)
+{
+    uint32_t len = 0;
+    const char *data = (const char *)GetAppPropertyExt(property, name, &len);
+    hash = NsCacheHash(hash, &len, sizeof(len));
+    return NsCacheHash(hash, data, len);
+}
+
+static uint64_t NsCacheHashInfo(uint64_t hash, const AppSpawningCtx *property)
+{
+    AppSpawnMsgBundleInfo *bundleInfo = (AppSpawnMsgBundleInfo *)GetAppProperty(property, TLV_BUNDLE_INFO);
+    if (bundleInfo != NULL) {
+        hash = NsCacheHash(hash, &bundleInfo->bundleIndex, sizeof(bundleInfo->bundleIndex));
+    }
+    AppSpawnMsgDomainInfo *domainInfo = (AppSpawnMsgDomainInfo *)GetAppProperty(property, TLV_DOMAIN_INFO);
+    if (domainInfo != NULL) {
+        hash = NsCacheHash(hash, &domainInfo->hapFlags, sizeof(domainInfo->hapFlags));
+        hash = NsCacheHash(hash, domainInfo->apl, strlen(domainInfo->apl));
+    }
+    AppSpawnMsgDacInfo *dacInfo = (AppSpawnMsgDacInfo *)GetAppProperty(property, TLV_DAC_INFO);
+    hash = NsCacheHash(hash, dacInfo, sizeof(AppSpawnMsgDacInfo));
+    hash = NsCacheHashExt(hash, property, MSG_EXT_NAME_APP_EXTENSION);
+    return NsCacheHashExt(hash, property, MSG_EXT_NAME_ACCOUNT_ID);
+}
+
+static uint64_t NsCacheHashUnlockStatus(uint64_t hash, const char *bundleName, uid_t uid)
+{
+    // el2未解锁时沙盒中挂载的是共享的占位目录，解锁前后的挂载结构不同
+    char path[NS_CACHE_UNLOCK_PATH_LEN] = {0};
+    int len = sprintf_s(path, sizeof(path), "/data/app/el2/%u/base/%s", uid / UID_BASE, bundleName);
+    uint8_t unlock = (uid / UID_BASE == 0 || (len > 0 && access(path, F_OK) == 0)) ? 1 : 0;
+    return NsCacheHash(hash, &unlock, sizeof(unlock));
+}
+
+static uint32_t GetNsCacheParameter(const char *name, uint32_t def)
+{
+    char tmp[NS_CACHE_PARAM_LEN] = {0};
+    int ret = GetParameter(name, "", tmp, sizeof(tmp));
+    if (ret <= 0) {
+        return def;
+    }
+    if (strcmp(tmp, "true") == 0) {
+        return 1;
+    }
+    if (strcmp(tmp, "false") == 0) {
+        return 0;
+    }
+    char *end = NULL;
+    unsigned long value = strtoul(tmp, &end, 10);  // 10 decimal
+    return (end == tmp) ? def : (uint32_t)value;
+}
+
+static int AppSpawnExtDataCompareDataId(ListNode *node, void *data)
+{
+    AppSpawnExtData *extData = (AppSpawnExtData *)ListEntry(node, AppSpawnExtData, node);
+    return extData->dataId - *(uint32_t *)data;
+}
+
+static SandboxNsCache *GetSandboxNsCache(const AppSpawnMgr *content)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(content != NULL, return NULL);
+    uint32_t dataId = EXT_DATA_NS_CACHE;
+    ListNode *node = OH_ListFind(&content->extData, (void *)&dataId, AppSpawnExtDataCompareDataId);
+    if (node == NULL) {
+        return NULL;
+    }
+    return (SandboxNsCache *)ListEntry(node, SandboxNsCache, extData);
+}
+
+static void DeleteNsCacheNode(SandboxNsCache *cache, SandboxNsCacheNode *node)
+{
+    OH_ListRemove(&node->node);
+    OH_ListInit(&node->node);
+    cache->count--;
+    cache->mountCount -= node->mountCount;
+    if (node->nsFd >= 0) {
+        close(node->nsFd);
+    }
+    free(node);
+}
+
+static void FreeSandboxNsCache(struct TagAppSpawnExtData *data)
+{
+    SandboxNsCache *cache = ListEntry(data, SandboxNsCache, extData);
+    APPSPAWN_CHECK_ONLY_EXPER(cache != NULL, return);
+    while (!ListEmpty(cache->lruQueue)) {
+        DeleteNsCacheNode(cache, ListEntry(cache->lruQueue.next, SandboxNsCacheNode, node));
+    }
+    OH_ListRemove(&cache->extData.node);
+    free(cache);
+}
+
+static void DumpSandboxNsCache(struct TagAppSpawnExtData *data)
+{
+    SandboxNsCache *cache = ListEntry(data, SandboxNsCache, extData);
+    uint32_t rate = cache->lookups == 0 ? 0 : cache->hits * 100 / cache->lookups;  // 100 percent
+    APPSPAPWN_DUMP("Sandbox ns cache entry: %{public}u/%{public}u mount: %{public}u/%{public}u",
+        cache->count, cache->maxCount, cache->mountCount, cache->maxMountCount);
+    APPSPAPWN_DUMP("Sandbox ns cache lookup: %{public}u hit: %{public}u rate: %{public}u%% "
+        "invalidation: %{public}u eviction: %{public}u",
+        cache->lookups, cache->hits, rate, cache->invalidations, cache->evictions);
+    ListNode *node = cache->lruQueue.next;
+    while (node != &cache->lruQueue) {
+        SandboxNsCacheNode *entry = ListEntry(node, SandboxNsCacheNode, node);
+        APPSPAPWN_DUMP("    bundle: %{public}s uid: %{public}u mount: %{public}u hits: %{public}u",
+            entry->bundleName, entry->uid, entry->mountCount, entry->hits);
+        node = node->next;
+    }
+}
+
+static bool IsNsCacheEligible(const AppSpawnMgr *content, const AppSpawningCtx *property)
+{
+    if (CheckAppMsgFlagsSet(property, APP_FLAGS_NO_SANDBOX) ||
+        CheckAppMsgFlagsSet(property, APP_FLAGS_IGNORE_SANDBOX)) {
+        return false;
+    }
+    // 独立pid命名空间中/proc属于孵化时的命名空间，不能复用
+    if ((content->content.sandboxNsFlags & CLONE_NEWPID) == CLONE_NEWPID) {
+        return false;
+    }
+    return GetBundleName(property) != NULL && GetAppProperty(property, TLV_DAC_INFO) != NULL;
+}
+
+static void GetNsCacheKey(const AppSpawningCtx *property, uint64_t *keyHash, uint64_t *contentHash)
+{
+    const char *processName = GetProcessName(property);
+    uint64_t hash = NsCacheHash(FNV_OFFSET_BASIS, processName, strlen(processName));
+    hash = NsCacheHashTlv(hash, property, TLV_MSG_FLAGS);
+    hash = NsCacheHashTlv(hash, property, TLV_PERMISSION);
+    hash = NsCacheHashInfo(hash, property);
+    AppSpawnMsgDacInfo *dacInfo = (AppSpawnMsgDacInfo *)GetAppProperty(property, TLV_DAC_INFO);
+    *keyHash = NsCacheHashUnlockStatus(hash, GetBundleName(property), dacInfo->uid);
+
+    hash = NsCacheHashExt(FNV_OFFSET_BASIS, property, MSG_EXT_NAME_HSP_LIST);
+    hash = NsCacheHashExt(hash, property, MSG_EXT_NAME_DATA_GROUP);
+    *contentHash = NsCacheHashExt(hash, property, MSG_EXT_NAME_OVERLAY);
+}
+
+static SandboxNsCacheNode *FindNsCacheNode(const SandboxNsCache *cache,
+    const char *bundleName, uid_t uid, uint64_t keyHash)
+{
+    ListNode *node = cache->lruQueue.next;
+    while (node != &cache->lruQueue) {
+        SandboxNsCacheNode *entry = ListEntry(node, SandboxNsCacheNode, node);
+        if (entry->uid == uid && entry->keyHash == keyHash && strcmp(entry->bundleName, bundleName) == 0) {
+            return entry;
+        }
+        node = node->next;
+    }
+    return NULL;
+}
+
+APPSPAWN_STATIC int SandboxNsCacheInit(AppSpawnMgr *content)
+{
+    if (GetNsCacheParameter(NS_CACHE_ENABLE_PARAM, 0) == 0) {
+        return 0;
+    }
+    APPSPAWN_CHECK(GetSandboxNsCache(content) == NULL, return 0, "Sandbox ns cache has been init");
+    SandboxNsCache *cache = (SandboxNsCache *)calloc(1, sizeof(SandboxNsCache));
+    APPSPAWN_CHECK(cache != NULL, return APPSPAWN_SYSTEM_ERROR, "Failed to create sandbox ns cache");
+    OH_ListInit(&cache->extData.node);
+    cache->extData.dataId = EXT_DATA_NS_CACHE;
+    cache->extData.freeNode = FreeSandboxNsCache;
+    cache->extData.dumpNode = DumpSandboxNsCache;
+    OH_ListInit(&cache->lruQueue);
+    cache->maxCount = GetNsCacheParameter(NS_CACHE_MAX_ENTRY_PARAM, NS_CACHE_DEFAULT_MAX_ENTRY);
+    cache->maxMountCount = GetNsCacheParameter(NS_CACHE_MAX_MOUNT_PARAM, NS_CACHE_DEFAULT_MAX_MOUNT);
+    OH_ListAddTail(&content->extData, &cache->extData.node);
+    APPSPAWN_LOGI("Sandbox ns cache enable max entry: %{public}u max mount: %{public}u",
+        cache->maxCount, cache->maxMountCount);
+    return 0;
+}
+
+APPSPAWN_STATIC int SandboxNsCacheCheck(AppSpawnMgr *content, AppSpawningCtx *property)
+{
+    SandboxNsCache *cache = GetSandboxNsCache(content);
+    if (cache == NULL || !IsNsCacheEligible(content, property)) {
+        return 0;
+    }
+    uint64_t keyHash = 0;
+    uint64_t contentHash = 0;
+    GetNsCacheKey(property, &keyHash, &contentHash);
+    AppSpawnMsgDacInfo *dacInfo = (AppSpawnMsgDacInfo *)GetAppProperty(property, TLV_DAC_INFO);
+    cache->lookups++;
+    SandboxNsCacheNode *entry = FindNsCacheNode(cache, GetBundleName(property), dacInfo->uid, keyHash);
+    if (entry == NULL) {
+        return 0;
+    }
+    // HspList/DataGroup/Overlay 变化或沙盒挂载点更新后沙盒内容不同，缓存失效
+    if (entry->contentHash != contentHash || entry->generation != content->sandboxGeneration) {
+        APPSPAWN_LOGI("Sandbox ns cache invalid %{public}s uid: %{public}u", entry->bundleName, entry->uid);
+        cache->invalidations++;
+        DeleteNsCacheNode(cache, entry);
+        return 0;
+    }
+    cache->hits++;
+    entry->hits++;
+    OH_ListRemove(&entry->node);
+    OH_ListInit(&entry->node);
+    OH_ListAddTail(&cache->lruQueue, &entry->node);
+    APPSPAWN_LOGV("Sandbox ns cache hit %{public}s uid: %{public}u", entry->bundleName, entry->uid);
+    return 0;
+}
+
+static uint64_t NsCacheHashMountInfo(uint64_t hash, char *line)
+{
+    // 36 35 98:0 /mnt1 /mnt2 rw,noatime master:1 - ext3 /dev/root rw
+    char *save = NULL;
+    uint32_t index = 0;
+    uint32_t sourceIndex = 0;
+    for (char *field = strtok_r(line, " \n", &save); field != NULL; field = strtok_r(NULL, " \n", &save)) {
+        if (sourceIndex > 0 || strcmp(field, "-") == 0) {
+            if (++sourceIndex == MOUNTINFO_SOURCE_INDEX + 1) {
+                return NsCacheHash(hash, field, strlen(field) + 1);
+            }
+            continue;
+        }
+        if (index == MOUNTINFO_ID_INDEX || index == MOUNTINFO_ROOT_INDEX || index == MOUNTINFO_TARGET_INDEX) {
+            hash = NsCacheHash(hash, field, strlen(field) + 1);
+        }
+        index++;
+    }
+    return hash;
+}
+
+uint32_t GetSandboxNsMountInfo(pid_t pid, uint64_t *digest)
+{
+    char path[NS_CACHE_PATH_LEN] = {0};
+    int len = (pid == 0) ? sprintf_s(path, sizeof(path), "/proc/self/mountinfo") :
+        sprintf_s(path, sizeof(path), "/proc/%d/mountinfo", pid);
+    APPSPAWN_CHECK(len > 0, return 0, "Failed to format mountinfo path %{public}d", pid);
+    FILE *fp = fopen(path, "r");
+    APPSPAWN_CHECK(fp != NULL, return 0, "Failed to open %{public}s errno: %{public}d", path, errno);
+    // 只比较行数时，卸载一个再挂载另一个无法发现
+    uint64_t hash = FNV_OFFSET_BASIS;
+    uint32_t count = 0;
+    char *line = NULL;
+    size_t size = 0;
+    while (getline(&line, &size, fp) > 0) {
+        hash = NsCacheHashMountInfo(hash, line);
+        count++;
+    }
+    free(line);
+    (void)fclose(fp);
+    if (digest != NULL) {
+        *digest = hash;
+    }
+    return count;
+}
+
+static void EvictNsCacheNode(SandboxNsCache *cache, uint32_t mountCount)
+{
+    while (!ListEmpty(cache->lruQueue) &&
+        (cache->count >= cache->maxCount || cache->mountCount + mountCount > cache->maxMountCount)) {
+        SandboxNsCacheNode *entry = ListEntry(cache->lruQueue.next, SandboxNsCacheNode, node);
+        APPSPAWN_LOGV("Sandbox ns cache evict %{public}s uid: %{public}u", entry->bundleName, entry->uid);
+        cache->evictions++;
+        DeleteNsCacheNode(cache, entry);
+    }
+}
+
+static bool IsSameNs(int nsFd, int otherFd)
+{
+    struct stat nsStat = {};
+    struct stat otherStat = {};
+    if (fstat(nsFd, &nsStat) != 0 || fstat(otherFd, &otherStat) != 0) {
+        return false;
+    }
+    return nsStat.st_dev == otherStat.st_dev && nsStat.st_ino == otherStat.st_ino;
+}
+
+APPSPAWN_STATIC int SandboxNsCacheAdd(AppSpawnMgr *content, AppSpawningCtx *property)
+{
+    SandboxNsCache *cache = GetSandboxNsCache(content);
+    if (cache == NULL || cache->maxCount == 0 || property->pid <= 0 || !IsNsCacheEligible(content, property)) {
+        return 0;
+    }
+    uint64_t keyHash = 0;
+    uint64_t contentHash = 0;
+    GetNsCacheKey(property, &keyHash, &contentHash);
+    AppSpawnMsgDacInfo *dacInfo = (AppSpawnMsgDacInfo *)GetAppProperty(property, TLV_DAC_INFO);
+    const char *bundleName = GetBundleName(property);
+    char path[NS_CACHE_PATH_LEN] = {0};
+    int len = sprintf_s(path, sizeof(path), "/proc/%d/ns/mnt", property->pid);
+    APPSPAWN_CHECK(len > 0, return 0, "Failed to format ns path %{public}d", property->pid);
+    int nsFd = open(path, O_RDONLY | O_CLOEXEC);
+    APPSPAWN_CHECK(nsFd >= 0, return 0, "Failed to open %{public}s errno: %{public}d", path, errno);
+
+    SandboxNsCacheNode *old = FindNsCacheNode(cache, bundleName, dacInfo->uid, keyHash);
+    if (old != NULL && IsSameNs(old->nsFd, nsFd)) {
+        // 新实例进入了缓存的命名空间，退出前不能再被其他实例进入
+        old->holderPid = property->pid;
+        close(nsFd);
+        return 0;
+    }
+    if (old != NULL) {
+        // 子进程校验缓存失败后重新创建了沙盒，使用新的命名空间替换
+        APPSPAWN_LOGI("Sandbox ns cache replace %{public}s uid: %{public}u", old->bundleName, old->uid);
+        cache->invalidations++;
+        DeleteNsCacheNode(cache, old);
+    }
+    uint64_t mountDigest = 0;
+    uint32_t mountCount = GetSandboxNsMountInfo(property->pid, &mountDigest);
+    APPSPAWN_CHECK(mountCount > 0 && mountCount <= cache->maxMountCount, close(nsFd);
+        return 0, "Skip sandbox ns cache %{public}s mount: %{public}u", bundleName, mountCount);
+
+    size_t nameLen = strlen(bundleName) + 1;
+    SandboxNsCacheNode *entry = (SandboxNsCacheNode *)calloc(1, sizeof(SandboxNsCacheNode) + nameLen);
+    APPSPAWN_CHECK(entry != NULL, close(nsFd);
+        return 0, "Failed to create sandbox ns cache node %{public}s", bundleName);
+    int ret = strcpy_s(entry->bundleName, nameLen, bundleName);
+    APPSPAWN_CHECK(ret == 0, close(nsFd);
+        free(entry);
+        return 0, "Failed to copy bundle name %{public}s", bundleName);
+    OH_ListInit(&entry->node);
+    entry->uid = dacInfo->uid;
+    entry->nsFd = nsFd;
+    entry->keyHash = keyHash;
+    entry->contentHash = contentHash;
+    entry->generation = content->sandboxGeneration;
+    entry->mountCount = mountCount;
+    entry->mountDigest = mountDigest;
+    entry->holderPid = property->pid;
+
+    EvictNsCacheNode(cache, mountCount);
+    OH_ListAddTail(&cache->lruQueue, &entry->node);
+    cache->count++;
+    cache->mountCount += mountCount;
+    APPSPAWN_LOGI("Sandbox ns cache add %{public}s uid: %{public}u mount: %{public}u",
+        bundleName, entry->uid, mountCount);
+    return 0;
+}
+
+int GetSandboxNsCacheFd(const AppSpawnMgr *content, const AppSpawningCtx *property, uint64_t *mountDigest)
+{
+    SandboxNsCache *cache = GetSandboxNsCache(content);
+    if (cache == NULL || mountDigest == NULL || !IsNsCacheEligible(content, property)) {
+        return -1;
+    }
+    uint64_t keyHash = 0;
+    uint64_t contentHash = 0;
+    GetNsCacheKey(property, &keyHash, &contentHash);
+    AppSpawnMsgDacInfo *dacInfo = (AppSpawnMsgDacInfo *)GetAppProperty(property, TLV_DAC_INFO);
+    SandboxNsCacheNode *entry = FindNsCacheNode(cache, GetBundleName(property), dacInfo->uid, keyHash);
+    if (entry == NULL || entry->contentHash != contentHash || entry->generation != content->sandboxGeneration) {
+        return -1;
+    }
+    // 使用该命名空间的应用仍在运行时，其挂载变化会影响新实例，不能进入
+    if (entry->holderPid > 0 && GetSpawnedProcess(entry->holderPid) != NULL) {
+        APPSPAWN_LOGV("Sandbox ns cache %{public}s in use by %{public}d", entry->bundleName, entry->holderPid);
+        return -1;
+    }
+    *mountDigest = entry->mountDigest;
+    // 预fork的子进程可能没有继承到后续打开的fd
+    return fcntl(entry->nsFd, F_GETFD) < 0 ? -1 : entry->nsFd;
+}
+
+void CloseSandboxNsCache(const AppSpawnMgr *content)
+{
+    SandboxNsCache *cache = GetSandboxNsCache(content);
+    APPSPAWN_CHECK_ONLY_EXPER(cache != NULL, return);
+    ListNode *node = cache->lruQueue.next;
+    while (node != &cache->lruQueue) {
+        SandboxNsCacheNode *entry = ListEntry(node, SandboxNsCacheNode, node);
+        if (entry->nsFd >= 0) {
+            close(entry->nsFd);
+            entry->nsFd = -1;
+        }
+        node = node->next;
+    }
+}
+
+#ifdef APPSPAWN_SANDBOX_NEW
+MODULE_CONSTRUCTOR(void)
+{
+    (void)AddServerStageHook(STAGE_SERVER_PRELOAD, HOOK_PRIO_SANDBOX, SandboxNsCacheInit);
+    (void)AddAppSpawnHook(STAGE_PARENT_PRE_FORK, HOOK_PRIO_SANDBOX + 1, SandboxNsCacheCheck);
+    (void)AddAppSpawnHook(STAGE_PARENT_PRE_RELY, HOOK_PRIO_SANDBOX, SandboxNsCacheAdd);
+}
+#endif
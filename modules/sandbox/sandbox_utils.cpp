@@ -38,6 +38,7 @@
 #include "init_param.h"
 #include "parameter.h"
 #include "parameters.h"
+#include "sandbox_ext_list.h"
 #include "securec.h"
 
 #ifdef WITH_SELINUX
@@ -1212,9 +1213,42 @@ std::string SandboxUtils::GetExtraInfoByType(const AppSpawningCtx *appProperty,
     return std::string(info, len);
 }
 
+int32_t SandboxUtils::MountHspItem(const std::string &libBundleName, const std::string &libModuleName,
+    const std::string &libVersion, const std::string &sandboxPackagePath)
+{
+    APPSPAWN_CHECK(CheckPath(libBundleName) && CheckPath(libModuleName) && CheckPath(libVersion),
+        return -1, "MountAllHsp: path error");
+
+    std::string libPhysicalPath = g_physicalAppInstallPath + libBundleName + "/" + libVersion + "/" + libModuleName;
+    std::string mntPath =  sandboxPackagePath + g_sandboxHspInstallPath + libBundleName + "/" + libModuleName;
+    int ret = DoAppSandboxMountOnce(libPhysicalPath.c_str(), mntPath.c_str(), "", BASIC_MOUNT_FLAGS, nullptr);
+    APPSPAWN_CHECK(ret == 0, return ret, "mount library failed %{public}d", ret);
+    return 0;
+}
+
 int32_t SandboxUtils::MountAllHsp(const AppSpawningCtx *appProperty, std::string &sandboxPackagePath)
 {
-    int ret = 0;
+    uint32_t size = 0;
+    ExtListReader reader = {};
+    const uint8_t *extInfo = static_cast<const uint8_t *>(
+        GetAppPropertyExt(appProperty, HSPLIST_SOCKET_TYPE.c_str(), &size));
+    int ret = GetExtListReader(extInfo, size, EXT_LIST_HSP, &reader);
+    if (ret == 0) {
+        APPSPAWN_LOGI("MountAllHsp: app = %{public}s, cnt = %{public}u", GetBundleName(appProperty), reader.count);
+        for (uint32_t i = 0; i < reader.count; i++) {
+            const char *libBundleName = ReadExtListString(&reader);
+            const char *libModuleName = ReadExtListString(&reader);
+            const char *libVersion = ReadExtListString(&reader);
+            APPSPAWN_CHECK(libBundleName != nullptr && libModuleName != nullptr && libVersion != nullptr,
+                return APPSPAWN_MSG_INVALID, "MountAllHsp: invalid hsp list at %{public}u", i);
+            ret = MountHspItem(libBundleName, libModuleName, libVersion, sandboxPackagePath);
+            APPSPAWN_CHECK_ONLY_EXPER(ret == 0, return ret);
+        }
+        return 0;
+    }
+    APPSPAWN_CHECK_ONLY_EXPER(ret == EXT_LIST_NOT_BINARY, return ret);
+
+    ret = 0;
     string hspListInfo = GetExtraInfoByType(appProperty, HSPLIST_SOCKET_TYPE);
     if (hspListInfo.length() == 0) {
         return ret;
@@ -1240,13 +1274,8 @@ int32_t SandboxUtils::MountAllHsp(const AppSpawningCtx *appProperty, std::string
         std::string libBundleName = bundles[i];
         std::string libModuleName = modules[i];
         std::string libVersion = versions[i];
-        APPSPAWN_CHECK(CheckPath(libBundleName) && CheckPath(libModuleName) && CheckPath(libVersion),
-            return -1, "MountAllHsp: path error");
-
-        std::string libPhysicalPath = g_physicalAppInstallPath + libBundleName + "/" + libVersion + "/" + libModuleName;
-        std::string mntPath =  sandboxPackagePath + g_sandboxHspInstallPath + libBundleName + "/" + libModuleName;
-        ret = DoAppSandboxMountOnce(libPhysicalPath.c_str(), mntPath.c_str(), "", BASIC_MOUNT_FLAGS, nullptr);
-        APPSPAWN_CHECK(ret == 0, return ret, "mount library failed %{public}d", ret);
+        ret = MountHspItem(libBundleName, libModuleName, libVersion, sandboxPackagePath);
+        APPSPAWN_CHECK_ONLY_EXPER(ret == 0, return ret);
     }
     return ret;
 }
@@ -1268,9 +1297,51 @@ int32_t SandboxUtils::DoSandboxRootFolderCreateAdapt(std::string &sandboxPackage
     return 0;
 }
 
+int32_t SandboxUtils::MountGroupItem(const AppSpawningCtx *appProperty, const std::string &libPhysicalPath,
+    const std::string &sandboxPackagePath)
+{
+    APPSPAWN_CHECK(!CheckPath(libPhysicalPath), return -1, "MountAllGroup: path error");
+
+    size_t lastPathSplitPos = libPhysicalPath.find_last_of(g_fileSeparator);
+    APPSPAWN_CHECK(lastPathSplitPos != std::string::npos, return -1, "MountAllGroup: path error");
+
+    std::string dataGroupUuid = libPhysicalPath.substr(lastPathSplitPos + 1);
+    std::string mntPath = sandboxPackagePath + g_sandboxGroupPath + dataGroupUuid;
+    mode_t mountFlags = MS_REC | MS_BIND;
+    mode_t mountSharedFlag = MS_SLAVE;
+    if (CheckAppMsgFlagsSet(appProperty, APP_FLAGS_ISOLATED_SANDBOX)) {
+        mountSharedFlag |= MS_REMOUNT | MS_NODEV | MS_RDONLY | MS_BIND;
+    }
+    int ret = DoAppSandboxMountOnce(libPhysicalPath.c_str(), mntPath.c_str(), "", mountFlags, nullptr,
+        mountSharedFlag);
+    APPSPAWN_CHECK(ret == 0, return ret, "mount library failed %{public}d", ret);
+    return 0;
+}
+
 int32_t SandboxUtils::MountAllGroup(const AppSpawningCtx *appProperty, std::string &sandboxPackagePath)
 {
-    int ret = 0;
+    uint32_t size = 0;
+    ExtListReader reader = {};
+    const uint8_t *extInfo = static_cast<const uint8_t *>(
+        GetAppPropertyExt(appProperty, DATA_GROUP_SOCKET_TYPE.c_str(), &size));
+    int ret = GetExtListReader(extInfo, size, EXT_LIST_DATA_GROUP, &reader);
+    if (ret == 0) {
+        APPSPAWN_LOGI("MountAllGroup: app = %{public}s, cnt = %{public}u", GetBundleName(appProperty), reader.count);
+        for (uint32_t i = 0; i < reader.count; i++) {
+            uint32_t gid = 0;
+            const char *dataGroupId = ReadExtListString(&reader);
+            ret = ReadExtListUint32(&reader, &gid);
+            const char *libPhysicalPath = ReadExtListString(&reader);
+            APPSPAWN_CHECK(dataGroupId != nullptr && ret == 0 && libPhysicalPath != nullptr,
+                return APPSPAWN_MSG_INVALID, "MountAllGroup: invalid data group list at %{public}u", i);
+            ret = MountGroupItem(appProperty, libPhysicalPath, sandboxPackagePath);
+            APPSPAWN_CHECK_ONLY_EXPER(ret == 0, return ret);
+        }
+        return 0;
+    }
+    APPSPAWN_CHECK_ONLY_EXPER(ret == EXT_LIST_NOT_BINARY, return ret);
+
+    ret = 0;
     string dataGroupInfo = GetExtraInfoByType(appProperty, DATA_GROUP_SOCKET_TYPE);
     if (dataGroupInfo.length() == 0) {
         return ret;
@@ -1294,21 +1365,8 @@ int32_t SandboxUtils::MountAllGroup(const AppSpawningCtx *appProperty, std::stri
             return -1, "MountAllGroup: element type error");
 
         std::string libPhysicalPath = dirs[i];
-        APPSPAWN_CHECK(!CheckPath(libPhysicalPath), return -1, "MountAllGroup: path error");
-
-        size_t lastPathSplitPos = libPhysicalPath.find_last_of(g_fileSeparator);
-        APPSPAWN_CHECK(lastPathSplitPos != std::string::npos, return -1, "MountAllGroup: path error");
-
-        std::string dataGroupUuid = libPhysicalPath.substr(lastPathSplitPos + 1);
-        std::string mntPath = sandboxPackagePath + g_sandboxGroupPath + dataGroupUuid;
-        mode_t mountFlags = MS_REC | MS_BIND;
-        mode_t mountSharedFlag = MS_SLAVE;
-        if (CheckAppMsgFlagsSet(appProperty, APP_FLAGS_ISOLATED_SANDBOX)) {
-            mountSharedFlag |= MS_REMOUNT | MS_NODEV | MS_RDONLY | MS_BIND;
-        }
-        ret = DoAppSandboxMountOnce(libPhysicalPath.c_str(), mntPath.c_str(), "", mountFlags, nullptr,
-            mountSharedFlag);
-        APPSPAWN_CHECK(ret == 0, return ret, "mount library failed %{public}d", ret);
+        ret = MountGroupItem(appProperty, libPhysicalPath, sandboxPackagePath);
+        APPSPAWN_CHECK_ONLY_EXPER(ret == 0, return ret);
     }
     return ret;
 }
@@ -1439,9 +1497,25 @@ int32_t SandboxUtils::SetOverlayAppSandboxProperty(const AppSpawningCtx *appProp
         return ret;
     }
 
-    string overlayInfo = GetExtraInfoByType(appProperty, OVERLAY_SOCKET_TYPE);
+    vector<string> splits;
+    uint32_t size = 0;
+    ExtListReader reader = {};
+    const uint8_t *extInfo = static_cast<const uint8_t *>(
+        GetAppPropertyExt(appProperty, OVERLAY_SOCKET_TYPE.c_str(), &size));
+    ret = GetExtListReader(extInfo, size, EXT_LIST_OVERLAY, &reader);
+    if (ret == 0) {
+        for (uint32_t i = 0; i < reader.count; i++) {
+            const char *hapPath = ReadExtListString(&reader);
+            APPSPAWN_CHECK(hapPath != nullptr, return APPSPAWN_MSG_INVALID, "Invalid overlay list at %{public}u", i);
+            splits.emplace_back(hapPath);
+        }
+    } else {
+        APPSPAWN_CHECK_ONLY_EXPER(ret == EXT_LIST_NOT_BINARY, return ret);
+        ret = 0;
+        string overlayInfo = GetExtraInfoByType(appProperty, OVERLAY_SOCKET_TYPE);
+        splits = split(overlayInfo, g_overlayDecollator);
+    }
     set<string> mountedSrcSet;
-    vector<string> splits = split(overlayInfo, g_overlayDecollator);
     string sandboxOverlayPath = sandboxPackagePath + g_overlayPath;
     for (auto hapPath : splits) {
         size_t pathIndex = hapPath.find_last_of(g_fileSeparator);
@@ -72,6 +72,10 @@ private:
                                                       std::string &sandboxPackagePath);
     static int32_t MountAllHsp(const AppSpawningCtx *appProperty, std::string &sandboxPackagePath);
     static int32_t MountAllGroup(const AppSpawningCtx *appProperty, std::string &sandboxPackagePath);
+    static int32_t MountHspItem(const std::string &libBundleName, const std::string &libModuleName,
+                                const std::string &libVersion, const std::string &sandboxPackagePath);
+    static int32_t MountGroupItem(const AppSpawningCtx *appProperty, const std::string &libPhysicalPath,
+                                  const std::string &sandboxPackagePath);
     static int32_t DoSandboxRootFolderCreateAdapt(std::string &sandboxPackagePath);
     static int32_t DoSandboxRootFolderCreate(const AppSpawningCtx *appProperty,
                                              std::string &sandboxPackagePath);
@@ -49,7 +49,11 @@ extern "C" {
 
 #define HNP_CFG_FILE_NAME "hnp.json"
 #define HNP_PACKAGE_INFO_JSON_FILE_PATH "/data/service/el1/startup/hnp_info.json"
+#define HNP_PROC_ROOT_PATH "/proc"
 #define HNP_ELF_FILE_CHECK_HEAD_LEN 4
+#define HNP_TREE_WALK_MAX_THREAD 4
+#define HNP_TREE_WALK_QUEUE_SIZE 64
+#define HNP_ZIP_MAX_JOBS 16
 
 #ifdef _WIN32
 #define DIR_SPLIT_SYMBOL '\\'
@@ -126,6 +130,13 @@ typedef struct HnpSignMapInfoStru {
     char value[MAX_FILE_PATH_LEN];
 } HnpSignMapInfo;
 
+/* 压缩参数 */
+typedef struct HnpZipParamStru {
+    int level;              // 压缩级别，0-9
+    int jobs;               // 压缩线程数
+    bool reproducible;      // 是否生成可复现的压缩包
+} HnpZipParam;
+
 /* 数字索引 */
 enum {
     HNP_INDEX_0 = 0,
@@ -261,7 +272,7 @@ int ReadFileToStream(const char *filePath, char **stream, int *streamLen);
 
 int GetRealPath(char *srcPath, char *realPath);
 
-int HnpZip(const char *inputDir, zipFile zf);
+int HnpZip(const char *inputDir, zipFile zf, const HnpZipParam *param);
 
 int HnpUnZip(const char *inputFile, const char *outputDir, const char *hnpSignKeyPrefix,
     HnpSignMapInfo *hnpSignMapInfos, int *count);
@@ -276,6 +287,14 @@ int HnpSymlink(const char *srcFile, const char *dstFile);
 
 int HnpProcessRunCheck(const char *runPath);
 
+int HnpProcessInUseCheck(const char *procRoot, const char **prefixes, int count, bool *inUse);
+
+/* 目录树遍历回调，dirFd为name所在目录，遍历根目录时dirFd为AT_FDCWD、parentPath为NULL */
+typedef int (*HnpTreeWalkFunc)(int dirFd, const char *name, const char *parentPath, bool isDir, void *arg);
+
+/* 多线程遍历目录树，postOrder为true时目录在其子项全部处理后回调 */
+int HnpTreeWalk(const char *path, HnpTreeWalkFunc func, void *arg, bool postOrder);
+
 int HnpDeleteFolder(const char *path);
 
 int HnpCreateFolder(const char* path);
@@ -23,6 +23,9 @@
 #include <unistd.h>
 #ifdef _WIN32
 #include <windows.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
 #endif
 
 #include "hnp_base.h"
@@ -129,74 +132,286 @@ int GetRealPath(char *srcPath, char *realPath)
     return 0;
 }
 
-static int HnpDeleteAllFileInPath(const char *path, DIR *dir)
+#ifndef _WIN32
+typedef struct HnpWalkDirStru {
+    struct HnpWalkDirStru *parent;
+    struct HnpWalkDirStru *next;    // 待遍历队列
+    DIR *dir;
+    int pending;                    // 本目录扫描及未完成的子目录数，为0时目录完成
+    const char *name;               // 相对父目录的名称，根目录为完整路径
+    char path[0];
+} HnpWalkDir;
+
+typedef struct HnpTreeWalkCtxStru {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    HnpWalkDir *head;
+    HnpWalkDir *tail;
+    int queued;
+    bool done;
+    bool postOrder;
+    int ret;
+    HnpTreeWalkFunc func;
+    void *arg;
+} HnpTreeWalkCtx;
+
+static void HnpTreeWalkSetResult(HnpTreeWalkCtx *ctx, int ret)
+{
+    pthread_mutex_lock(&ctx->mutex);
+    if (ctx->ret == 0) {
+        ctx->ret = ret;
+    }
+    pthread_mutex_unlock(&ctx->mutex);
+}
+
+static bool HnpTreeWalkFailed(HnpTreeWalkCtx *ctx)
+{
+    pthread_mutex_lock(&ctx->mutex);
+    bool failed = ctx->ret != 0;
+    pthread_mutex_unlock(&ctx->mutex);
+    return failed;
+}
+
+static void HnpTreeWalkCallback(HnpTreeWalkCtx *ctx, const HnpWalkDir *parent, const char *name, bool isDir)
+{
+    if (HnpTreeWalkFailed(ctx)) {
+        return;
+    }
+    int ret = (parent == NULL) ? ctx->func(AT_FDCWD, name, NULL, isDir, ctx->arg) :
+        ctx->func(dirfd(parent->dir), name, parent->path, isDir, ctx->arg);
+    if (ret != 0) {
+        HnpTreeWalkSetResult(ctx, ret);
+    }
+}
+
+static HnpWalkDir *HnpWalkDirCreate(HnpWalkDir *parent, const char *name)
+{
+    const char *parentPath = (parent == NULL) ? "" : parent->path;
+    size_t parentLen = strlen(parentPath);
+    size_t len = parentLen + strlen(name) + 2; // 2: '/' and '\0'
+    if (len > MAX_FILE_PATH_LEN) {
+        HNP_LOGE("tree walk path over max len, parent=%{public}s, name=%{public}s", parentPath, name);
+        return NULL;
+    }
+    HnpWalkDir *node = (HnpWalkDir *)calloc(1, sizeof(HnpWalkDir) + len);
+    if (node == NULL) {
+        HNP_LOGE("tree walk malloc unsuccess, name=%{public}s", name);
+        return NULL;
+    }
+    int ret = (parent == NULL) ? sprintf_s(node->path, len, "%s", name) :
+        sprintf_s(node->path, len, "%s/%s", parentPath, name);
+    if (ret < 0) {
+        HNP_LOGE("tree walk sprintf unsuccess, name=%{public}s", name);
+        free(node);
+        return NULL;
+    }
+    int fd = (parent == NULL) ? open(name, O_RDONLY | O_DIRECTORY | O_CLOEXEC) :
+        openat(dirfd(parent->dir), name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0 || (node->dir = fdopendir(fd)) == NULL) {
+        HNP_LOGE("tree walk open dir=%{public}s unsuccess, errno=%{public}d", node->path, errno);
+        if (fd >= 0) {
+            close(fd);
+        }
+        free(node);
+        return NULL;
+    }
+    node->parent = parent;
+    node->pending = 1;
+    node->name = (parent == NULL) ? node->path : node->path + parentLen + 1;
+    return node;
+}
+
+/* 目录及其所有子项处理完成后回调并释放，逐级通知父目录 */
+static void HnpWalkDirDone(HnpTreeWalkCtx *ctx, HnpWalkDir *node)
+{
+    while (node != NULL) {
+        pthread_mutex_lock(&ctx->mutex);
+        bool finished = (--node->pending == 0);
+        pthread_mutex_unlock(&ctx->mutex);
+        if (!finished) {
+            return;
+        }
+        HnpWalkDir *parent = node->parent;
+        closedir(node->dir);
+        if (ctx->postOrder) {
+            HnpTreeWalkCallback(ctx, parent, node->name, true);
+        }
+        free(node);
+        if (parent == NULL) {
+            pthread_mutex_lock(&ctx->mutex);
+            ctx->done = true;
+            pthread_cond_broadcast(&ctx->cond);
+            pthread_mutex_unlock(&ctx->mutex);
+        }
+        node = parent;
+    }
+}
+
+static bool HnpWalkEntryIsDir(int dirFd, const struct dirent *entry)
+{
+    if (entry->d_type != DT_UNKNOWN) {
+        return entry->d_type == DT_DIR;
+    }
+    struct stat st;
+    if (fstatat(dirFd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        return false; // 如果是已被删除源文件的软链，按文件处理
+    }
+    return S_ISDIR(st.st_mode);
+}
+
+static void HnpWalkDirScan(HnpTreeWalkCtx *ctx, HnpWalkDir *node);
+
+/* 队列已满时在当前线程直接遍历子目录，限制队列及同时打开的目录数量 */
+static void HnpWalkDirPush(HnpTreeWalkCtx *ctx, HnpWalkDir *child)
+{
+    pthread_mutex_lock(&ctx->mutex);
+    child->parent->pending++;
+    if (ctx->queued < HNP_TREE_WALK_QUEUE_SIZE) {
+        if (ctx->tail == NULL) {
+            ctx->head = child;
+        } else {
+            ctx->tail->next = child;
+        }
+        ctx->tail = child;
+        ctx->queued++;
+        pthread_cond_signal(&ctx->cond);
+        pthread_mutex_unlock(&ctx->mutex);
+        return;
+    }
+    pthread_mutex_unlock(&ctx->mutex);
+    HnpWalkDirScan(ctx, child);
+}
+
+static void HnpWalkDirScan(HnpTreeWalkCtx *ctx, HnpWalkDir *node)
 {
-    int ret = 0;
-#ifdef _WIN32
-    return ret;
-#else
     struct dirent *entry;
-    struct stat statbuf;
-    char filePath[MAX_FILE_PATH_LEN];
+    int fd = dirfd(node->dir);
 
-    while ((entry = readdir(dir)) != NULL) {
+    while (!HnpTreeWalkFailed(ctx) && (entry = readdir(node->dir)) != NULL) {
         if ((strcmp(entry->d_name, ".") == 0) || (strcmp(entry->d_name, "..") == 0)) {
             continue;
         }
-
-        ret = sprintf_s(filePath, MAX_FILE_PATH_LEN, "%s/%s", path, entry->d_name);
-        if (ret < 0) {
-            HNP_LOGE("delete folder sprintf path[%{public}s], file[%{public}s] unsuccess.", path, entry->d_name);
-            return HNP_ERRNO_BASE_SPRINTF_FAILED;
+        if (!HnpWalkEntryIsDir(fd, entry)) {
+            HnpTreeWalkCallback(ctx, node, entry->d_name, false);
+            continue;
+        }
+        if (!ctx->postOrder) {
+            HnpTreeWalkCallback(ctx, node, entry->d_name, true);
         }
+        HnpWalkDir *child = HnpWalkDirCreate(node, entry->d_name);
+        if (child == NULL) {
+            HnpTreeWalkSetResult(ctx, HNP_ERRNO_BASE_DIR_OPEN_FAILED);
+            break;
+        }
+        HnpWalkDirPush(ctx, child);
+    }
+    HnpWalkDirDone(ctx, node);
+}
 
-        if (lstat(filePath, &statbuf) < 0) {
-            unlink(filePath); // 如果是已被删除源文件的软链，是获取不到文件信息的，此处作删除处理
+static void *HnpTreeWalkWorker(void *arg)
+{
+    HnpTreeWalkCtx *ctx = (HnpTreeWalkCtx *)arg;
+
+    pthread_mutex_lock(&ctx->mutex);
+    while (!ctx->done) {
+        if (ctx->head == NULL) {
+            pthread_cond_wait(&ctx->cond, &ctx->mutex);
             continue;
         }
+        HnpWalkDir *node = ctx->head;
+        ctx->head = node->next;
+        if (ctx->head == NULL) {
+            ctx->tail = NULL;
+        }
+        ctx->queued--;
+        pthread_mutex_unlock(&ctx->mutex);
+        HnpWalkDirScan(ctx, node);
+        pthread_mutex_lock(&ctx->mutex);
+    }
+    pthread_mutex_unlock(&ctx->mutex);
+    return NULL;
+}
 
-        if (S_ISDIR(statbuf.st_mode)) {
-            /* 如果是文件夹，递归删除 */
-            ret = HnpDeleteFolder(filePath);
-            if (ret != 0) {
-                return ret;
-            }
-        } else {
-            ret = unlink(filePath);
-            if (ret != 0) {
-                HNP_LOGE("delete file unsuccess.ret=%{public}d, path=%{public}s, errno=%{public}d", ret, filePath,
-                    errno);
-                return HNP_ERRNO_BASE_UNLINK_FAILED;
-            }
+static int HnpTreeWalkThreadNum(void)
+{
+    long num = sysconf(_SC_NPROCESSORS_ONLN);
+    if (num <= 1) {
+        return 1;
+    }
+    return (num > HNP_TREE_WALK_MAX_THREAD) ? HNP_TREE_WALK_MAX_THREAD : (int)num;
+}
+
+int HnpTreeWalk(const char *path, HnpTreeWalkFunc func, void *arg, bool postOrder)
+{
+    if (path == NULL || func == NULL) {
+        HNP_LOGE("tree walk params invalid");
+        return HNP_ERRNO_BASE_PARAMS_INVALID;
+    }
+
+    HnpTreeWalkCtx ctx = {0};
+    ctx.postOrder = postOrder;
+    ctx.func = func;
+    ctx.arg = arg;
+    (void)pthread_mutex_init(&ctx.mutex, NULL);
+    (void)pthread_cond_init(&ctx.cond, NULL);
+    if (!postOrder) {
+        HnpTreeWalkCallback(&ctx, NULL, path, true);
+    }
+    HnpWalkDir *root = (ctx.ret == 0) ? HnpWalkDirCreate(NULL, path) : NULL;
+    if (root == NULL) {
+        (void)pthread_cond_destroy(&ctx.cond);
+        (void)pthread_mutex_destroy(&ctx.mutex);
+        return (ctx.ret != 0) ? ctx.ret : HNP_ERRNO_BASE_DIR_OPEN_FAILED;
+    }
+    ctx.head = root;
+    ctx.tail = root;
+    ctx.queued = 1;
+
+    /* 当前线程也参与遍历，线程创建失败时由已有线程完成 */
+    pthread_t threads[HNP_TREE_WALK_MAX_THREAD];
+    int threadNum = 0;
+    int maxThread = HnpTreeWalkThreadNum();
+    for (int i = 1; i < maxThread; i++) {
+        if (pthread_create(&threads[threadNum], NULL, HnpTreeWalkWorker, &ctx) == 0) {
+            threadNum++;
         }
     }
+    (void)HnpTreeWalkWorker(&ctx);
+    for (int i = 0; i < threadNum; i++) {
+        (void)pthread_join(threads[i], NULL);
+    }
+    (void)pthread_cond_destroy(&ctx.cond);
+    (void)pthread_mutex_destroy(&ctx.mutex);
+    return ctx.ret;
+}
 
+static int HnpDeleteEntry(int dirFd, const char *name, const char *parentPath, bool isDir, void *arg)
+{
+    (void)arg;
+    if (unlinkat(dirFd, name, isDir ? AT_REMOVEDIR : 0) != 0 && errno != ENOENT) {
+        HNP_LOGE("delete unsuccess, path=%{public}s/%{public}s, errno=%{public}d", (parentPath == NULL) ? "" :
+            parentPath, name, errno);
+        return HNP_ERRNO_BASE_UNLINK_FAILED;
+    }
     return 0;
-#endif
 }
+#endif
 
 int HnpDeleteFolder(const char *path)
 {
     if (access(path, F_OK) != 0) {
         return 0;
     }
-    DIR *dir = opendir(path);
-    if (dir == NULL) {
-        HNP_LOGE("delete folder open dir=%{public}s unsuccess ", path);
-        return HNP_ERRNO_BASE_DIR_OPEN_FAILED;
-    }
-
-    int ret = HnpDeleteAllFileInPath(path, dir);
-    closedir(dir);
-    if (ret != 0) {
-        return ret;
-    }
-
-    ret = rmdir(path);
+#ifdef _WIN32
+    int ret = rmdir(path);
     if (ret != 0) {
         HNP_LOGE("rmdir path unsuccess.ret=%{public}d, path=%{public}s, errno=%{public}d", ret, path, errno);
     }
     return ret;
+#else
+    /* 子项删除完成后再删除目录 */
+    return HnpTreeWalk(path, HnpDeleteEntry, NULL, true);
+#endif
 }
 
 int HnpCreateFolder(const char* path)
@@ -13,6 +13,9 @@
  * limitations under the License.
  */
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -27,32 +30,159 @@
 extern "C" {
 #endif
 
-int HnpProcessRunCheck(const char *runPath)
+#define PROC_MAPS_PATH_INDEX 5  // maps 第6列为映射文件路径
+
+typedef struct {
+    const char **prefixes;
+    bool *inUse;
+    int count;
+    int found;
+} HnpInUseContext;
+
+static void HnpInUseMatch(HnpInUseContext *ctx, const char *path, pid_t pid, const char *type)
 {
-    char cmdBuffer[BUFFER_SIZE];
-    FILE *cmdOutput;
+    if (path[0] != DIR_SPLIT_SYMBOL) {
+        return;
+    }
+    for (int i = 0; i < ctx->count; i++) {
+        if (ctx->inUse[i]) {
+            continue;
+        }
+        size_t len = strlen(ctx->prefixes[i]);
+        if (strncmp(path, ctx->prefixes[i], len) == 0 && (path[len] == '\0' || path[len] == DIR_SPLIT_SYMBOL)) {
+            HNP_LOGE("hnp path is running now, pid=%{public}d, %{public}s=%{public}s", pid, type, path);
+            ctx->inUse[i] = true;
+            ctx->found++;
+        }
+    }
+}
 
-    HNP_LOGI("runPath[%{public}s] running check", runPath);
+static void HnpInUseCheckLink(HnpInUseContext *ctx, int dirFd, const char *name, pid_t pid)
+{
+    char linkPath[MAX_FILE_PATH_LEN];
+    ssize_t len = readlinkat(dirFd, name, linkPath, sizeof(linkPath) - 1);
+    if (len <= 0) {
+        return;
+    }
+    linkPath[len] = '\0';
+    HnpInUseMatch(ctx, linkPath, pid, name);
+}
 
-    /* 判断进程是否运行 */
-    cmdOutput = popen("lsof", "rb");
-    if (cmdOutput == NULL) {
-        HNP_LOGE("hnp uninstall lsof command unsuccess");
-        return HNP_ERRNO_BASE_FILE_OPEN_FAILED;
+static void HnpInUseCheckMaps(HnpInUseContext *ctx, int pidFd, pid_t pid)
+{
+    int fd = openat(pidFd, "maps", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    FILE *fp = fdopen(fd, "r");
+    if (fp == NULL) {
+        close(fd);
+        return;
+    }
+    char line[MAX_FILE_PATH_LEN + BUFFER_SIZE];
+    while (ctx->found < ctx->count && fgets(line, sizeof(line), fp) != NULL) {
+        // 跳过地址、权限、偏移、设备、inode列
+        char *path = line;
+        for (int i = 0; i < PROC_MAPS_PATH_INDEX && path != NULL; i++) {
+            path = strchr(path, ' ');
+            path = (path == NULL) ? NULL : path + strspn(path, " ");
+        }
+        if (path == NULL) {
+            continue;
+        }
+        path[strcspn(path, "\n")] = '\0';
+        HnpInUseMatch(ctx, path, pid, "maps");
+    }
+    (void)fclose(fp);
+}
+
+static void HnpInUseCheckFds(HnpInUseContext *ctx, int pidFd, pid_t pid)
+{
+    int fdDirFd = openat(pidFd, "fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fdDirFd < 0) {
+        return;
     }
+    DIR *dir = fdopendir(fdDirFd);
+    if (dir == NULL) {
+        close(fdDirFd);
+        return;
+    }
+    struct dirent *entry;
+    while (ctx->found < ctx->count && (entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        HnpInUseCheckLink(ctx, fdDirFd, entry->d_name, pid);
+    }
+    (void)closedir(dir);
+}
 
-    while (fgets(cmdBuffer, sizeof(cmdBuffer), cmdOutput) != NULL) {
-        if (strstr(cmdBuffer, runPath) != NULL) {
-            HNP_LOGE("hnp install path is running now, path[%{public}s]", cmdBuffer);
-            pclose(cmdOutput);
-            return HNP_ERRNO_PROCESS_RUNNING;
+static bool HnpIsPidDir(const char *name)
+{
+    if (*name == '\0') {
+        return false;
+    }
+    for (; *name != '\0'; name++) {
+        if (*name < '0' || *name > '9') {
+            return false;
         }
     }
+    return true;
+}
+
+int HnpProcessInUseCheck(const char *procRoot, const char **prefixes, int count, bool *inUse)
+{
+    if (procRoot == NULL || prefixes == NULL || inUse == NULL || count <= 0) {
+        return HNP_ERRNO_BASE_PARAMS_INVALID;
+    }
+    HnpInUseContext ctx = {prefixes, inUse, count, 0};
+    for (int i = 0; i < count; i++) {
+        inUse[i] = false;
+    }
 
-    pclose(cmdOutput);
+    DIR *procDir = opendir(procRoot);
+    if (procDir == NULL) {
+        HNP_LOGE("hnp run check open %{public}s unsuccess, errno=%{public}d", procRoot, errno);
+        return HNP_ERRNO_BASE_DIR_OPEN_FAILED;
+    }
+    /* 一次遍历所有进程，检查可执行文件、工作目录、映射文件和打开的文件 */
+    int procFd = dirfd(procDir);
+    struct dirent *entry;
+    while (ctx.found < ctx.count && (entry = readdir(procDir)) != NULL) {
+        if (!HnpIsPidDir(entry->d_name)) {
+            continue;
+        }
+        int pidFd = openat(procFd, entry->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (pidFd < 0) {
+            continue;  // 进程已退出
+        }
+        pid_t pid = (pid_t)atoi(entry->d_name);
+        HnpInUseCheckLink(&ctx, pidFd, "exe", pid);
+        HnpInUseCheckLink(&ctx, pidFd, "cwd", pid);
+        if (ctx.found < ctx.count) {
+            HnpInUseCheckMaps(&ctx, pidFd, pid);
+        }
+        if (ctx.found < ctx.count) {
+            HnpInUseCheckFds(&ctx, pidFd, pid);
+        }
+        close(pidFd);
+    }
+    (void)closedir(procDir);
     return 0;
 }
 
+int HnpProcessRunCheck(const char *runPath)
+{
+    HNP_LOGI("runPath[%{public}s] running check", runPath);
+
+    bool inUse = false;
+    int ret = HnpProcessInUseCheck(HNP_PROC_ROOT_PATH, &runPath, 1, &inUse);
+    if (ret != 0) {
+        return ret;
+    }
+    return inUse ? HNP_ERRNO_PROCESS_RUNNING : 0;
+}
+
 APPSPAWN_STATIC void HnpRelPath(const char *fromPath, const char *toPath, char *relPath)
 {
     char *from = strdup(fromPath);
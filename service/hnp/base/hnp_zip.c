@@ -23,7 +23,8 @@
 #include <dirent.h>
 #ifdef _WIN32
 #include <windows.h>
-
+#else
+#include <pthread.h>
 #endif
 
 #include "zlib.h"
@@ -39,6 +40,11 @@ extern "C" {
 #endif
 
 #define ZIP_EXTERNAL_FA_OFFSET 16
+#define HNP_ZIP_ENTRY_INIT_NUM 64
+#define HNP_ZIP_READ_BUFFER_SIZE (64 * 1024)
+#define HNP_ZIP_WINDOW_SIZE 64
+#define HNP_ZIP_FILE_MODE 0644
+#define HNP_ZIP_EXEC_FILE_MODE 0755
 
 // zipOpenNewFileInZip3只识别带‘/’的路径，需要将路径中‘\’转换成‘/’
 static void TransPath(const char *input, char *output)
@@ -68,61 +74,6 @@ static bool TransWidePath(const char *inPath, wchar_t *outPath)
 }
 #endif
 
-// 向zip压缩包中添加文件
-static int ZipAddFile(const char* file, int offset, zipFile zf)
-{
-    int err;
-    char buf[1024];
-    char transPath[MAX_FILE_PATH_LEN];
-    size_t len;
-    FILE *f;
-    zip_fileinfo fileInfo = {0};
-
-#ifdef _WIN32
-    struct _stat buffer = {0};
-    // 使用wchar_t支持处理字符串长度超过260的路径字符串
-    wchar_t wideFullPath[MAX_FILE_PATH_LEN] = {0};
-    if (!TransWidePath(file, wideFullPath)) {
-        return HNP_ERRNO_BASE_STAT_FAILED;
-    }
-    if (_wstat(wideFullPath, &buffer) != 0) {
-        HNP_LOGE("get filefile[%{public}s] stat fail.", file);
-        return HNP_ERRNO_BASE_STAT_FAILED;
-    }
-    buffer.st_mode |= S_IXOTH;
-#else
-    struct stat buffer = {0};
-    if (stat(file, &buffer) != 0) {
-        HNP_LOGE("get filefile[%{public}s] stat fail.", file);
-        return HNP_ERRNO_BASE_STAT_FAILED;
-    }
-#endif
-    fileInfo.external_fa = (buffer.st_mode & 0xFFFF) << ZIP_EXTERNAL_FA_OFFSET;
-    TransPath(file, transPath);
-    err = zipOpenNewFileInZip3(zf, transPath + offset, &fileInfo, NULL, 0, NULL, 0, NULL, Z_DEFLATED,
-        Z_BEST_COMPRESSION, 0, -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY, NULL, 0);
-    if (err != ZIP_OK) {
-        HNP_LOGE("open new file[%{public}s] in zip unsuccess ", file);
-        return HNP_ERRNO_BASE_CREATE_ZIP_FAILED;
-    }
-#ifdef _WIN32
-    f = _wfopen(wideFullPath, L"rb");
-#else
-    f = fopen(file, "rb");
-#endif
-    if (f == NULL) {
-        HNP_LOGE("open file[%{public}s] unsuccess ", file);
-        return HNP_ERRNO_BASE_FILE_OPEN_FAILED;
-    }
-
-    while ((len = fread(buf, 1, sizeof(buf), f)) > 0) {
-        zipWriteInFileInZip(zf, buf, len);
-    }
-    (void)fclose(f);
-    zipCloseFileInZip(zf);
-    return 0;
-}
-
 // 判断是否为目录
 static int IsDirPath(struct dirent *entry, char *fullPath, int *isDir)
 {
@@ -146,30 +97,99 @@ static int IsDirPath(struct dirent *entry, char *fullPath, int *isDir)
     return 0;
 }
 
-static int ZipAddDir(const char *sourcePath, int offset, zipFile zf);
+typedef struct HnpZipEntryStru {
+    char *path;                 // 源路径，目录以'/'结尾
+    bool isDir;
+    bool done;                  // 已完成压缩
+    unsigned long externalFa;
+    unsigned long size;         // 原始大小
+    unsigned long crc;
+    unsigned char *data;        // deflate压缩后的数据
+    unsigned long dataLen;
+    unsigned long capacity;
+} HnpZipEntry;
+
+typedef struct HnpZipCtxStru {
+    HnpZipEntry *entries;
+    int num;
+    int capacity;
+    int offset;                 // zip内只保存相对路径
+    int next;                   // 下一个待压缩的文件
+    int written;                // 已写入zip的文件数
+    int ret;
+    HnpZipParam param;
+#ifndef _WIN32
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+#endif
+} HnpZipCtx;
 
-static int ZipHandleDir(char *fullPath, int offset, zipFile zf)
+static void ZipCtxLock(HnpZipCtx *ctx)
 {
-    int ret;
-    char transPath[MAX_FILE_PATH_LEN];
-    TransPath(fullPath, transPath);
-    if (zipOpenNewFileInZip3(zf, transPath + offset, NULL, NULL, 0, NULL, 0, NULL, Z_DEFLATED,
-                             Z_BEST_COMPRESSION, 0, -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY,
-                             NULL, 0) != ZIP_OK) {
-        HNP_LOGE("open new file[%{public}s] in zip unsuccess ", fullPath);
-        return HNP_ERRNO_BASE_CREATE_ZIP_FAILED;
+#ifndef _WIN32
+    pthread_mutex_lock(&ctx->mutex);
+#endif
+}
+
+static void ZipCtxUnlock(HnpZipCtx *ctx)
+{
+#ifndef _WIN32
+    pthread_mutex_unlock(&ctx->mutex);
+#endif
+}
+
+static void ZipCtxWait(HnpZipCtx *ctx)
+{
+#ifndef _WIN32
+    pthread_cond_wait(&ctx->cond, &ctx->mutex);
+#endif
+}
+
+static void ZipCtxBroadcast(HnpZipCtx *ctx)
+{
+#ifndef _WIN32
+    pthread_cond_broadcast(&ctx->cond);
+#endif
+}
+
+static void ZipCtxFree(HnpZipCtx *ctx)
+{
+    for (int i = 0; i < ctx->num; i++) {
+        free(ctx->entries[i].path);
+        free(ctx->entries[i].data);
     }
-    zipCloseFileInZip(zf);
-    ret = ZipAddDir(fullPath, offset, zf);
-    if (ret != 0) {
-        HNP_LOGE("zip add dir[%{public}s] unsuccess ", fullPath);
-        return ret;
+    free(ctx->entries);
+    ctx->entries = NULL;
+    ctx->num = 0;
+}
+
+static int ZipEntryAdd(HnpZipCtx *ctx, const char *path, bool isDir)
+{
+    if (ctx->num == ctx->capacity) {
+        int capacity = (ctx->capacity == 0) ? HNP_ZIP_ENTRY_INIT_NUM : ctx->capacity * 2; // 2: 倍数扩容
+        HnpZipEntry *entries = (HnpZipEntry *)realloc(ctx->entries, sizeof(HnpZipEntry) * capacity);
+        if (entries == NULL) {
+            HNP_LOGE("zip entry realloc unsuccess, capacity=%{public}d", capacity);
+            return HNP_ERRNO_NOMEM;
+        }
+        ctx->entries = entries;
+        ctx->capacity = capacity;
     }
+    HnpZipEntry *entry = &ctx->entries[ctx->num];
+    (void)memset_s(entry, sizeof(HnpZipEntry), 0, sizeof(HnpZipEntry));
+    entry->path = strdup(path);
+    if (entry->path == NULL) {
+        HNP_LOGE("zip entry strdup unsuccess, path=%{public}s", path);
+        return HNP_ERRNO_BASE_STRDUP_FAILED;
+    }
+    entry->isDir = isDir;
+    entry->done = isDir;
+    ctx->num++;
     return 0;
 }
 
-// sourcePath--文件夹路径  zf--压缩文件句柄
-static int ZipAddDir(const char *sourcePath, int offset, zipFile zf)
+// sourcePath--文件夹路径，收集目录下所有待压缩的文件
+static int ZipCollectDir(HnpZipCtx *ctx, const char *sourcePath)
 {
     struct dirent *entry;
     char fullPath[MAX_FILE_PATH_LEN];
@@ -191,26 +211,22 @@ static int ZipAddDir(const char *sourcePath, int offset, zipFile zf)
             return HNP_ERRNO_BASE_SPRINTF_FAILED;
         }
         int ret = IsDirPath(entry, fullPath, &isDir);
-        if (ret != 0) {
-            closedir(dir);
-            return ret;
-        }
-        if (isDir) {
+        if (ret == 0 && isDir) {
             int endPos = strlen(fullPath);
-            if (endPos + 1 < MAX_FILE_PATH_LEN) {
-                fullPath[endPos] = DIR_SPLIT_SYMBOL;
-                fullPath[endPos + 1] = '\0';
-            } else {
+            if (endPos + 1 >= MAX_FILE_PATH_LEN) {
                 closedir(dir);
                 return HNP_ERRNO_BASE_STRING_LEN_OVER_LIMIT;
             }
-            ret = ZipHandleDir(fullPath, offset, zf);
-            if (ret != 0) {
-                closedir(dir);
-                return ret;
+            fullPath[endPos] = DIR_SPLIT_SYMBOL;
+            fullPath[endPos + 1] = '\0';
+            ret = ZipEntryAdd(ctx, fullPath, true);
+            if (ret == 0) {
+                ret = ZipCollectDir(ctx, fullPath);
             }
-        } else if ((ret = ZipAddFile(fullPath, offset, zf)) != 0) {
-            HNP_LOGE("zip add file[%{public}s] unsuccess ", fullPath);
+        } else if (ret == 0) {
+            ret = ZipEntryAdd(ctx, fullPath, false);
+        }
+        if (ret != 0) {
             closedir(dir);
             return ret;
         }
@@ -220,32 +236,270 @@ static int ZipAddDir(const char *sourcePath, int offset, zipFile zf)
     return 0;
 }
 
-static int ZipDir(const char *sourcePath, int offset, zipFile zf)
+static FILE *ZipOpenSourceFile(const char *file, unsigned long *externalFa, bool reproducible)
+{
+#ifdef _WIN32
+    struct _stat buffer = {0};
+    // 使用wchar_t支持处理字符串长度超过260的路径字符串
+    wchar_t wideFullPath[MAX_FILE_PATH_LEN] = {0};
+    if (!TransWidePath(file, wideFullPath) || _wstat(wideFullPath, &buffer) != 0) {
+        HNP_LOGE("get filefile[%{public}s] stat fail.", file);
+        return NULL;
+    }
+    buffer.st_mode |= S_IXOTH;
+#else
+    struct stat buffer = {0};
+    if (stat(file, &buffer) != 0) {
+        HNP_LOGE("get filefile[%{public}s] stat fail.", file);
+        return NULL;
+    }
+#endif
+    unsigned long mode = buffer.st_mode & 0xFFFF;
+    /* 解压时只关注其他人是否有可执行权限，可复现模式下固定其余权限位 */
+    if (reproducible) {
+        mode = S_IFREG | (((mode & S_IXOTH) != 0) ? HNP_ZIP_EXEC_FILE_MODE : HNP_ZIP_FILE_MODE);
+    }
+    *externalFa = mode << ZIP_EXTERNAL_FA_OFFSET;
+#ifdef _WIN32
+    FILE *f = _wfopen(wideFullPath, L"rb");
+#else
+    FILE *f = fopen(file, "rb");
+#endif
+    if (f == NULL) {
+        HNP_LOGE("open file[%{public}s] unsuccess ", file);
+    }
+    return f;
+}
+
+static int ZipEntryReserve(HnpZipEntry *entry)
+{
+    if (entry->capacity - entry->dataLen >= HNP_ZIP_READ_BUFFER_SIZE) {
+        return 0;
+    }
+    unsigned long capacity = (entry->capacity < HNP_ZIP_READ_BUFFER_SIZE) ? HNP_ZIP_READ_BUFFER_SIZE * 2 :
+        entry->capacity * 2; // 2: 倍数扩容
+    unsigned char *data = (unsigned char *)realloc(entry->data, capacity);
+    if (data == NULL) {
+        HNP_LOGE("zip entry data realloc unsuccess, capacity=%{public}lu", capacity);
+        return HNP_ERRNO_NOMEM;
+    }
+    entry->data = data;
+    entry->capacity = capacity;
+    return 0;
+}
+
+// 将文件压缩为独立的deflate数据，写入zip时不再压缩
+static int ZipEntryDeflate(HnpZipEntry *entry, FILE *f, unsigned char *in, int level)
+{
+    z_stream strm = {0};
+    if (deflateInit2(&strm, level, Z_DEFLATED, -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK) {
+        HNP_LOGE("deflate init unsuccess, file=%{public}s", entry->path);
+        return HNP_ERRNO_BASE_CREATE_ZIP_FAILED;
+    }
+    int flush = Z_NO_FLUSH;
+    int ret = Z_OK;
+    while (flush != Z_FINISH) {
+        size_t len = fread(in, 1, HNP_ZIP_READ_BUFFER_SIZE, f);
+        if (ferror(f)) {
+            HNP_LOGE("read file[%{public}s] unsuccess", entry->path);
+            (void)deflateEnd(&strm);
+            return HNP_ERRNO_BASE_FILE_READ_FAILED;
+        }
+        flush = feof(f) ? Z_FINISH : Z_NO_FLUSH;
+        entry->crc = crc32(entry->crc, in, len);
+        entry->size += len;
+        strm.next_in = in;
+        strm.avail_in = len;
+        do {
+            if (ZipEntryReserve(entry) != 0) {
+                (void)deflateEnd(&strm);
+                return HNP_ERRNO_NOMEM;
+            }
+            strm.next_out = entry->data + entry->dataLen;
+            strm.avail_out = entry->capacity - entry->dataLen;
+            ret = deflate(&strm, flush);
+            entry->dataLen = entry->capacity - strm.avail_out;
+        } while (strm.avail_out == 0);
+    }
+    (void)deflateEnd(&strm);
+    if (ret != Z_STREAM_END) {
+        HNP_LOGE("deflate file[%{public}s] unsuccess, ret=%{public}d", entry->path, ret);
+        return HNP_ERRNO_BASE_CREATE_ZIP_FAILED;
+    }
+    return 0;
+}
+
+static int ZipEntryCompress(HnpZipEntry *entry, const HnpZipParam *param)
+{
+    if (entry->isDir) {
+        return 0;
+    }
+    FILE *f = ZipOpenSourceFile(entry->path, &entry->externalFa, param->reproducible);
+    if (f == NULL) {
+        return HNP_ERRNO_BASE_FILE_OPEN_FAILED;
+    }
+    unsigned char *in = (unsigned char *)malloc(HNP_ZIP_READ_BUFFER_SIZE);
+    if (in == NULL) {
+        (void)fclose(f);
+        return HNP_ERRNO_NOMEM;
+    }
+    int ret = ZipEntryDeflate(entry, f, in, param->level);
+    free(in);
+    (void)fclose(f);
+    return ret;
+}
+
+static int ZipEntryWrite(HnpZipCtx *ctx, HnpZipEntry *entry, zipFile zf)
 {
-    int ret;
     char transPath[MAX_FILE_PATH_LEN];
+    TransPath(entry->path, transPath);
 
-    TransPath(sourcePath, transPath);
+    if (entry->isDir) {
+        if (zipOpenNewFileInZip3(zf, transPath + ctx->offset, NULL, NULL, 0, NULL, 0, NULL, Z_DEFLATED,
+            ctx->param.level, 0, -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY, NULL, 0) != ZIP_OK) {
+            HNP_LOGE("open new file[%{public}s] in zip unsuccess ", entry->path);
+            return HNP_ERRNO_BASE_CREATE_ZIP_FAILED;
+        }
+        zipCloseFileInZip(zf);
+        return 0;
+    }
 
-    // 将外层文件夹信息保存到zip文件中
-    ret = zipOpenNewFileInZip3(zf, transPath + offset, NULL, NULL, 0, NULL, 0, NULL, Z_DEFLATED, Z_BEST_COMPRESSION,
-        0, -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY, NULL, 0);
-    if (ret != ZIP_OK) {
-        HNP_LOGE("open new file[%{public}s] in zip unsuccess ", sourcePath + offset);
+    zip_fileinfo fileInfo = {0};
+    fileInfo.external_fa = entry->externalFa;
+    if (zipOpenNewFileInZip3(zf, transPath + ctx->offset, &fileInfo, NULL, 0, NULL, 0, NULL, Z_DEFLATED,
+        ctx->param.level, 1, -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY, NULL, 0) != ZIP_OK) {
+        HNP_LOGE("open new file[%{public}s] in zip unsuccess ", entry->path);
         return HNP_ERRNO_BASE_CREATE_ZIP_FAILED;
     }
-    zipCloseFileInZip(zf);
-    ret = ZipAddDir(sourcePath, offset, zf);
+    int ret = zipWriteInFileInZip(zf, entry->data, entry->dataLen);
+    if (zipCloseFileInZipRaw(zf, entry->size, entry->crc) != ZIP_OK || ret != ZIP_OK) {
+        HNP_LOGE("write file[%{public}s] in zip unsuccess ", entry->path);
+        return HNP_ERRNO_BASE_FILE_WRITE_FAILED;
+    }
+    return 0;
+}
+
+// 压缩线程在写入窗口内提前压缩，限制未写入数据占用的内存
+static void *ZipCompressWorker(void *arg)
+{
+    HnpZipCtx *ctx = (HnpZipCtx *)arg;
+
+    ZipCtxLock(ctx);
+    while (ctx->ret == 0 && ctx->next < ctx->num) {
+        if (ctx->next >= ctx->written + HNP_ZIP_WINDOW_SIZE) {
+            ZipCtxWait(ctx);
+            continue;
+        }
+        HnpZipEntry *entry = &ctx->entries[ctx->next++];
+        ZipCtxUnlock(ctx);
+        int ret = ZipEntryCompress(entry, &ctx->param);
+        ZipCtxLock(ctx);
+        entry->done = true;
+        if (ret != 0 && ctx->ret == 0) {
+            ctx->ret = ret;
+        }
+        ZipCtxBroadcast(ctx);
+    }
+    ZipCtxUnlock(ctx);
+    return NULL;
+}
+
+// 按收集顺序写入zip，待写入的文件未被压缩线程领取时由当前线程压缩
+static int ZipWriteEntries(HnpZipCtx *ctx, zipFile zf)
+{
+    for (int i = 0; i < ctx->num; i++) {
+        HnpZipEntry *entry = &ctx->entries[i];
+        ZipCtxLock(ctx);
+        bool compress = false;
+        if (ctx->next == i) {
+            ctx->next++;
+            compress = true;
+        }
+        while (!compress && !entry->done && ctx->ret == 0) {
+            ZipCtxWait(ctx);
+        }
+        int ret = ctx->ret;
+        ZipCtxUnlock(ctx);
+
+        if (ret == 0 && compress) {
+            ret = ZipEntryCompress(entry, &ctx->param);
+        }
+        if (ret == 0) {
+            ret = ZipEntryWrite(ctx, entry, zf);
+        }
+        free(entry->data);
+        entry->data = NULL;
+
+        ZipCtxLock(ctx);
+        ctx->written = i + 1;
+        if (ret != 0 && ctx->ret == 0) {
+            ctx->ret = ret;
+        }
+        ret = ctx->ret;
+        ZipCtxBroadcast(ctx);
+        ZipCtxUnlock(ctx);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+    return 0;
+}
+
+static int ZipEntryCompare(const void *left, const void *right)
+{
+    return strcmp(((const HnpZipEntry *)left)->path, ((const HnpZipEntry *)right)->path);
+}
+
+static int ZipDir(const char *sourcePath, int offset, zipFile zf, const HnpZipParam *param)
+{
+    HnpZipCtx ctx = {0};
+    ctx.offset = offset;
+    ctx.param = *param;
+
+    // 外层文件夹信息也保存到zip文件中
+    int ret = ZipEntryAdd(&ctx, sourcePath, true);
+    if (ret == 0) {
+        ret = ZipCollectDir(&ctx, sourcePath);
+    }
+    if (ret != 0) {
+        ZipCtxFree(&ctx);
+        return ret;
+    }
+    /* 可复现模式下按路径排序，与目录遍历顺序无关；目录路径是其子项的前缀，排序后仍在子项之前 */
+    if (param->reproducible) {
+        qsort(ctx.entries, ctx.num, sizeof(HnpZipEntry), ZipEntryCompare);
+    }
 
+#ifndef _WIN32
+    pthread_t threads[HNP_ZIP_MAX_JOBS];
+    int threadNum = 0;
+    (void)pthread_mutex_init(&ctx.mutex, NULL);
+    (void)pthread_cond_init(&ctx.cond, NULL);
+    for (int i = 1; i < param->jobs && i < HNP_ZIP_MAX_JOBS; i++) {
+        if (pthread_create(&threads[threadNum], NULL, ZipCompressWorker, &ctx) == 0) {
+            threadNum++;
+        }
+    }
+#endif
+    ret = ZipWriteEntries(&ctx, zf);
+#ifndef _WIN32
+    for (int i = 0; i < threadNum; i++) {
+        (void)pthread_join(threads[i], NULL);
+    }
+    (void)pthread_cond_destroy(&ctx.cond);
+    (void)pthread_mutex_destroy(&ctx.mutex);
+#endif
+    ZipCtxFree(&ctx);
     return ret;
 }
 
-int HnpZip(const char *inputDir, zipFile zf)
+int HnpZip(const char *inputDir, zipFile zf, const HnpZipParam *param)
 {
     int ret;
     char *strPtr;
     int offset;
     char sourcePath[MAX_FILE_PATH_LEN];
+    HnpZipParam defaultParam = {Z_BEST_COMPRESSION, 1, false};
 
     // zip压缩文件内只保存相对路径，不保存绝对路径信息，偏移到压缩文件夹位置
     strPtr = strrchr(inputDir, DIR_SPLIT_SYMBOL);
@@ -262,7 +516,7 @@ int HnpZip(const char *inputDir, zipFile zf)
         return HNP_ERRNO_BASE_SPRINTF_FAILED;
     }
 
-    ret = ZipDir(sourcePath, offset, zf);
+    ret = ZipDir(sourcePath, offset, zf, (param == NULL) ? &defaultParam : param);
 
     return ret;
 }
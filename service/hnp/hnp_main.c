@@ -45,7 +45,7 @@ int HnpShowHelp(int argc, char *argv[])
     (void)argv;
 
     HNP_LOGI("\r\nusage:hnp <command> <args> [-u <user id>][-p <hap package name>][-i <hap install path>][-f]"
-            "[-s <hap source path>][-a <system abi>]\r\n"
+            "[-s <hap source path>][-a <system abi>][-j <jobs>]\r\n"
         "\r\nThese are common hnp commands used in various situations:\r\n"
         "\r\ninstall: install one hap package"
         "\r\n           hnp install <-u [user id]> <-p [hap package name]> <-i [hap install path]> <-f>"
@@ -55,7 +55,8 @@ int HnpShowHelp(int argc, char *argv[])
         "\r\n           -s    : [required]    hap source path"
         "\r\n           -a    : [required]    system abi"
         "\r\n           -f    : [optional]    if provided, the hnp package will be installed forcely, ignoring old"
-            " versions of the hnp package\r\n"
+            " versions of the hnp package"
+        "\r\n           -j    : [optional]    number of hnp packages installed in parallel, range 1-8, default 1\r\n"
         "\r\nuninstall: uninstall one hap package"
         "\r\n           hnp uninstall <-u [user id]> <-p [hap package name]>"
         "\r\n           -u    : [required]    user id"
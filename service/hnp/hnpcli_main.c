@@ -44,14 +44,17 @@ int HnpCliShowHelp(int argc, char *argv[])
     (void)argv;
 
     HNP_LOGI("\r\nusage:hnpcli <command> <args> [-i <software package dir>][-o <hnp output path>]"
-        "[-n <native package name>][-v <native package version>]\r\n"
+        "[-n <native package name>][-v <native package version>][-l <level>][-j <jobs>][-r]\r\n"
         "\r\nThese are common hnpcli commands used in various situations:\r\n"
         "\r\npack:    packet native software package to .hnp file"
         "\r\n         hnpcli pack <-i [source path]> <-o [dst path]> <-n [software name]> <-v [software version]>"
         "\r\n         -i    : [required]    input path of software package dir"
         "\r\n         -o    : [optional]    output path of hnp file. if not set then ouput to current directory"
         "\r\n         -n    : [optional]    software name. if not hnp.json in input dir then must set"
-        "\r\n         -v    : [optional]    software version. if not hnp.json in input dir then must set\r\n"
+        "\r\n         -v    : [optional]    software version. if not hnp.json in input dir then must set"
+        "\r\n         -l    : [optional]    compression level 0-9, default 9"
+        "\r\n         -j    : [optional]    number of compression threads 1-16, default 1"
+        "\r\n         -r    : [optional]    reproducible output, sort entries by path and normalize file mode\r\n"
         "\r\nfor example:\r\n"
         "\r\n    hnpcli pack -i /usr1/native_sample -o /usr1/output -n native_sample -v 1.1\r\n");
 
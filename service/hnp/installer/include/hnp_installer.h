@@ -16,6 +16,8 @@
 #ifndef HNP_INSTALLER_H
 #define HNP_INSTALLER_H
 
+#include <pthread.h>
+
 #include "hnp_base.h"
 
 #ifdef __cplusplus
@@ -43,8 +45,15 @@ extern "C" {
 // 0x801307 restorecon 安装目录失败
 #define HNP_ERRNO_INSTALLER_RESTORECON_HNP_PATH_FAIL       HNP_ERRNO_COMMON(HNP_MID_INSTALLER, 0x7)
 
+// 0x801308 安装命令参数jobs错误
+#define HNP_ERRNO_INSTALLER_ARGV_JOBS_INVALID              HNP_ERRNO_COMMON(HNP_MID_INSTALLER, 0x8)
+
 #define HNP_DEFAULT_INSTALL_ROOT_PATH "/data/app/el1/bundle"
 #define HNP_SANDBOX_BASE_PATH "/data/service/hnp"
+#define HNP_INSTALL_MAX_JOBS 8
+#define HNP_INSTALL_JOB_INIT_NUM 8
+#define HNP_MS_PER_SECOND 1000
+#define HNP_NS_PER_MS 1000000
 
 /* hap安装信息 */
 typedef struct HapInstallInfoStru {
@@ -54,6 +63,7 @@ typedef struct HapInstallInfoStru {
     char *hapPath;                            // hap目录
     char *abi;                                // 系统abi路径
     bool isForce;                             // 是否强制安装
+    int jobs;                                 // 并行安装线程数
 } HapInstallInfo;
 
 /* hnp安装信息 */
@@ -66,6 +76,31 @@ typedef struct HnpInstallInfoStru {
     char hnpSignKeyPrefix[MAX_FILE_PATH_LEN]; // hnp包验签前缀,hnp/{abi}/xxxx/xxx.hnp
 } HnpInstallInfo;
 
+/* 单个hnp包安装任务 */
+typedef struct HnpInstallJobStru {
+    HnpInstallInfo hnpInfo;                   // hnp安装信息
+    HnpCfgInfo hnpCfg;                        // hnp配置信息
+    char hnpFile[MAX_FILE_PATH_LEN];          // hnp包路径
+    HnpSignMapInfo *signMapInfos;             // 本包验签信息起始位置
+    int signCapacity;                         // 本包文件数，验签信息最大数量
+    int signCount;                            // 本包验签信息数量
+    int result;                               // 解压结果
+    bool isSerial;                            // 与前面的包安装到同一软件目录，需按顺序安装
+    bool isInstalled;                         // 已创建安装目录，失败时需要回滚
+    bool isRegistered;                        // 已写入公共hnp安装信息，失败时需要删除
+    long long extractTime;                    // 解压耗时，单位ms
+} HnpInstallJob;
+
+/* hap内所有hnp包安装任务 */
+typedef struct HnpInstallJobListStru {
+    HnpInstallJob *jobs;
+    int num;
+    int capacity;
+    int next;                                 // 下一个待解压的任务
+    int ret;                                  // 第一个失败的解压结果
+    pthread_mutex_t mutex;
+} HnpInstallJobList;
+
 int HnpCmdInstall(int argc, char *argv[]);
 
 int HnpCmdUnInstall(int argc, char *argv[]);
@@ -21,7 +21,10 @@
 #include <sys/stat.h>
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
+#include <time.h>
 
 #include "policycoreutils.h"
 #ifdef CODE_SIGNATURE_ENABLE
@@ -47,7 +50,53 @@ static int HnpInstallerUidGet(const char *uidIn, int *uidOut)
     return 0;
 }
 
-static int HnpGenerateSoftLinkAllByJson(const char *installPath, const char *dstPath, HnpCfgInfo *hnpCfg)
+static int HnpInstallerJobsGet(const char *jobsIn, int *jobsOut)
+{
+    char *end = NULL;
+
+    /* 只接受1~HNP_INSTALL_MAX_JOBS的十进制数，不允许空串、符号及溢出 */
+    if (!isdigit((unsigned char)jobsIn[0])) {
+        return HNP_ERRNO_INSTALLER_ARGV_JOBS_INVALID;
+    }
+    errno = 0;
+    long jobs = strtol(jobsIn, &end, 10); // 10进制
+    if (errno != 0 || *end != '\0' || jobs < 1 || jobs > HNP_INSTALL_MAX_JOBS) {
+        return HNP_ERRNO_INSTALLER_ARGV_JOBS_INVALID;
+    }
+    *jobsOut = (int)jobs;
+    return 0;
+}
+
+static int HnpRestoreconEntry(int dirFd, const char *name, const char *parentPath, bool isDir, void *arg)
+{
+    char path[MAX_FILE_PATH_LEN];
+    (void)dirFd;
+    (void)isDir;
+    (void)arg;
+
+    if (sprintf_s(path, MAX_FILE_PATH_LEN, "%s%s%s", (parentPath == NULL) ? "" : parentPath,
+        (parentPath == NULL) ? "" : "/", name) < 0) {
+        HNP_LOGE("sprintf fail, get hnp restorecon path fail");
+        return HNP_ERRNO_INSTALLER_RESTORECON_HNP_PATH_FAIL;
+    }
+    if (Restorecon(path) != 0) {
+        HNP_LOGE("restorecon hnp path[%{public}s] fail", path);
+        return HNP_ERRNO_INSTALLER_RESTORECON_HNP_PATH_FAIL;
+    }
+    return 0;
+}
+
+/* 公有hnp只刷新本次安装涉及的路径，避免安装耗时随已安装hnp数量增长 */
+static int HnpRestoreconPath(const char *path, bool isPublic)
+{
+    if (!isPublic) {
+        return 0;
+    }
+    return HnpRestoreconEntry(AT_FDCWD, path, NULL, false, NULL);
+}
+
+static int HnpGenerateSoftLinkAllByJson(const char *installPath, const char *dstPath, HnpCfgInfo *hnpCfg,
+    bool isPublic)
 {
     char srcFile[MAX_FILE_PATH_LEN];
     char dstFile[MAX_FILE_PATH_LEN];
@@ -60,6 +109,10 @@ static int HnpGenerateSoftLinkAllByJson(const char *installPath, const char *dst
             HNP_LOGE("mkdir [%{public}s] unsuccess, ret=%{public}d, errno:%{public}d", dstPath, ret, errno);
             return HNP_ERRNO_BASE_MKDIR_PATH_FAILED;
         }
+        ret = HnpRestoreconPath(dstPath, isPublic);
+        if (ret != 0) {
+            return ret;
+        }
     }
 
     for (unsigned int i = 0; i < hnpCfg->linkNum; i++) {
@@ -93,6 +146,9 @@ static int HnpGenerateSoftLinkAllByJson(const char *installPath, const char *dst
         }
         /* 生成软链接 */
         ret = HnpSymlink(srcFile, dstFile);
+        if (ret == 0) {
+            ret = HnpRestoreconPath(dstFile, isPublic);
+        }
         if (ret != 0) {
             return ret;
         }
@@ -103,7 +159,7 @@ static int HnpGenerateSoftLinkAllByJson(const char *installPath, const char *dst
     return 0;
 }
 
-static int HnpGenerateSoftLinkAll(const char *installPath, const char *dstPath)
+static int HnpGenerateSoftLinkAll(const char *installPath, const char *dstPath, bool isPublic)
 {
     char srcPath[MAX_FILE_PATH_LEN];
     char srcFile[MAX_FILE_PATH_LEN];
@@ -130,6 +186,11 @@ static int HnpGenerateSoftLinkAll(const char *installPath, const char *dstPath)
             HNP_LOGE("mkdir [%{public}s] unsuccess, ret=%{public}d, errno:%{public}d", dstPath, ret, errno);
             return HNP_ERRNO_BASE_MKDIR_PATH_FAILED;
         }
+        ret = HnpRestoreconPath(dstPath, isPublic);
+        if (ret != 0) {
+            closedir(dir);
+            return ret;
+        }
     }
 
     while (((entry = readdir(dir)) != NULL)) {
@@ -152,6 +213,9 @@ static int HnpGenerateSoftLinkAll(const char *installPath, const char *dstPath)
         }
         /* 生成软链接 */
         ret = HnpSymlink(srcFile, dstFile);
+        if (ret == 0) {
+            ret = HnpRestoreconPath(dstFile, isPublic);
+        }
         if (ret != 0) {
             closedir(dir);
             return ret;
@@ -162,7 +226,8 @@ static int HnpGenerateSoftLinkAll(const char *installPath, const char *dstPath)
     return 0;
 }
 
-static int HnpGenerateSoftLink(const char *installPath, const char *hnpBasePath, HnpCfgInfo *hnpCfg)
+static int HnpGenerateSoftLink(const char *installPath, const char *hnpBasePath, HnpCfgInfo *hnpCfg,
+    bool isPublic)
 {
     int ret = 0;
     char binPath[MAX_FILE_PATH_LEN];
@@ -174,16 +239,15 @@ static int HnpGenerateSoftLink(const char *installPath, const char *hnpBasePath,
     }
 
     if (hnpCfg->linkNum == 0) {
-        ret = HnpGenerateSoftLinkAll(installPath, binPath);
+        ret = HnpGenerateSoftLinkAll(installPath, binPath, isPublic);
     } else {
-        ret = HnpGenerateSoftLinkAllByJson(installPath, binPath, hnpCfg);
+        ret = HnpGenerateSoftLinkAllByJson(installPath, binPath, hnpCfg, isPublic);
     }
 
     return ret;
 }
 
-static int HnpInstall(const char *hnpFile, HnpInstallInfo *hnpInfo, HnpCfgInfo *hnpCfg,
-    HnpSignMapInfo *hnpSignMapInfos, int *count)
+static int HnpInstall(const char *hnpFile, HnpInstallInfo *hnpInfo, HnpSignMapInfo *hnpSignMapInfos, int *count)
 {
     int ret;
 
@@ -193,12 +257,31 @@ static int HnpInstall(const char *hnpFile, HnpInstallInfo *hnpInfo, HnpCfgInfo *
         return ret; /* 内部已打印日志 */
     }
 
-    /* 生成软链 */
-    return HnpGenerateSoftLink(hnpInfo->hnpVersionPath, hnpInfo->hnpBasePath, hnpCfg);
+    /* 公有hnp只刷新新安装的版本目录 */
+    if (hnpInfo->isPublic) {
+        ret = HnpRestoreconPath(hnpInfo->hnpSoftwarePath, true);
+        if (ret == 0) {
+            ret = HnpTreeWalk(hnpInfo->hnpVersionPath, HnpRestoreconEntry, NULL, false);
+        }
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+static int HnpPublicRunPathGet(const char *name, char *sandboxPath)
+{
+    if (sprintf_s(sandboxPath, MAX_FILE_PATH_LEN, HNP_SANDBOX_BASE_PATH"/%s.org", name) < 0) {
+        HNP_LOGE("sprintf unstall base path unsuccess.");
+        return HNP_ERRNO_BASE_SPRINTF_FAILED;
+    }
+    return 0;
 }
 
 /**
- * 卸载公共hnp.
+ * 删除公共hnp，调用前需完成进程占用检查.
  *
  * @param packageName hap名称.
  * @param name  hnp名称
@@ -208,13 +291,12 @@ static int HnpInstall(const char *hnpFile, HnpInstallInfo *hnpInfo, HnpCfgInfo *
  *
  * @return 0:success;other means failure.
  */
-static int HnpUnInstallPublicHnp(const char* packageName, const char *name, const char *version, int uid,
+static int HnpDeletePublicHnp(const char* packageName, const char *name, const char *version, int uid,
     bool isInstallVersion)
 {
     int ret;
     char hnpNamePath[MAX_FILE_PATH_LEN];
     char hnpVersionPath[MAX_FILE_PATH_LEN];
-    char sandboxPath[MAX_FILE_PATH_LEN];
 
     if (sprintf_s(hnpNamePath, MAX_FILE_PATH_LEN, HNP_DEFAULT_INSTALL_ROOT_PATH"/%d/hnppublic/%s.org", uid, name) < 0) {
         HNP_LOGE("hnp uninstall name path sprintf unsuccess,uid:%{public}d,name:%{public}s", uid, name);
@@ -226,16 +308,6 @@ static int HnpUnInstallPublicHnp(const char* packageName, const char *name, cons
         return HNP_ERRNO_BASE_SPRINTF_FAILED;
     }
 
-    if (sprintf_s(sandboxPath, MAX_FILE_PATH_LEN, HNP_SANDBOX_BASE_PATH"/%s.org", name) < 0) {
-        HNP_LOGE("sprintf unstall base path unsuccess.");
-        return HNP_ERRNO_BASE_SPRINTF_FAILED;
-    }
-
-    ret = HnpProcessRunCheck(sandboxPath);
-    if (ret != 0) {
-        return ret;
-    }
-
     if (!isInstallVersion) {
         ret = HnpPackageInfoHnpDelete(packageName, name, version);
         if (ret != 0) {
@@ -255,6 +327,35 @@ static int HnpUnInstallPublicHnp(const char* packageName, const char *name, cons
     return 0;
 }
 
+/**
+ * 卸载公共hnp.
+ *
+ * @param packageName hap名称.
+ * @param name  hnp名称
+ * @param version 版本号.
+ * @param uid 用户id.
+ * @param isInstallVersion 是否卸载安装版本.
+ *
+ * @return 0:success;other means failure.
+ */
+static int HnpUnInstallPublicHnp(const char* packageName, const char *name, const char *version, int uid,
+    bool isInstallVersion)
+{
+    char sandboxPath[MAX_FILE_PATH_LEN];
+
+    int ret = HnpPublicRunPathGet(name, sandboxPath);
+    if (ret != 0) {
+        return ret;
+    }
+
+    ret = HnpProcessRunCheck(sandboxPath);
+    if (ret != 0) {
+        return ret;
+    }
+
+    return HnpDeletePublicHnp(packageName, name, version, uid, isInstallVersion);
+}
+
 static int HnpNativeUnInstall(HnpPackageInfo *packageInfo, int uid, const char *packageName)
 {
     int ret;
@@ -264,7 +365,7 @@ static int HnpNativeUnInstall(HnpPackageInfo *packageInfo, int uid, const char *
         packageName);
 
     if (!packageInfo->hnpExist) {
-        ret = HnpUnInstallPublicHnp(packageName, packageInfo->name, packageInfo->currentVersion, uid, false);
+        ret = HnpDeletePublicHnp(packageName, packageInfo->name, packageInfo->currentVersion, uid, false);
         if (ret != 0) {
             return ret;
         }
@@ -272,7 +373,7 @@ static int HnpNativeUnInstall(HnpPackageInfo *packageInfo, int uid, const char *
 
     if (strcmp(packageInfo->installVersion, "none") != 0 &&
         strcmp(packageInfo->currentVersion, packageInfo->installVersion) != 0) {
-        ret = HnpUnInstallPublicHnp(packageName, packageInfo->name, packageInfo->installVersion, uid, true);
+        ret = HnpDeletePublicHnp(packageName, packageInfo->name, packageInfo->installVersion, uid, true);
         if (ret != 0) {
             return ret;
         }
@@ -285,6 +386,65 @@ static int HnpNativeUnInstall(HnpPackageInfo *packageInfo, int uid, const char *
     return 0;
 }
 
+static inline bool HnpIsPublicHnpUnInstall(const HnpPackageInfo *packageInfo)
+{
+    return !packageInfo->hnpExist || (strcmp(packageInfo->installVersion, "none") != 0 &&
+        strcmp(packageInfo->currentVersion, packageInfo->installVersion) != 0);
+}
+
+static int HnpUnInstallRunCheckByPath(const HnpPackageInfo *packageInfo, int count, char *runPaths,
+    const char **prefixes, bool *inUse)
+{
+    int num = 0;
+    for (int i = 0; i < count; i++) {
+        if (!HnpIsPublicHnpUnInstall(&packageInfo[i])) {
+            continue;
+        }
+        char *runPath = runPaths + num * MAX_FILE_PATH_LEN;
+        int ret = HnpPublicRunPathGet(packageInfo[i].name, runPath);
+        if (ret != 0) {
+            return ret;
+        }
+        prefixes[num++] = runPath;
+    }
+    if (num == 0) {
+        return 0;
+    }
+
+    int ret = HnpProcessInUseCheck(HNP_PROC_ROOT_PATH, prefixes, num, inUse);
+    if (ret != 0) {
+        return ret;
+    }
+    for (int i = 0; i < num; i++) {
+        if (inUse[i]) {
+            HNP_LOGE("hnp uninstall path[%{public}s] is running now", prefixes[i]);
+            return HNP_ERRNO_PROCESS_RUNNING;
+        }
+    }
+    return 0;
+}
+
+/* 一次遍历进程检查本次卸载的所有公共hnp是否被占用，全部未占用时才开始删除 */
+static int HnpUnInstallRunCheck(const HnpPackageInfo *packageInfo, int count)
+{
+    if (count <= 0) {
+        return 0;
+    }
+    char *runPaths = (char *)malloc((size_t)count * MAX_FILE_PATH_LEN);
+    const char **prefixes = (const char **)malloc((size_t)count * sizeof(char *));
+    bool *inUse = (bool *)malloc((size_t)count * sizeof(bool));
+    int ret = HNP_ERRNO_NOMEM;
+    if (runPaths != NULL && prefixes != NULL && inUse != NULL) {
+        ret = HnpUnInstallRunCheckByPath(packageInfo, count, runPaths, prefixes, inUse);
+    } else {
+        HNP_LOGE("hnp uninstall run check malloc unsuccess.");
+    }
+    free(runPaths);
+    free(prefixes);
+    free(inUse);
+    return ret;
+}
+
 static int HnpUnInstall(int uid, const char *packageName)
 {
     HnpPackageInfo *packageInfo = NULL;
@@ -309,6 +469,12 @@ static int HnpUnInstall(int uid, const char *packageName)
         return ret;
     }
 
+    ret = HnpUnInstallRunCheck(packageInfo, count);
+    if (ret != 0) {
+        free(packageInfo);
+        return ret;
+    }
+
     /* 卸载公有native */
     for (int i = 0; i < count; i++) {
         ret = HnpNativeUnInstall(&packageInfo[i], uid, packageName);
@@ -398,87 +564,69 @@ static int HnpPublicDealAfterInstall(HnpInstallInfo *hnpInfo, HnpCfgInfo *hnpCfg
     return HnpInstallInfoJsonWrite(hnpInfo->hapInstallInfo->hapPackageName, hnpCfg);
 }
 
-static int HnpReadAndInstall(char *srcFile, HnpInstallInfo *hnpInfo, HnpSignMapInfo *hnpSignMapInfos, int *count)
+static bool HnpFileCheck(const char *file)
 {
-    int ret;
-    HnpCfgInfo hnpCfg = {0};
-
-    HNP_LOGI("hnp install start now! src file=%{public}s, dst path=%{public}s", srcFile, hnpInfo->hnpBasePath);
-    /* 从hnp zip获取cfg信息 */
-    ret = HnpCfgGetFromZip(srcFile, &hnpCfg);
-    if (ret != 0) {
-        return ret;
+    const char suffix[] = ".hnp";
+    int len = strlen(file);
+    int suffixLen = strlen(suffix);
+    if ((len >= suffixLen) && (strcmp(file + len - suffixLen, suffix) == 0)) {
+        return true;
     }
 
-    ret = HnpInstallPathGet(&hnpCfg, hnpInfo);
-    if (ret != 0) {
-        // 释放软链接占用的内存
-        if (hnpCfg.links != NULL) {
-            free(hnpCfg.links);
-        }
-        return ret;
-    }
+    return false;
+}
 
-    /* 存在对应版本的公有hnp包跳过安装 */
-    if (access(hnpInfo->hnpVersionPath, F_OK) == 0 && hnpInfo->isPublic) {
-        /* 刷新软链 */
-        ret = HnpGenerateSoftLink(hnpInfo->hnpVersionPath, hnpInfo->hnpBasePath, &hnpCfg);
-        if (ret != 0) {
-            return ret;
-        }
-        // 释放软链接占用的内存
-        if (hnpCfg.links != NULL) {
-            free(hnpCfg.links);
-        }
-        return HnpPublicDealAfterInstall(hnpInfo, &hnpCfg);
-    }
+static long long HnpGetTimeMs(void)
+{
+    struct timespec ts = {0};
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * HNP_MS_PER_SECOND + ts.tv_nsec / HNP_NS_PER_MS;
+}
 
-    ret = HnpInstallForceCheck(&hnpCfg, hnpInfo);
-    if (ret != 0) {
+static void HnpInstallJobListFree(HnpInstallJobList *jobList)
+{
+    for (int i = 0; i < jobList->num; i++) {
         // 释放软链接占用的内存
-        if (hnpCfg.links != NULL) {
-            free(hnpCfg.links);
+        if (jobList->jobs[i].hnpCfg.links != NULL) {
+            free(jobList->jobs[i].hnpCfg.links);
         }
-        return ret;
     }
+    free(jobList->jobs);
+    jobList->jobs = NULL;
+    jobList->num = 0;
+    jobList->capacity = 0;
+}
 
-    /* hnp安装 */
-    ret = HnpInstall(srcFile, hnpInfo, &hnpCfg, hnpSignMapInfos, count);
-    // 释放软链接占用的内存
-    if (hnpCfg.links != NULL) {
-        free(hnpCfg.links);
-    }
-    if (ret != 0) {
-        HnpUnInstallPublicHnp(hnpInfo->hapInstallInfo->hapPackageName, hnpCfg.name, hnpCfg.version,
-            hnpInfo->hapInstallInfo->uid, false);
-        return ret;
+static int HnpInstallJobAdd(HnpInstallJobList *jobList, const char *hnpFile, const HnpInstallInfo *hnpInfo)
+{
+    if (jobList->num >= MAX_PACKAGE_HNP_NUM) {
+        HNP_LOGE("hnp install package num over limit %{public}d", MAX_PACKAGE_HNP_NUM);
+        return HNP_ERRNO_INSTALLER_GET_HNP_PATH_FAILED;
     }
-
-    if (hnpInfo->isPublic) {
-        ret = HnpPublicDealAfterInstall(hnpInfo, &hnpCfg);
-        if (ret != 0) {
-            HnpUnInstallPublicHnp(hnpInfo->hapInstallInfo->hapPackageName, hnpCfg.name, hnpCfg.version,
-                hnpInfo->hapInstallInfo->uid, false);
+    if (jobList->num == jobList->capacity) {
+        int capacity = (jobList->capacity == 0) ? HNP_INSTALL_JOB_INIT_NUM : jobList->capacity * 2; // 2: 倍数扩容
+        HnpInstallJob *jobs = (HnpInstallJob *)realloc(jobList->jobs, sizeof(HnpInstallJob) * capacity);
+        if (jobs == NULL) {
+            HNP_LOGE("hnp install job realloc unsuccess, capacity=%{public}d", capacity);
+            return HNP_ERRNO_NOMEM;
         }
+        jobList->jobs = jobs;
+        jobList->capacity = capacity;
     }
 
-    return ret;
-}
-
-static bool HnpFileCheck(const char *file)
-{
-    const char suffix[] = ".hnp";
-    int len = strlen(file);
-    int suffixLen = strlen(suffix);
-    if ((len >= suffixLen) && (strcmp(file + len - suffixLen, suffix) == 0)) {
-        return true;
+    HnpInstallJob *job = &jobList->jobs[jobList->num];
+    (void)memset_s(job, sizeof(HnpInstallJob), 0, sizeof(HnpInstallJob));
+    if (strcpy_s(job->hnpFile, MAX_FILE_PATH_LEN, hnpFile) != EOK ||
+        memcpy_s(&job->hnpInfo, sizeof(HnpInstallInfo), hnpInfo, sizeof(HnpInstallInfo)) != EOK) {
+        HNP_LOGE("hnp install job copy unsuccess, file=%{public}s", hnpFile);
+        return HNP_ERRNO_BASE_COPY_FAILED;
     }
-
-    return false;
+    jobList->num++;
+    return 0;
 }
 
-static int HnpPackageGetAndInstall(const char *dirPath, HnpInstallInfo *hnpInfo, char *sunDir,
-    HnpSignMapInfo *hnpSignMapInfos, int *count)
+static int HnpPackageGetAndCollect(const char *dirPath, HnpInstallInfo *hnpInfo, char *sunDir,
+    HnpInstallJobList *jobList)
 {
     DIR *dir;
     struct dirent *entry;
@@ -500,41 +648,33 @@ static int HnpPackageGetAndInstall(const char *dirPath, HnpInstallInfo *hnpInfo,
             return HNP_ERRNO_BASE_SPRINTF_FAILED;
         }
 
+        int ret = 0;
         if (entry->d_type == DT_DIR) {
             if (sprintf_s(sunDirNew, MAX_FILE_PATH_LEN, "%s%s/", sunDir, entry->d_name) < 0) {
                 HNP_LOGE("hnp install sprintf sub dir unsuccess");
                 closedir(dir);
                 return HNP_ERRNO_BASE_SPRINTF_FAILED;
             }
-            int ret = HnpPackageGetAndInstall(path, hnpInfo, sunDirNew, hnpSignMapInfos, count);
-            if (ret != 0) {
-                closedir(dir);
-                return ret;
-            }
-        } else {
-            if (HnpFileCheck(path) == false) {
-                continue;
-            }
+            ret = HnpPackageGetAndCollect(path, hnpInfo, sunDirNew, jobList);
+        } else if (HnpFileCheck(path)) {
             if (sprintf_s(hnpInfo->hnpSignKeyPrefix, MAX_FILE_PATH_LEN, "hnp/%s/%s%s", hnpInfo->hapInstallInfo->abi,
                 sunDir, entry->d_name) < 0) {
                 HNP_LOGE("hnp install sprintf unsuccess,sub[%{public}s],path[%{public}s]", sunDir, entry->d_name);
                 closedir(dir);
                 return HNP_ERRNO_BASE_SPRINTF_FAILED;
             }
-            int ret = HnpReadAndInstall(path, hnpInfo, hnpSignMapInfos, count);
-            HNP_LOGI("hnp install end, ret=%{public}d", ret);
-            if (ret != 0) {
-                closedir(dir);
-                return ret;
-            }
+            ret = HnpInstallJobAdd(jobList, path, hnpInfo);
+        }
+        if (ret != 0) {
+            closedir(dir);
+            return ret;
         }
     }
     closedir(dir);
     return 0;
 }
 
-static int HapReadAndInstall(const char *dstPath, HapInstallInfo *installInfo, HnpSignMapInfo *hnpSignMapInfos,
-    int *count)
+static int HapReadAndCollect(const char *dstPath, HapInstallInfo *installInfo, HnpInstallJobList *jobList)
 {
     struct dirent *entry;
     char hnpPath[MAX_FILE_PATH_LEN];
@@ -571,7 +711,7 @@ static int HapReadAndInstall(const char *dstPath, HapInstallInfo *installInfo, H
             continue;
         }
 
-        ret = HnpPackageGetAndInstall(hnpPath, &hnpInfo, "", hnpSignMapInfos, count);
+        ret = HnpPackageGetAndCollect(hnpPath, &hnpInfo, "", jobList);
         if (ret != 0) {
             closedir(dir);
             return ret;
@@ -582,89 +722,254 @@ static int HapReadAndInstall(const char *dstPath, HapInstallInfo *installInfo, H
     return 0;
 }
 
-static int HnpInstallHnpFileCountGet(char *hnpPath, int *count)
+static int HnpInstallJobCompare(const void *left, const void *right)
 {
-    DIR *dir;
-    struct dirent *entry;
-    char path[MAX_FILE_PATH_LEN];
-    int ret;
+    return strcmp(((const HnpInstallJob *)left)->hnpFile, ((const HnpInstallJob *)right)->hnpFile);
+}
 
-    if ((dir = opendir(hnpPath)) == NULL) {
-        HNP_LOGE("hnp install count get opendir:%{public}s unsuccess, errno=%{public}d", hnpPath, errno);
-        return HNP_ERRNO_BASE_DIR_OPEN_FAILED;
+/* 读取hnp配置并确定安装路径，与前面的包安装到同一软件目录时只能串行安装 */
+static int HnpInstallJobPrepare(HnpInstallJobList *jobList, int index)
+{
+    HnpInstallJob *job = &jobList->jobs[index];
+
+    int ret = HnpCfgGetFromZip(job->hnpFile, &job->hnpCfg);
+    if (ret != 0) {
+        return ret;
+    }
+    ret = HnpInstallPathGet(&job->hnpCfg, &job->hnpInfo);
+    if (ret != 0) {
+        return ret;
+    }
+    ret = HnpFileCountGet(job->hnpFile, &job->signCapacity);
+    if (ret != 0) {
+        return ret;
+    }
+    for (int i = 0; i < index; i++) {
+        if (strcmp(jobList->jobs[i].hnpInfo.hnpSoftwarePath, job->hnpInfo.hnpSoftwarePath) == 0) {
+            job->isSerial = true;
+            break;
+        }
     }
+    return 0;
+}
 
-    while ((entry = readdir(dir)) != NULL) {
-        if ((strcmp(entry->d_name, ".") == 0) || (strcmp(entry->d_name, "..") == 0)) {
+static int HnpInstallJobExtract(HnpInstallJob *job)
+{
+    HnpInstallInfo *hnpInfo = &job->hnpInfo;
+    long long startTime = HnpGetTimeMs();
+
+    HNP_LOGI("hnp install start now! src file=%{public}s, dst path=%{public}s", job->hnpFile, hnpInfo->hnpBasePath);
+    /* 存在对应版本的公有hnp包跳过安装，只刷新软链 */
+    if (access(hnpInfo->hnpVersionPath, F_OK) == 0 && hnpInfo->isPublic) {
+        return 0;
+    }
+
+    int ret = HnpInstallForceCheck(&job->hnpCfg, hnpInfo);
+    if (ret != 0) {
+        return ret;
+    }
+    job->isInstalled = true;
+
+    /* hnp安装 */
+    ret = HnpInstall(job->hnpFile, hnpInfo, job->signMapInfos, &job->signCount);
+    job->extractTime = HnpGetTimeMs() - startTime;
+    return ret;
+}
+
+static void *HnpInstallJobWorker(void *arg)
+{
+    HnpInstallJobList *jobList = (HnpInstallJobList *)arg;
+
+    pthread_mutex_lock(&jobList->mutex);
+    while (jobList->next < jobList->num && jobList->ret == 0) {
+        HnpInstallJob *job = &jobList->jobs[jobList->next++];
+        if (job->isSerial) {
             continue;
         }
-
-        if (sprintf_s(path, MAX_FILE_PATH_LEN, "%s/%s", hnpPath, entry->d_name) < 0) {
-            HNP_LOGE("hnp install count get sprintf unsuccess, dir[%{public}s], path[%{public}s]", hnpPath,
-                entry->d_name);
-            closedir(dir);
-            return HNP_ERRNO_BASE_SPRINTF_FAILED;
+        pthread_mutex_unlock(&jobList->mutex);
+        job->result = HnpInstallJobExtract(job);
+        pthread_mutex_lock(&jobList->mutex);
+        if (job->result != 0 && jobList->ret == 0) {
+            jobList->ret = job->result;
         }
+    }
+    pthread_mutex_unlock(&jobList->mutex);
+    return NULL;
+}
 
-        if (entry->d_type == DT_DIR) {
-            if (sprintf_s(path, MAX_FILE_PATH_LEN, "%s/%s", hnpPath, entry->d_name) < 0) {
-                HNP_LOGE("hnp install sprintf sub dir unsuccess");
-                closedir(dir);
-                return HNP_ERRNO_BASE_SPRINTF_FAILED;
-            }
-            ret = HnpInstallHnpFileCountGet(path, count);
-            if (ret != 0) {
-                closedir(dir);
-                return ret;
-            }
-        } else {
-            if (HnpFileCheck(path) == false) {
-                continue;
-            }
-            ret = HnpFileCountGet(path, count);
-            if (ret != 0) {
-                closedir(dir);
-                return ret;
-            }
+/* 各hnp解压到不同目录，使用有限的线程并行解压；jobs为1时在当前线程串行解压 */
+static void HnpInstallJobExtractAll(HnpInstallJobList *jobList, int jobs)
+{
+    pthread_t threads[HNP_INSTALL_MAX_JOBS];
+    int threadNum = 0;
+
+    (void)pthread_mutex_init(&jobList->mutex, NULL);
+    jobList->next = 0;
+    jobList->ret = 0;
+    for (int i = 1; i < jobs && i < jobList->num; i++) {
+        if (pthread_create(&threads[threadNum], NULL, HnpInstallJobWorker, jobList) == 0) {
+            threadNum++;
         }
     }
-
-    closedir(dir);
-    return 0;
+    (void)HnpInstallJobWorker(jobList);
+    for (int i = 0; i < threadNum; i++) {
+        (void)pthread_join(threads[i], NULL);
+    }
+    (void)pthread_mutex_destroy(&jobList->mutex);
 }
 
-static int HnpInstallHapFileCountGet(const char *root, int *count)
+/* 按固定顺序生成软链并写入安装信息 */
+static int HnpInstallJobCommit(HnpInstallJob *job)
 {
-    struct dirent *entry;
-    char hnpPath[MAX_FILE_PATH_LEN];
+    HnpInstallInfo *hnpInfo = &job->hnpInfo;
+    long long startTime = HnpGetTimeMs();
 
-    DIR *dir = opendir(root);
-    if (dir == NULL) {
-        HNP_LOGE("hnp install opendir:%{public}s unsuccess, errno=%{public}d", root, errno);
-        return HNP_ERRNO_BASE_DIR_OPEN_FAILED;
+    if (job->isSerial) {
+        job->result = HnpInstallJobExtract(job);
+    }
+    int ret = job->result;
+    if (ret == 0) {
+        /* 生成软链 */
+        ret = HnpGenerateSoftLink(hnpInfo->hnpVersionPath, hnpInfo->hnpBasePath, &job->hnpCfg, hnpInfo->isPublic);
     }
+    if (ret == 0 && hnpInfo->isPublic) {
+        ret = HnpPublicDealAfterInstall(hnpInfo, &job->hnpCfg);
+        job->isRegistered = true;
+    }
+    HNP_LOGI("hnp install end, ret=%{public}d, name=%{public}s, version=%{public}s, extract cost %{public}lld ms, "
+        "link cost %{public}lld ms", ret, job->hnpCfg.name, job->hnpCfg.version, job->extractTime,
+        HnpGetTimeMs() - startTime);
+    return ret;
+}
 
-    while ((entry = readdir(dir)) != NULL) {
-        if ((strcmp(entry->d_name, "public") != 0) && (strcmp(entry->d_name, "private") != 0)) {
+/* 删除本次安装写入的公共hnp安装信息，跳过安装的包只删除安装信息，不删除其他hap共用的目录 */
+static void HnpInstallJobRollbackPublic(HnpInstallJobList *jobList, char *runPaths, const char **prefixes,
+    bool *inUse)
+{
+    int num = 0;
+    for (int i = 0; i < jobList->num; i++) {
+        HnpInstallJob *job = &jobList->jobs[i];
+        if (job->hnpInfo.isPublic && job->isInstalled) {
+            char *runPath = runPaths + num * MAX_FILE_PATH_LEN;
+            if (HnpPublicRunPathGet(job->hnpCfg.name, runPath) != 0) {
+                runPath[0] = '\0'; // 空前缀匹配所有路径，按占用处理
+            }
+            prefixes[num++] = runPath;
+        }
+    }
+    /* 一次遍历进程检查所有待删除的公共hnp是否被占用 */
+    if (num > 0 && HnpProcessInUseCheck(HNP_PROC_ROOT_PATH, prefixes, num, inUse) != 0) {
+        HNP_LOGE("hnp rollback running check unsuccess");
+        for (int i = 0; i < num; i++) {
+            inUse[i] = true;
+        }
+    }
+
+    int index = 0;
+    for (int i = 0; i < jobList->num; i++) {
+        HnpInstallJob *job = &jobList->jobs[i];
+        HapInstallInfo *hapInfo = job->hnpInfo.hapInstallInfo;
+        if (!job->hnpInfo.isPublic || !(job->isInstalled || job->isRegistered)) {
             continue;
         }
-        if (sprintf_s(hnpPath, MAX_FILE_PATH_LEN, "%s/%s", root, entry->d_name) < 0) {
-            HNP_LOGE("hnp install private base path sprintf unsuccess.");
-            closedir(dir);
-            return HNP_ERRNO_BASE_SPRINTF_FAILED;
+        if (!job->isInstalled) {
+            (void)HnpPackageInfoHnpDelete(hapInfo->hapPackageName, job->hnpCfg.name, job->hnpCfg.version);
+            continue;
+        }
+        if (inUse[index++]) {
+            HNP_LOGE("hnp rollback path[%{public}s] is running now", prefixes[index - 1]);
+            continue;
+        }
+        (void)HnpDeletePublicHnp(hapInfo->hapPackageName, job->hnpCfg.name, job->hnpCfg.version, hapInfo->uid,
+            false);
+    }
+}
+
+/* 回滚本次已解压的所有hnp */
+static void HnpInstallJobRollback(HnpInstallJobList *jobList)
+{
+    for (int i = jobList->num - 1; i >= 0; i--) {
+        HnpInstallJob *job = &jobList->jobs[i];
+        if (job->isInstalled && !job->hnpInfo.isPublic) {
+            (void)HnpDeleteFolder(job->hnpInfo.hnpVersionPath);
         }
+    }
+
+    char *runPaths = (char *)malloc((size_t)jobList->num * MAX_FILE_PATH_LEN);
+    const char **prefixes = (const char **)malloc((size_t)jobList->num * sizeof(char *));
+    bool *inUse = (bool *)malloc((size_t)jobList->num * sizeof(bool));
+    if (runPaths != NULL && prefixes != NULL && inUse != NULL) {
+        HnpInstallJobRollbackPublic(jobList, runPaths, prefixes, inUse);
+    } else {
+        HNP_LOGE("hnp rollback public hnp malloc unsuccess");
+    }
+    free(runPaths);
+    free(prefixes);
+    free(inUse);
+}
+
+static int HnpInstallJobListRun(HnpInstallJobList *jobList, int jobs, HnpSignMapInfo *hnpSignMapInfos, int *count)
+{
+    int offset = 0;
+    for (int i = 0; i < jobList->num && hnpSignMapInfos != NULL; i++) {
+        jobList->jobs[i].signMapInfos = hnpSignMapInfos + offset;
+        offset += jobList->jobs[i].signCapacity;
+    }
 
-        int ret = HnpInstallHnpFileCountGet(hnpPath, count);
+    HnpInstallJobExtractAll(jobList, jobs);
+    for (int i = 0; i < jobList->num; i++) {
+        int ret = HnpInstallJobCommit(&jobList->jobs[i]);
         if (ret != 0) {
-            closedir(dir);
+            HnpInstallJobRollback(jobList);
             return ret;
         }
     }
 
-    closedir(dir);
+    /* 按安装顺序合并验签信息 */
+    int sum = 0;
+    for (int i = 0; i < jobList->num; i++) {
+        HnpInstallJob *job = &jobList->jobs[i];
+        if (job->signCount > 0 && job->signMapInfos != hnpSignMapInfos + sum) {
+            (void)memmove_s(hnpSignMapInfos + sum, sizeof(HnpSignMapInfo) * job->signCount, job->signMapInfos,
+                sizeof(HnpSignMapInfo) * job->signCount);
+        }
+        sum += job->signCount;
+    }
+    *count = sum;
     return 0;
 }
 
+static int HapReadAndInstall(const char *dstPath, HapInstallInfo *installInfo, HnpSignMapInfo **hnpSignMapInfos,
+    int *count)
+{
+    HnpInstallJobList jobList = {0};
+
+    int ret = HapReadAndCollect(dstPath, installInfo, &jobList);
+    if (ret != 0 || jobList.num == 0) {
+        HnpInstallJobListFree(&jobList);
+        return ret;
+    }
+
+    /* 安装顺序与目录遍历顺序无关，保证软链及安装信息的写入顺序固定 */
+    qsort(jobList.jobs, jobList.num, sizeof(HnpInstallJob), HnpInstallJobCompare);
+    int signCount = 0;
+    for (int i = 0; i < jobList.num && ret == 0; i++) {
+        ret = HnpInstallJobPrepare(&jobList, i);
+        signCount += jobList.jobs[i].signCapacity;
+    }
+    if (ret == 0 && signCount > 0) {
+        *hnpSignMapInfos = (HnpSignMapInfo *)malloc(sizeof(HnpSignMapInfo) * signCount);
+        if (*hnpSignMapInfos == NULL) {
+            ret = HNP_ERRNO_NOMEM;
+        }
+    }
+    if (ret == 0) {
+        ret = HnpInstallJobListRun(&jobList, installInfo->jobs, *hnpSignMapInfos, count);
+    }
+    HnpInstallJobListFree(&jobList);
+    return ret;
+}
+
 static int SetHnpRestorecon(char *path)
 {
     int ret;
@@ -682,12 +987,8 @@ static int SetHnpRestorecon(char *path)
         }
     }
 
-    if (RestoreconRecurse(publicPath)) {
-        HNP_LOGE("restorecon hnp path fail");
-        return HNP_ERRNO_INSTALLER_RESTORECON_HNP_PATH_FAIL;
-    }
-
-    return 0;
+    /* 子目录在安装对应hnp时刷新 */
+    return HnpRestoreconPath(publicPath, true);
 }
 
 static int CheckInstallPath(char *dstPath, HapInstallInfo *installInfo)
@@ -719,20 +1020,11 @@ static int HnpInsatllPre(HapInstallInfo *installInfo)
 #endif
     int ret;
 
-    if ((ret = CheckInstallPath(dstPath, installInfo)) != 0 ||
-        (ret = HnpInstallHapFileCountGet(installInfo->hnpRootPath, &count)) != 0) {
+    if ((ret = CheckInstallPath(dstPath, installInfo)) != 0) {
         return ret;
     }
 
-    if (count > 0) {
-        hnpSignMapInfos = (HnpSignMapInfo *)malloc(sizeof(HnpSignMapInfo) * count);
-        if (hnpSignMapInfos == NULL) {
-            return HNP_ERRNO_NOMEM;
-        }
-    }
-
-    count = 0;
-    ret = HapReadAndInstall(dstPath, installInfo, hnpSignMapInfos, &count);
+    ret = HapReadAndInstall(dstPath, installInfo, &hnpSignMapInfos, &count);
     HNP_LOGI("sign start hap path[%{public}s],abi[%{public}s],count=%{public}d", installInfo->hapPath, installInfo->abi,
         count);
 #ifdef CODE_SIGNATURE_ENABLE
@@ -766,7 +1058,7 @@ static int ParseInstallArgs(int argc, char *argv[], HapInstallInfo *installInfo)
     int ch;
 
     optind = 1; // 从头开始遍历参数
-    while ((ch = getopt_long(argc, argv, "hu:p:i:s:a:f", NULL, NULL)) != -1) {
+    while ((ch = getopt_long(argc, argv, "hu:p:i:s:a:fj:", NULL, NULL)) != -1) {
         switch (ch) {
             case 'h' :
                 return HNP_ERRNO_OPERATOR_ARGV_MISS;
@@ -792,6 +1084,13 @@ static int ParseInstallArgs(int argc, char *argv[], HapInstallInfo *installInfo)
             case 'f': // is force
                 installInfo->isForce = true;
                 break;
+            case 'j': // 并行安装线程数
+                ret = HnpInstallerJobsGet(optarg, &installInfo->jobs);
+                if (ret != 0) {
+                    HNP_LOGE("hnp install argv jobs[%{public}s] invalid", optarg);
+                    return ret;
+                }
+                break;
             default:
                 break;
         }
@@ -811,6 +1110,7 @@ int HnpCmdInstall(int argc, char *argv[])
     HapInstallInfo installInfo = {0};
 
     installInfo.uid = -1; // 预设值，判断简单
+    installInfo.jobs = 1; // 默认串行安装
     // 解析参数并生成安装信息
     int ret = ParseInstallArgs(argc, argv, &installInfo);
     if (ret != 0) {
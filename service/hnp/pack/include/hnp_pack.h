@@ -31,12 +31,18 @@ extern "C" {
 // 0x801203 压缩目录失败
 #define HNP_ERRNO_PACK_ZIP_DIR_FAILED           HNP_ERRNO_COMMON(HNP_MID_PACK, 0x3)
 
+// 0x801204 打包参数取值非法
+#define HNP_ERRNO_PACK_ARGV_INVALID             HNP_ERRNO_COMMON(HNP_MID_PACK, 0x4)
+
 /* hnp打包参数 */
 typedef struct HnpPackArgvStru {
     char *source;       // 待打包目录
     char *output;       // 打包后文件存放目录
     char *name;         // 软件包名
     char *version;      // 版本号
+    char *level;        // 压缩级别
+    char *jobs;         // 压缩线程数
+    bool reproducible;  // 是否生成可复现的压缩包
 } HnpPackArgv;
 
 /* hnp打包信息 */
@@ -45,6 +51,7 @@ typedef struct HnpPackInfoStru {
     char output[MAX_FILE_PATH_LEN];     // 打包后文件存放目录
     HnpCfgInfo cfgInfo;                 // hnp配置信息
     int hnpCfgExist;                    // 是否存在配置文件
+    HnpZipParam zipParam;               // 压缩参数
 } HnpPackInfo;
 
 int HnpCmdPack(int argc, char *argv[]);
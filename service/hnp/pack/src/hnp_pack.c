@@ -14,10 +14,13 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <unistd.h>
 #include <getopt.h>
 
+#include "zlib.h"
 #include "securec.h"
 
 #include "hnp_pack.h"
@@ -90,7 +93,7 @@ static int PackHnp(const char *hnpSrcPath, const char *hnpDstPath, HnpPackInfo *
     }
 
     /* 将软件包压缩成独立的.hnp文件 */
-    ret = HnpZip(hnpSrcPath, zf);
+    ret = HnpZip(hnpSrcPath, zf, &hnpPack->zipParam);
     if (ret != 0) {
         HNP_LOGE("zip dir unsuccess! srcPath=%{public}s, hnpName=%{public}s, hnpVer=%{public}s, hnpDstPath=%{public}s"
             "ret=%{public}d", hnpSrcPath, hnpCfg->name, hnpCfg->version, hnpDstPath, ret);
@@ -148,6 +151,39 @@ static int GetHnpCfgInfo(const char *hnpCfgPath, const char *sourcePath, HnpCfgI
     return 0;
 }
 
+static int ParsePackNumArg(const char *arg, int min, int max, int *value)
+{
+    char *end = NULL;
+
+    errno = 0;
+    long num = strtol(arg, &end, 10); // 10: 十进制
+    if ((errno != 0) || (end == arg) || (*end != '\0') || (num < min) || (num > max)) {
+        HNP_LOGE("argv[%{public}s] invalid, range [%{public}d, %{public}d].", arg, min, max);
+        return HNP_ERRNO_PACK_ARGV_INVALID;
+    }
+    *value = (int)num;
+    return 0;
+}
+
+static int ParsePackZipArgs(HnpPackArgv *packArgv, HnpPackInfo *packInfo)
+{
+    HnpZipParam *zipParam = &packInfo->zipParam;
+
+    zipParam->level = Z_BEST_COMPRESSION;
+    zipParam->jobs = 1;
+    zipParam->reproducible = packArgv->reproducible;
+    if (packArgv->level != NULL) {
+        int ret = ParsePackNumArg(packArgv->level, Z_NO_COMPRESSION, Z_BEST_COMPRESSION, &zipParam->level);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+    if (packArgv->jobs != NULL) {
+        return ParsePackNumArg(packArgv->jobs, 1, HNP_ZIP_MAX_JOBS, &zipParam->jobs);
+    }
+    return 0;
+}
+
 static int ParsePackArgs(HnpPackArgv *packArgv, HnpPackInfo *packInfo)
 {
     char cfgPath[MAX_FILE_PATH_LEN];
@@ -156,6 +192,10 @@ static int ParsePackArgs(HnpPackArgv *packArgv, HnpPackInfo *packInfo)
         HNP_LOGE("source dir is null.");
         return HNP_ERRNO_OPERATOR_ARGV_MISS;
     }
+    int ret = ParsePackZipArgs(packArgv, packInfo);
+    if (ret != 0) {
+        return ret;
+    }
     if (GetRealPath(packArgv->source, packInfo->source) != 0) {
         HNP_LOGE("source dir path=%{public}s is invalid.", packArgv->source);
         return HNP_ERRNO_PACK_GET_REALPATH_FAILED;
@@ -169,7 +209,7 @@ static int ParsePackArgs(HnpPackArgv *packArgv, HnpPackInfo *packInfo)
         return HNP_ERRNO_PACK_GET_REALPATH_FAILED;
     }
     /* 确认hnp.json文件是否存在，存在则对hnp.json文件进行解析并校验内容是否正确 */
-    int ret = sprintf_s(cfgPath, MAX_FILE_PATH_LEN, "%s%c"HNP_CFG_FILE_NAME, packInfo->source, DIR_SPLIT_SYMBOL);
+    ret = sprintf_s(cfgPath, MAX_FILE_PATH_LEN, "%s%c"HNP_CFG_FILE_NAME, packInfo->source, DIR_SPLIT_SYMBOL);
     if (ret < 0) {
         HNP_LOGE("sprintf unsuccess.");
         return HNP_ERRNO_BASE_SPRINTF_FAILED;
@@ -206,7 +246,7 @@ int HnpCmdPack(int argc, char *argv[])
     int opt;
 
     optind = 1; // 从头开始遍历参数
-    while ((opt = getopt_long(argc, argv, "hi:o:n:v:", NULL, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "hi:o:n:v:l:j:r", NULL, NULL)) != -1) {
         switch (opt) {
             case 'h' :
                 return HNP_ERRNO_OPERATOR_ARGV_MISS;
@@ -222,6 +262,15 @@ int HnpCmdPack(int argc, char *argv[])
             case 'v' :
                 packArgv.version = optarg;
                 break;
+            case 'l' :
+                packArgv.level = optarg;
+                break;
+            case 'j' :
+                packArgv.jobs = optarg;
+                break;
+            case 'r' :
+                packArgv.reproducible = true;
+                break;
             default:
                 break;
         }
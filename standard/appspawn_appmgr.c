@@ -31,6 +31,7 @@
 #include "appspawn_hook.h"
 #include "appspawn_msg.h"
 #include "appspawn_manager.h"
+#include "appspawn_memaudit.h"
 #include "securec.h"
 
 #define SLEEP_DURATION 3000 // us
@@ -285,9 +286,11 @@ AppSpawningCtx *CreateAppSpawningCtx(void)
     property->forkCtx.watcherHandle = NULL;
     property->forkCtx.pidFdWatcherHandle = NULL;
     property->forkCtx.coldRunPath = NULL;
-    property->forkCtx.timer = NULL;
+    AppSpawnInitTimer(&property->forkCtx.timer);
     property->forkCtx.fd[0] = -1;
     property->forkCtx.fd[1] = -1;
+    property->forkCtx.resultSlot = -1;
+    property->forkCtx.timeline.count = 0;
     property->isPrefork = false;
     property->forkCtx.childMsg = NULL;
     property->message = NULL;
@@ -308,10 +311,7 @@ void DeleteAppSpawningCtx(AppSpawningCtx *property)
     DeleteAppSpawnMsg(property->message);
 
     OH_ListRemove(&property->node);
-    if (property->forkCtx.timer) {
-        LE_StopTimer(LE_GetDefaultLoop(), property->forkCtx.timer);
-        property->forkCtx.timer = NULL;
-    }
+    AppSpawnStopTimer(&property->forkCtx.timer);
     if (property->forkCtx.watcherHandle) {
         LE_RemoveWatcher(LE_GetDefaultLoop(), property->forkCtx.watcherHandle);
         property->forkCtx.watcherHandle = NULL;
@@ -320,6 +320,7 @@ void DeleteAppSpawningCtx(AppSpawningCtx *property)
         free(property->forkCtx.coldRunPath);
         property->forkCtx.coldRunPath = NULL;
     }
+    AppSpawnReleaseResultSlot(property);
     if (property->forkCtx.fd[0] >= 0) {
         close(property->forkCtx.fd[0]);
     }
@@ -347,6 +348,23 @@ AppSpawningCtx *GetAppSpawningCtxByPid(pid_t pid)
     return ListEntry(node, AppSpawningCtx, node);
 }
 
+static int AppPropertyCompareClientId(ListNode *node, void *data)
+{
+    AppSpawningCtx *property = ListEntry(node, AppSpawningCtx, node);
+    if (property->client.id == *(uint32_t *)data) {
+        return 0;
+    }
+    return 1;
+}
+
+AppSpawningCtx *GetAppSpawningCtxByClientId(uint32_t id)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(g_appSpawnMgr != NULL, return NULL);
+    ListNode *node = OH_ListFind(&g_appSpawnMgr->appSpawnQueue, (void *)&id, AppPropertyCompareClientId);
+    APPSPAWN_CHECK_ONLY_EXPER(node != NULL, return NULL);
+    return ListEntry(node, AppSpawningCtx, node);
+}
+
 void AppSpawningCtxTraversal(ProcessTraversal traversal, void *data)
 {
     APPSPAWN_CHECK_ONLY_EXPER(g_appSpawnMgr != NULL && traversal != NULL, return);
@@ -359,6 +377,26 @@ void AppSpawningCtxTraversal(ProcessTraversal traversal, void *data)
     }
 }
 
+int FormatSpawnTimeline(const AppSpawnedProcess *appInfo, char *buffer, uint32_t size)
+{
+    const AppSpawnTimeline *timeline = &appInfo->timeline;
+    // 格式: "fork: us stage/prio: start-end ..."，fork为从收到消息到子进程执行第一个hook的耗时
+    int len = snprintf_s(buffer, size, size - 1, "fork: %" PRIu64,
+        DiffTime(&appInfo->spawnStart, &timeline->base));
+    APPSPAWN_CHECK(len > 0, return -1, "Failed to format timeline");
+    uint32_t count = timeline->count < APP_SPAWN_TIMELINE_MAX ? timeline->count : APP_SPAWN_TIMELINE_MAX;
+    for (uint32_t i = 0; i < count; i++) {
+        const AppSpawnTimelineItem *item = &timeline->items[i];
+        int ret = snprintf_s(buffer + len, size - (uint32_t)len, size - (uint32_t)len - 1, " %u/%u: %u-%u",
+            item->stage, item->prio, item->start, item->end);
+        if (ret < 0) {  // 超长截断
+            break;
+        }
+        len += ret;
+    }
+    return len;
+}
+
 static int DumpAppSpawnQueue(ListNode *node, void *data)
 {
     AppSpawningCtx *property = ListEntry(node, AppSpawningCtx, node);
@@ -377,6 +415,12 @@ static int DumpAppQueue(ListNode *node, void *data)
     APPSPAPWN_DUMP("App info uid: %{public}u pid: %{public}x", appInfo->uid, appInfo->pid);
     APPSPAPWN_DUMP("App info name: %{public}s exitStatus: 0x%{public}x spawn time: %{public}" PRIu64 " us ",
         appInfo->name, appInfo->exitStatus, diff);
+    if (appInfo->timeline.count > 0) {
+        char buffer[1024] = {0};  // 1024 max
+        if (FormatSpawnTimeline(appInfo, buffer, sizeof(buffer)) > 0) {
+            APPSPAPWN_DUMP("App info timeline: %{public}s", buffer);
+        }
+    }
     return 0;
 }
 
@@ -421,8 +465,16 @@ void ProcessAppSpawnDumpMsg(const AppSpawnMsgNode *message)
     OH_ListTraversal((ListNode *)&g_appSpawnMgr->appQueue, "App queue", DumpAppQueue, 0);
     APPSPAPWN_DUMP("APP died queue: ");
     OH_ListTraversal((ListNode *)&g_appSpawnMgr->diedQueue, "App died queue", DumpAppQueue, 0);
+    DumpSpawnQuarantine();
     APPSPAPWN_DUMP("Ext data: ");
     OH_ListTraversal((ListNode *)&g_appSpawnMgr->extData, "Ext data", DumpExtData, 0);
+    char *memPid = GetAppSpawnMsgExtInfo(message, MSG_EXT_NAME_MEM_AUDIT_PID, NULL);
+    if (memPid != NULL) {
+        DumpAppMemorySharing(atoi(memPid));
+    }
+#ifdef APPSPAWN_LOG_RING
+    AppSpawnLogRingDump();
+#endif
     APPSPAPWN_DUMP("Dump appspawn info finish ");
     if (stream != NULL) {
         (void)fflush(stream);
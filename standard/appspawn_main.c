@@ -25,8 +25,6 @@
 #include "parameter.h"
 #include "securec.h"
 
-#define APPSPAWN_PRELOAD "libappspawn_helper.z.so"
-
 #ifndef CJAPP_SPAWN
 static AppSpawnStartArgTemplate g_appSpawnStartArgTemplate[PROCESS_INVALID] = {
     {APPSPAWN_SERVER_NAME, {MODE_FOR_APP_SPAWN, MODULE_APPSPAWN, APPSPAWN_SOCKET_NAME, APPSPAWN_SERVER_NAME, 1}},
@@ -102,9 +100,6 @@ int main(int argc, char *const argv[])
     if (end == 0) {
         return 0;
     }
-    InitCommonEnv();
-    CheckPreload(argv);
-    (void)signal(SIGPIPE, SIG_IGN);
     uint32_t argvSize = end - start;
     AppSpawnStartArg *arg;
     AppSpawnStartArgTemplate *argTemp = NULL;
@@ -125,6 +120,12 @@ int main(int argc, char *const argv[])
     }
 #endif
     arg = &argTemp->arg;
+    // 冷启动进程继承了appspawn的环境变量，不需要再次初始化
+    if (arg->initArg != 0 || !IsLeanColdRunEnabled()) {
+        InitCommonEnv();
+    }
+    CheckPreload(argv);
+    (void)signal(SIGPIPE, SIG_IGN);
     if (arg->initArg == 0) {
         APPSPAWN_CHECK(argc >= ARG_NULL, return 0, "Invalid arg for cold start %{public}d", argc);
     } else {
@@ -24,6 +24,7 @@
 #include "appspawn_hook.h"
 #include "appspawn_msg.h"
 #include "appspawn_server.h"
+#include "appspawn_timer.h"
 #include "appspawn_utils.h"
 #include "list.h"
 #include "loop_event.h"
@@ -53,6 +54,10 @@ extern "C" {
 
 #define APPSPAWN_INLINE __attribute__((always_inline)) inline
 
+#define APP_SPAWN_TIMELINE_MAX 32
+#define APP_SPAWN_SLOW_THRESHOLD (100 * 1000)  // 100ms，超过时输出子进程各阶段耗时
+#define APP_SPAWN_RESULT_SLOT_MAX 64
+
 typedef struct AppSpawnContent AppSpawnContent;
 typedef struct AppSpawnClient AppSpawnClient;
 typedef struct TagAppSpawnConnection AppSpawnConnection;
@@ -65,14 +70,35 @@ typedef struct TagAppSpawnMsgNode {
     uint8_t *buffer;
 } AppSpawnMsgNode;
 
+typedef struct {
+    uint16_t stage;
+    uint16_t prio;
+    uint32_t start;  // us, 相对于timeline的base
+    uint32_t end;
+} AppSpawnTimelineItem;
+
+typedef struct {
+    struct timespec base;  // 子进程执行第一个hook的时间
+    uint32_t count;
+    AppSpawnTimelineItem items[APP_SPAWN_TIMELINE_MAX];
+} AppSpawnTimeline;
+
+// 子进程通过fd[1]回复给父进程的结果
+typedef struct {
+    int result;
+    AppSpawnTimeline timeline;
+} AppSpawnChildResponse;
+
 typedef struct {
     int32_t fd[2];  // 2 fd count
     WatcherHandle watcherHandle;
     WatcherHandle pidFdWatcherHandle;
-    TimerHandle timer;
+    AppSpawnTimer timer;
     char *childMsg;
     uint32_t msgSize;
     char *coldRunPath;
+    int32_t resultSlot;  // 共享结果槽，-1时通过fd回复结果
+    AppSpawnTimeline timeline;
 } AppSpawnForkCtx;
 
 typedef struct TagAppSpawningCtx {
@@ -94,6 +120,7 @@ typedef struct TagAppSpawnedProcess {
     int exitStatus;
     struct timespec spawnStart;
     struct timespec spawnEnd;
+    AppSpawnTimeline timeline;
 #ifdef DEBUG_BEGETCTL_BOOT
     AppSpawnMsgNode *message;
 #endif
@@ -119,6 +146,7 @@ typedef struct TagAppSpawnMgr {
     struct timespec perLoadEnd;
     struct ListNode extData;
     struct SpawnTime spawnTime;
+    uint32_t sandboxGeneration;  // 沙盒挂载点更新计数，用于沙盒命名空间缓存失效
 } AppSpawnMgr;
 
 /**
@@ -130,6 +158,46 @@ AppSpawnMgr *GetAppSpawnMgr(void);
 void DeleteAppSpawnMgr(AppSpawnMgr *mgr);
 AppSpawnContent *GetAppSpawnContent(void);
 
+/**
+ * @brief 后台任务，在常驻的工作线程中逐个执行；路径任务完成后恢复延后的孵化请求
+ *
+ */
+void AppSpawnDestroyWorker(void);
+void AppSpawnResumeDeferredSpawn(void);
+
+/**
+ * @brief 共享结果槽，子进程写入结果后通过一个共享的eventfd通知父进程，父进程一次唤醒处理所有已完成的结果
+ *
+ */
+typedef void (*ChildResultProcess)(AppSpawningCtx *property, const AppSpawnChildResponse *response, bool hasTimeline);
+int AppSpawnAcquireResultSlot(AppSpawningCtx *property, ChildResultProcess process);
+void AppSpawnReleaseResultSlot(AppSpawningCtx *property);
+int AppSpawnWriteResultSlot(const AppSpawningCtx *property, const AppSpawnChildResponse *response);
+void AppSpawnDetachResultSlab(void);
+void AppSpawnDestroyResultSlab(void);
+
+/**
+ * @brief 按bundle及孵化方式统计孵化失败，连续失败的bundle按指数退避隔离，隔离期间直接返回失败
+ *
+ */
+#define APP_SPAWN_QUARANTINE_MAX 32
+int AppSpawnCheckQuarantine(const AppSpawnMsgNode *message);
+bool AppSpawnRecordSpawnFailure(const AppSpawnMsgNode *message);
+void AppSpawnRecordSpawnSuccess(const AppSpawnMsgNode *message);
+void DumpSpawnQuarantine(void);
+
+/**
+ * @brief 处理非appspawn直接fork的子进程退出，如pid namespace中fork helper孵化的应用
+ *
+ */
+void AppSpawnProcessChildExit(pid_t pid, uid_t uid, int status);
+
+/**
+ * @brief forkChild返回成功但pid为0时，插件在子进程创建完成后上报pid或者失败原因
+ *
+ */
+void AppSpawnProcessForkResult(AppSpawningCtx *property, pid_t pid, int result);
+
 /**
  * @brief 孵化成功后进程或者app实例的操作
  *
@@ -140,6 +208,7 @@ AppSpawnedProcess *AddSpawnedProcess(pid_t pid, const char *processName);
 AppSpawnedProcess *GetSpawnedProcess(pid_t pid);
 AppSpawnedProcess *GetSpawnedProcessByName(const char *name);
 void TerminateSpawnedProcess(AppSpawnedProcess *node);
+int FormatSpawnTimeline(const AppSpawnedProcess *appInfo, char *buffer, uint32_t size);
 
 /**
  * @brief 孵化过程中的ctx对象的操作
@@ -148,6 +217,7 @@ void TerminateSpawnedProcess(AppSpawnedProcess *node);
 typedef void (*ProcessTraversal)(const AppSpawnMgr *mgr, AppSpawningCtx *ctx, void *data);
 void AppSpawningCtxTraversal(ProcessTraversal traversal, void *data);
 AppSpawningCtx *GetAppSpawningCtxByPid(pid_t pid);
+AppSpawningCtx *GetAppSpawningCtxByClientId(uint32_t id);
 AppSpawningCtx *CreateAppSpawningCtx();
 void DeleteAppSpawningCtx(AppSpawningCtx *property);
 int KillAndWaitStatus(pid_t pid, int sig, int *exitStatus);
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "appspawn_memaudit.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "appspawn_manager.h"
+#include "appspawn_utils.h"
+#include "securec.h"
+
+#define PAGEMAP_ENTRY_PRESENT (1ULL << 63)
+#define PAGEMAP_PFN_MASK ((1ULL << 55) - 1)  // bits 0-54
+#define PAGEMAP_BATCH_COUNT 512
+#define SMAPS_LINE_MAX 512
+#define SMAPS_NAME_FIELD 5  // 地址、权限、偏移、设备、inode之后为映射名
+#define BYTES_PER_KB 1024
+
+typedef struct {
+    int childFd;
+    int parentFd;
+    uint64_t pageSize;
+    MemAuditResult *result;
+} MemAuditContext;
+
+static const char *g_memAuditTypeName[MEM_AUDIT_TYPE_MAX] = {
+    "js heap", "ace lib", "malloc", "other file", "other anon"
+};
+
+MemAuditType GetMemAuditType(const char *name)
+{
+    if (name == NULL || name[0] == '\0') {
+        return MEM_AUDIT_OTHER_ANON;
+    }
+    if (strncmp(name, "[anon:Ark", strlen("[anon:Ark")) == 0) {
+        return MEM_AUDIT_JS_HEAP;
+    }
+    if (strstr(name, "/libace") != NULL) {
+        return MEM_AUDIT_ACE_LIB;
+    }
+    if (strcmp(name, "[heap]") == 0 || strncmp(name, "[anon:libc_malloc", strlen("[anon:libc_malloc")) == 0 ||
+        strncmp(name, "[anon:native_heap", strlen("[anon:native_heap")) == 0 ||
+        strncmp(name, "[anon:scudo", strlen("[anon:scudo")) == 0 ||
+        strncmp(name, "[anon:jemalloc", strlen("[anon:jemalloc")) == 0) {
+        return MEM_AUDIT_MALLOC;
+    }
+    return name[0] == '/' ? MEM_AUDIT_OTHER_FILE : MEM_AUDIT_OTHER_ANON;
+}
+
+static bool IsPfnReadable(int pagemapFd, uint64_t pageSize)
+{
+    // 读取本进程栈上一页的页号，无CAP_SYS_ADMIN时页号为0
+    volatile uint64_t probe = 1;
+    uint64_t entry = 0;
+    off_t offset = (off_t)((uintptr_t)&probe / pageSize * sizeof(uint64_t));
+    if (pread(pagemapFd, &entry, sizeof(entry), offset) != (ssize_t)sizeof(entry)) {
+        return false;
+    }
+    return (entry & PAGEMAP_ENTRY_PRESENT) != 0 && (entry & PAGEMAP_PFN_MASK) != 0;
+}
+
+static void ComparePages(const MemAuditContext *context, MemAuditMapping *mapping)
+{
+    uint64_t child[PAGEMAP_BATCH_COUNT];
+    uint64_t parent[PAGEMAP_BATCH_COUNT];
+    uint64_t pageKb = context->pageSize / BYTES_PER_KB;
+    uint64_t endPage = mapping->end / context->pageSize;
+    for (uint64_t page = mapping->start / context->pageSize; page < endPage;) {
+        uint64_t count = endPage - page < PAGEMAP_BATCH_COUNT ? endPage - page : PAGEMAP_BATCH_COUNT;
+        off_t offset = (off_t)(page * sizeof(uint64_t));
+        ssize_t len = pread(context->childFd, child, count * sizeof(uint64_t), offset);
+        if (len <= 0) {
+            break;
+        }
+        count = (uint64_t)len / sizeof(uint64_t);
+        (void)memset_s(parent, sizeof(parent), 0, sizeof(parent));
+        (void)pread(context->parentFd, parent, count * sizeof(uint64_t), offset);
+        for (uint64_t i = 0; i < count; i++) {
+            if ((child[i] & PAGEMAP_ENTRY_PRESENT) == 0 || (parent[i] & PAGEMAP_ENTRY_PRESENT) == 0) {
+                continue;
+            }
+            if ((child[i] & PAGEMAP_PFN_MASK) == (parent[i] & PAGEMAP_PFN_MASK)) {
+                mapping->stat.shared += pageKb;
+            } else {
+                mapping->stat.copied += pageKb;
+            }
+        }
+        page += count;
+    }
+}
+
+static void AddMemAuditStat(MemAuditStat *total, const MemAuditStat *stat)
+{
+    total->rss += stat->rss;
+    total->privateDirty += stat->privateDirty;
+    total->shared += stat->shared;
+    total->copied += stat->copied;
+}
+
+static uint64_t GetMemAuditOrder(const MemAuditResult *result, const MemAuditMapping *mapping)
+{
+    return result->pfnValid ? mapping->stat.copied : mapping->stat.privateDirty;
+}
+
+static void AddTopMapping(MemAuditResult *result, const MemAuditMapping *mapping)
+{
+    uint64_t order = GetMemAuditOrder(result, mapping);
+    if (order == 0) {
+        return;
+    }
+    uint32_t index = result->topCount;
+    while (index > 0 && GetMemAuditOrder(result, &result->top[index - 1]) < order) {
+        index--;
+    }
+    if (index >= MEM_AUDIT_TOP_COUNT) {
+        return;
+    }
+    uint32_t last = result->topCount < MEM_AUDIT_TOP_COUNT ? result->topCount : MEM_AUDIT_TOP_COUNT - 1;
+    uint32_t moveCount = last - index;
+    if (moveCount > 0) {
+        (void)memmove_s(&result->top[index + 1], (MEM_AUDIT_TOP_COUNT - index - 1) * sizeof(MemAuditMapping),
+            &result->top[index], moveCount * sizeof(MemAuditMapping));
+    }
+    result->top[index] = *mapping;
+    if (result->topCount < MEM_AUDIT_TOP_COUNT) {
+        result->topCount++;
+    }
+}
+
+static void FinishMapping(const MemAuditContext *context, MemAuditMapping *mapping)
+{
+    if (mapping->end <= mapping->start || mapping->stat.rss == 0) {
+        return;
+    }
+    MemAuditResult *result = context->result;
+    if (result->pfnValid) {
+        ComparePages(context, mapping);
+    }
+    AddMemAuditStat(&result->stats[mapping->type], &mapping->stat);
+    AddMemAuditStat(&result->total, &mapping->stat);
+    AddTopMapping(result, mapping);
+}
+
+static bool ParseMappingHeader(char *line, MemAuditMapping *mapping)
+{
+    char *next = NULL;
+    uint64_t start = strtoull(line, &next, 16);  // 16 hex
+    if (next == line || *next != '-') {
+        return false;
+    }
+    uint64_t end = strtoull(next + 1, NULL, 16);  // 16 hex
+    (void)memset_s(mapping, sizeof(MemAuditMapping), 0, sizeof(MemAuditMapping));
+    mapping->start = start;
+    mapping->end = end;
+    line[strcspn(line, "\n")] = '\0';
+    char *name = line;
+    for (uint32_t i = 0; i < SMAPS_NAME_FIELD && name != NULL; i++) {
+        name = strchr(name, ' ');
+        name = name == NULL ? NULL : name + strspn(name, " ");
+    }
+    if (name != NULL) {
+        (void)strncpy_s(mapping->name, sizeof(mapping->name), name, sizeof(mapping->name) - 1);
+    }
+    mapping->type = GetMemAuditType(mapping->name);
+    return true;
+}
+
+static void ParseMappingField(const char *line, MemAuditMapping *mapping)
+{
+    if (strncmp(line, "Rss:", strlen("Rss:")) == 0) {
+        mapping->stat.rss = strtoull(line + strlen("Rss:"), NULL, 10);  // 10 decimal
+    } else if (strncmp(line, "Private_Dirty:", strlen("Private_Dirty:")) == 0) {
+        mapping->stat.privateDirty = strtoull(line + strlen("Private_Dirty:"), NULL, 10);  // 10 decimal
+    }
+}
+
+int AuditMemorySharing(const char *smapsPath, const char *pagemapPath, const char *parentPagemap,
+    MemAuditResult *result)
+{
+    APPSPAWN_CHECK(smapsPath != NULL && result != NULL, return APPSPAWN_ARG_INVALID, "Invalid mem audit arg");
+    (void)memset_s(result, sizeof(MemAuditResult), 0, sizeof(MemAuditResult));
+    FILE *fp = fopen(smapsPath, "r");
+    APPSPAWN_CHECK(fp != NULL, return errno, "Failed to open %{public}s errno: %{public}d", smapsPath, errno);
+    MemAuditContext context = {-1, -1, (uint64_t)sysconf(_SC_PAGESIZE), result};
+    if (pagemapPath != NULL && parentPagemap != NULL) {
+        context.childFd = open(pagemapPath, O_RDONLY | O_CLOEXEC);
+        context.parentFd = open(parentPagemap, O_RDONLY | O_CLOEXEC);
+        result->pfnValid = context.childFd >= 0 && context.parentFd >= 0 &&
+            IsPfnReadable(context.parentFd, context.pageSize);
+    }
+
+    MemAuditMapping mapping = {};
+    char line[SMAPS_LINE_MAX] = {0};
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        // 映射行以地址开始，其余为"Key: value kB"
+        size_t keyLen = strcspn(line, " ");
+        if (keyLen > 0 && line[keyLen - 1] == ':') {
+            ParseMappingField(line, &mapping);
+            continue;
+        }
+        FinishMapping(&context, &mapping);
+        if (!ParseMappingHeader(line, &mapping)) {
+            (void)memset_s(&mapping, sizeof(mapping), 0, sizeof(mapping));
+        }
+    }
+    FinishMapping(&context, &mapping);
+    (void)fclose(fp);
+    if (context.childFd >= 0) {
+        close(context.childFd);
+    }
+    if (context.parentFd >= 0) {
+        close(context.parentFd);
+    }
+    return 0;
+}
+
+static void DumpMemAuditStat(const char *name, const MemAuditStat *stat)
+{
+    APPSPAPWN_DUMP("    %{public}s rss: %{public}" PRIu64 " KB private dirty: %{public}" PRIu64
+        " KB shared: %{public}" PRIu64 " KB copied: %{public}" PRIu64 " KB",
+        name, stat->rss, stat->privateDirty, stat->shared, stat->copied);
+}
+
+void DumpAppMemorySharing(pid_t pid)
+{
+    // 只允许审计appspawn孵化的应用
+    AppSpawnedProcess *appInfo = GetSpawnedProcess(pid);
+    APPSPAWN_CHECK(appInfo != NULL, return, "Can not find app %{public}d for mem audit", pid);
+    char smapsPath[32] = {0};    // 32 max of /proc/<pid>/smaps
+    char pagemapPath[32] = {0};  // 32 max of /proc/<pid>/pagemap
+    int ret = snprintf_s(smapsPath, sizeof(smapsPath), sizeof(smapsPath) - 1, "/proc/%d/smaps", pid);
+    APPSPAWN_CHECK_ONLY_EXPER(ret > 0, return);
+    ret = snprintf_s(pagemapPath, sizeof(pagemapPath), sizeof(pagemapPath) - 1, "/proc/%d/pagemap", pid);
+    APPSPAWN_CHECK_ONLY_EXPER(ret > 0, return);
+
+    MemAuditResult *result = (MemAuditResult *)calloc(1, sizeof(MemAuditResult));
+    APPSPAWN_CHECK(result != NULL, return, "Failed to alloc mem audit result");
+    ret = AuditMemorySharing(smapsPath, pagemapPath, "/proc/self/pagemap", result);
+    if (ret != 0) {
+        free(result);
+        return;
+    }
+    APPSPAPWN_DUMP("Memory sharing of app %{public}s pid: %{public}d pfn: %{public}d",
+        appInfo->name, pid, result->pfnValid);
+    DumpMemAuditStat("total", &result->total);
+    for (uint32_t i = 0; i < MEM_AUDIT_TYPE_MAX; i++) {
+        DumpMemAuditStat(g_memAuditTypeName[i], &result->stats[i]);
+    }
+    APPSPAPWN_DUMP("Top mappings by %{public}s: ", result->pfnValid ? "copied" : "private dirty");
+    for (uint32_t i = 0; i < result->topCount; i++) {
+        const MemAuditMapping *mapping = &result->top[i];
+        APPSPAPWN_DUMP("    %{public}" PRIx64 "-%{public}" PRIx64 " %{public}s rss: %{public}" PRIu64
+            " KB private dirty: %{public}" PRIu64 " KB copied: %{public}" PRIu64 " KB", mapping->start, mapping->end,
+            mapping->name, mapping->stat.rss, mapping->stat.privateDirty, mapping->stat.copied);
+    }
+    free(result);
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef APPSPAWN_MEMAUDIT_H
+#define APPSPAWN_MEMAUDIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEM_AUDIT_NAME_MAX 128
+#define MEM_AUDIT_TOP_COUNT 10
+#define MSG_EXT_NAME_MEM_AUDIT_PID "mem-pid"  // dump消息中指定审计的应用pid
+
+typedef enum {
+    MEM_AUDIT_JS_HEAP,
+    MEM_AUDIT_ACE_LIB,
+    MEM_AUDIT_MALLOC,
+    MEM_AUDIT_OTHER_FILE,
+    MEM_AUDIT_OTHER_ANON,
+    MEM_AUDIT_TYPE_MAX
+} MemAuditType;
+
+typedef struct {
+    uint64_t rss;           // KB
+    uint64_t privateDirty;  // KB
+    uint64_t shared;        // KB, still the same page of appspawn
+    uint64_t copied;        // KB, page of appspawn copied after fork
+} MemAuditStat;
+
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    MemAuditType type;
+    MemAuditStat stat;
+    char name[MEM_AUDIT_NAME_MAX];
+} MemAuditMapping;
+
+typedef struct {
+    bool pfnValid;  // 无权限读取物理页号时，只统计smaps
+    MemAuditStat total;
+    MemAuditStat stats[MEM_AUDIT_TYPE_MAX];
+    uint32_t topCount;
+    MemAuditMapping top[MEM_AUDIT_TOP_COUNT];  // 按copied(无页号时按privateDirty)降序
+} MemAuditResult;
+
+/**
+ * @brief 统计应用与appspawn共享的内存，smapsPath/pagemapPath为应用的smaps及pagemap，
+ *        parentPagemap为appspawn的pagemap
+ */
+int AuditMemorySharing(const char *smapsPath, const char *pagemapPath, const char *parentPagemap,
+    MemAuditResult *result);
+MemAuditType GetMemAuditType(const char *name);
+void DumpAppMemorySharing(pid_t pid);
+
+#ifdef __cplusplus
+}
+#endif
+#endif  // APPSPAWN_MEMAUDIT_H
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "appspawn_manager.h"
+#include "appspawn_utils.h"
+#include "securec.h"
+
+#define QUARANTINE_THRESHOLD 3                  // 连续失败3次后开始隔离
+#define QUARANTINE_BASE_TIME 2000               // 首次隔离2s，之后每次失败翻倍
+#define QUARANTINE_MAX_TIME (5 * 60 * 1000)     // 最长隔离5min
+#define QUARANTINE_MAX_SHIFT 16
+#define QUARANTINE_RESET_TIME (10 * 60 * 1000)  // 10min内没有再失败则重新计数
+#define QUARANTINE_MODE_COLD 0x100
+#define RESTART_BUNDLE_COUNT 5                  // 连续失败涉及5个不同bundle时重启
+#define RESTART_WINDOW_TIME (60 * 1000)         // 只统计1min内的连续失败
+
+typedef struct {
+    char bundleName[APP_LEN_BUNDLE_NAME];
+    uint32_t mode;           // 消息类型及是否冷启动
+    uint32_t failures;       // 连续失败次数
+    uint32_t rejected;       // 隔离期间拒绝的请求数
+    uint64_t lastFailure;    // ms, CLOCK_MONOTONIC
+    uint64_t expire;         // 隔离截止时间
+    bool inStreak;
+} AppSpawnQuarantine;
+
+static struct {
+    AppSpawnQuarantine items[APP_SPAWN_QUARANTINE_MAX];
+    uint32_t streakCount;    // 本轮连续失败涉及的bundle数，任一孵化成功时清零
+    uint64_t streakStart;
+} g_quarantine = {};
+
+static uint64_t GetCurrentMs(void)
+{
+    struct timespec now = {0};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * APPSPAWN_SEC_TO_MSEC + (uint64_t)now.tv_nsec / APPSPAWN_MSEC_TO_NSEC;
+}
+
+static uint32_t GetQuarantineMode(const AppSpawnMsgNode *message)
+{
+    // 冷启动与普通孵化分开统计
+    uint32_t mode = message->msgHeader.msgType;
+    if (CheckAppSpawnMsgFlag(message, TLV_MSG_FLAGS, APP_FLAGS_COLD_BOOT)) {
+        mode |= QUARANTINE_MODE_COLD;
+    }
+    return mode;
+}
+
+static const char *GetQuarantineName(const AppSpawnMsgNode *message)
+{
+    AppSpawnMsgBundleInfo *info = (AppSpawnMsgBundleInfo *)GetAppSpawnMsgInfo(message, TLV_BUNDLE_INFO);
+    return info != NULL ? info->bundleName : message->msgHeader.processName;
+}
+
+static AppSpawnQuarantine *FindQuarantine(const char *name, uint32_t mode)
+{
+    for (uint32_t i = 0; i < APP_SPAWN_QUARANTINE_MAX; i++) {
+        AppSpawnQuarantine *item = &g_quarantine.items[i];
+        if (item->bundleName[0] != '\0' && item->mode == mode && strcmp(item->bundleName, name) == 0) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static AppSpawnQuarantine *AddQuarantine(const char *name, uint32_t mode)
+{
+    // 没有空闲记录时替换最早失败的
+    AppSpawnQuarantine *item = &g_quarantine.items[0];
+    for (uint32_t i = 0; i < APP_SPAWN_QUARANTINE_MAX; i++) {
+        if (g_quarantine.items[i].bundleName[0] == '\0') {
+            item = &g_quarantine.items[i];
+            break;
+        }
+        if (g_quarantine.items[i].lastFailure < item->lastFailure) {
+            item = &g_quarantine.items[i];
+        }
+    }
+    (void)memset_s(item, sizeof(AppSpawnQuarantine), 0, sizeof(AppSpawnQuarantine));
+    (void)strncpy_s(item->bundleName, sizeof(item->bundleName), name, sizeof(item->bundleName) - 1);
+    item->mode = mode;
+    return item;
+}
+
+static void ClearFailureStreak(void)
+{
+    for (uint32_t i = 0; i < APP_SPAWN_QUARANTINE_MAX; i++) {
+        g_quarantine.items[i].inStreak = false;
+    }
+    g_quarantine.streakCount = 0;
+    g_quarantine.streakStart = 0;
+}
+
+static void AddFailureStreak(AppSpawnQuarantine *item, uint64_t now)
+{
+    if (g_quarantine.streakCount > 0 && now - g_quarantine.streakStart > RESTART_WINDOW_TIME) {
+        ClearFailureStreak();
+    }
+    if (item->inStreak) {
+        return;
+    }
+    item->inStreak = true;
+    // 同一bundle不同孵化方式的失败只统计一次
+    for (uint32_t i = 0; i < APP_SPAWN_QUARANTINE_MAX; i++) {
+        AppSpawnQuarantine *other = &g_quarantine.items[i];
+        if (other != item && other->inStreak && strcmp(other->bundleName, item->bundleName) == 0) {
+            return;
+        }
+    }
+    if (g_quarantine.streakCount++ == 0) {
+        g_quarantine.streakStart = now;
+    }
+}
+
+APPSPAWN_STATIC int CheckSpawnQuarantine(const char *name, uint32_t mode, uint64_t now)
+{
+    AppSpawnQuarantine *item = FindQuarantine(name, mode);
+    // 隔离到期后放行一次，再次失败时隔离时间加倍
+    if (item == NULL || item->expire <= now) {
+        return 0;
+    }
+    item->rejected++;
+    return APPSPAWN_SPAWN_QUARANTINED;
+}
+
+APPSPAWN_STATIC bool RecordSpawnFailure(const char *name, uint32_t mode, uint64_t now)
+{
+    AppSpawnQuarantine *item = FindQuarantine(name, mode);
+    if (item == NULL) {
+        item = AddQuarantine(name, mode);
+    } else if (now - item->lastFailure > QUARANTINE_RESET_TIME) {
+        item->failures = 0;
+    }
+    item->failures++;
+    item->lastFailure = now;
+    if (item->failures >= QUARANTINE_THRESHOLD) {
+        uint32_t shift = item->failures - QUARANTINE_THRESHOLD;
+        uint64_t duration = QUARANTINE_MAX_TIME;
+        if (shift < QUARANTINE_MAX_SHIFT) {
+            duration = (uint64_t)QUARANTINE_BASE_TIME << shift;
+            duration = duration < QUARANTINE_MAX_TIME ? duration : QUARANTINE_MAX_TIME;
+        }
+        item->expire = now + duration;
+        APPSPAWN_LOGW("Quarantine %{public}s mode 0x%{public}x failures %{public}u for %{public}" PRIu64 " ms",
+            item->bundleName, item->mode, item->failures, duration);
+    }
+    AddFailureStreak(item, now);
+    return g_quarantine.streakCount >= RESTART_BUNDLE_COUNT;
+}
+
+APPSPAWN_STATIC void RecordSpawnSuccess(const char *name, uint32_t mode)
+{
+    ClearFailureStreak();
+    AppSpawnQuarantine *item = FindQuarantine(name, mode);
+    if (item != NULL) {
+        (void)memset_s(item, sizeof(AppSpawnQuarantine), 0, sizeof(AppSpawnQuarantine));
+    }
+}
+
+int AppSpawnCheckQuarantine(const AppSpawnMsgNode *message)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(message != NULL, return 0);
+    int ret = CheckSpawnQuarantine(GetQuarantineName(message), GetQuarantineMode(message), GetCurrentMs());
+    APPSPAWN_CHECK_ONLY_LOG(ret == 0, "Spawn %{public}s quarantined", GetQuarantineName(message));
+    return ret;
+}
+
+bool AppSpawnRecordSpawnFailure(const AppSpawnMsgNode *message)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(message != NULL, return false);
+    return RecordSpawnFailure(GetQuarantineName(message), GetQuarantineMode(message), GetCurrentMs());
+}
+
+void AppSpawnRecordSpawnSuccess(const AppSpawnMsgNode *message)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(message != NULL, return);
+    RecordSpawnSuccess(GetQuarantineName(message), GetQuarantineMode(message));
+}
+
+void DumpSpawnQuarantine(void)
+{
+    uint64_t now = GetCurrentMs();
+    APPSPAPWN_DUMP("Spawn failure streak bundles: %{public}u", g_quarantine.streakCount);
+    for (uint32_t i = 0; i < APP_SPAWN_QUARANTINE_MAX; i++) {
+        const AppSpawnQuarantine *item = &g_quarantine.items[i];
+        if (item->bundleName[0] == '\0') {
+            continue;
+        }
+        uint64_t remain = item->expire > now ? item->expire - now : 0;
+        APPSPAPWN_DUMP("Quarantine bundle: %{public}s mode: 0x%{public}x failures: %{public}u "
+            "rejected: %{public}u remain: %{public}" PRIu64 " ms",
+            item->bundleName, item->mode, item->failures, item->rejected, remain);
+    }
+}
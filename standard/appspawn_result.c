@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+
+#include "appspawn_manager.h"
+#include "appspawn_utils.h"
+#include "loop_event.h"
+#include "securec.h"
+
+#define RESULT_SLOT_FREE 0
+#define RESULT_SLOT_WAIT 1  // 已分配给子进程，等待结果
+#define RESULT_SLOT_WRITING 2  // 子进程已占用，正在写入结果
+#define RESULT_SLOT_DONE 3  // 子进程已写入结果
+
+// 状态与clientId合为一个字，子进程通过一次CAS确认槽仍属于自己
+#define RESULT_SLOT_CLIENT_SHIFT 32
+#define RESULT_SLOT_WORD(clientId, state) (((uint64_t)(clientId) << RESULT_SLOT_CLIENT_SHIFT) | (state))
+#define RESULT_SLOT_STATE(word) ((uint32_t)((word) & UINT32_MAX))
+#define RESULT_SLOT_CLIENT(word) ((uint32_t)((word) >> RESULT_SLOT_CLIENT_SHIFT))
+
+// 父子进程共享的结果槽，子进程写入结果后通过eventfd通知父进程
+typedef struct {
+    uint64_t owner;
+    AppSpawnChildResponse response;
+} AppSpawnResultSlot;
+
+typedef struct {
+    AppSpawnResultSlot *slots;
+    AppSpawningCtx *owners[APP_SPAWN_RESULT_SLOT_MAX];  // 仅父进程使用
+    ChildResultProcess process;
+    WatcherHandle watcher;
+    int eventFd;
+    pid_t ownerPid;
+    uint32_t next;
+} AppSpawnResultSlab;
+
+static AppSpawnResultSlab g_resultSlab = {NULL, {NULL}, NULL, NULL, -1, 0, 0};
+
+APPSPAWN_STATIC void ProcessResultSlots(void)
+{
+    for (uint32_t i = 0; i < APP_SPAWN_RESULT_SLOT_MAX; i++) {
+        AppSpawningCtx *property = g_resultSlab.owners[i];
+        AppSpawnResultSlot *slot = &g_resultSlab.slots[i];
+        uint64_t owner = __atomic_load_n(&slot->owner, __ATOMIC_ACQUIRE);
+        if (RESULT_SLOT_STATE(owner) != RESULT_SLOT_DONE) {
+            continue;
+        }
+        if (property == NULL || RESULT_SLOT_CLIENT(owner) != property->client.id) {
+            // 请求已被回收，丢弃迟到的结果
+            __atomic_store_n(&slot->owner, RESULT_SLOT_WORD(0, RESULT_SLOT_FREE), __ATOMIC_RELAXED);
+            continue;
+        }
+        AppSpawnChildResponse response = slot->response;
+        g_resultSlab.owners[i] = NULL;
+        __atomic_store_n(&slot->owner, RESULT_SLOT_WORD(0, RESULT_SLOT_FREE), __ATOMIC_RELAXED);
+        property->forkCtx.resultSlot = -1;
+        g_resultSlab.process(property, &response, true);
+    }
+}
+
+static void ProcessResultEvent(const WatcherHandle taskHandle, int fd, uint32_t *events, const void *context)
+{
+    uint64_t count = 0;
+    (void)read(fd, &count, sizeof(count));
+    // 一次唤醒处理所有已完成的结果
+    ProcessResultSlots();
+}
+
+static bool CreateResultSlab(void)
+{
+    size_t size = sizeof(AppSpawnResultSlot) * APP_SPAWN_RESULT_SLOT_MAX;
+    void *slots = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    APPSPAWN_CHECK(slots != MAP_FAILED, return false, "Failed to map result slab errno: %{public}d", errno);
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    APPSPAWN_CHECK(fd >= 0, munmap(slots, size);
+        return false, "Failed to create result eventfd errno: %{public}d", errno);
+
+    LE_WatchInfo watchInfo = {};
+    watchInfo.fd = fd;
+    watchInfo.flags = 0;
+    watchInfo.events = EVENT_READ;
+    watchInfo.processEvent = ProcessResultEvent;
+    LE_STATUS status = LE_StartWatcher(LE_GetDefaultLoop(), &g_resultSlab.watcher, &watchInfo, NULL);
+    APPSPAWN_CHECK(status == LE_SUCCESS, munmap(slots, size);
+        close(fd);
+        return false, "Failed to watch result eventfd");
+    g_resultSlab.slots = (AppSpawnResultSlot *)slots;
+    g_resultSlab.eventFd = fd;
+    g_resultSlab.ownerPid = getpid();
+    APPSPAWN_LOGI("Result slab created size: %{public}zu", size);
+    return true;
+}
+
+int AppSpawnAcquireResultSlot(AppSpawningCtx *property, ChildResultProcess process)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(property != NULL && process != NULL, return APPSPAWN_ARG_INVALID);
+    if (g_resultSlab.slots == NULL && !CreateResultSlab()) {
+        return APPSPAWN_SYSTEM_ERROR;
+    }
+    APPSPAWN_CHECK_ONLY_EXPER(g_resultSlab.ownerPid == getpid(), return APPSPAWN_SYSTEM_ERROR);
+    g_resultSlab.process = process;
+    for (uint32_t i = 0; i < APP_SPAWN_RESULT_SLOT_MAX; i++) {
+        uint32_t index = (g_resultSlab.next + i) % APP_SPAWN_RESULT_SLOT_MAX;
+        AppSpawnResultSlot *slot = &g_resultSlab.slots[index];
+        // 被回收时子进程仍在写入的槽，等写完后由ProcessResultSlots释放
+        if (g_resultSlab.owners[index] != NULL ||
+            RESULT_SLOT_STATE(__atomic_load_n(&slot->owner, __ATOMIC_ACQUIRE)) != RESULT_SLOT_FREE) {
+            continue;
+        }
+        __atomic_store_n(&slot->owner, RESULT_SLOT_WORD(property->client.id, RESULT_SLOT_WAIT), __ATOMIC_RELEASE);
+        g_resultSlab.owners[index] = property;
+        g_resultSlab.next = index + 1;
+        property->forkCtx.resultSlot = (int32_t)index;
+        return 0;
+    }
+    APPSPAWN_LOGW("No free result slot for %{public}u", property->client.id);
+    return APPSPAWN_SYSTEM_ERROR;
+}
+
+void AppSpawnReleaseResultSlot(AppSpawningCtx *property)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(property != NULL, return);
+    int32_t index = property->forkCtx.resultSlot;
+    property->forkCtx.resultSlot = -1;
+    if (index < 0 || index >= APP_SPAWN_RESULT_SLOT_MAX || g_resultSlab.slots == NULL ||
+        g_resultSlab.ownerPid != getpid()) {
+        return;
+    }
+    if (g_resultSlab.owners[index] == property) {
+        g_resultSlab.owners[index] = NULL;
+        // 子进程尚未占用时直接释放，否则保留到子进程写完
+        uint64_t expect = RESULT_SLOT_WORD(property->client.id, RESULT_SLOT_WAIT);
+        (void)__atomic_compare_exchange_n(&g_resultSlab.slots[index].owner, &expect,
+            RESULT_SLOT_WORD(0, RESULT_SLOT_FREE), false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+    }
+}
+
+int AppSpawnWriteResultSlot(const AppSpawningCtx *property, const AppSpawnChildResponse *response)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(property != NULL && response != NULL, return APPSPAWN_ARG_INVALID);
+    int32_t index = property->forkCtx.resultSlot;
+    APPSPAWN_CHECK_ONLY_EXPER(index >= 0 && index < APP_SPAWN_RESULT_SLOT_MAX && g_resultSlab.slots != NULL,
+        return APPSPAWN_ARG_INVALID);
+    AppSpawnResultSlot *slot = &g_resultSlab.slots[index];
+    // 先占用再写入，槽已被父进程回收(如超时)或分配给其他请求时不再写入
+    uint64_t expect = RESULT_SLOT_WORD(property->client.id, RESULT_SLOT_WAIT);
+    if (!__atomic_compare_exchange_n(&slot->owner, &expect, RESULT_SLOT_WORD(property->client.id, RESULT_SLOT_WRITING),
+        false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        APPSPAWN_LOGW("Result slot %{public}d not owned by %{public}u", index, property->client.id);
+        return APPSPAWN_SYSTEM_ERROR;
+    }
+    slot->response = *response;
+    __atomic_store_n(&slot->owner, RESULT_SLOT_WORD(property->client.id, RESULT_SLOT_DONE), __ATOMIC_RELEASE);
+    uint64_t count = 1;
+    ssize_t ret = write(g_resultSlab.eventFd, &count, sizeof(count));
+    APPSPAWN_CHECK(ret == (ssize_t)sizeof(count), return APPSPAWN_SYSTEM_ERROR,
+        "Failed to notify result errno: %{public}d", errno);
+    return 0;
+}
+
+void AppSpawnDetachResultSlab(void)
+{
+    // 子进程回复结果后解除映射，避免应用进程修改其他孵化请求的结果
+    if (g_resultSlab.slots == NULL || g_resultSlab.ownerPid == getpid()) {
+        return;
+    }
+    (void)munmap(g_resultSlab.slots, sizeof(AppSpawnResultSlot) * APP_SPAWN_RESULT_SLOT_MAX);
+    g_resultSlab.slots = NULL;
+    (void)close(g_resultSlab.eventFd);
+    g_resultSlab.eventFd = -1;
+    g_resultSlab.watcher = NULL;
+}
+
+void AppSpawnDestroyResultSlab(void)
+{
+    if (g_resultSlab.slots == NULL) {
+        return;
+    }
+    if (g_resultSlab.ownerPid != getpid()) {
+        AppSpawnDetachResultSlab();
+        return;
+    }
+    for (uint32_t i = 0; i < APP_SPAWN_RESULT_SLOT_MAX; i++) {
+        if (g_resultSlab.owners[i] != NULL) {
+            g_resultSlab.owners[i]->forkCtx.resultSlot = -1;
+            g_resultSlab.owners[i] = NULL;
+        }
+    }
+    if (g_resultSlab.watcher != NULL) {
+        LE_RemoveWatcher(LE_GetDefaultLoop(), g_resultSlab.watcher);
+        g_resultSlab.watcher = NULL;
+    }
+    (void)munmap(g_resultSlab.slots, sizeof(AppSpawnResultSlot) * APP_SPAWN_RESULT_SLOT_MAX);
+    g_resultSlab.slots = NULL;
+    (void)close(g_resultSlab.eventFd);
+    g_resultSlab.eventFd = -1;
+}
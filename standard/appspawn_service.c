@@ -56,11 +56,26 @@
 #define PIDFD_NONBLOCK O_NONBLOCK
 #endif
 
-static void WaitChildTimeout(const TimerHandle taskHandle, void *context);
+static void WaitChildTimeout(AppSpawnTimer *timer, void *context);
 static void ProcessChildResponse(const WatcherHandle taskHandle, int fd, uint32_t *events, const void *context);
+static void ProcessChildResult(AppSpawningCtx *property, const AppSpawnChildResponse *response, bool hasTimeline);
+static int IsChildColdRun(AppSpawningCtx *property);
 static void WaitChildDied(pid_t pid);
 static void OnReceiveRequest(const TaskHandle taskHandle, const uint8_t *buffer, uint32_t buffLen);
 static void ProcessRecvMsg(AppSpawnConnection *connection, AppSpawnMsgNode *message);
+static bool DeferSpawnReqMsg(AppSpawningCtx *property);
+
+typedef struct {
+    struct ListNode node;
+    AppSpawnConnection *connection;
+    AppSpawnMsgNode *message;
+    char data[0];
+} AppSpawnPendingMsg;
+
+// 等待同一用户后台任务完成的孵化请求
+static struct ListNode g_deferredSpawnQueue = {&g_deferredSpawnQueue, &g_deferredSpawnQueue};
+// 后台任务完成后才回复的请求
+static struct ListNode g_pendingReplyQueue = {&g_pendingReplyQueue, &g_pendingReplyQueue};
 
 #ifdef USE_ENCAPS
 static int OpenDevEncaps(void)
@@ -177,6 +192,13 @@ static void HandleDiedPid(pid_t pid, uid_t uid, int status)
     TerminateSpawnedProcess(appInfo);
 }
 
+void AppSpawnProcessChildExit(pid_t pid, uid_t uid, int status)
+{
+    APPSPAWN_CHECK(WIFSIGNALED(status) || WIFEXITED(status), return,
+        "Process child exit with wrong status:%{public}d", status);
+    HandleDiedPid(pid, uid, status);
+}
+
 APPSPAWN_STATIC void ProcessSignal(const struct signalfd_siginfo *siginfo)
 {
     APPSPAWN_LOGI("ProcessSignal signum %{public}d %{public}d", siginfo->ssi_signo, siginfo->ssi_pid);
@@ -218,6 +240,50 @@ static void AppSpawningCtxOnClose(const AppSpawnMgr *mgr, AppSpawningCtx *ctx, v
     DeleteAppSpawningCtx(ctx);
 }
 
+static AppSpawnPendingMsg *CreatePendingMsg(struct ListNode *queue,
+    AppSpawnConnection *connection, AppSpawnMsgNode *message, const char *data)
+{
+    size_t len = (data == NULL) ? 0 : strlen(data) + 1;
+    AppSpawnPendingMsg *pending = (AppSpawnPendingMsg *)calloc(1, sizeof(AppSpawnPendingMsg) + len);
+    APPSPAWN_CHECK(pending != NULL, return NULL, "Failed to create pending msg");
+    if (len > 0) {
+        (void)strcpy_s(pending->data, len, data);
+    }
+    pending->connection = connection;
+    pending->message = message;
+    OH_ListAddTail(queue, &pending->node);
+    return pending;
+}
+
+static void DeletePendingMsg(AppSpawnPendingMsg *pending)
+{
+    OH_ListRemove(&pending->node);
+    DeleteAppSpawnMsg(pending->message);
+    free(pending);
+}
+
+// connection为NULL时清理所有连接的请求
+static void ClearPendingMsg(const AppSpawnConnection *connection)
+{
+    ListNode *node = g_deferredSpawnQueue.next;
+    while (node != &g_deferredSpawnQueue) {
+        AppSpawnPendingMsg *pending = ListEntry(node, AppSpawnPendingMsg, node);
+        node = node->next;
+        if (connection == NULL || pending->connection == connection) {
+            DeletePendingMsg(pending);
+        }
+    }
+    // 后台任务仍在执行，完成时不再回复
+    node = g_pendingReplyQueue.next;
+    while (node != &g_pendingReplyQueue) {
+        AppSpawnPendingMsg *pending = ListEntry(node, AppSpawnPendingMsg, node);
+        node = node->next;
+        if (connection == NULL || pending->connection == connection) {
+            pending->connection = NULL;
+        }
+    }
+}
+
 static void OnClose(const TaskHandle taskHandle)
 {
     if (!IsSpawnServer(GetAppSpawnMgr())) {
@@ -225,16 +291,14 @@ static void OnClose(const TaskHandle taskHandle)
     }
     AppSpawnConnection *connection = (AppSpawnConnection *)LE_GetUserData(taskHandle);
     APPSPAWN_CHECK(connection != NULL, return, "Invalid connection");
-    if (connection->receiverCtx.timer) {
-        LE_StopTimer(LE_GetDefaultLoop(), connection->receiverCtx.timer);
-        connection->receiverCtx.timer = NULL;
-    }
+    AppSpawnStopTimer(&connection->receiverCtx.timer);
     APPSPAWN_LOGI("OnClose connectionId: %{public}u socket %{public}d",
         connection->connectionId, LE_GetSocketFd(taskHandle));
     DeleteAppSpawnMsg(connection->receiverCtx.incompleteMsg);
     connection->receiverCtx.incompleteMsg = NULL;
     // connect close, to close spawning app
     AppSpawningCtxTraversal(AppSpawningCtxOnClose, connection);
+    ClearPendingMsg(connection);
 }
 
 static void OnDisConnect(const TaskHandle taskHandle)
@@ -281,7 +345,7 @@ static int SendResponse(const AppSpawnConnection *connection, const AppSpawnMsg
     return LE_Send(LE_GetDefaultLoop(), connection->stream, handle, bufferSize);
 }
 
-static void WaitMsgCompleteTimeOut(const TimerHandle taskHandle, void *context)
+static void WaitMsgCompleteTimeOut(AppSpawnTimer *timer, void *context)
 {
     AppSpawnConnection *connection = (AppSpawnConnection *)context;
     APPSPAWN_LOGE("Long time no msg complete so close connectionId: %{public}u", connection->connectionId);
@@ -292,14 +356,11 @@ static void WaitMsgCompleteTimeOut(const TimerHandle taskHandle, void *context)
 
 static inline int StartTimerForCheckMsg(AppSpawnConnection *connection)
 {
-    if (connection->receiverCtx.timer != NULL) {
+    if (AppSpawnTimerActive(&connection->receiverCtx.timer)) {
         return 0;
     }
-    int ret = LE_CreateTimer(LE_GetDefaultLoop(), &connection->receiverCtx.timer, WaitMsgCompleteTimeOut, connection);
-    if (ret == 0) {
-        ret = LE_StartTimer(LE_GetDefaultLoop(), connection->receiverCtx.timer, MAX_WAIT_MSG_COMPLETE, 1);
-    }
-    return ret;
+    return AppSpawnStartTimer(&connection->receiverCtx.timer, MAX_WAIT_MSG_COMPLETE,
+        WaitMsgCompleteTimeOut, connection);
 }
 
 static int HandleRecvMessage(const TaskHandle taskHandle, uint8_t * buffer, int bufferSize, int flags)
@@ -372,7 +433,7 @@ static int OnConnection(const LoopHandle loopHandle, const TaskHandle server)
     connection->stream = stream;
     connection->receiverCtx.fdCount = 0;
     connection->receiverCtx.incompleteMsg = NULL;
-    connection->receiverCtx.timer = NULL;
+    AppSpawnInitTimer(&connection->receiverCtx.timer);
     connection->receiverCtx.msgRecvLen = 0;
     connection->receiverCtx.nextMsgId = 1;
     APPSPAWN_LOGI("OnConnection connectionId: %{public}u fd %{public}d ",
@@ -407,10 +468,7 @@ static void OnReceiveRequest(const TaskHandle taskHandle, const uint8_t *buffer,
             break;
         }
         connection->receiverCtx.msgRecvLen = 0;
-        if (connection->receiverCtx.timer) {
-            LE_StopTimer(LE_GetDefaultLoop(), connection->receiverCtx.timer);
-            connection->receiverCtx.timer = NULL;
-        }
+        AppSpawnStopTimer(&connection->receiverCtx.timer);
         // decode msg
         ret = DecodeAppSpawnMsg(message);
         APPSPAWN_CHECK_ONLY_EXPER(ret == 0, break);
@@ -486,6 +544,12 @@ APPSPAWN_STATIC int WriteMsgToChild(AppSpawningCtx *property, bool isNweb)
 
 static int InitForkContext(AppSpawningCtx *property)
 {
+    // 冷启动exec后及由其他进程fork的子进程无法继承共享结果槽，仍使用pipe
+    AppSpawnContent *content = GetAppSpawnContent();
+    if (content != NULL && (content->forkChild == NULL || content->forkChildInSelf) && !IsChildColdRun(property) &&
+        AppSpawnAcquireResultSlot(property, ProcessChildResult) == 0) {
+        return 0;
+    }
     if (pipe(property->forkCtx.fd) == -1) {
         APPSPAWN_LOGE("create pipe fail, errno: %{public}d", errno);
         return errno;
@@ -582,25 +646,23 @@ static int AddChildWatcher(AppSpawningCtx *property)
 {
     uint32_t defTimeout = IsChildColdRun(property) ? COLD_CHILD_RESPONSE_TIMEOUT : WAIT_CHILD_RESPONSE_TIMEOUT;
     uint32_t timeout = GetSpawnTimeout(defTimeout);
-    LE_WatchInfo watchInfo = {};
-    watchInfo.fd = property->forkCtx.fd[0];
-    watchInfo.flags = WATCHER_ONCE;
-    watchInfo.events = EVENT_READ;
-    watchInfo.processEvent = ProcessChildResponse;
-    LE_STATUS status = LE_StartWatcher(LE_GetDefaultLoop(), &property->forkCtx.watcherHandle, &watchInfo, property);
-    APPSPAWN_CHECK(status == LE_SUCCESS,
-        return APPSPAWN_SYSTEM_ERROR, "Failed to watch child %{public}d", property->pid);
-    status = LE_CreateTimer(LE_GetDefaultLoop(), &property->forkCtx.timer, WaitChildTimeout, property);
-    if (status == LE_SUCCESS) {
-        status = LE_StartTimer(LE_GetDefaultLoop(), property->forkCtx.timer, timeout * 1000, 0); // 1000 1s
-    }
-    if (status != LE_SUCCESS) {
-        if (property->forkCtx.timer != NULL) {
-            LE_StopTimer(LE_GetDefaultLoop(), property->forkCtx.timer);
+    if (property->forkCtx.resultSlot < 0) {  // 使用结果槽时由共享的eventfd统一处理
+        LE_WatchInfo watchInfo = {};
+        watchInfo.fd = property->forkCtx.fd[0];
+        watchInfo.flags = WATCHER_ONCE;
+        watchInfo.events = EVENT_READ;
+        watchInfo.processEvent = ProcessChildResponse;
+        LE_STATUS status = LE_StartWatcher(LE_GetDefaultLoop(), &property->forkCtx.watcherHandle, &watchInfo, property);
+        APPSPAWN_CHECK(status == LE_SUCCESS,
+            return APPSPAWN_SYSTEM_ERROR, "Failed to watch child %{public}d", property->pid);
+    }
+    int ret = AppSpawnStartTimer(&property->forkCtx.timer, (uint64_t)timeout * 1000,  // 1000 1s
+        WaitChildTimeout, property);
+    if (ret != 0) {
+        if (property->forkCtx.watcherHandle != NULL) {
+            LE_RemoveWatcher(LE_GetDefaultLoop(), property->forkCtx.watcherHandle);
+            property->forkCtx.watcherHandle = NULL;
         }
-        property->forkCtx.timer = NULL;
-        LE_RemoveWatcher(LE_GetDefaultLoop(), property->forkCtx.watcherHandle);
-        property->forkCtx.watcherHandle = NULL;
         APPSPAWN_LOGE("Failed to watch child %{public}d", property->pid);
         return APPSPAWN_SYSTEM_ERROR;
     }
@@ -702,6 +764,8 @@ static void ProcessPreFork(AppSpawnContent *content, AppSpawningCtx *property)
     if (content->reservedPid == 0) {
         (void)close(property->forkCtx.fd[0]);
         (void)close(property->forkCtx.fd[1]);
+        AppSpawnDetachResultSlab();
+        property->forkCtx.resultSlot = -1;
         int isRet = prctl(PR_SET_NAME, "apppool");
         APPSPAWN_LOGI("prefork process start wait read msg with set processname %{public}d", isRet);
         AppSpawnClient client = {0, 0};
@@ -811,6 +875,9 @@ static int RunAppSpawnProcessMsg(AppSpawnContent *content, AppSpawnClient *clien
 static void ProcessSpawnReqMsg(AppSpawnConnection *connection, AppSpawnMsgNode *message)
 {
     int ret = CheckAppSpawnMsg(message);
+    if (ret == 0) {
+        ret = AppSpawnCheckQuarantine(message);
+    }
     if (ret != 0) {
         SendResponse(connection, &message->msgHeader, ret, 0);
         DeleteAppSpawnMsg(message);
@@ -835,6 +902,9 @@ static void ProcessSpawnReqMsg(AppSpawnConnection *connection, AppSpawnMsgNode *
     property->state = APP_STATE_SPAWNING;
     property->message = message;
     message->connection = connection;
+    if (DeferSpawnReqMsg(property)) {
+        return;
+    }
     // mount el2 dir
     // getWrapBundleNameValue
     AppSpawnHookExecute(STAGE_PARENT_PRE_FORK, 0, GetAppSpawnContent(), &property->client);
@@ -845,60 +915,122 @@ static void ProcessSpawnReqMsg(AppSpawnConnection *connection, AppSpawnMsgNode *
     clock_gettime(CLOCK_MONOTONIC, &property->spawnStart);
     ret = RunAppSpawnProcessMsg(GetAppSpawnContent(), &property->client, &property->pid);
     AppSpawnHookExecute(STAGE_PARENT_POST_FORK, 0, GetAppSpawnContent(), &property->client);
-    if (ret != 0) { // wait child process result
-        SendResponse(connection, &message->msgHeader, ret, 0);
+    if (ret == 0 && property->pid == 0) {
+        // 子进程由插件异步创建，完成后通过AppSpawnProcessForkResult上报
+        return;
+    }
+    AppSpawnProcessForkResult(property, property->pid, ret);
+}
+
+void AppSpawnProcessForkResult(AppSpawningCtx *property, pid_t pid, int result)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(property != NULL && property->message != NULL, return);
+    AppSpawnConnection *connection = property->message->connection;
+    property->pid = pid;
+    if (result != 0) { // wait child process result
+        SendResponse(connection, &property->message->msgHeader, result, 0);
         DeleteAppSpawningCtx(property);
         return;
     }
     if (AddChildWatcher(property) != 0) { // wait child process result
         kill(property->pid, SIGKILL);
-        SendResponse(connection, &message->msgHeader, ret, 0);
+        SendResponse(connection, &property->message->msgHeader, result, 0);
         DeleteAppSpawningCtx(property);
         return;
     }
 }
 
-static uint32_t g_lastDiedAppId = 0;
-static uint32_t g_crashTimes = 0;
-#define MAX_CRASH_TIME 5
+static bool DeferSpawnReqMsg(AppSpawningCtx *property)
+{
+    // 孵化使用的沙盒路径正在后台卸载，延后孵化，不阻塞事件循环
+    int ret = AppSpawnHookExecute(STAGE_PARENT_CHECK_DEFER, HOOK_STOP_WHEN_ERROR,
+        GetAppSpawnContent(), &property->client);
+    if (ret != APPSPAWN_SPAWN_DEFERRED) {
+        return false;
+    }
+    AppSpawnMsgNode *message = property->message;
+    AppSpawnPendingMsg *pending = CreatePendingMsg(&g_deferredSpawnQueue, message->connection, message, NULL);
+    APPSPAWN_CHECK_ONLY_EXPER(pending != NULL, return false);
+    APPSPAWN_LOGI("Defer spawn %{public}s until sandbox work done", message->msgHeader.processName);
+    property->message = NULL;
+    DeleteAppSpawningCtx(property);
+    return true;
+}
+
+void AppSpawnResumeDeferredSpawn(void)
+{
+    // 仍被占用的请求重新进入延后队列，先取出当前所有请求
+    ListNode deferred;
+    OH_ListInit(&deferred);
+    while (!ListEmpty(g_deferredSpawnQueue)) {
+        ListNode *node = g_deferredSpawnQueue.next;
+        OH_ListRemove(node);
+        OH_ListAddTail(&deferred, node);
+    }
+    while (!ListEmpty(deferred)) {
+        AppSpawnPendingMsg *pending = ListEntry(deferred.next, AppSpawnPendingMsg, node);
+        AppSpawnConnection *connection = pending->connection;
+        AppSpawnMsgNode *message = pending->message;
+        pending->message = NULL;
+        DeletePendingMsg(pending);
+        ProcessSpawnReqMsg(connection, message);
+    }
+}
+
 static void WaitChildDied(pid_t pid)
 {
     AppSpawningCtx *property = GetAppSpawningCtxByPid(pid);
     if (property != NULL && property->state == APP_STATE_SPAWNING) {
         APPSPAWN_LOGI("Child process %{public}s fail \'child crash \'pid %{public}d appId: %{public}d",
             GetProcessName(property), property->pid, property->client.id);
-        if (property->client.id == g_lastDiedAppId + 1) {
-            g_crashTimes++;
-        } else {
-            g_crashTimes = 1;
-        }
-        g_lastDiedAppId = property->client.id;
+        // 单个bundle失败只隔离该bundle，多个不相关的bundle连续失败时才重启
+        bool restart = AppSpawnRecordSpawnFailure(property->message);
 
         SendResponse(property->message->connection, &property->message->msgHeader, APPSPAWN_CHILD_CRASH, 0);
         DeleteAppSpawningCtx(property);
 
-        if (g_crashTimes >= MAX_CRASH_TIME) {
-            APPSPAWN_LOGW("Continuous failures in spawning the app, restart appspawn");
+        if (restart) {
+            APPSPAWN_LOGW("Continuous failures in spawning different apps, restart appspawn");
             StopAppSpawn();
         }
     }
 }
 
-static void WaitChildTimeout(const TimerHandle taskHandle, void *context)
+static void WaitChildTimeout(AppSpawnTimer *timer, void *context)
 {
     AppSpawningCtx *property = (AppSpawningCtx *)context;
     APPSPAWN_LOGI("Child process %{public}s fail \'wait child timeout \'pid %{public}d appId: %{public}d",
         GetProcessName(property), property->pid, property->client.id);
     if (property->pid > 0) {
 #if (!defined(CJAPP_SPAWN) && !defined(NATIVE_SPAWN))
-        DumpSpawnStack(property->pid);
-#endif
+        if (DumpSpawnStackAsync(property->pid, GetBundleName(property)) != 0) {
+            kill(property->pid, SIGKILL);
+        }
+#else
         kill(property->pid, SIGKILL);
+#endif
     }
+    (void)AppSpawnRecordSpawnFailure(property->message);
     SendResponse(property->message->connection, &property->message->msgHeader, APPSPAWN_SPAWN_TIMEOUT, 0);
     DeleteAppSpawningCtx(property);
 }
 
+static void SaveSpawnTimeline(AppSpawnedProcess *appInfo, const AppSpawnTimeline *timeline)
+{
+    if (timeline->count == 0) {
+        return;
+    }
+    appInfo->timeline = *timeline;
+    uint64_t diff = DiffTime(&appInfo->spawnStart, &appInfo->spawnEnd);
+    if (diff < APP_SPAWN_SLOW_THRESHOLD) {
+        return;
+    }
+    char buffer[1024] = {0};  // 1024 max
+    (void)FormatSpawnTimeline(appInfo, buffer, sizeof(buffer));
+    APPSPAWN_LOGW("Slow spawn %{public}s pid %{public}d cost %{public}" PRIu64 " us, timeline %{public}s",
+        appInfo->name, appInfo->pid, diff, buffer);
+}
+
 #define MSG_EXT_NAME_MAX_DECIMAL 10
 #define MSG_EXT_NAME 1
 static void ProcessChildResponse(const WatcherHandle taskHandle, int fd, uint32_t *events, const void *context)
@@ -907,8 +1039,14 @@ static void ProcessChildResponse(const WatcherHandle taskHandle, int fd, uint32_
     property->forkCtx.watcherHandle = NULL;  // delete watcher
     LE_RemoveWatcher(LE_GetDefaultLoop(), (WatcherHandle)taskHandle);
 
-    int result = 0;
-    (void)read(fd, &result, sizeof(result));
+    AppSpawnChildResponse response = {0};
+    ssize_t readLen = read(fd, &response, sizeof(response));
+    ProcessChildResult(property, &response, readLen == (ssize_t)sizeof(response));
+}
+
+static void ProcessChildResult(AppSpawningCtx *property, const AppSpawnChildResponse *response, bool hasTimeline)
+{
+    int result = response->result;
     APPSPAWN_LOGI("Child process %{public}s success pid %{public}d appId: %{public}d result: %{public}d",
         GetProcessName(property), property->pid, property->client.id, result);
     APPSPAWN_CHECK(property->message != NULL, return, "Invalid message in ctx %{public}d", property->client.id);
@@ -919,6 +1057,7 @@ static void ProcessChildResponse(const WatcherHandle taskHandle, int fd, uint32_
         return;
     }
     // success
+    AppSpawnRecordSpawnSuccess(property->message);
     AppSpawnedProcess *appInfo = AddSpawnedProcess(property->pid, GetBundleName(property));
     uint32_t len = 0;
     char *pidMaxStr = NULL;
@@ -943,6 +1082,9 @@ static void ProcessChildResponse(const WatcherHandle taskHandle, int fd, uint32_
 #endif
         clock_gettime(CLOCK_MONOTONIC, &appInfo->spawnEnd);
         // add max info
+        if (hasTimeline) {
+            SaveSpawnTimeline(appInfo, &response->timeline);
+        }
     }
     WatchChildProcessFd(property);
     ProcessMgrHookExecute(STAGE_SERVER_APP_ADD, GetAppSpawnContent(), appInfo);
@@ -961,12 +1103,19 @@ static void ProcessChildResponse(const WatcherHandle taskHandle, int fd, uint32_
 static void NotifyResToParent(AppSpawnContent *content, AppSpawnClient *client, int result)
 {
     AppSpawningCtx *property = (AppSpawningCtx *)client;
+    AppSpawnChildResponse response = {0};
+    response.result = result;
+    response.timeline = property->forkCtx.timeline;
     int fd = property->forkCtx.fd[1];
-    if (fd >= 0) {
-        (void)write(fd, &result, sizeof(result));
+    if (property->forkCtx.resultSlot >= 0) {
+        (void)AppSpawnWriteResultSlot(property, &response);
+        property->forkCtx.resultSlot = -1;
+    } else if (fd >= 0) {
+        (void)write(fd, &response, sizeof(response));
         (void)close(fd);
         property->forkCtx.fd[1] = -1;
     }
+    AppSpawnDetachResultSlab();
     APPSPAWN_LOGV("NotifyResToParent client id: %{public}u result: 0x%{public}x", client->id, result);
 }
 
@@ -1017,11 +1166,42 @@ void AppSpawnDestroyContent(AppSpawnContent *content)
         LE_CloseStreamTask(LE_GetDefaultLoop(), appSpawnContent->server);
         appSpawnContent->server = NULL;
     }
+    ClearPendingMsg(NULL);
+    AppSpawnDestroyWorker();
+    AppSpawnDestroyResultSlab();
+    AppSpawnDestroyTimerWheel();
+#ifdef APPSPAWN_LOG_RING
+    AppSpawnLogRingStop();
+#endif
     LE_StopLoop(LE_GetDefaultLoop());
     LE_CloseLoop(LE_GetDefaultLoop());
     DeleteAppSpawnMgr(appSpawnContent);
 }
 
+bool IsLeanColdRunEnabled(void)
+{
+    char buffer[PARAM_BUFFER_SIZE] = {0};
+    int ret = GetParameter("persist.appspawn.cold.lean.enable", "true", buffer, sizeof(buffer));
+    return ret > 0 && strcmp(buffer, "true") == 0;
+}
+
+APPSPAWN_STATIC int SetLeanColdRunPreload(void)
+{
+    // 启动冷启动进程时直接带上helper，避免进程启动后为设置LD_PRELOAD再次execv
+    char buffer[PATH_SIZE] = APPSPAWN_PRELOAD;
+    const char *preload = getenv("LD_PRELOAD");
+    if (preload != NULL && strstr(preload, APPSPAWN_PRELOAD) != NULL) {
+        return 0;
+    }
+    if (preload != NULL && preload[0] != '\0') {
+        int len = sprintf_s(buffer, sizeof(buffer), "%s:" APPSPAWN_PRELOAD, preload);
+        APPSPAWN_CHECK(len > 0, return -1, "preload too long: %{public}s", preload);
+    }
+    int ret = setenv("LD_PRELOAD", buffer, true);
+    APPSPAWN_CHECK(ret == 0, return -1, "setenv fail(%{public}d): %{public}s", errno, buffer);
+    return 0;
+}
+
 APPSPAWN_STATIC int AppSpawnColdStartApp(struct AppSpawnContent *content, AppSpawnClient *client)
 {
     AppSpawningCtx *property = (AppSpawningCtx *)client;
@@ -1056,6 +1236,9 @@ APPSPAWN_STATIC int AppSpawnColdStartApp(struct AppSpawnContent *content, AppSpa
         path, "-mode", mode, "-fd", buffer[0], buffer[1], buffer[2],
         "-param", GetProcessName(property), buffer[3], NULL
     };
+    if (IsLeanColdRunEnabled()) {
+        (void)SetLeanColdRunPreload();
+    }
 
     ret = execv(path, (char **)formatCmds);
     if (ret != 0) {
@@ -1162,6 +1345,10 @@ static void AppSpawnRun(AppSpawnContent *content, int argc, char *const argv[])
 
 #ifdef USE_ENCAPS
     appSpawnContent->content.fdEncaps = OpenDevEncaps();
+#endif
+#ifdef APPSPAWN_LOG_RING
+    // 预加载及孵化nwebspawn完成后再创建刷新线程
+    (void)AppSpawnLogRingStart();
 #endif
     LE_RunLoop(LE_GetDefaultLoop());
     APPSPAWN_LOGI("AppSpawnRun exit mode: %{public}d ", content->mode);
@@ -1240,7 +1427,11 @@ AppSpawnContent *StartSpawnService(const AppSpawnStartArg *startArg, uint32_t ar
     }
 
     // load module appspawn/common
-    AppSpawnLoadAutoRunModules(MODULE_COMMON);
+    if (arg->initArg == 0 && IsLeanColdRunEnabled()) {
+        AppSpawnLoadColdRunModules(MODULE_COMMON);
+    } else {
+        AppSpawnLoadAutoRunModules(MODULE_COMMON);
+    }
     AppSpawnModuleMgrInstall(ASAN_MODULE_PATH);
 
     APPSPAWN_CHECK(LE_GetDefaultLoop() != NULL, return NULL, "Invalid default loop");
@@ -1324,12 +1515,9 @@ static bool CheckAllDigit(char *userId)
 }
 
 #ifdef APPSPAWN_SANDBOX_NEW
-static int ProcessSpawnRemountMsg(AppSpawnConnection *connection, AppSpawnMsgNode *message)
+static int RemountArkWebCore(void *data)
 {
-    char srcPath[PATH_SIZE] = {0};
-    int len = GetArkWebInstallPath("persist.arkwebcore.install_path", srcPath);
-    APPSPAWN_CHECK(len > 0, return -1, "Failed to get arkwebcore install path");
-
+    const char *srcPath = ((AppSpawnPendingMsg *)data)->data;
     char *rootPath = "/mnt/sandbox";
     DIR *rootDir = opendir(rootPath);
     APPSPAWN_CHECK(rootDir != NULL, return -1, "Failed to opendir %{public}s, errno %{public}d", rootPath, errno);
@@ -1368,12 +1556,9 @@ static int ProcessSpawnRemountMsg(AppSpawnConnection *connection, AppSpawnMsgNod
     return 0;
 }
 #else
-static int ProcessSpawnRemountMsg(AppSpawnConnection *connection, AppSpawnMsgNode *message)
+static int RemountArkWebCore(void *data)
 {
-    char srcPath[PATH_SIZE] = {0};
-    int len = GetArkWebInstallPath("persist.arkwebcore.install_path", srcPath);
-    APPSPAWN_CHECK(len > 0, return -1, "Failed to get arkwebcore install path");
-
+    const char *srcPath = ((AppSpawnPendingMsg *)data)->data;
     char *rootPath = "/mnt/sandbox";
     DIR *rootDir = opendir(rootPath);
     APPSPAWN_CHECK(rootDir != NULL, return -1, "Failed to opendir %{public}s, errno %{public}d", rootPath, errno);
@@ -1424,6 +1609,38 @@ static int ProcessSpawnRemountMsg(AppSpawnConnection *connection, AppSpawnMsgNod
 }
 #endif
 
+static void RemountArkWebCoreComplete(void *data, int result)
+{
+    AppSpawnPendingMsg *pending = (AppSpawnPendingMsg *)data;
+    APPSPAWN_LOGI("Remount arkwebcore %{public}s complete result %{public}d", pending->data, result);
+    // 缓存的沙盒命名空间中仍是旧的挂载
+    AppSpawnMgr *content = GetAppSpawnMgr();
+    if (content != NULL) {
+        content->sandboxGeneration++;
+    }
+    if (pending->connection != NULL) {
+        SendResponse(pending->connection, &pending->message->msgHeader, result, 0);
+    }
+    DeletePendingMsg(pending);
+}
+
+static int ProcessSpawnRemountMsg(AppSpawnConnection *connection, AppSpawnMsgNode *message)
+{
+    char srcPath[PATH_SIZE] = {0};
+    int len = GetArkWebInstallPath("persist.arkwebcore.install_path", srcPath);
+    APPSPAWN_CHECK(len > 0, return -1, "Failed to get arkwebcore install path");
+
+    // 遍历所有沙盒重新挂载耗时较长，放到工作线程中处理，完成后再回复；未执行的重复请求按最新的路径执行一次
+    AppSpawnPendingMsg *pending = CreatePendingMsg(&g_pendingReplyQueue, connection, message, srcPath);
+    APPSPAWN_CHECK(pending != NULL, return APPSPAWN_SYSTEM_ERROR, "Failed to create remount %{public}s", srcPath);
+    int ret = AppSpawnPostWork("remount-arkwebcore", RemountArkWebCore, RemountArkWebCoreComplete, pending);
+    if (ret != 0) {
+        pending->message = NULL;  // 由调用者回复并释放
+        DeletePendingMsg(pending);
+    }
+    return ret;
+}
+
 static void ProcessSpawnRestartMsg(AppSpawnConnection *connection, AppSpawnMsgNode *message)
 {
     AppSpawnContent *content = GetAppSpawnContent();
@@ -1494,8 +1711,12 @@ static void ProcessRecvMsg(AppSpawnConnection *connection, AppSpawnMsgNode *mess
             DeleteAppSpawnMsg(message);
             break;
         case MSG_UPDATE_MOUNT_POINTS:
+            // 成功时在重新挂载完成后回复
             ret = ProcessSpawnRemountMsg(connection, message);
-            SendResponse(connection, msg, ret, 0);
+            if (ret != 0) {
+                SendResponse(connection, msg, ret, 0);
+                DeleteAppSpawnMsg(message);
+            }
             break;
         case MSG_RESTART_SPAWNER:
             ProcessSpawnRestartMsg(connection, message);
@@ -24,6 +24,7 @@
 #include "appspawn_hook.h"
 #include "appspawn_msg.h"
 #include "appspawn_server.h"
+#include "appspawn_timer.h"
 #include "appspawn_utils.h"
 #include "list.h"
 #include "loop_event.h"
@@ -41,12 +42,13 @@ extern "C" {
 #define COLD_CHILD_RESPONSE_TIMEOUT 5
 #define WAIT_CHILD_RESPONSE_TIMEOUT 3  //3s
 #endif
+#define APPSPAWN_PRELOAD "libappspawn_helper.z.so"
 
 typedef struct TagAppSpawnMsgNode AppSpawnMsgNode;
 typedef struct TagAppSpawnMsgReceiverCtx {
     uint32_t nextMsgId;              // 校验消息id
     uint32_t msgRecvLen;             // 已经接收的长度
-    TimerHandle timer;               // 测试消息完整
+    AppSpawnTimer timer;             // 测试消息完整
     int fdCount;
     int fds[APP_MAX_FD_COUNT];
     AppSpawnMsgNode *incompleteMsg;  // 保存不完整的消息，额外保存消息头信息
@@ -75,6 +77,7 @@ pid_t NWebSpawnLaunch(void);
 void NWebSpawnInit(void);
 AppSpawnContent *StartSpawnService(const AppSpawnStartArg *arg, uint32_t argvSize, int argc, char *const argv[]);
 void AppSpawnDestroyContent(AppSpawnContent *content);
+bool IsLeanColdRunEnabled(void);
 
 #ifdef __cplusplus
 }
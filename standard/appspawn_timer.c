@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "appspawn_timer.h"
+
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/timerfd.h>
+
+#include "appspawn_utils.h"
+#include "loop_event.h"
+
+#define TIMER_WHEEL_LEVEL 4
+#define TIMER_ROOT_BITS 8   // 第一级256个槽，每槽1ms
+#define TIMER_LEVEL_BITS 6  // 其余每级64个槽
+#define TIMER_ROOT_SIZE (1 << TIMER_ROOT_BITS)
+#define TIMER_LEVEL_SIZE (1 << TIMER_LEVEL_BITS)
+#define TIMER_LEVEL_SHIFT(level) (TIMER_ROOT_BITS + ((level) - 1) * TIMER_LEVEL_BITS)
+#define TIMER_MAX_DELTA ((1ULL << TIMER_LEVEL_SHIFT(TIMER_WHEEL_LEVEL)) - 1)  // 约18.6小时
+
+typedef struct {
+    ListNode root[TIMER_ROOT_SIZE];
+    ListNode levels[TIMER_WHEEL_LEVEL - 1][TIMER_LEVEL_SIZE];
+    uint64_t current;  // 下一个待处理的tick
+    uint64_t armed;    // timerfd到期时间，0表示未设置
+    uint32_t count;
+    int timerFd;
+    WatcherHandle watcher;
+    pid_t ownerPid;
+} AppSpawnTimerWheel;
+
+static AppSpawnTimerWheel g_timerWheel = {.timerFd = -1};
+
+static uint64_t GetCurrentMs(void)
+{
+    struct timespec now = {0};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;  // 1000 s-ms 1000000 ns-ms
+}
+
+static ListNode *GetTimerSlot(uint64_t expire)
+{
+    uint64_t delta = expire > g_timerWheel.current ? expire - g_timerWheel.current : 0;
+    if (delta < TIMER_ROOT_SIZE) {
+        // 已过期的放入当前槽，下次处理时执行
+        uint64_t tick = expire > g_timerWheel.current ? expire : g_timerWheel.current;
+        return &g_timerWheel.root[tick & (TIMER_ROOT_SIZE - 1)];
+    }
+    for (int level = 1; level < TIMER_WHEEL_LEVEL; level++) {
+        if (delta < (1ULL << TIMER_LEVEL_SHIFT(level + 1))) {
+            uint64_t index = (expire >> TIMER_LEVEL_SHIFT(level)) & (TIMER_LEVEL_SIZE - 1);
+            return &g_timerWheel.levels[level - 1][index];
+        }
+    }
+    return NULL;
+}
+
+static void AddTimerToWheel(AppSpawnTimer *timer)
+{
+    if (timer->expire > g_timerWheel.current && timer->expire - g_timerWheel.current > TIMER_MAX_DELTA) {
+        timer->expire = g_timerWheel.current + TIMER_MAX_DELTA;
+    }
+    OH_ListAddTail(GetTimerSlot(timer->expire), &timer->node);
+}
+
+static void ArmTimerFd(uint64_t expire)
+{
+    struct itimerspec spec = {};
+    if (expire != 0) {
+        spec.it_value.tv_sec = (time_t)(expire / 1000);  // 1000 s-ms
+        spec.it_value.tv_nsec = (long)(expire % 1000) * 1000000;  // 1000 s-ms 1000000 ms-ns
+    }
+    int ret = timerfd_settime(g_timerWheel.timerFd, TFD_TIMER_ABSTIME, &spec, NULL);
+    APPSPAWN_CHECK(ret == 0, return, "Failed to set timerfd errno: %{public}d", errno);
+    g_timerWheel.armed = expire;
+}
+
+static uint64_t GetNextCascadeTick(int level)
+{
+    // 上级槽在下级时间轮转到该槽的起始tick时级联，槽中定时器都不早于该tick
+    uint32_t shift = TIMER_LEVEL_SHIFT(level);
+    uint64_t base = (g_timerWheel.current + (1ULL << shift) - 1) >> shift;
+    for (uint64_t i = 0; i < TIMER_LEVEL_SIZE; i++) {
+        if (!ListEmpty(g_timerWheel.levels[level - 1][(base + i) & (TIMER_LEVEL_SIZE - 1)])) {
+            return (base + i) << shift;
+        }
+    }
+    return UINT64_MAX;
+}
+
+// 下一个需要处理的tick：第一级最早的非空槽，或者上级最早的非空槽级联的tick，与定时器个数无关
+APPSPAWN_STATIC uint64_t GetNextTimerExpire(void)
+{
+    uint64_t next = UINT64_MAX;
+    for (uint64_t i = 0; i < TIMER_ROOT_SIZE; i++) {
+        uint64_t tick = g_timerWheel.current + i;
+        if (!ListEmpty(g_timerWheel.root[tick & (TIMER_ROOT_SIZE - 1)])) {
+            next = tick;
+            break;
+        }
+    }
+    for (int level = 1; level < TIMER_WHEEL_LEVEL; level++) {
+        uint64_t tick = GetNextCascadeTick(level);
+        next = tick < next ? tick : next;
+    }
+    return next;
+}
+
+static void CascadeTimers(int level)
+{
+    uint64_t index = (g_timerWheel.current >> TIMER_LEVEL_SHIFT(level)) & (TIMER_LEVEL_SIZE - 1);
+    ListNode *head = &g_timerWheel.levels[level - 1][index];
+    while (!ListEmpty(*head)) {
+        ListNode *node = head->next;
+        OH_ListRemove(node);
+        OH_ListInit(node);
+        AddTimerToWheel(ListEntry(node, AppSpawnTimer, node));
+    }
+}
+
+static void RunExpiredTimers(ListNode *head)
+{
+    // 先转移到本地链表，回调中可以启动或停止其他定时器
+    ListNode expired = {&expired, &expired};
+    if (!ListEmpty(*head)) {
+        expired.next = head->next;
+        expired.prev = head->prev;
+        expired.next->prev = &expired;
+        expired.prev->next = &expired;
+        OH_ListInit(head);
+    }
+    while (!ListEmpty(expired)) {
+        AppSpawnTimer *timer = ListEntry(expired.next, AppSpawnTimer, node);
+        OH_ListRemove(&timer->node);
+        OH_ListInit(&timer->node);
+        g_timerWheel.count--;
+        timer->process(timer, timer->context);
+    }
+}
+
+APPSPAWN_STATIC void ProcessTimerWheel(uint64_t now)
+{
+    while (g_timerWheel.count > 0) {
+        // 跳过没有定时器到期也不需要级联的tick
+        uint64_t current = GetNextTimerExpire();
+        if (current > now) {
+            g_timerWheel.current = now >= g_timerWheel.current ? now + 1 : g_timerWheel.current;
+            break;
+        }
+        g_timerWheel.current = current;
+        // 下级时间轮转完一圈时，将上级对应槽的定时器分散到下级
+        for (int level = 1; level < TIMER_WHEEL_LEVEL; level++) {
+            if ((current & ((1ULL << TIMER_LEVEL_SHIFT(level)) - 1)) != 0) {
+                break;
+            }
+            CascadeTimers(level);
+        }
+        ListNode *head = &g_timerWheel.root[current & (TIMER_ROOT_SIZE - 1)];
+        g_timerWheel.current++;
+        RunExpiredTimers(head);
+    }
+    if (g_timerWheel.count == 0) {
+        g_timerWheel.current = now + 1;
+        if (g_timerWheel.armed != 0) {
+            ArmTimerFd(0);
+        }
+        return;
+    }
+    uint64_t next = GetNextTimerExpire();
+    ArmTimerFd(next != UINT64_MAX ? next : 0);
+}
+
+static void ProcessTimerEvent(const WatcherHandle taskHandle, int fd, uint32_t *events, const void *context)
+{
+    uint64_t count = 0;
+    (void)read(fd, &count, sizeof(count));
+    g_timerWheel.armed = 0;
+    ProcessTimerWheel(GetCurrentMs());
+}
+
+static int InitTimerWheel(void)
+{
+    if (g_timerWheel.timerFd >= 0) {
+        return g_timerWheel.ownerPid == getpid() ? 0 : APPSPAWN_SYSTEM_ERROR;
+    }
+    g_timerWheel.timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    APPSPAWN_CHECK(g_timerWheel.timerFd >= 0, return APPSPAWN_SYSTEM_ERROR,
+        "Failed to create timerfd errno: %{public}d", errno);
+    LE_WatchInfo watchInfo = {};
+    watchInfo.fd = g_timerWheel.timerFd;
+    watchInfo.flags = 0;
+    watchInfo.events = EVENT_READ;
+    watchInfo.processEvent = ProcessTimerEvent;
+    LE_STATUS status = LE_StartWatcher(LE_GetDefaultLoop(), &g_timerWheel.watcher, &watchInfo, NULL);
+    APPSPAWN_CHECK(status == LE_SUCCESS, close(g_timerWheel.timerFd);
+        g_timerWheel.timerFd = -1;
+        return APPSPAWN_SYSTEM_ERROR, "Failed to watch timerfd");
+    for (int i = 0; i < TIMER_ROOT_SIZE; i++) {
+        OH_ListInit(&g_timerWheel.root[i]);
+    }
+    for (int level = 0; level < TIMER_WHEEL_LEVEL - 1; level++) {
+        for (int i = 0; i < TIMER_LEVEL_SIZE; i++) {
+            OH_ListInit(&g_timerWheel.levels[level][i]);
+        }
+    }
+    g_timerWheel.current = GetCurrentMs();
+    g_timerWheel.armed = 0;
+    g_timerWheel.count = 0;
+    g_timerWheel.ownerPid = getpid();
+    return 0;
+}
+
+void AppSpawnInitTimer(AppSpawnTimer *timer)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(timer != NULL, return);
+    OH_ListInit(&timer->node);
+    timer->expire = 0;
+    timer->process = NULL;
+    timer->context = NULL;
+}
+
+bool AppSpawnTimerActive(const AppSpawnTimer *timer)
+{
+    return timer != NULL && timer->node.next != NULL && timer->node.next != &timer->node;
+}
+
+int AppSpawnStartTimer(AppSpawnTimer *timer, uint64_t timeout, AppSpawnTimerProcess process, void *context)
+{
+    APPSPAWN_CHECK(timer != NULL && process != NULL, return APPSPAWN_ARG_INVALID, "Invalid timer");
+    int ret = InitTimerWheel();
+    APPSPAWN_CHECK_ONLY_EXPER(ret == 0, return ret);
+    AppSpawnStopTimer(timer);
+    uint64_t now = GetCurrentMs();
+    if (g_timerWheel.count == 0 && g_timerWheel.current <= now) {
+        g_timerWheel.current = now;  // 时间轮为空时不逐tick推进
+    }
+    OH_ListInit(&timer->node);
+    timer->expire = now + timeout;
+    timer->process = process;
+    timer->context = context;
+    AddTimerToWheel(timer);
+    g_timerWheel.count++;
+    if (g_timerWheel.armed == 0 || timer->expire < g_timerWheel.armed) {
+        ArmTimerFd(timer->expire);
+    }
+    return 0;
+}
+
+void AppSpawnStopTimer(AppSpawnTimer *timer)
+{
+    if (!AppSpawnTimerActive(timer)) {
+        return;
+    }
+    OH_ListRemove(&timer->node);
+    OH_ListInit(&timer->node);
+    if (g_timerWheel.count > 0) {
+        g_timerWheel.count--;
+    }
+    // 不重新设置timerfd，提前唤醒时重新计算
+}
+
+static void DetachTimers(ListNode *head)
+{
+    while (!ListEmpty(*head)) {
+        ListNode *node = head->next;
+        OH_ListRemove(node);
+        OH_ListInit(node);
+    }
+}
+
+void AppSpawnDestroyTimerWheel(void)
+{
+    if (g_timerWheel.timerFd < 0) {
+        return;
+    }
+    // 未停止的定时器不再执行
+    for (int i = 0; i < TIMER_ROOT_SIZE; i++) {
+        DetachTimers(&g_timerWheel.root[i]);
+    }
+    for (int level = 0; level < TIMER_WHEEL_LEVEL - 1; level++) {
+        for (int i = 0; i < TIMER_LEVEL_SIZE; i++) {
+            DetachTimers(&g_timerWheel.levels[level][i]);
+        }
+    }
+    if (g_timerWheel.ownerPid == getpid() && g_timerWheel.watcher != NULL) {
+        LE_RemoveWatcher(LE_GetDefaultLoop(), g_timerWheel.watcher);
+    }
+    g_timerWheel.watcher = NULL;
+    (void)close(g_timerWheel.timerFd);
+    g_timerWheel.timerFd = -1;
+    g_timerWheel.armed = 0;
+    g_timerWheel.count = 0;
+}
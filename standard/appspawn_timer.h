@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef APPSPAWN_TIMER_H
+#define APPSPAWN_TIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "list.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct TagAppSpawnTimer AppSpawnTimer;
+typedef void (*AppSpawnTimerProcess)(AppSpawnTimer *timer, void *context);
+
+// 定时器嵌入到使用者的结构中，启动及停止时不申请内存
+struct TagAppSpawnTimer {
+    ListNode node;
+    uint64_t expire;  // ms, CLOCK_MONOTONIC
+    AppSpawnTimerProcess process;
+    void *context;
+};
+
+/**
+ * @brief 所有定时器共用一个timerfd的分层时间轮，启动及停止为O(1)
+ *
+ * @param timer 定时器，使用前需要清零或者调用AppSpawnInitTimer
+ * @param timeout 超时时间，单位ms，超时后只执行一次
+ */
+void AppSpawnInitTimer(AppSpawnTimer *timer);
+int AppSpawnStartTimer(AppSpawnTimer *timer, uint64_t timeout, AppSpawnTimerProcess process, void *context);
+void AppSpawnStopTimer(AppSpawnTimer *timer);
+bool AppSpawnTimerActive(const AppSpawnTimer *timer);
+void AppSpawnDestroyTimerWheel(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif  // APPSPAWN_TIMER_H
@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/eventfd.h>
+
+#include "appspawn_hook.h"
+#include "appspawn_manager.h"
+#include "appspawn_utils.h"
+#include "list.h"
+#include "loop_event.h"
+#include "securec.h"
+
+typedef struct TagAppSpawnWork {
+    ListNode node;
+    struct TagAppSpawnWork *merged;  // 被本任务取代的相同任务，只调用完成函数
+    AppSpawnWorkProcess process;
+    AppSpawnWorkComplete complete;
+    void *data;
+    int result;
+    uint32_t pathCount;  // 任务未完成时，使用这些路径的孵化请求延后处理
+    char **paths;
+    char key[0];
+} AppSpawnWork;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    ListNode pendingQueue;
+    ListNode doneQueue;
+    AppSpawnWork *running;
+    pthread_t thread;
+    WatcherHandle watcher;
+    int eventFd;  // 任务完成后通知事件循环
+    int started;
+    int stop;
+    pid_t ownerPid;
+} AppSpawnWorker;
+
+static AppSpawnWorker g_worker = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    {&g_worker.pendingQueue, &g_worker.pendingQueue}, {&g_worker.doneQueue, &g_worker.doneQueue},
+    NULL, 0, NULL, -1, 0, 0, 0
+};
+
+static void CompleteWork(AppSpawnWork *work, int result)
+{
+    APPSPAWN_LOGV("Work %{public}s complete result %{public}d", work->key, result);
+    while (work != NULL) {
+        AppSpawnWork *merged = work->merged;
+        if (work->complete != NULL) {
+            work->complete(work->data, result);
+        }
+        free(work);
+        work = merged;
+    }
+}
+
+static void *AppSpawnWorkThread(void *arg)
+{
+    // 信号统一由事件循环通过signalfd处理
+    sigset_t mask;
+    sigfillset(&mask);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    pthread_mutex_lock(&g_worker.mutex);
+    while (true) {
+        while (!g_worker.stop && ListEmpty(g_worker.pendingQueue)) {
+            pthread_cond_wait(&g_worker.cond, &g_worker.mutex);
+        }
+        if (ListEmpty(g_worker.pendingQueue)) {
+            break;
+        }
+        AppSpawnWork *work = ListEntry(g_worker.pendingQueue.next, AppSpawnWork, node);
+        OH_ListRemove(&work->node);
+        OH_ListInit(&work->node);
+        g_worker.running = work;
+        pthread_mutex_unlock(&g_worker.mutex);
+
+        int ret = work->process(work->data);
+        work->result = ret == 0 ? 0 : APPSPAWN_SYSTEM_ERROR;
+
+        pthread_mutex_lock(&g_worker.mutex);
+        g_worker.running = NULL;
+        OH_ListAddTail(&g_worker.doneQueue, &work->node);
+        uint64_t value = 1;
+        (void)write(g_worker.eventFd, &value, sizeof(value));
+    }
+    pthread_mutex_unlock(&g_worker.mutex);
+    return NULL;
+}
+
+// 在事件循环中调用完成函数，一次唤醒处理所有已完成的任务
+static void ProcessDoneWork(void)
+{
+    ListNode doneQueue;
+    OH_ListInit(&doneQueue);
+    pthread_mutex_lock(&g_worker.mutex);
+    if (!ListEmpty(g_worker.doneQueue)) {
+        doneQueue.next = g_worker.doneQueue.next;
+        doneQueue.prev = g_worker.doneQueue.prev;
+        doneQueue.next->prev = &doneQueue;
+        doneQueue.prev->next = &doneQueue;
+        OH_ListInit(&g_worker.doneQueue);
+    }
+    pthread_mutex_unlock(&g_worker.mutex);
+
+    bool hasPathWork = false;
+    while (!ListEmpty(doneQueue)) {
+        AppSpawnWork *work = ListEntry(doneQueue.next, AppSpawnWork, node);
+        OH_ListRemove(&work->node);
+        hasPathWork = hasPathWork || work->pathCount > 0;
+        CompleteWork(work, work->result);
+    }
+    if (hasPathWork) {
+        AppSpawnResumeDeferredSpawn();
+    }
+}
+
+static void ProcessWorkEvent(const WatcherHandle taskHandle, int fd, uint32_t *events, const void *context)
+{
+    uint64_t count = 0;
+    (void)read(fd, &count, sizeof(count));
+    ProcessDoneWork();
+}
+
+static int StartWorker(void)
+{
+    if (g_worker.started && g_worker.ownerPid == getpid()) {
+        return 0;
+    }
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    APPSPAWN_CHECK(fd >= 0, return APPSPAWN_SYSTEM_ERROR, "Failed to create work eventfd errno: %{public}d", errno);
+    LE_WatchInfo watchInfo = {};
+    watchInfo.fd = fd;
+    watchInfo.flags = 0;
+    watchInfo.events = EVENT_READ;
+    watchInfo.processEvent = ProcessWorkEvent;
+    LE_STATUS status = LE_StartWatcher(LE_GetDefaultLoop(), &g_worker.watcher, &watchInfo, NULL);
+    APPSPAWN_CHECK(status == LE_SUCCESS, close(fd);
+        return APPSPAWN_SYSTEM_ERROR, "Failed to watch work eventfd");
+    g_worker.eventFd = fd;
+    g_worker.stop = 0;
+    // 常驻一个工作线程逐个执行任务，不再为每个任务派生整个孵化器
+    int ret = pthread_create(&g_worker.thread, NULL, AppSpawnWorkThread, NULL);
+    if (ret != 0) {
+        LE_RemoveWatcher(LE_GetDefaultLoop(), g_worker.watcher);
+        g_worker.watcher = NULL;
+        g_worker.eventFd = -1;
+        (void)close(fd);
+        APPSPAWN_LOGE("Failed to create work thread %{public}d", ret);
+        return APPSPAWN_SYSTEM_ERROR;
+    }
+    g_worker.ownerPid = getpid();
+    g_worker.started = 1;
+    return 0;
+}
+
+static AppSpawnWork *FindPendingWork(const char *key)
+{
+    ListNode *node = g_worker.pendingQueue.next;
+    while (node != &g_worker.pendingQueue) {
+        AppSpawnWork *work = ListEntry(node, AppSpawnWork, node);
+        if (strcmp(work->key, key) == 0) {
+            return work;
+        }
+        node = node->next;
+    }
+    return NULL;
+}
+
+// 孵化请求等待路径任务，路径任务排在其他任务之前
+static ListNode *GetWorkInsertPos(const AppSpawnWork *work)
+{
+    if (work->pathCount == 0) {
+        return &g_worker.pendingQueue;
+    }
+    ListNode *node = g_worker.pendingQueue.next;
+    while (node != &g_worker.pendingQueue) {
+        if (ListEntry(node, AppSpawnWork, node)->pathCount == 0) {
+            return node;
+        }
+        node = node->next;
+    }
+    return &g_worker.pendingQueue;
+}
+
+static AppSpawnWork *CreateWork(const char *key, const char *const *paths, uint32_t count)
+{
+    size_t keyLen = strlen(key) + 1;
+    size_t keySize = (keyLen + sizeof(char *) - 1) & ~(sizeof(char *) - 1);
+    size_t size = sizeof(AppSpawnWork) + keySize + sizeof(char *) * count;
+    for (uint32_t i = 0; i < count; i++) {
+        size += strlen(paths[i]) + 1;
+    }
+    AppSpawnWork *work = (AppSpawnWork *)calloc(1, size);
+    APPSPAWN_CHECK(work != NULL, return NULL, "Failed to create work %{public}s", key);
+    OH_ListInit(&work->node);
+    (void)strcpy_s(work->key, keyLen, key);
+    // 路径复制到任务中，处理函数修改任务数据时不影响事件循环中的检查
+    work->paths = (char **)(work->key + keySize);
+    char *buffer = (char *)(work->paths + count);
+    for (uint32_t i = 0; i < count; i++) {
+        size_t len = strlen(paths[i]) + 1;
+        (void)strcpy_s(buffer, len, paths[i]);
+        work->paths[i] = buffer;
+        buffer += len;
+    }
+    work->pathCount = count;
+    return work;
+}
+
+static int PostWork(const char *key, const char *const *paths, uint32_t count,
+    AppSpawnWorkProcess process, AppSpawnWorkComplete complete, void *data)
+{
+    APPSPAWN_CHECK(key != NULL && process != NULL, return APPSPAWN_ARG_INVALID, "Invalid work");
+    APPSPAWN_CHECK(count == 0 || paths != NULL, return APPSPAWN_ARG_INVALID, "Invalid work paths");
+    AppSpawnWork *work = CreateWork(key, paths, count);
+    APPSPAWN_CHECK_ONLY_EXPER(work != NULL, return APPSPAWN_SYSTEM_ERROR);
+    work->process = process;
+    work->complete = complete;
+    work->data = data;
+    if (StartWorker() != 0) {
+        APPSPAWN_LOGW("Run work %{public}s synchronously", key);
+        CompleteWork(work, process(data) == 0 ? 0 : APPSPAWN_SYSTEM_ERROR);
+        return 0;
+    }
+
+    pthread_mutex_lock(&g_worker.mutex);
+    // 尚未执行的相同任务由新任务取代，按最新的数据执行一次
+    AppSpawnWork *pending = FindPendingWork(key);
+    if (pending != NULL) {
+        OH_ListAddTail(&pending->node, &work->node);  // 插入到pending之前，保持队列中的位置
+        OH_ListRemove(&pending->node);
+        OH_ListInit(&pending->node);
+        work->merged = pending;
+        APPSPAWN_LOGV("Work %{public}s merged", key);
+    } else {
+        OH_ListAddTail(GetWorkInsertPos(work), &work->node);
+    }
+    pthread_cond_signal(&g_worker.cond);
+    pthread_mutex_unlock(&g_worker.mutex);
+    return 0;
+}
+
+int AppSpawnPostWork(const char *key, AppSpawnWorkProcess process, AppSpawnWorkComplete complete, void *data)
+{
+    return PostWork(key, NULL, 0, process, complete, data);
+}
+
+int AppSpawnPostPathWork(const char *key, const char *const *paths, uint32_t count,
+    AppSpawnWorkProcess process, AppSpawnWorkComplete complete, void *data)
+{
+    return PostWork(key, paths, count, process, complete, data);
+}
+
+static bool IsPathOverlap(const char *path1, const char *path2)
+{
+    size_t len1 = strlen(path1);
+    size_t len2 = strlen(path2);
+    size_t len = len1 < len2 ? len1 : len2;
+    if (strncmp(path1, path2, len) != 0) {
+        return false;
+    }
+    // 相同路径，或者一个是另一个的父目录
+    return len1 == len2 || (len1 < len2 ? path2[len] : path1[len]) == '/';
+}
+
+static bool IsPathWork(const AppSpawnWork *work, const char *path)
+{
+    for (; work != NULL; work = work->merged) {
+        for (uint32_t i = 0; i < work->pathCount; i++) {
+            if (IsPathOverlap(work->paths[i], path)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool AppSpawnIsPathBusy(const char *path)
+{
+    APPSPAWN_CHECK_ONLY_EXPER(path != NULL, return false);
+    pthread_mutex_lock(&g_worker.mutex);
+    bool busy = IsPathWork(g_worker.running, path);
+    ListNode *node = g_worker.pendingQueue.next;
+    while (!busy && node != &g_worker.pendingQueue) {
+        busy = IsPathWork(ListEntry(node, AppSpawnWork, node), path);
+        node = node->next;
+    }
+    // 已完成但完成函数还未执行的任务仍占用路径，完成函数执行后再恢复延后的孵化
+    node = g_worker.doneQueue.next;
+    while (!busy && node != &g_worker.doneQueue) {
+        busy = IsPathWork(ListEntry(node, AppSpawnWork, node), path);
+        node = node->next;
+    }
+    pthread_mutex_unlock(&g_worker.mutex);
+    return busy;
+}
+
+static bool IsAllWorkDone(void)
+{
+    pthread_mutex_lock(&g_worker.mutex);
+    bool done = g_worker.running == NULL && ListEmpty(g_worker.pendingQueue) && ListEmpty(g_worker.doneQueue);
+    pthread_mutex_unlock(&g_worker.mutex);
+    return done;
+}
+
+APPSPAWN_STATIC void WaitAllWorkDone(void)
+{
+    while (!IsAllWorkDone()) {
+        struct pollfd pollFd = {g_worker.eventFd, POLLIN, 0};
+        if (poll(&pollFd, 1, -1) < 0 && errno != EINTR) {
+            APPSPAWN_LOGE("Failed to wait work errno: %{public}d", errno);
+            break;
+        }
+        uint64_t count = 0;
+        (void)read(g_worker.eventFd, &count, sizeof(count));
+        ProcessDoneWork();
+    }
+}
+
+void AppSpawnDestroyWorker(void)
+{
+    if (!g_worker.started || g_worker.ownerPid != getpid()) {
+        return;
+    }
+    // 退出前执行完剩余任务
+    WaitAllWorkDone();
+    pthread_mutex_lock(&g_worker.mutex);
+    g_worker.stop = 1;
+    pthread_cond_signal(&g_worker.cond);
+    pthread_mutex_unlock(&g_worker.mutex);
+    pthread_join(g_worker.thread, NULL);
+    if (g_worker.watcher != NULL) {
+        LE_RemoveWatcher(LE_GetDefaultLoop(), g_worker.watcher);
+        g_worker.watcher = NULL;
+    }
+    (void)close(g_worker.eventFd);
+    g_worker.eventFd = -1;
+    g_worker.started = 0;
+}
@@ -118,6 +118,12 @@ void SetDeveloperMode(bool mode)
     g_developerMode = mode;
 }
 
+static bool g_sandboxNsCacheEnable = false;
+void SetSandboxNsCacheEnable(bool enable)
+{
+    g_sandboxNsCacheEnable = enable;
+}
+
 int GetParameter(const char *key, const char *def, char *value, uint32_t len)
 {
     static uint32_t count = 0;
@@ -136,6 +142,9 @@ int GetParameter(const char *key, const char *def, char *value, uint32_t len)
         }
         return strcpy_s(value, len, tmp) == 0 ? strlen(tmp) : -1;
     }
+    if (strcmp(key, "persist.appspawn.sandbox.nscache.enable") == 0) {
+        return g_sandboxNsCacheEnable ? (strcpy_s(value, len, "true") == 0 ? strlen("true") : -1) : -1;
+    }
     if (strcmp(key, "const.security.developermode.state") == 0) {
         return g_developerMode ? (strcpy_s(value, len, "true") == 0 ? strlen("true") : -1) : -1;
     }
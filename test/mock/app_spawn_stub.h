@@ -55,8 +55,11 @@ typedef struct TagAppSpawnedProcess AppSpawnedProcessInfo;
 AppSpawnNamespace *GetAppSpawnNamespace(const AppSpawnMgr *content);
 void DeleteAppSpawnNamespace(AppSpawnNamespace *ns);
 void FreeAppSpawnNamespace(struct TagAppSpawnExtData *data);
-int PreForkSetPidNamespace(AppSpawnMgr *content, AppSpawningCtx *property);
-int PostForkSetPidNamespace(AppSpawnMgr *content, AppSpawningCtx *property);
+int PidNsForkChild(AppSpawnContent *content, AppSpawnClient *client, pid_t *childPid);
+int NsHelperForkChild(AppSpawnContent *content, AppSpawnClient *client, pid_t *childPid);
+int NsHelperSendRequest(int fd, const AppSpawningCtx *property);
+AppSpawningCtx *NsHelperRecvRequest(int fd);
+void NsHelperFreeRequest(AppSpawningCtx *property);
 int ProcessMgrRemoveApp(const AppSpawnMgr *content, const AppSpawnedProcessInfo *appInfo);
 int ProcessMgrAddApp(const AppSpawnMgr *content, const AppSpawnedProcessInfo *appInfo);
 void TryCreateSocket(AppSpawnReqMsgMgr *reqMgr);
@@ -74,6 +77,11 @@ int ReplaceVariableForDepSrcPath(const SandboxContext *context,
 int ReplaceVariableForDepPath(const SandboxContext *context,
     const char *buffer, uint32_t bufferLen, uint32_t *realLen, const VarExtraData *extraData);
 int SpawnPrepareSandboxCfg(AppSpawnMgr *content, AppSpawningCtx *property);
+int SandboxNsCacheInit(AppSpawnMgr *content);
+int SandboxNsCacheCheck(AppSpawnMgr *content, AppSpawningCtx *property);
+int SandboxNsCacheAdd(AppSpawnMgr *content, AppSpawningCtx *property);
+void WaitAllWorkDone(void);
+int ProcessSandboxUnmountWork(void *data);
 unsigned long GetMountModeFromConfig(const cJSON *config, const char *key, unsigned long def);
 uint32_t GetFlagIndexFromJson(const cJSON *config);
 int ParseMountPathsConfig(AppSpawnSandboxCfg *sandbox,
@@ -83,6 +91,8 @@ int ParseSymbolLinksConfig(AppSpawnSandboxCfg *sandbox, const cJSON *symbolLinkC
 int ParseGidTableConfig(AppSpawnSandboxCfg *sandbox, const cJSON *configs, SandboxSection *section);
 
 int AppSpawnColdStartApp(struct AppSpawnContent *content, AppSpawnClient *client);
+int SetLeanColdRunPreload(void);
+int GetColdRunModuleName(const char *fileName, char *name, uint32_t size);
 void ProcessSignal(const struct signalfd_siginfo *siginfo);
 int CreateClientSocket(uint32_t type, int block);
 void CloseClientSocket(int socketId);
@@ -99,6 +109,7 @@ int WriteMsgToChild(AppSpawningCtx *property, bool isNweb);
 int WriteToFile(const char *path, int truncated, pid_t pids[], uint32_t count);
 int GetCgroupPath(const AppSpawnedProcess *appInfo, char *buffer, uint32_t buffLen);
 void SetDeveloperMode(bool mode);
+void SetSandboxNsCacheEnable(bool enable);
 int LoadPermission(AppSpawnClientType type);
 void DeletePermission(AppSpawnClientType type);
 int SetProcessName(const AppSpawnMgr *content, const AppSpawningCtx *property);
@@ -107,8 +118,16 @@ int PreLoadEnablePidNs(AppSpawnMgr *content);
 int NsInitFunc();
 int GetNsPidFd(pid_t pid);
 int PreLoadEnablePidNs(AppSpawnMgr *content);
-pid_t GetPidByName(const char *name);
 int RunBegetctlBootApp(AppSpawnMgr *content, AppSpawningCtx *property);
+int PreLoadTrimMemory(AppSpawnMgr *content);
+void AddSpawnTimelineItem(AppSpawnTimeline *timeline, int stage, int prio,
+    const struct timespec *start, const struct timespec *end);
+void ProcessResultSlots(void);
+void ProcessTimerWheel(uint64_t now);
+uint64_t GetNextTimerExpire(void);
+int CheckSpawnQuarantine(const char *name, uint32_t mode, uint64_t now);
+bool RecordSpawnFailure(const char *name, uint32_t mode, uint64_t now);
+void RecordSpawnSuccess(const char *name, uint32_t mode);
 void SetSystemEnv(void);
 void RunAppSandbox(const char *ptyName);
 HOOK_MGR *GetAppSpawnHookMgr(void);
@@ -14,7 +14,9 @@
  */
 #include <gtest/gtest.h>
 
+#include <cinttypes>
 #include <cstdio>
+#include <ctime>
 #include <fcntl.h>
 #include <random>
 #include <unistd.h>
@@ -22,6 +24,7 @@
 #include "appspawn.h"
 #include "appspawn_msg.h"
 #include "appspawn_utils.h"
+#include "parameter.h"
 #include "securec.h"
 
 #include "appspawn_test_cmder.h"
@@ -1849,5 +1852,43 @@ HWTEST_F(AppSpawnModuleTest, AppSpawn_Msg_004, TestSize.Level0)
     }
     HILOG_INFO(LOG_CORE, "AppSpawn_Msg_004 end");
 }
+
+/**
+ * @brief 对比冷启动进程精简启动流程与原启动流程的孵化耗时
+ *
+ */
+HWTEST_F(AppSpawnModuleTest, AppSpawn_Cold_Run_Benchmark, TestSize.Level0)
+{
+    HILOG_INFO(LOG_CORE, "AppSpawn_Cold_Run_Benchmark start");
+    const uint32_t spawnCount = 10;  // 10 spawn for each mode
+    const char *leanEnable[] = {"false", "true"};
+    uint64_t cost[ARRAY_LENGTH(leanEnable)] = {0};
+    SetParameter("startup.appspawn.cold.boot", "true");
+    for (uint32_t i = 0; i < ARRAY_LENGTH(leanEnable); i++) {
+        SetParameter("persist.appspawn.cold.lean.enable", leanEnable[i]);
+        for (uint32_t j = 0; j < spawnCount; j++) {
+            OHOS::AppSpawnModuleTest::AppSpawnTestCommander commander;
+            AppSpawnReqMsgHandle reqHandle;
+            AppSpawnResult result = {};
+            commander.CreateMsg(reqHandle, defaultAppInfo1.c_str());
+            (void)AppSpawnReqMsgSetAppFlag(reqHandle, APP_FLAGS_COLD_BOOT);
+            struct timespec startTime = {};
+            struct timespec endTime = {};
+            clock_gettime(CLOCK_MONOTONIC, &startTime);
+            int ret = AppSpawnClientSendMsg(commander.GetClientHandle(), reqHandle, &result);
+            clock_gettime(CLOCK_MONOTONIC, &endTime);
+            EXPECT_EQ(0, ret);
+            EXPECT_EQ(0, result.result);
+            cost[i] += DiffTime(&startTime, &endTime);
+            if (result.pid > 0) {
+                EXPECT_EQ(0, kill(result.pid, SIGKILL));
+            }
+        }
+    }
+    SetParameter("persist.appspawn.cold.lean.enable", "true");
+    printf("Cold run spawn cost: current %" PRIu64 " us, lean %" PRIu64 " us\n",
+        cost[0] / spawnCount, cost[1] / spawnCount);
+    HILOG_INFO(LOG_CORE, "AppSpawn_Cold_Run_Benchmark end");
+}
 }  // namespace AppSpawn
 }  // namespace OHOS
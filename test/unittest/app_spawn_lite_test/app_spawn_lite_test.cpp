@@ -14,6 +14,8 @@
  */
 
 #include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include <cerrno>
 #include <cstdio>
@@ -374,6 +376,148 @@ HWTEST_F(AppSpawnLiteTest, msgFuncSplitTest_002, TestSize.Level1)
     FreeMessageSt(&msgSt);
 }
 
+/*
+ ** @tc.name: msgFuncParseBinTest_001
+ ** @tc.desc: parse binary message function, pack and parse in place test
+ ** @tc.type: FUNC
+ **/
+HWTEST_F(AppSpawnLiteTest, msgFuncParseBinTest_001, TestSize.Level1)
+{
+    unsigned int caps[] = {0, 1, 5};  // 0 1 5, test capability
+    char bundleName[] = "validName";
+    char identityID[] = "135";
+    MessageSt srcSt = {bundleName, identityID, TEST_UID, TEST_GID, caps, sizeof(caps) / sizeof(caps[0]), 0};
+    MessageBinSt bin = {};
+    EXPECT_NE(PackMessageSt(nullptr, &bin), 0);
+    EXPECT_NE(PackMessageSt(&srcSt, nullptr), 0);
+    EXPECT_EQ(PackMessageSt(&srcSt, &bin), 0);
+
+    MessageSt msgSt = {0};
+    EXPECT_NE(ParseMessageBin(&bin, sizeof(bin), nullptr), 0);
+    EXPECT_NE(ParseMessageBin(nullptr, sizeof(bin), &msgSt), 0);
+    EXPECT_NE(ParseMessageBin(&bin, sizeof(bin) - 1, &msgSt), 0);
+    EXPECT_EQ(ParseMessageBin(&bin, sizeof(bin), &msgSt), 0);
+    EXPECT_EQ(msgSt.bundleName, bin.bundleName);
+    EXPECT_EQ(msgSt.identityID, bin.identityID);
+    EXPECT_EQ(strcmp("validName", msgSt.bundleName), 0);
+    EXPECT_EQ(strcmp("135", msgSt.identityID), 0);
+    EXPECT_EQ(TEST_UID, msgSt.uID);
+    EXPECT_EQ(TEST_GID, msgSt.gID);
+    EXPECT_EQ(msgSt.capsCnt, sizeof(caps) / sizeof(caps[0]));
+    for (size_t i = 0; i < msgSt.capsCnt; ++i) {
+        EXPECT_EQ(caps[i], msgSt.caps[i]);
+    }
+    // in place fields are not freed
+    FreeMessageSt(&msgSt);
+    EXPECT_EQ(msgSt.bundleName, nullptr);
+    EXPECT_EQ(msgSt.inPlace, 0);
+
+    MessageBinSt badBin = bin;
+    badBin.version = APPSPAWN_MSG_BIN_VERSION + 1;
+    EXPECT_NE(ParseMessageBin(&badBin, sizeof(badBin), &msgSt), 0);
+    badBin = bin;
+    (void)memset(badBin.bundleName, 'a', sizeof(badBin.bundleName));
+    EXPECT_NE(ParseMessageBin(&badBin, sizeof(badBin), &msgSt), 0);
+    badBin = bin;
+    (void)memset(badBin.identityID, 0, sizeof(badBin.identityID));
+    EXPECT_NE(ParseMessageBin(&badBin, sizeof(badBin), &msgSt), 0);
+    badBin = bin;
+    badBin.capsCnt = APPSPAWN_MSG_BIN_CAPS_MAX + 1;
+    EXPECT_NE(ParseMessageBin(&badBin, sizeof(badBin), &msgSt), 0);
+    badBin = bin;
+    badBin.caps[0] = 0xffff;  // 0xffff, invalid capability
+    EXPECT_NE(ParseMessageBin(&badBin, sizeof(badBin), &msgSt), 0);
+    badBin = bin;
+    badBin.uID = 0;
+    EXPECT_NE(ParseMessageBin(&badBin, sizeof(badBin), &msgSt), 0);
+    EXPECT_EQ(msgSt.bundleName, nullptr);
+}
+
+/*
+ ** @tc.name: msgFuncParseBinTest_002
+ ** @tc.desc: parse time of json message and binary message
+ ** @tc.type: FUNC
+ **/
+HWTEST_F(AppSpawnLiteTest, msgFuncParseBinTest_002, TestSize.Level1)
+{
+    const int count = 1000;  // 1000 parse times
+    std::string validStr =
+        "{\"bundleName\":\"validName\",\"identityID\":\"135\",\"uID\":999,\"gID\":888,\"capability\":[0, 1, 5]}";
+    MessageSt msgSt = {0};
+    EXPECT_EQ(SplitMessage(validStr.c_str(), validStr.length(), &msgSt), 0);
+    MessageBinSt bin = {};
+    EXPECT_EQ(PackMessageSt(&msgSt, &bin), 0);
+    FreeMessageSt(&msgSt);
+
+    struct timespec tmStart = {0};
+    GetCurrentTime(&tmStart);
+    for (int i = 0; i < count; ++i) {
+        EXPECT_EQ(SplitMessage(validStr.c_str(), validStr.length(), &msgSt), 0);
+        FreeMessageSt(&msgSt);
+    }
+    struct timespec tmMiddle = {0};
+    GetCurrentTime(&tmMiddle);
+    for (int i = 0; i < count; ++i) {
+        EXPECT_EQ(ParseMessageBin(&bin, sizeof(bin), &msgSt), 0);
+        FreeMessageSt(&msgSt);
+    }
+    struct timespec tmEnd = {0};
+    GetCurrentTime(&tmEnd);
+
+    long jsonUsed = (tmMiddle.tv_sec - tmStart.tv_sec) * NANOSECONDS_PER_SECOND +
+        (tmMiddle.tv_nsec - tmStart.tv_nsec);
+    long binUsed = (tmEnd.tv_sec - tmMiddle.tv_sec) * NANOSECONDS_PER_SECOND + (tmEnd.tv_nsec - tmMiddle.tv_nsec);
+    printf("[----------] AppSpawnLiteTest, msgFuncParseBinTest_002, json %ld ns, binary %ld ns, cnt %d.\n",
+        jsonUsed, binUsed, count);
+}
+
+static unsigned int WaitPreforkReady(unsigned int count)
+{
+    const int retryCount = 100;  // 100 * 10ms
+    const useconds_t waitTime = 10000;  // 10ms
+    for (int i = 0; i < retryCount && AppSpawnPreforkReadyCount() < count; ++i) {
+        usleep(waitTime);
+    }
+    return AppSpawnPreforkReadyCount();
+}
+
+/*
+ ** @tc.name: preforkSpawnTest_001
+ ** @tc.desc: hand over message to standby child, and refill the pool
+ ** @tc.type: FUNC
+ **/
+HWTEST_F(AppSpawnLiteTest, preforkSpawnTest_001, TestSize.Level1)
+{
+    AppSpawnContent *content = AppSpawnCreateContent("AppSpawn", NULL, 0, 0);
+    ASSERT_NE(content, nullptr);
+    SetContentFunction(content);
+
+    AppSpawnClientLite client = {};
+    client.client.id = 1;
+    std::string validStr =
+        "{\"bundleName\":\"validName\",\"identityID\":\"135\",\"uID\":999,\"gID\":888,\"capability\":[0, 1, 5]}";
+    EXPECT_EQ(SplitMessage(validStr.c_str(), validStr.length(), &client.message), 0);
+
+    pid_t pid = 0;
+    EXPECT_NE(AppSpawnPreforkSpawn(&client, &pid), 0);
+    EXPECT_NE(AppSpawnPreforkInit(nullptr, 1), 0);
+    EXPECT_NE(AppSpawnPreforkInit(content, 0), 0);
+    EXPECT_EQ(AppSpawnPreforkInit(content, APPSPAWN_PREFORK_MAX + 1), 0);
+    EXPECT_EQ(WaitPreforkReady(APPSPAWN_PREFORK_MAX), APPSPAWN_PREFORK_MAX);
+
+    EXPECT_EQ(AppSpawnPreforkSpawn(&client, &pid), 0);
+    EXPECT_GT(pid, 0);
+    int status = 0;
+    EXPECT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_EQ(WaitPreforkReady(APPSPAWN_PREFORK_MAX), APPSPAWN_PREFORK_MAX);
+
+    // pool closed, invoke forks directly
+    AppSpawnPreforkExit();
+    EXPECT_EQ(AppSpawnPreforkReadyCount(), 0);
+    EXPECT_NE(AppSpawnPreforkSpawn(&client, &pid), 0);
+    FreeMessageSt(&client.message);
+}
+
 HWTEST_F(AppSpawnLiteTest, SetContentFunctionTest_001, TestSize.Level0)
 {
     GTEST_LOG_(INFO) << "SetContentFunctionTest_001 start";
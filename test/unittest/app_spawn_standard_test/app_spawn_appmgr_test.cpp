@@ -15,14 +15,21 @@
 
 #include <gtest/gtest.h>
 
+#include <csignal>
 #include <cstring>
+#include <string>
+#include <vector>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 #include "appspawn.h"
+#include "appspawn_adapter.h"
 #include "appspawn_hook.h"
 #include "appspawn_manager.h"
+#include "appspawn_memaudit.h"
 #include "appspawn_modulemgr.h"
 #include "appspawn_permission.h"
 #include "appspawn_sandbox.h"
@@ -249,6 +256,10 @@ HWTEST_F(AppSpawnAppMgrTest, App_Spawn_AppSpawningCtx_001, TestSize.Level0)
     appCtx = GetAppSpawningCtxByPid(100);  // 100 test
     EXPECT_EQ(appCtx != nullptr, 1);
 
+    // GetAppSpawningCtxByClientId
+    EXPECT_EQ(GetAppSpawningCtxByClientId(appCtx->client.id), appCtx);
+    EXPECT_EQ(GetAppSpawningCtxByClientId(appCtx->client.id + 1), nullptr);
+
     AppSpawningCtxTraversal(TestProcessTraversal, reinterpret_cast<void *>(appCtx));
     AppSpawningCtxTraversal(nullptr, reinterpret_cast<void *>(appCtx));
     AppSpawningCtxTraversal(TestProcessTraversal, nullptr);
@@ -1159,4 +1170,391 @@ HWTEST_F(AppSpawnAppMgrTest, App_Spawn_KillAndWaitStatus, TestSize.Level0)
     ret = KillAndWaitStatus(pid, sig, &exitStatus);
     EXPECT_EQ(-1, ret);
 }
+
+typedef struct {
+    int blockFd;  // 工作线程中阻塞读，直到测试写入
+    int result;
+    int expect;
+    int order;  // 执行顺序
+} TestWorkData;
+
+static int g_workCompleteCount = 0;
+static int g_workOrder = 0;
+
+static int TestWorkProcess(void *data)
+{
+    TestWorkData *work = reinterpret_cast<TestWorkData *>(data);
+    work->order = ++g_workOrder;
+    if (work->blockFd >= 0) {
+        char buffer = 0;
+        (void)read(work->blockFd, &buffer, sizeof(buffer));
+    }
+    return work->result;
+}
+
+static void TestWorkComplete(void *data, int result)
+{
+    TestWorkData *work = reinterpret_cast<TestWorkData *>(data);
+    EXPECT_EQ(result, work->expect);
+    g_workCompleteCount++;
+}
+
+/**
+ * @brief 后台任务在工作线程中执行，相同key的未执行任务由最新的任务取代，路径任务优先执行
+ *
+ */
+HWTEST_F(AppSpawnAppMgrTest, App_Spawn_Work_001, TestSize.Level0)
+{
+    int fds[2] = {-1, -1};  // 2 pipe fds
+    ASSERT_EQ(pipe(fds), 0);
+    g_workCompleteCount = 0;
+    g_workOrder = 0;
+    // 第一个任务阻塞工作线程，后续相同key的任务处于等待状态
+    TestWorkData running = {fds[0], 0, 0, 0};
+    TestWorkData pending1 = {-1, -1, 0, 0};  // 被取代，按最新任务的结果完成
+    TestWorkData pending2 = {-1, 0, 0, 0};
+    TestWorkData pathWork = {-1, -1, APPSPAWN_SYSTEM_ERROR, 0};
+    const char *paths[] = {"/mnt/sandbox/100/app-root/data"};
+    int ret = AppSpawnPostWork("test-work|running", TestWorkProcess, TestWorkComplete, &running);
+    EXPECT_EQ(ret, 0);
+    ret = AppSpawnPostWork("test-work|pending", TestWorkProcess, TestWorkComplete, &pending1);
+    EXPECT_EQ(ret, 0);
+    ret = AppSpawnPostWork("test-work|pending", TestWorkProcess, TestWorkComplete, &pending2);
+    EXPECT_EQ(ret, 0);
+    ret = AppSpawnPostPathWork("test-work|path", paths, ARRAY_LENGTH(paths), TestWorkProcess, TestWorkComplete,
+        &pathWork);
+    EXPECT_EQ(ret, 0);
+    EXPECT_TRUE(AppSpawnIsPathBusy("/mnt/sandbox/100/app-root"));
+    EXPECT_TRUE(AppSpawnIsPathBusy("/mnt/sandbox/100/app-root/data/storage"));
+    EXPECT_FALSE(AppSpawnIsPathBusy("/mnt/sandbox/100/app-root/database"));
+    EXPECT_FALSE(AppSpawnIsPathBusy("/mnt/sandbox/101/app-root"));
+    EXPECT_EQ(g_workCompleteCount, 0);
+
+    (void)write(fds[1], "1", 1);
+    WaitAllWorkDone();
+    EXPECT_EQ(g_workCompleteCount, 4);  // 4 all complete
+    EXPECT_FALSE(AppSpawnIsPathBusy("/mnt/sandbox/100/app-root"));
+    EXPECT_LT(pathWork.order, pending2.order);  // 路径任务排在等待的任务之前
+    EXPECT_EQ(pending1.order, 0);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/**
+ * @brief 卸载任务，已卸载目录下的路径不再单独卸载
+ *
+ */
+HWTEST_F(AppSpawnAppMgrTest, App_Spawn_Work_002, TestSize.Level0)
+{
+    const char *testPaths[] = {
+        "/mnt/sandbox/100/app-root/data/storage/el2/base",
+        "/mnt/sandbox/100/app-root/data",
+        "/mnt/sandbox/100/app-root/data-tmp",
+        "/mnt/sandbox/100/app-root/data/storage",
+        "/mnt/sandbox/100/app-root/system",
+    };
+    size_t count = ARRAY_LENGTH(testPaths);
+    struct {
+        char *rootPath;
+        uint32_t count;
+        uint32_t capacity;
+        char *paths[ARRAY_LENGTH(testPaths)];
+    } work = {nullptr, static_cast<uint32_t>(count), static_cast<uint32_t>(count), {}};
+    for (size_t i = 0; i < count; i++) {
+        work.paths[i] = const_cast<char *>(testPaths[i]);
+    }
+    int ret = ProcessSandboxUnmountWork(&work);
+    EXPECT_EQ(ret, 0);
+    EXPECT_STREQ(work.paths[0], "/mnt/sandbox/100/app-root/data");
+    EXPECT_STREQ(work.paths[count - 1], "/mnt/sandbox/100/app-root/system");
+}
+
+static pid_t ForkSleepChild(void)
+{
+    pid_t pid = fork();
+    if (pid == 0) {
+        while (true) {
+            pause();
+        }
+    }
+    return pid;
+}
+
+/**
+ * @brief 超时子进程后台抓栈，完成后杀掉子进程，同一应用限频
+ *
+ */
+HWTEST_F(AppSpawnAppMgrTest, App_Spawn_DumpStackAsync_001, TestSize.Level0)
+{
+    const char *bundleName = "com.example.dumpstack";
+    EXPECT_NE(DumpSpawnStackAsync(0, bundleName), 0);
+    pid_t pid = ForkSleepChild();
+    ASSERT_GT(pid, 0);
+    EXPECT_EQ(DumpSpawnStackAsync(pid, bundleName), 0);
+    EXPECT_NE(DumpSpawnStackAsync(pid, "com.example.other"), 0);  // dump is running
+
+    WaitAllWorkDone();
+    int status = 0;
+    EXPECT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL);
+
+    // 同一应用短时间内不再抓栈
+    pid = ForkSleepChild();
+    ASSERT_GT(pid, 0);
+    EXPECT_NE(DumpSpawnStackAsync(pid, bundleName), 0);
+    kill(pid, SIGKILL);
+    EXPECT_EQ(waitpid(pid, &status, 0), pid);
+}
+
+/**
+ * @brief 内存共享审计，子进程写过的页不再与父进程共享
+ *
+ */
+HWTEST_F(AppSpawnAppMgrTest, App_Spawn_MemAudit_001, TestSize.Level0)
+{
+    const size_t pageCount = 64;  // 64 pages
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    char *buffer = static_cast<char *>(mmap(nullptr, pageCount * pageSize, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    ASSERT_NE(buffer, MAP_FAILED);
+    (void)memset_s(buffer, pageCount * pageSize, 1, pageCount * pageSize);
+    int pipeFd[2] = {-1, -1};  // 2 pipe fd
+    ASSERT_EQ(pipe(pipeFd), 0);
+    pid_t pid = fork();
+    if (pid == 0) {
+        for (size_t i = 0; i < pageCount / 2; i++) {  // 2 half of pages
+            buffer[i * pageSize] = 2;  // 2 copy on write
+        }
+        char ready = 1;
+        (void)write(pipeFd[1], &ready, sizeof(ready));
+        pause();
+        _exit(0);
+    }
+    ASSERT_GT(pid, 0);
+    char ready = 0;
+    EXPECT_EQ(read(pipeFd[0], &ready, sizeof(ready)), sizeof(ready));
+
+    char smaps[32] = {0};    // 32 max path
+    char pagemap[32] = {0};  // 32 max path
+    (void)sprintf_s(smaps, sizeof(smaps), "/proc/%d/smaps", pid);
+    (void)sprintf_s(pagemap, sizeof(pagemap), "/proc/%d/pagemap", pid);
+    MemAuditResult *result = static_cast<MemAuditResult *>(calloc(1, sizeof(MemAuditResult)));
+    EXPECT_NE(result, nullptr);
+    if (result != nullptr) {
+        EXPECT_EQ(AuditMemorySharing(smaps, pagemap, "/proc/self/pagemap", result), 0);
+        EXPECT_GT(result->total.rss, 0);
+        uint64_t halfKb = pageCount / 2 * pageSize / 1024;  // 2 half, 1024 KB
+        EXPECT_GE(result->stats[MEM_AUDIT_OTHER_ANON].privateDirty, halfKb);
+        if (result->pfnValid) {
+            EXPECT_GE(result->stats[MEM_AUDIT_OTHER_ANON].copied, halfKb);
+            EXPECT_GE(result->stats[MEM_AUDIT_OTHER_ANON].shared, halfKb);
+            ASSERT_GT(result->topCount, 0);
+            EXPECT_GE(result->top[0].stat.copied, result->top[result->topCount - 1].stat.copied);
+        }
+        free(result);
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+    close(pipeFd[0]);
+    close(pipeFd[1]);
+    munmap(buffer, pageCount * pageSize);
+    EXPECT_NE(AuditMemorySharing("/proc/-1/smaps", nullptr, nullptr, nullptr), 0);
+}
+
+HWTEST_F(AppSpawnAppMgrTest, App_Spawn_MemAudit_002, TestSize.Level0)
+{
+    EXPECT_EQ(GetMemAuditType("[anon:ArkTS Heap]"), MEM_AUDIT_JS_HEAP);
+    EXPECT_EQ(GetMemAuditType("/system/lib64/platformsdk/libace_compatible.z.so"), MEM_AUDIT_ACE_LIB);
+    EXPECT_EQ(GetMemAuditType("[anon:libc_malloc]"), MEM_AUDIT_MALLOC);
+    EXPECT_EQ(GetMemAuditType("[heap]"), MEM_AUDIT_MALLOC);
+    EXPECT_EQ(GetMemAuditType("/system/lib64/libc++.so"), MEM_AUDIT_OTHER_FILE);
+    EXPECT_EQ(GetMemAuditType(""), MEM_AUDIT_OTHER_ANON);
+    EXPECT_EQ(GetMemAuditType("[stack]"), MEM_AUDIT_OTHER_ANON);
+    DumpAppMemorySharing(-1);
+}
+
+/**
+ * @brief 子进程各hook耗时记录及格式化
+ *
+ */
+HWTEST_F(AppSpawnAppMgrTest, App_Spawn_Timeline_001, TestSize.Level0)
+{
+    const char *name = "com.example.myapplication";
+    AppSpawnedProcess *appInfo = static_cast<AppSpawnedProcess *>(
+        calloc(1, sizeof(AppSpawnedProcess) + strlen(name) + 1));
+    ASSERT_NE(appInfo, nullptr);
+    appInfo->spawnStart = {10, 0};  // 10 s
+    struct timespec start = {10, 2000000};  // 10 s 2 ms
+    struct timespec end = {10, 2500000};  // 10 s 2.5 ms
+    AddSpawnTimelineItem(&appInfo->timeline, STAGE_CHILD_EXECUTE, HOOK_PRIO_SANDBOX, &start, &end);
+    start = {10, 3000000};  // 10 s 3 ms
+    end = {10, 4000000};  // 10 s 4 ms
+    AddSpawnTimelineItem(&appInfo->timeline, STAGE_CHILD_PRE_RELY, HOOK_PRIO_COMMON, &start, &end);
+    EXPECT_EQ(appInfo->timeline.count, 2);
+
+    char buffer[256] = {0};  // 256 max
+    EXPECT_GT(FormatSpawnTimeline(appInfo, buffer, sizeof(buffer)), 0);
+    std::string expect = "fork: 2000 " + std::to_string(STAGE_CHILD_EXECUTE) + "/" +
+        std::to_string(HOOK_PRIO_SANDBOX) + ": 0-500 " + std::to_string(STAGE_CHILD_PRE_RELY) + "/" +
+        std::to_string(HOOK_PRIO_COMMON) + ": 1000-2000";
+    EXPECT_STREQ(buffer, expect.c_str());
+
+    // 超过最大个数时丢弃，格式化时超长截断
+    for (uint32_t i = 0; i < APP_SPAWN_TIMELINE_MAX; i++) {
+        AddSpawnTimelineItem(&appInfo->timeline, STAGE_CHILD_EXECUTE, HOOK_PRIO_HIGHEST, &start, &end);
+    }
+    EXPECT_EQ(appInfo->timeline.count, APP_SPAWN_TIMELINE_MAX);
+    char shortBuffer[64] = {0};  // 64 short
+    EXPECT_GT(FormatSpawnTimeline(appInfo, shortBuffer, sizeof(shortBuffer)), 0);
+    EXPECT_EQ(strncmp(shortBuffer, buffer, strlen("fork: 2000")), 0);
+    free(appInfo);
+}
+
+static int g_childResult = -1;
+static void TestChildResultProcess(AppSpawningCtx *property, const AppSpawnChildResponse *response, bool hasTimeline)
+{
+    g_childResult = response->result;
+    EXPECT_TRUE(hasTimeline);
+    EXPECT_EQ(property->forkCtx.resultSlot, -1);
+}
+
+/**
+ * @brief 子进程通过共享结果槽回复结果，父进程一次处理所有已完成的槽
+ *
+ */
+HWTEST_F(AppSpawnAppMgrTest, App_Spawn_ResultSlot_001, TestSize.Level0)
+{
+    AppSpawningCtx *property = CreateAppSpawningCtx();
+    AppSpawningCtx *released = CreateAppSpawningCtx();
+    AppSpawningCtx *reused = CreateAppSpawningCtx();
+    ASSERT_NE(property, nullptr);
+    ASSERT_NE(released, nullptr);
+    ASSERT_NE(reused, nullptr);
+    EXPECT_EQ(AppSpawnAcquireResultSlot(property, TestChildResultProcess), 0);
+    EXPECT_EQ(AppSpawnAcquireResultSlot(released, TestChildResultProcess), 0);
+    EXPECT_GE(property->forkCtx.resultSlot, 0);
+    EXPECT_NE(property->forkCtx.resultSlot, released->forkCtx.resultSlot);
+    int32_t releasedSlot = released->forkCtx.resultSlot;
+    AppSpawnReleaseResultSlot(released);
+    EXPECT_EQ(released->forkCtx.resultSlot, -1);
+    EXPECT_EQ(AppSpawnAcquireResultSlot(reused, TestChildResultProcess), 0);
+    // 模拟超时回收后子进程仍写入，槽可能已分配给其他请求
+    int32_t reusedSlot = reused->forkCtx.resultSlot;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        AppSpawnChildResponse response = {};
+        response.result = APPSPAWN_SPAWN_TIMEOUT;
+        released->forkCtx.resultSlot = releasedSlot;
+        int ret = AppSpawnWriteResultSlot(released, &response);
+        released->forkCtx.resultSlot = reusedSlot;
+        ret = (ret != 0 && AppSpawnWriteResultSlot(released, &response) != 0) ? 0 : 1;
+        response.result = 12;  // 12 test result
+        ret = (ret == 0 && AppSpawnWriteResultSlot(property, &response) == 0) ? 0 : 1;
+        AppSpawnDetachResultSlab();
+        _exit(ret);
+    }
+    ASSERT_GT(pid, 0);
+    int status = -1;
+    EXPECT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    g_childResult = -1;
+    ProcessResultSlots();
+    EXPECT_EQ(g_childResult, 12);  // 12 test result
+    EXPECT_EQ(reused->forkCtx.resultSlot, reusedSlot);
+    g_childResult = -1;
+    ProcessResultSlots();
+    EXPECT_EQ(g_childResult, -1);
+
+    AppSpawnReleaseResultSlot(reused);
+    DeleteAppSpawningCtx(reused);
+    DeleteAppSpawningCtx(released);
+    DeleteAppSpawningCtx(property);
+    AppSpawnDestroyResultSlab();
+}
+
+static std::vector<int> g_timerOrder;
+static void TestTimerProcess(AppSpawnTimer *timer, void *context)
+{
+    g_timerOrder.push_back(static_cast<int>(reinterpret_cast<intptr_t>(context)));
+}
+
+/**
+ * @brief 时间轮定时器按超时时间执行，停止的定时器不执行
+ *
+ */
+HWTEST_F(AppSpawnAppMgrTest, App_Spawn_TimerWheel_001, TestSize.Level0)
+{
+    const uint32_t count = 5;  // 5 timers
+    const uint64_t timeouts[count] = {5, 300, 20000, 1, 300};  // 300 20000 cascade from upper level
+    AppSpawnTimer timers[count];
+    for (uint32_t i = 0; i < count; i++) {
+        AppSpawnInitTimer(&timers[i]);
+        EXPECT_FALSE(AppSpawnTimerActive(&timers[i]));
+    }
+    g_timerOrder.clear();
+    for (uint32_t i = 0; i < count; i++) {
+        EXPECT_EQ(AppSpawnStartTimer(&timers[i], timeouts[i], TestTimerProcess,
+            reinterpret_cast<void *>(static_cast<intptr_t>(i))), 0);
+        EXPECT_TRUE(AppSpawnTimerActive(&timers[i]));
+    }
+    AppSpawnStopTimer(&timers[4]);  // 4 stopped timer
+    EXPECT_FALSE(AppSpawnTimerActive(&timers[4]));
+    uint64_t base = GetNextTimerExpire() - 1;  // 1 first timer
+
+    ProcessTimerWheel(base + 100);  // 100 ms later
+    ASSERT_EQ(g_timerOrder.size(), 2);
+    EXPECT_EQ(g_timerOrder[0], 3);
+    EXPECT_EQ(g_timerOrder[1], 0);
+    ProcessTimerWheel(base + 1000);  // 1000 ms later
+    ASSERT_EQ(g_timerOrder.size(), 3);
+    EXPECT_EQ(g_timerOrder[2], 1);
+    // 上级槽中的定时器在级联时唤醒，不晚于其超时时间
+    uint64_t next = GetNextTimerExpire();
+    EXPECT_GT(next, base + 1000);  // 1000 ms
+    EXPECT_LE(next, base + 20000);  // 20000 ms
+    ProcessTimerWheel(base + 30000);  // 30000 ms later
+    ASSERT_EQ(g_timerOrder.size(), 4);
+    EXPECT_EQ(g_timerOrder[3], 2);
+    EXPECT_FALSE(AppSpawnTimerActive(&timers[2]));
+    AppSpawnDestroyTimerWheel();
+}
+
+/**
+ * @brief 同一bundle连续失败时按指数退避隔离，多个不同bundle连续失败时才需要重启
+ *
+ */
+HWTEST_F(AppSpawnAppMgrTest, App_Spawn_Quarantine_001, TestSize.Level0)
+{
+    const char *name = "com.example.quarantine";
+    const uint32_t mode = MSG_APP_SPAWN;
+    const uint64_t now = 1000000;  // 1000000 test time ms
+    EXPECT_FALSE(RecordSpawnFailure(name, mode, now));
+    EXPECT_FALSE(RecordSpawnFailure(name, mode, now));
+    EXPECT_EQ(CheckSpawnQuarantine(name, mode, now), 0);
+    EXPECT_FALSE(RecordSpawnFailure(name, mode, now));
+    EXPECT_EQ(CheckSpawnQuarantine(name, mode, now + 1000), APPSPAWN_SPAWN_QUARANTINED);  // 1000 in 2s quarantine
+    EXPECT_EQ(CheckSpawnQuarantine(name, MSG_SPAWN_NATIVE_PROCESS, now + 1000), 0);  // 1000 other mode
+    EXPECT_EQ(CheckSpawnQuarantine(name, mode, now + 2000), 0);  // 2000 expired
+
+    EXPECT_FALSE(RecordSpawnFailure(name, mode, now + 2000));  // 2000 failed again, quarantine 4s
+    EXPECT_EQ(CheckSpawnQuarantine(name, mode, now + 5000), APPSPAWN_SPAWN_QUARANTINED);  // 5000 in quarantine
+    EXPECT_EQ(CheckSpawnQuarantine(name, mode, now + 6000), 0);  // 6000 expired
+    RecordSpawnSuccess(name, mode);
+    EXPECT_FALSE(RecordSpawnFailure(name, mode, now + 7000));  // 7000 count again after success
+    EXPECT_EQ(CheckSpawnQuarantine(name, mode, now + 7000), 0);  // 7000 not quarantine
+
+    // 同一bundle不同孵化方式只统计一次
+    EXPECT_FALSE(RecordSpawnFailure(name, MSG_SPAWN_NATIVE_PROCESS, now + 8000));  // 8000 test time
+    const uint32_t count = 4;  // 4 other bundles
+    for (uint32_t i = 0; i < count; i++) {
+        std::string bundleName = "com.example.crash" + std::to_string(i);
+        EXPECT_EQ(RecordSpawnFailure(bundleName.c_str(), mode, now + 8000), i == count - 1);  // 8000 test time
+    }
+    DumpSpawnQuarantine();
+    RecordSpawnSuccess(name, mode);
+    EXPECT_FALSE(RecordSpawnFailure(name, mode, now + 9000));  // 9000 streak cleared after success
+    RecordSpawnSuccess(name, mode);
+}
 }  // namespace OHOS
@@ -13,6 +13,7 @@
  * limitations under the License.
  */
 
+#include <climits>
 #include <cstdlib>
 #include <cstring>
 #include <string>
@@ -279,4 +280,34 @@ HWTEST_F(AppSpawnColdRunTest, App_Spawn_Cold_Run_005, TestSize.Level0)
     ASSERT_EQ(ret, APPSPAWN_SYSTEM_ERROR);
     free(appProperty.message);
 }
+
+/**
+ * @brief 冷启动进程启动时直接带上helper，不再为设置LD_PRELOAD重新execv
+ *
+ */
+HWTEST_F(AppSpawnColdRunTest, App_Spawn_Cold_Run_006, TestSize.Level0)
+{
+    const char *preload = getenv("LD_PRELOAD");
+    std::string oldPreload = preload != nullptr ? preload : "";
+
+    unsetenv("LD_PRELOAD");
+    EXPECT_EQ(SetLeanColdRunPreload(), 0);
+    EXPECT_STREQ(getenv("LD_PRELOAD"), APPSPAWN_PRELOAD);
+    EXPECT_EQ(SetLeanColdRunPreload(), 0);
+    EXPECT_STREQ(getenv("LD_PRELOAD"), APPSPAWN_PRELOAD);
+
+    setenv("LD_PRELOAD", "libtest.so", 1);
+    EXPECT_EQ(SetLeanColdRunPreload(), 0);
+    EXPECT_STREQ(getenv("LD_PRELOAD"), "libtest.so:" APPSPAWN_PRELOAD);
+
+    std::string longPreload(PATH_MAX, 'a');
+    setenv("LD_PRELOAD", longPreload.c_str(), 1);
+    EXPECT_NE(SetLeanColdRunPreload(), 0);
+
+    if (oldPreload.empty()) {
+        unsetenv("LD_PRELOAD");
+    } else {
+        setenv("LD_PRELOAD", oldPreload.c_str(), 1);
+    }
+}
 }  // namespace OHOS
\ No newline at end of file
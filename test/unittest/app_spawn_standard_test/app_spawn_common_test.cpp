@@ -20,8 +20,15 @@
 #include <string>
 #include <unistd.h>
 #include <gtest/gtest.h>
+#include <csignal>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <sys/prctl.h>
+#include <sys/ptrace.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 
 #include "appspawn_modulemgr.h"
 #include "appspawn_server.h"
@@ -364,7 +371,6 @@ HWTEST_F(AppSpawnCommonTest, App_Spawn_Common_014, TestSize.Level0)
 {
     NsInitFunc();
     EXPECT_EQ(GetNsPidFd(-1), -1);
-    GetPidByName("///////");
 }
 
 HWTEST_F(AppSpawnCommonTest, App_Spawn_Common_015, TestSize.Level0)
@@ -629,10 +635,13 @@ HWTEST_F(AppSpawnCommonTest, App_Spawn_Common_030, TestSize.Level0)
     int ret = -1;
     AppSpawnMgr *mgr = CreateAppSpawnMgr(MODE_FOR_APP_SPAWN);
     EXPECT_EQ(mgr != nullptr, 1);
-    mgr->content.sandboxNsFlags = 1;
-    ret = PreForkSetPidNamespace(mgr, nullptr);
+    mgr->content.sandboxNsFlags = CLONE_NEWPID;
+    // pid_ns_init不可用时孵化失败，不在appspawn的pid namespace中fork
+    pid_t pid = 0;
+    ret = PidNsForkChild(&mgr->content, nullptr, &pid);
     DeleteAppSpawnMgr(mgr);
-    ASSERT_EQ(ret, 0);
+    ASSERT_EQ(ret, APPSPAWN_SYSTEM_ERROR);
+    ASSERT_EQ(pid, 0);
 }
 
 HWTEST_F(AppSpawnCommonTest, App_Spawn_Common_031, TestSize.Level0)
@@ -640,13 +649,68 @@ HWTEST_F(AppSpawnCommonTest, App_Spawn_Common_031, TestSize.Level0)
     int ret = -1;
     AppSpawnMgr *mgr = CreateAppSpawnMgr(MODE_FOR_APP_SPAWN);
     EXPECT_EQ(mgr != nullptr, 1);
-    mgr->content.sandboxNsFlags = 0;
-    ret = PostForkSetPidNamespace(mgr, nullptr);
+    mgr->content.sandboxNsFlags = CLONE_NEWPID;
+    pid_t pid = 0;
+    ret = NsHelperForkChild(&mgr->content, nullptr, &pid);
     DeleteAppSpawnMgr(mgr);
-    ASSERT_EQ(ret, 0);
+    ASSERT_EQ(ret, APPSPAWN_SYSTEM_ERROR);
+    ASSERT_EQ(pid, 0);
     AppSpawnClientInit(nullptr, nullptr);
 }
 
+HWTEST_F(AppSpawnCommonTest, App_Spawn_Common_032, TestSize.Level0)
+{
+    AppSpawnClientHandle clientHandle = nullptr;
+    AppSpawnReqMsgHandle reqHandle = 0;
+    AppSpawningCtx *property = nullptr;
+    AppSpawningCtx *request = nullptr;
+    int sockets[2] = {-1, -1};  // 2 socket pair
+    int ret = -1;
+    do {
+        ret = AppSpawnClientInit(APPSPAWN_SERVER_NAME, &clientHandle);
+        APPSPAWN_CHECK(ret == 0, break, "Failed to create reqMgr %{public}s", APPSPAWN_SERVER_NAME);
+        reqHandle = g_testHelper.CreateMsg(clientHandle, MSG_APP_SPAWN, 0);
+        APPSPAWN_CHECK(reqHandle != INVALID_REQ_HANDLE, break,
+            "Failed to create req %{public}s", APPSPAWN_SERVER_NAME);
+        property = g_testHelper.GetAppProperty(clientHandle, reqHandle);
+        APPSPAWN_CHECK_ONLY_EXPER(property != nullptr, break);
+        ret = pipe(property->forkCtx.fd);
+        APPSPAWN_CHECK_ONLY_EXPER(ret == 0, break);
+        ret = socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+        APPSPAWN_CHECK_ONLY_EXPER(ret == 0, break);
+
+        // fork ctx pipe and msg are sent to helper
+        ret = NsHelperSendRequest(sockets[0], property);
+        APPSPAWN_CHECK_ONLY_EXPER(ret == 0, break);
+        request = NsHelperRecvRequest(sockets[1]);
+        APPSPAWN_CHECK(request != nullptr, ret = -1;
+            break, "Failed to recv request");
+        EXPECT_EQ(request->client.id, property->client.id);
+        EXPECT_EQ(request->message->msgHeader.msgLen, property->message->msgHeader.msgLen);
+        EXPECT_EQ(strcmp(GetProcessName(request), GetProcessName(property)), 0);
+        EXPECT_NE(request->message->connection, nullptr);
+        EXPECT_GE(request->forkCtx.fd[1], 0);
+        int result = 0;
+        EXPECT_EQ(write(request->forkCtx.fd[1], &result, sizeof(result)), sizeof(result));
+        EXPECT_EQ(read(property->forkCtx.fd[0], &result, sizeof(result)), sizeof(result));
+
+        // appspawn closed
+        close(sockets[0]);
+        sockets[0] = -1;
+        EXPECT_EQ(NsHelperRecvRequest(sockets[1]), nullptr);
+    } while (0);
+    NsHelperFreeRequest(request);
+    if (sockets[0] >= 0) {
+        close(sockets[0]);
+    }
+    if (sockets[1] >= 0) {
+        close(sockets[1]);
+    }
+    DeleteAppSpawningCtx(property);
+    AppSpawnClientDestroy(clientHandle);
+    ASSERT_EQ(ret, 0);
+}
+
 HWTEST_F(AppSpawnCommonTest, App_Spawn_SetFdEnv, TestSize.Level0)
 {
     int ret = SetFdEnv(nullptr, nullptr);
@@ -683,4 +747,82 @@ HWTEST_F(AppSpawnCommonTest, App_Spawn_SetFdEnv, TestSize.Level0)
     free(property.message);
 }
 
+HWTEST_F(AppSpawnCommonTest, App_Spawn_PreLoadTrimMemory, TestSize.Level0)
+{
+    AppSpawnMgr *mgr = CreateAppSpawnMgr(MODE_FOR_APP_COLD_RUN);
+    ASSERT_NE(mgr, nullptr);
+    EXPECT_EQ(PreLoadTrimMemory(mgr), 0);  // cold run mode, skip
+    DeleteAppSpawnMgr(mgr);
+
+    mgr = CreateAppSpawnMgr(MODE_FOR_APP_SPAWN);
+    ASSERT_NE(mgr, nullptr);
+    void *buffer = malloc(1024 * 1024);  // 1024 * 1024 1M
+    ASSERT_NE(buffer, nullptr);
+    free(buffer);
+    EXPECT_EQ(PreLoadTrimMemory(mgr), 0);
+    DeleteAppSpawnMgr(mgr);
+}
+
+static struct sock_filter g_testSeccompFilter[] = {
+    BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 0),
+    BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+};
+
+static bool TestSetSeccompPolicy(int type, const char *name)
+{
+    struct sock_fprog prog = {
+        sizeof(g_testSeccompFilter) / sizeof(g_testSeccompFilter[0]), g_testSeccompFilter
+    };
+    (void)prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0);
+    return syscall(__NR_seccomp, SECCOMP_SET_MODE_FILTER, 0, &prog) == 0;
+}
+
+HWTEST_F(AppSpawnCommonTest, App_Spawn_SeccompFilterCache, TestSize.Level0)
+{
+    EXPECT_NE(AddSeccompFilterCache(1, "app", nullptr), 0);
+    EXPECT_EQ(GetSeccompFilterCache(1, "app", nullptr), nullptr);
+    EXPECT_NE(InstallSeccompFilterCache(1, "app"), 0);
+    if (AddSeccompFilterCache(1, "app", TestSetSeccompPolicy) != 0) {
+        // 读取过滤器需要CAP_SYS_ADMIN且测试进程未启用seccomp
+        ClearSeccompFilterCache();
+        return;
+    }
+    unsigned int flags = 0;
+    const struct sock_fprog *prog = GetSeccompFilterCache(1, "app", &flags);
+    ASSERT_NE(prog, nullptr);
+    ASSERT_EQ(prog->len, sizeof(g_testSeccompFilter) / sizeof(g_testSeccompFilter[0]));
+    EXPECT_EQ(memcmp(prog->filter, g_testSeccompFilter, sizeof(g_testSeccompFilter)), 0);
+    EXPECT_EQ(GetSeccompFilterCache(2, "app", nullptr), nullptr);  // 2 other type
+    EXPECT_EQ(GetSeccompFilterCache(1, "app_privilege", nullptr), nullptr);
+
+    // 子进程一次系统调用安装的过滤器与按名称安装的逐字节一致
+    pid_t pid = fork();
+    if (pid == 0) {
+        int result = -1;
+        if (ptrace(PTRACE_TRACEME, 0, nullptr, nullptr) == 0) {
+            result = InstallSeccompFilterCache(1, "app");
+        }
+        (void)raise(SIGSTOP);
+        _exit(result == 0 ? 0 : 1);
+    }
+    ASSERT_GT(pid, 0);
+    int status = 0;
+    EXPECT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFSTOPPED(status));
+    struct sock_fprog installed = {0, nullptr};
+    unsigned int installedFlags = 0;
+    EXPECT_EQ(ReadSeccompFilter(pid, &installed, &installedFlags), 0);
+    EXPECT_EQ(installed.len, prog->len);
+    EXPECT_EQ(installedFlags, flags);
+    if (installed.filter != nullptr && installed.len == prog->len) {
+        EXPECT_EQ(memcmp(installed.filter, prog->filter, prog->len * sizeof(struct sock_filter)), 0);
+    }
+    free(installed.filter);
+    (void)ptrace(PTRACE_CONT, pid, nullptr, nullptr);
+    EXPECT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    ClearSeccompFilterCache();
+    EXPECT_EQ(GetSeccompFilterCache(1, "app", nullptr), nullptr);
+}
+
 }  // namespace OHOS
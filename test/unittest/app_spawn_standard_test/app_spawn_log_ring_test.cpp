@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "appspawn_utils.h"
+
+using namespace testing;
+using namespace testing::ext;
+
+namespace OHOS {
+class AppSpawnLogRingTest : public testing::Test {
+public:
+    static void SetUpTestCase() {}
+    static void TearDownTestCase() {}
+    void SetUp()
+    {
+        (void)AppSpawnLogRingFlush();
+    }
+    void TearDown() {}
+};
+
+static std::string DumpLogRing(void)
+{
+    const char *path = "/data/appspawn_log_ring_dump";
+    FILE *stream = fopen(path, "w+");
+    if (stream == nullptr) {
+        return "";
+    }
+    SetDumpToStream(stream);
+    AppSpawnLogRingDump();
+    SetDumpToStream(stdout);
+    std::string content;
+    char buffer[512] = {0};  // 512 line
+    rewind(stream);
+    while (fgets(buffer, sizeof(buffer), stream) != nullptr) {
+        content += buffer;
+    }
+    (void)fclose(stream);
+    unlink(path);
+    return content;
+}
+
+static uint64_t GetCurrentTime(void)
+{
+    struct timespec time = {};
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return static_cast<uint64_t>(time.tv_sec) * APPSPAWN_SEC_TO_NSEC + time.tv_nsec;
+}
+
+/**
+ * @brief 日志环只保存参数，dump时按格式串格式化
+ *
+ */
+HWTEST_F(AppSpawnLogRingTest, App_Spawn_LogRing_001, TestSize.Level0)
+{
+    const char *name = "com.example.myapplication";
+    APPSPAWN_LOG_RING_WRITE(APPSPAWN_LOG_RING_INFO, "spawn %{public}s id: %{public}u flags: 0x%{public}x",
+        name, 12u, 0x10);  // 12 id 0x10 flags
+    APPSPAWN_LOG_RING_WRITE(APPSPAWN_LOG_RING_DEBUG, "cost %{public}" PRId64 " us %{public}.2f %{public}zu 100%%",
+        static_cast<int64_t>(-5), 3.5, sizeof(uint64_t));  // -5 3.5 test data
+    APPSPAWN_LOG_RING_WRITE(APPSPAWN_LOG_RING_INFO, "null %{public}s", static_cast<const char *>(nullptr));
+    std::string longName(256, 'a');  // 256 long name
+    APPSPAWN_LOG_RING_WRITE(APPSPAWN_LOG_RING_INFO, "long %{public}s end", longName.c_str());
+    APPSPAWN_LOG_RING_WRITE(APPSPAWN_LOG_RING_INFO, "width %{public}*d", 5, 1);  // 5 1 not support, direct output
+
+    std::string content = DumpLogRing();
+    EXPECT_NE(content.find("app_spawn_log_ring_test.cpp:"), std::string::npos);
+    EXPECT_NE(content.find("spawn com.example.myapplication id: 12 flags: 0x10"), std::string::npos);
+    EXPECT_NE(content.find("cost -5 us 3.50 8 100%"), std::string::npos);
+    EXPECT_NE(content.find("null (null)"), std::string::npos);
+    EXPECT_NE(content.find("long aaaa"), std::string::npos);
+    EXPECT_EQ(content.find(longName), std::string::npos);
+    EXPECT_EQ(content.find("width"), std::string::npos);
+    EXPECT_EQ(AppSpawnLogRingFlush(), 0);
+}
+
+/**
+ * @brief 日志环满时丢弃新日志，不阻塞写入
+ *
+ */
+HWTEST_F(AppSpawnLogRingTest, App_Spawn_LogRing_002, TestSize.Level0)
+{
+    const uint32_t count = 1024;  // 1024 more than ring size
+    for (uint32_t i = 0; i < count; i++) {
+        APPSPAWN_LOG_RING_WRITE(APPSPAWN_LOG_RING_INFO, "log %{public}u", i);
+    }
+    uint32_t flushed = AppSpawnLogRingFlush();
+    EXPECT_GT(flushed, 0);
+    EXPECT_LT(flushed, count);
+    APPSPAWN_LOG_RING_WRITE(APPSPAWN_LOG_RING_INFO, "log after flush");
+    EXPECT_EQ(AppSpawnLogRingFlush(), 1);
+
+    // 子进程丢弃继承的日志，只输出自己的
+    APPSPAWN_LOG_RING_WRITE(APPSPAWN_LOG_RING_INFO, "log before fork");
+    pid_t pid = fork();
+    if (pid == 0) {
+        AppSpawnLogRingAfterFork();
+        APPSPAWN_LOG_RING_WRITE(APPSPAWN_LOG_RING_INFO, "log in child");
+        _exit(AppSpawnLogRingFlush() == 1 ? 0 : 1);
+    }
+    ASSERT_GT(pid, 0);
+    int status = -1;
+    EXPECT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    EXPECT_EQ(AppSpawnLogRingFlush(), 1);
+}
+
+/**
+ * @brief 对比每次孵化热路径日志的耗时，直接输出与写入日志环
+ *
+ */
+HWTEST_F(AppSpawnLogRingTest, App_Spawn_LogRing_Benchmark, TestSize.Level0)
+{
+    const uint32_t spawnCount = 200;  // 200 spawn
+    const uint32_t logPerSpawn = 20;  // 20 hook start and end logs per spawn
+    const char *name = "com.example.myapplication";
+    uint64_t directCost = 0;
+    uint64_t ringCost = 0;
+    for (uint32_t i = 0; i < spawnCount; i++) {
+        uint64_t start = GetCurrentTime();
+        for (uint32_t j = 0; j < logPerSpawn; j++) {
+            APPSPAWN_LOGI("Hook stage: %{public}d prio: %{public}d end time %{public}" PRId64 " ns %{public}s",
+                static_cast<int>(j), static_cast<int>(i), static_cast<int64_t>(start), name);
+        }
+        uint64_t middle = GetCurrentTime();
+        for (uint32_t j = 0; j < logPerSpawn; j++) {
+            APPSPAWN_LOG_RING_WRITE(APPSPAWN_LOG_RING_INFO,
+                "Hook stage: %{public}d prio: %{public}d end time %{public}" PRId64 " ns %{public}s",
+                static_cast<int>(j), static_cast<int>(i), static_cast<int64_t>(start), name);
+        }
+        uint64_t end = GetCurrentTime();
+        directCost += middle - start;
+        ringCost += end - middle;
+        (void)AppSpawnLogRingFlush();  // 刷新线程中执行，不计入孵化耗时
+    }
+    printf("Logging cost per spawn: direct %" PRIu64 " ns, log ring %" PRIu64 " ns\n",
+        directCost / spawnCount, ringCost / spawnCount);
+    EXPECT_GT(ringCost, 0);
+}
+}  // namespace OHOS
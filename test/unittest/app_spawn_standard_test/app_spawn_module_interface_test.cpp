@@ -88,6 +88,34 @@ HWTEST_F(AppSpawnModuleInterfaceTest, App_Spawn_AppSpawnLoadAutoRunModules_001,
     AppSpawnModuleMgrUnInstall(100);
 }
 
+HWTEST_F(AppSpawnModuleInterfaceTest, App_Spawn_AppSpawnLoadColdRunModules_001, TestSize.Level1)
+{
+    int ret = AppSpawnLoadColdRunModules(MODULE_COMMON);
+    EXPECT_EQ(0, ret);
+    ret = AppSpawnLoadColdRunModules(MODULE_COMMON);
+    EXPECT_EQ(0, ret);
+    AppSpawnModuleMgrUnInstall(MODULE_COMMON);
+    ret = AppSpawnLoadColdRunModules(MODULE_APPSPAWN);
+    EXPECT_EQ(0, ret);
+    AppSpawnModuleMgrUnInstall(MODULE_APPSPAWN);
+    ret = AppSpawnLoadColdRunModules(MODULE_MAX);
+    EXPECT_NE(0, ret);
+}
+
+HWTEST_F(AppSpawnModuleInterfaceTest, App_Spawn_GetColdRunModuleName_001, TestSize.Level1)
+{
+    char name[64] = {0};  // 64 max name
+    EXPECT_EQ(GetColdRunModuleName("libappspawn_common.z.so", name, sizeof(name)), 0);
+    EXPECT_STREQ(name, "appspawn_common");
+    EXPECT_EQ(GetColdRunModuleName("libappspawn_sandbox.z.so", name, sizeof(name)), 0);
+    EXPECT_STREQ(name, "appspawn_sandbox");
+    // 服务端模块和非模块文件不安装
+    EXPECT_NE(GetColdRunModuleName("libevent_reporter.z.so", name, sizeof(name)), 0);
+    EXPECT_NE(GetColdRunModuleName("libappspawn_common.so", name, sizeof(name)), 0);
+    EXPECT_NE(GetColdRunModuleName("appspawn_common.z.so", name, sizeof(name)), 0);
+    EXPECT_NE(GetColdRunModuleName("lib.z.so", name, sizeof(name)), 0);
+}
+
 /**
  * @brief hook interface
  *
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <unistd.h>
+
+#include "appspawn_manager.h"
+#include "preload_report.h"
+#include "preload_usage.h"
+
+#include "app_spawn_stub.h"
+#include "app_spawn_test_helper.h"
+
+using namespace testing;
+using namespace testing::ext;
+
+namespace OHOS {
+using namespace AppSpawn;
+
+class AppSpawnPreloadReportTest : public testing::Test {
+public:
+    static void SetUpTestCase() {}
+    static void TearDownTestCase() {}
+    void SetUp() {}
+    void TearDown() {}
+};
+
+static int PreloadReportCompareDataId(ListNode *node, void *data)
+{
+    AppSpawnExtData *extData = ListEntry(node, AppSpawnExtData, node);
+    return extData->dataId - *static_cast<uint32_t *>(data);
+}
+
+HWTEST_F(AppSpawnPreloadReportTest, Preload_Report_001, TestSize.Level0)
+{
+    const char *path = "/data/preload_report_smaps_rollup";
+    FILE *fp = fopen(path, "w");
+    ASSERT_NE(fp, nullptr);
+    fprintf(fp, "00400000-ffffffffff601000 ---p 00000000 00:00 0      [rollup]\n");
+    fprintf(fp, "Rss:               12345 kB\n");
+    fprintf(fp, "Pss:                6789 kB\n");
+    fprintf(fp, "Pss_Anon:           1000 kB\n");
+    fclose(fp);
+
+    PreloadMemInfo info;
+    EXPECT_TRUE(PreloadProfiler::ReadMemInfo(path, info));
+    EXPECT_EQ(info.rss, 12345);
+    EXPECT_EQ(info.pss, 6789);
+    unlink(path);
+    EXPECT_FALSE(PreloadProfiler::ReadMemInfo(path, info));
+}
+
+HWTEST_F(AppSpawnPreloadReportTest, Preload_Report_002, TestSize.Level0)
+{
+    AppSpawnMgr *mgr = CreateAppSpawnMgr(MODE_FOR_APP_SPAWN);
+    ASSERT_NE(mgr, nullptr);
+    PreloadProfiler profiler(true);
+    profiler.Start("application.Ability");
+    profiler.Stop();
+    profiler.Start("hilog");
+    usleep(1000);  // 1000 1ms
+    profiler.Stop();
+    ASSERT_EQ(profiler.GetStats().size(), 2);
+    EXPECT_EQ(profiler.GetStats()[1].name, "hilog");
+    EXPECT_GE(profiler.GetStats()[1].cost, 1000);  // 1000 1ms
+
+    // report again replace the old one
+    profiler.Report(mgr);
+    profiler.Report(mgr);
+    uint32_t dataId = EXT_DATA_PRELOAD_REPORT;
+    ListNode *node = OH_ListFind(&mgr->extData, static_cast<void *>(&dataId), PreloadReportCompareDataId);
+    ASSERT_NE(node, nullptr);
+    EXPECT_EQ(OH_ListGetCnt(&mgr->extData), 1);
+    AppSpawnExtData *extData = ListEntry(node, AppSpawnExtData, node);
+    ASSERT_NE(extData->dumpNode, nullptr);
+    extData->dumpNode(extData);
+    DeleteAppSpawnMgr(mgr);
+}
+
+HWTEST_F(AppSpawnPreloadReportTest, Preload_Usage_001, TestSize.Level0)
+{
+    const char *path = "/data/preload_usage_smaps";
+    FILE *fp = fopen(path, "w");
+    ASSERT_NE(fp, nullptr);
+    fprintf(fp, "7f0000000000-7f0000001000 r--p 00000000 fd:00 11 /system/lib64/module/libhilog_napi.z.so\n");
+    fprintf(fp, "Size:                  4 kB\n");
+    fprintf(fp, "Rss:                   4 kB\n");
+    fprintf(fp, "7f0000001000-7f0000003000 r-xp 00001000 fd:00 11 /system/lib64/module/libhilog_napi.z.so\n");
+    fprintf(fp, "Rss:                   8 kB\n");
+    fprintf(fp, "VmFlags: rd ex mr mw me\n");
+    fprintf(fp, "7f0000003000-7f0000004000 rw-p 00000000 00:00 0\n");
+    fprintf(fp, "Rss:                 100 kB\n");
+    fprintf(fp, "7f0000004000-7f0000005000 r--p 00000000 fd:00 12 /system/lib64/module/multimedia/libimage.z.so\n");
+    fprintf(fp, "Rss:                  16 kB\n");
+    fclose(fp);
+
+    std::map<std::string, uint64_t> usage;
+    EXPECT_TRUE(PreloadUsageAggregator::ParseSmaps(path, "/system/lib64/module/", usage));
+    unlink(path);
+    ASSERT_EQ(usage.size(), 2);
+    EXPECT_EQ(usage["/system/lib64/module/libhilog_napi.z.so"], 12);
+    EXPECT_EQ(usage["/system/lib64/module/multimedia/libimage.z.so"], 16);
+    EXPECT_FALSE(PreloadUsageAggregator::ParseSmaps(path, "/system/lib64/module/", usage));
+
+    EXPECT_EQ(PreloadUsageAggregator::GetModuleName("/system/lib64/module/",
+        "/system/lib64/module/libhilog_napi.z.so"), "hilog");
+    EXPECT_EQ(PreloadUsageAggregator::GetModuleName("/system/lib64/module/",
+        "/system/lib64/module/multimedia/libimage.z.so"), "multimedia.image");
+}
+
+HWTEST_F(AppSpawnPreloadReportTest, Preload_Usage_002, TestSize.Level0)
+{
+    const std::string moduleDir = "/system/lib64/module/";
+    const std::string hilog = moduleDir + "libhilog_napi.z.so";
+    const std::string image = moduleDir + "multimedia/libimage.z.so";
+    const std::string util = moduleDir + "libutil.z.so";
+    PreloadUsageAggregator aggregator(moduleDir, {util}, 1024);  // 1024 1us per KB
+    aggregator.AddApp({{hilog, 10}, {image, 100}, {util, 50}});
+    aggregator.AddApp({{hilog, 30}, {util, 50}});
+    aggregator.AddApp({{util, 50}});
+    EXPECT_EQ(aggregator.GetAppCount(), 3);
+
+    // 已预加载的模块不作为候选，按使用的应用数排序
+    std::vector<PreloadCandidate> candidates = aggregator.GetCandidates();
+    ASSERT_EQ(candidates.size(), 2);
+    EXPECT_EQ(candidates[0].module, "hilog");
+    EXPECT_EQ(candidates[0].appCount, 2);
+    EXPECT_EQ(candidates[0].avgRss, 20);
+    EXPECT_EQ(candidates[0].memSaving, 20);
+    EXPECT_EQ(candidates[0].timeSaving, 40);
+    EXPECT_EQ(candidates[1].module, "multimedia.image");
+    EXPECT_EQ(candidates[1].memSaving, 0);
+}
+}  // namespace OHOS
@@ -708,4 +708,57 @@ HWTEST_F(AppSpawnSandboxCoverageTest, App_Spawn_Sandbox_load_006, TestSize.Level
         free(section.gidTable);
     }
 }
+
+HWTEST_F(AppSpawnSandboxCoverageTest, App_Spawn_Sandbox_mount_api_001, TestSize.Level0)
+{
+    // syscall 被打桩返回0，真实内核对非法fd不会返回成功，因此判定为不支持
+    int ret = SandboxMountApiInit();
+    EXPECT_EQ(ret, 0);
+    EXPECT_EQ(IsSandboxMountApiSupport(), 0);
+
+    MountArg arg = {"/data/app/el1/bundle/public/test", "/mnt/sandbox/100/test/data/storage/el1/bundle",
+        nullptr, MS_BIND | MS_REC, nullptr, MS_SLAVE | MS_REMOUNT | MS_NODEV | MS_RDONLY | MS_BIND};
+    // 内核不支持时全部走mount(2)
+    EXPECT_EQ(IsSandboxMountApiPreferred(&arg), false);
+    ret = SandboxBindMountByApi(&arg);
+    EXPECT_EQ(ret, 0);
+    ret = SandboxSetSubtreeAttr(nullptr, 0, MS_SLAVE);
+    EXPECT_EQ(ret, APPSPAWN_ARG_INVALID);
+    ret = SandboxSetSubtreeAttr("/", 0, MS_SLAVE);
+    EXPECT_EQ(ret, 0);
+}
+
+HWTEST_F(AppSpawnSandboxCoverageTest, App_Spawn_Sandbox_mount_api_002, TestSize.Level0)
+{
+    MountArg arg = {"/data/app/el1/bundle/public/test", "/mnt/sandbox/100/test/data/storage/el1/bundle",
+        nullptr, MS_BIND | MS_REC, nullptr, MS_SLAVE};
+    EXPECT_EQ(IsSandboxMountPropagationInherited(&arg), false);
+
+    SandboxMountBatchBegin("/mnt/sandbox/100/test", MS_SLAVE);
+    EXPECT_EQ(IsSandboxMountPropagationInherited(&arg), true);
+    arg.mountSharedFlag = MS_SHARED;
+    EXPECT_EQ(IsSandboxMountPropagationInherited(&arg), false);
+    arg.mountSharedFlag = MS_SLAVE;
+    arg.fsType = "sharefs";
+    EXPECT_EQ(IsSandboxMountPropagationInherited(&arg), false);
+    arg.fsType = nullptr;
+    // 源路径在沙盒内或目标不在沙盒内，不能依赖继承
+    arg.originPath = "/mnt/sandbox/100/test/data";
+    EXPECT_EQ(IsSandboxMountPropagationInherited(&arg), false);
+    arg.originPath = "/data/app/el1/bundle/public/test";
+    arg.destinationPath = "/mnt/sandbox/100/test2/data";
+    EXPECT_EQ(IsSandboxMountPropagationInherited(&arg), false);
+    arg.destinationPath = "/mnt/sandbox/100/test/data";
+    int ret = SandboxMountPath(&arg);
+    EXPECT_EQ(ret, 0);
+    // 父挂载点为shared时不能依赖继承
+    SandboxMountBatchAddShared("/mnt/sandbox/100/test/data");
+    arg.destinationPath = "/mnt/sandbox/100/test/data/storage";
+    EXPECT_EQ(IsSandboxMountPropagationInherited(&arg), false);
+    arg.destinationPath = "/mnt/sandbox/100/test/system";
+    EXPECT_EQ(IsSandboxMountPropagationInherited(&arg), true);
+
+    SandboxMountBatchEnd();
+    EXPECT_EQ(IsSandboxMountPropagationInherited(&arg), false);
+}
 }
\ No newline at end of file
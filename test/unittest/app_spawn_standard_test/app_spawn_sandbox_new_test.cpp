@@ -843,6 +843,106 @@ HWTEST_F(AppSpawnSandboxTest, App_Spawn_ExpandCfg_03, TestSize.Level0)
     ASSERT_EQ(ret, 0);
 }
 
+/**
+ * @brief HspList/DataGroup/Overlay 使用二进制编码
+ *
+ */
+HWTEST_F(AppSpawnSandboxTest, App_Spawn_ExpandCfg_Binary_01, TestSize.Level0)
+{
+    AppSpawnClientHandle clientHandle = nullptr;
+    AppSpawnReqMsgHandle reqHandle = 0;
+    AppSpawningCtx *property = nullptr;
+    AppSpawnSandboxCfg *sandbox = nullptr;
+    int ret = -1;
+    do {
+        sandbox = CreateAppSpawnSandbox(EXT_DATA_SANDBOX);
+        APPSPAWN_CHECK_ONLY_EXPER(sandbox != nullptr, break);
+        LoadAppSandboxConfig(sandbox, MODE_FOR_APP_SPAWN);
+        // add default
+        AddDefaultExpandAppSandboxConfigHandle();
+        // create msg
+        ret = AppSpawnClientInit(APPSPAWN_SERVER_NAME, &clientHandle);
+        APPSPAWN_CHECK(ret == 0, break, "Failed to create reqMgr %{public}s", APPSPAWN_SERVER_NAME);
+        reqHandle = g_testHelper.CreateMsg(clientHandle, MSG_SPAWN_NATIVE_PROCESS, 0);
+        APPSPAWN_CHECK(reqHandle != INVALID_REQ_HANDLE, break, "Failed to create req %{public}s", APPSPAWN_SERVER_NAME);
+        // add expand info to msg
+        const AppSpawnHspInfo hspList[] = {
+            {"test.bundle1", "module1", "v10001"},
+            {"test.bundle2", "module2", "v10002"},
+        };
+        ret = AppSpawnReqMsgAddHspList(reqHandle, hspList, ARRAY_LENGTH(hspList));
+        APPSPAWN_CHECK(ret == 0, break, "Failed to add hsp list");
+        const AppSpawnDataGroupInfo groupList[] = {
+            {"1234abcd5678efgh", "/data/app/el2/100/group/091a68a9-2cc9-4279-8849-28631b598975", 10003},
+            {"abcduiop1234", "/data/app/el2/100/group/ce876162-fe69-45d3-aa8e-411a047af564", 10004},
+        };
+        ret = AppSpawnReqMsgAddDataGroupList(reqHandle, groupList, ARRAY_LENGTH(groupList));
+        APPSPAWN_CHECK(ret == 0, break, "Failed to add data group list");
+        const char *overlayList[] = {
+            "/data/app/el1/bundle/public/com.ohos.demo/feature.hsp",
+            "/data/app/el1/bundle/public/com.ohos.demo/feature2.hsp",
+        };
+        AppSpawnReqMsgSetAppFlag(reqHandle, APP_FLAGS_OVERLAY);
+        ret = AppSpawnReqMsgAddOverlayList(reqHandle, overlayList, ARRAY_LENGTH(overlayList));
+        APPSPAWN_CHECK(ret == 0, break, "Failed to add overlay list");
+
+        property = g_testHelper.GetAppProperty(clientHandle, reqHandle);
+        APPSPAWN_CHECK_ONLY_EXPER(property != nullptr, break);
+        ret = MountSandboxConfigs(sandbox, property, 0);
+    } while (0);
+    if (sandbox != nullptr) {
+        sandbox->extData.freeNode(&sandbox->extData);
+    }
+    DeleteAppSpawningCtx(property);
+    AppSpawnClientDestroy(clientHandle);
+    ASSERT_EQ(ret, 0);
+}
+
+/**
+ * @brief 二进制编码被截断时拒绝处理
+ *
+ */
+HWTEST_F(AppSpawnSandboxTest, App_Spawn_ExpandCfg_Binary_02, TestSize.Level0)
+{
+    AppSpawnClientHandle clientHandle = nullptr;
+    AppSpawnReqMsgHandle reqHandle = 0;
+    AppSpawningCtx *property = nullptr;
+    AppSpawnSandboxCfg *sandbox = nullptr;
+    int ret = -1;
+    do {
+        sandbox = CreateAppSpawnSandbox(EXT_DATA_SANDBOX);
+        APPSPAWN_CHECK_ONLY_EXPER(sandbox != nullptr, break);
+        LoadAppSandboxConfig(sandbox, MODE_FOR_APP_SPAWN);
+        AddDefaultExpandAppSandboxConfigHandle();
+        ret = AppSpawnClientInit(APPSPAWN_SERVER_NAME, &clientHandle);
+        APPSPAWN_CHECK(ret == 0, break, "Failed to create reqMgr %{public}s", APPSPAWN_SERVER_NAME);
+        reqHandle = g_testHelper.CreateMsg(clientHandle, MSG_SPAWN_NATIVE_PROCESS, 0);
+        APPSPAWN_CHECK(reqHandle != INVALID_REQ_HANDLE, break, "Failed to create req %{public}s", APPSPAWN_SERVER_NAME);
+        // 头部声明了2个记录，实际只有1个
+        AppSpawnExtListHeader header = {APPSPAWN_EXT_LIST_MAGIC, APPSPAWN_EXT_LIST_VERSION, EXT_LIST_OVERLAY, 2};
+        const char hapPath[] = "/data/app/el1/bundle/public/com.ohos.demo/feature.hsp";
+        uint16_t len = strlen(hapPath);
+        uint8_t buffer[sizeof(header) + sizeof(len) + sizeof(hapPath)] = {};
+        (void)memcpy_s(buffer, sizeof(buffer), &header, sizeof(header));
+        (void)memcpy_s(buffer + sizeof(header), sizeof(buffer) - sizeof(header), &len, sizeof(len));
+        (void)memcpy_s(buffer + sizeof(header) + sizeof(len),
+            sizeof(buffer) - sizeof(header) - sizeof(len), hapPath, sizeof(hapPath));
+        AppSpawnReqMsgSetAppFlag(reqHandle, APP_FLAGS_OVERLAY);
+        ret = AppSpawnReqMsgAddExtInfo(reqHandle, MSG_EXT_NAME_OVERLAY, buffer, sizeof(buffer));
+        APPSPAWN_CHECK(ret == 0, break, "Failed to add overlay list");
+
+        property = g_testHelper.GetAppProperty(clientHandle, reqHandle);
+        APPSPAWN_CHECK_ONLY_EXPER(property != nullptr, break);
+        ret = MountSandboxConfigs(sandbox, property, 0);
+    } while (0);
+    if (sandbox != nullptr) {
+        sandbox->extData.freeNode(&sandbox->extData);
+    }
+    DeleteAppSpawningCtx(property);
+    AppSpawnClientDestroy(clientHandle);
+    ASSERT_NE(ret, 0);
+}
+
 HWTEST_F(AppSpawnSandboxTest, App_Spawn_ExpandCfg_04, TestSize.Level0)
 {
     AppSpawnClientHandle clientHandle = nullptr;
@@ -2368,4 +2468,121 @@ HWTEST_F(AppSpawnSandboxTest, App_Spawn_Sandbox_permission, TestSize.Level0)
     ret = PermissionRenumber(nullptr);
     ASSERT_EQ(ret, -1);
 }
+
+/**
+ * @brief 挂载命名空间缓存默认关闭，不影响正常挂载流程
+ *
+ */
+HWTEST_F(AppSpawnSandboxTest, App_Spawn_Sandbox_NsCache_001, TestSize.Level0)
+{
+    AppSpawnMgr *mgr = CreateAppSpawnMgr(MODE_FOR_APP_SPAWN);
+    ASSERT_NE(mgr, nullptr);
+    AppSpawningCtx *spawningCtx = TestCreateAppSpawningCtx();
+    ASSERT_NE(spawningCtx, nullptr);
+
+    int ret = SandboxNsCacheInit(mgr);
+    EXPECT_EQ(ret, 0);
+    ret = SandboxNsCacheCheck(mgr, spawningCtx);
+    EXPECT_EQ(ret, 0);
+    spawningCtx->pid = getpid();
+    ret = SandboxNsCacheAdd(mgr, spawningCtx);
+    EXPECT_EQ(ret, 0);
+    uint64_t mountDigest = 0;
+    EXPECT_EQ(GetSandboxNsCacheFd(mgr, spawningCtx, &mountDigest), -1);
+    CloseSandboxNsCache(mgr);
+
+    DeleteAppSpawningCtx(spawningCtx);
+    DeleteAppSpawnMgr(mgr);
+}
+
+/**
+ * @brief 沙盒挂载状态表：从mountinfo初始化，挂载/卸载后更新
+ *
+ */
+HWTEST_F(AppSpawnSandboxTest, App_Spawn_Sandbox_MountState_001, TestSize.Level0)
+{
+    const char *mountInfo = APPSPAWN_BASE_DIR "/test_mountinfo";
+    (void)MakeDirRec(APPSPAWN_BASE_DIR, 0711, 1);  // 0711 mode
+    FILE *file = fopen(mountInfo, "w");
+    ASSERT_NE(file, nullptr);
+    fprintf(file, "36 35 98:0 / /mnt/sandbox/100/app-root/lib rw,noatime master:1 - ext3 /dev/root rw\n");
+    fprintf(file, "37 35 98:0 / /data rw,noatime master:1 - ext3 /dev/root rw\n");
+    fclose(file);
+
+    EXPECT_EQ(LoadSandboxMountState(nullptr, "/mnt/sandbox/<currentUserId>/app-root"), APPSPAWN_ARG_INVALID);
+    EXPECT_EQ(LoadSandboxMountState(mountInfo, "/mnt/sandbox/<currentUserId>/app-root"), 0);
+    EXPECT_EQ(IsSandboxPathMounted("system-const", "/mnt/sandbox/100/app-root", "/lib"), true);
+    EXPECT_EQ(IsSandboxPathMounted("system-const", "/mnt/sandbox/101/app-root", "/lib"), false);
+    EXPECT_EQ(IsSandboxPathMounted("system-const", "/data", nullptr), false);
+
+    SetSandboxPathMounted("system-const", "/mnt/sandbox/101/app-root", true);
+    EXPECT_EQ(IsSandboxPathMounted("system-const", "/mnt/sandbox/101/app-root", "/lib"), true);
+    SetSandboxPathMounted("system-const", "/mnt/sandbox/100/app-root", false);
+    EXPECT_EQ(IsSandboxPathMounted("system-const", "/mnt/sandbox/100/app-root", "/lib"), false);
+
+    ClearSandboxMountState();
+    EXPECT_EQ(IsSandboxPathMounted("system-const", "/mnt/sandbox/101/app-root", nullptr), false);
+    ClearSandboxMountState();
+    unlink(mountInfo);
+}
+
+/**
+ * @brief 挂载命名空间缓存命中与失效
+ *
+ */
+HWTEST_F(AppSpawnSandboxTest, App_Spawn_Sandbox_NsCache_002, TestSize.Level0)
+{
+    AppSpawnMgr *mgr = CreateAppSpawnMgr(MODE_FOR_APP_SPAWN);
+    ASSERT_NE(mgr, nullptr);
+    AppSpawningCtx *spawningCtx = TestCreateAppSpawningCtx();
+    ASSERT_NE(spawningCtx, nullptr);
+    AppSpawnMsgBundleInfo *bundleInfo = (AppSpawnMsgBundleInfo *)GetAppProperty(spawningCtx, TLV_BUNDLE_INFO);
+    ASSERT_NE(bundleInfo, nullptr);
+
+    SetSandboxNsCacheEnable(true);
+    int ret = SandboxNsCacheInit(mgr);
+    SetSandboxNsCacheEnable(false);
+    EXPECT_EQ(ret, 0);
+    uint64_t mountDigest = 0;
+    EXPECT_EQ(GetSandboxNsCacheFd(mgr, spawningCtx, &mountDigest), -1);
+
+    // 孵化成功后缓存命名空间，相同key命中
+    spawningCtx->pid = getpid();
+    ret = SandboxNsCacheAdd(mgr, spawningCtx);
+    EXPECT_EQ(ret, 0);
+    EXPECT_GE(GetSandboxNsCacheFd(mgr, spawningCtx, &mountDigest), 0);
+    uint64_t digest = 0;
+    EXPECT_GT(GetSandboxNsMountInfo(0, &digest), 0);
+    EXPECT_EQ(mountDigest, digest);
+    ret = SandboxNsCacheCheck(mgr, spawningCtx);
+    EXPECT_EQ(ret, 0);
+    EXPECT_GE(GetSandboxNsCacheFd(mgr, spawningCtx, &mountDigest), 0);
+
+    // 分身序号不同不命中
+    bundleInfo->bundleIndex++;
+    EXPECT_EQ(GetSandboxNsCacheFd(mgr, spawningCtx, &mountDigest), -1);
+    bundleInfo->bundleIndex--;
+    EXPECT_GE(GetSandboxNsCacheFd(mgr, spawningCtx, &mountDigest), 0);
+
+    // 沙盒挂载点更新后缓存失效
+    mgr->sandboxGeneration++;
+    EXPECT_EQ(GetSandboxNsCacheFd(mgr, spawningCtx, &mountDigest), -1);
+    ret = SandboxNsCacheCheck(mgr, spawningCtx);
+    EXPECT_EQ(ret, 0);
+    ret = SandboxNsCacheAdd(mgr, spawningCtx);
+    EXPECT_EQ(ret, 0);
+    EXPECT_GE(GetSandboxNsCacheFd(mgr, spawningCtx, &mountDigest), 0);
+
+    // 使用该命名空间的应用仍在运行时不能进入
+    AppSpawnedProcess *holder = AddSpawnedProcess(getpid(), "com.example.holder");
+    ASSERT_NE(holder, nullptr);
+    EXPECT_EQ(GetSandboxNsCacheFd(mgr, spawningCtx, &mountDigest), -1);
+    TerminateSpawnedProcess(holder);
+    EXPECT_GE(GetSandboxNsCacheFd(mgr, spawningCtx, &mountDigest), 0);
+
+    CloseSandboxNsCache(mgr);
+    EXPECT_EQ(GetSandboxNsCacheFd(mgr, spawningCtx, &mountDigest), -1);
+    DeleteAppSpawningCtx(spawningCtx);
+    DeleteAppSpawnMgr(mgr);
+}
 }  // namespace OHOS
\ No newline at end of file
@@ -1060,6 +1060,72 @@ static bool IsHnpInstallEnable()
     return false;
 }
 
+/**
+* @tc.name: Hnp_Install_011
+* @tc.desc:  Verify install multiple hnp packages in parallel if HnpCmdInstall succeed.
+* @tc.type: FUNC
+* @tc.require:issueI9BU5F
+* @tc.author:
+*/
+HWTEST_F(HnpInstallerTest, Hnp_Install_011, TestSize.Level0)
+{
+    GTEST_LOG_(INFO) << "Hnp_Installer_011 start";
+
+    EXPECT_EQ(mkdir(HNP_BASE_PATH, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH), 0);
+    HnpPackWithBin(const_cast<char *>("sample_public"), const_cast<char *>("1.1"), true, true,
+        S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH);
+    HnpPackWithBin(const_cast<char *>("sample_public2"), const_cast<char *>("1.1"), true, false,
+        S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH);
+    HnpPackWithBin(const_cast<char *>("sample_public3"), const_cast<char *>("1.1"), true, false,
+        S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH);
+    HnpPackWithBin(const_cast<char *>("sample_private"), const_cast<char *>("1.1"), false, false,
+        S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH);
+
+    char arg1[] = "hnp";
+    char arg2[] = "install";
+    char arg3[] = "-u";
+    char arg4[] = "10000";
+    char arg5[] = "-p";
+    char arg6[] = "sample";
+    char arg7[] = "-i";
+    char arg8[] = "./hnp_out";
+    char arg9[] = "-f";
+    char arg10[] = "-s";
+    char arg11[] = "./hnp_out";
+    char arg12[] = "-a";
+    char arg13[] = "system64";
+    char arg14[] = "-j";
+    { // invalid jobs
+        const char *invalidJobs[] = {"0", "", "9", "4x", "+4", "99999999999"};
+        for (const char *jobs : invalidJobs) {
+            char arg15[16] = {0}; // 16 buffer size
+            (void)strcpy_s(arg15, sizeof(arg15), jobs);
+            char* argv[] = {arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11, arg12, arg13, arg14,
+                arg15};
+            int argc = sizeof(argv) / sizeof(argv[0]);
+            EXPECT_EQ(HnpCmdInstall(argc, argv), HNP_ERRNO_INSTALLER_ARGV_JOBS_INVALID);
+        }
+    }
+    { // ok
+        char arg15[] = "4";
+        char* argv[] = {arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11, arg12, arg13, arg14,
+            arg15};
+        int argc = sizeof(argv) / sizeof(argv[0]);
+        EXPECT_EQ(HnpCmdInstall(argc, argv), 0);
+        EXPECT_EQ(access(HNP_BASE_PATH"/hnppublic/sample_public.org/sample_public_1.1/bin/out", F_OK), 0);
+        EXPECT_EQ(access(HNP_BASE_PATH"/hnppublic/sample_public2.org/sample_public2_1.1/bin/out", F_OK), 0);
+        EXPECT_EQ(access(HNP_BASE_PATH"/hnppublic/sample_public3.org/sample_public3_1.1/bin/out", F_OK), 0);
+        EXPECT_EQ(access(HNP_BASE_PATH"/hnppublic/bin/out", F_OK), 0);
+        EXPECT_EQ(access(HNP_BASE_PATH"/hnp/sample/bin/out", F_OK), 0);
+    }
+
+    HnpDeleteFolder(HNP_BASE_PATH);
+    HnpPackWithBinDelete();
+    remove(HNP_PACKAGE_INFO_JSON_FILE_PATH);
+
+    GTEST_LOG_(INFO) << "Hnp_Installer_011 end";
+}
+
 /**
 * @tc.name: Hnp_Install_API_001
 * @tc.desc:  Verify set Arg if NativeInstallHnp succeed.
@@ -1529,4 +1595,104 @@ HWTEST_F(HnpInstallerTest, Hnp_UnInstall_API_003, TestSize.Level0)
     GTEST_LOG_(INFO) << "Hnp_UnInstall_API_003 end";
 }
 
+/**
+* @tc.name: Hnp_RunCheck_001
+* @tc.desc:  Verify HnpProcessInUseCheck scan exe, maps and fd with synthetic proc root.
+* @tc.type: FUNC
+* @tc.require:issueI9DQSE
+* @tc.author:
+*/
+HWTEST_F(HnpInstallerTest, Hnp_RunCheck_001, TestSize.Level0)
+{
+    GTEST_LOG_(INFO) << "Hnp_RunCheck_001 start";
+
+    const char procRoot[] = "./hnp_proc_test";
+    EXPECT_EQ(mkdir(procRoot, S_IRWXU), 0);
+    EXPECT_EQ(mkdir("./hnp_proc_test/self", S_IRWXU), 0);
+    EXPECT_EQ(mkdir("./hnp_proc_test/100", S_IRWXU), 0);
+    EXPECT_EQ(mkdir("./hnp_proc_test/100/fd", S_IRWXU), 0);
+    EXPECT_EQ(mkdir("./hnp_proc_test/200", S_IRWXU), 0);
+    EXPECT_EQ(symlink("/system/bin/sh", "./hnp_proc_test/100/exe"), 0);
+    EXPECT_EQ(symlink("/data/service/hnp/fd.org/fd_1.0/data.db", "./hnp_proc_test/100/fd/3"), 0);
+    EXPECT_EQ(symlink("/data/service/hnp/exe.org/exe_1.0/bin/exe", "./hnp_proc_test/200/exe"), 0);
+    FILE *fp = fopen("./hnp_proc_test/200/maps", "w");
+    EXPECT_NE(fp, nullptr);
+    if (fp != nullptr) {
+        (void)fprintf(fp, "7f0000000000-7f0000001000 r-xp 00000000 fd:01 1234      "
+            "/data/service/hnp/maps.org/maps_1.0/lib/libmaps.so\n");
+        (void)fprintf(fp, "7f0000002000-7f0000003000 rw-p 00000000 00:00 0\n");
+        (void)fclose(fp);
+    }
+
+    const char *prefixes[] = {
+        "/data/service/hnp/exe.org", "/data/service/hnp/maps.org", "/data/service/hnp/fd.org",
+        "/data/service/hnp/none.org", "/data/service/hnp/maps"
+    };
+    int count = sizeof(prefixes) / sizeof(prefixes[0]);
+    bool inUse[sizeof(prefixes) / sizeof(prefixes[0])] = {};
+    EXPECT_EQ(HnpProcessInUseCheck(procRoot, prefixes, count, inUse), 0);
+    EXPECT_TRUE(inUse[0]);
+    EXPECT_TRUE(inUse[1]);
+    EXPECT_TRUE(inUse[2]);
+    EXPECT_FALSE(inUse[3]);
+    EXPECT_FALSE(inUse[4]); // prefix must match whole path component
+
+    EXPECT_EQ(HnpProcessInUseCheck("./hnp_proc_test_none", prefixes, count, inUse), HNP_ERRNO_BASE_DIR_OPEN_FAILED);
+    EXPECT_EQ(HnpProcessInUseCheck(procRoot, prefixes, 0, inUse), HNP_ERRNO_BASE_PARAMS_INVALID);
+
+    HnpDeleteFolder(procRoot);
+
+    GTEST_LOG_(INFO) << "Hnp_RunCheck_001 end";
+}
+
+static int HnpTreeWalkCount(int dirFd, const char *name, const char *parentPath, bool isDir, void *arg)
+{
+    (void)dirFd;
+    (void)name;
+    (void)parentPath;
+    int *count = static_cast<int *>(arg);
+    __atomic_add_fetch(&count[isDir ? 0 : 1], 1, __ATOMIC_SEQ_CST);
+    return 0;
+}
+
+/**
+* @tc.name: Hnp_TreeWalk_001
+* @tc.desc:  Verify HnpTreeWalk visit all entries and HnpDeleteFolder delete whole tree.
+* @tc.type: FUNC
+* @tc.require:issueI9DQSE
+* @tc.author:
+*/
+HWTEST_F(HnpInstallerTest, Hnp_TreeWalk_001, TestSize.Level0)
+{
+    GTEST_LOG_(INFO) << "Hnp_TreeWalk_001 start";
+
+    const int dirNum = HNP_TREE_WALK_QUEUE_SIZE + 8; // more than queue size, walk inline when queue is full
+    char path[MAX_FILE_PATH_LEN];
+    EXPECT_EQ(mkdir("./hnp_walk_test", S_IRWXU), 0);
+    for (int i = 0; i < dirNum; i++) {
+        EXPECT_GT(sprintf_s(path, sizeof(path), "./hnp_walk_test/%d/bin", i), 0);
+        EXPECT_EQ(HnpCreateFolder(path), 0);
+        EXPECT_GT(sprintf_s(path, sizeof(path), "./hnp_walk_test/%d/bin/out", i), 0);
+        FILE *fp = fopen(path, "w");
+        EXPECT_NE(fp, nullptr);
+        if (fp != nullptr) {
+            (void)fclose(fp);
+        }
+        EXPECT_GT(sprintf_s(path, sizeof(path), "./hnp_walk_test/%d/link", i), 0);
+        EXPECT_EQ(symlink("/hnp_walk_test/none", path), 0);
+    }
+
+    int count[2] = {0};
+    EXPECT_EQ(HnpTreeWalk("./hnp_walk_test", HnpTreeWalkCount, count, false), 0);
+    EXPECT_EQ(count[0], 1 + dirNum * 2); // 2: version dir and bin dir
+    EXPECT_EQ(count[1], dirNum * 2); // 2: out file and link
+    EXPECT_EQ(HnpTreeWalk(nullptr, HnpTreeWalkCount, count, false), HNP_ERRNO_BASE_PARAMS_INVALID);
+    EXPECT_EQ(HnpTreeWalk("./hnp_walk_test_none", HnpTreeWalkCount, count, true), HNP_ERRNO_BASE_DIR_OPEN_FAILED);
+
+    EXPECT_EQ(HnpDeleteFolder("./hnp_walk_test"), 0);
+    EXPECT_NE(access("./hnp_walk_test", F_OK), 0);
+
+    GTEST_LOG_(INFO) << "Hnp_TreeWalk_001 end";
+}
+
 }
\ No newline at end of file
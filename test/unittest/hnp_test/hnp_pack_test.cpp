@@ -403,4 +403,82 @@ HWTEST_F(HnpPackTest, Hnp_Pack_006, TestSize.Level0)
 }
 
 
+/**
+* @tc.name: Hnp_Pack_007
+* @tc.desc:  Verify pack with parallel compression and reproducible output if HnpCmdPack succeed.
+* @tc.type: FUNC
+* @tc.require:issueI98PSE
+* @tc.author:
+*/
+HWTEST_F(HnpPackTest, Hnp_Pack_007, TestSize.Level0)
+{
+    GTEST_LOG_(INFO) << "Hnp_Pack_007 start";
+
+    const int fileNum = 32;
+    char path[MAX_FILE_PATH_LEN];
+    EXPECT_EQ(mkdir("hnp_sample", S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH), 0);
+    EXPECT_EQ(mkdir("hnp_sample/bin", S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH), 0);
+    EXPECT_EQ(mkdir("hnp_out", S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH), 0);
+    for (int i = 0; i < fileNum; i++) {
+        EXPECT_GT(sprintf_s(path, sizeof(path), "hnp_sample/bin/out%d", i), 0);
+        FILE *fp = fopen(path, "w");
+        EXPECT_NE(fp, nullptr);
+        for (int j = 0; fp != nullptr && j < i * BUFFER_SIZE; j++) {
+            (void)fprintf(fp, "%d", j);
+        }
+        if (fp != nullptr) {
+            (void)fclose(fp);
+        }
+    }
+
+    char arg1[] = "hnp", arg2[] = "pack";
+    char arg3[] = "-i", arg4[] = "./hnp_sample", arg5[] = "-o", arg6[] = "./hnp_out";
+    char arg7[] = "-n", arg8[] = "sample", arg9[] = "-v", arg10[] = "1.1";
+    char arg11[] = "-r", arg12[] = "-l", arg14[] = "-j";
+    { // invalid level and jobs
+        char arg13[] = "10", arg15[] = "4";
+        char *argv[] = {arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11, arg12, arg13, arg14,
+            arg15};
+        int argc = sizeof(argv) / sizeof(argv[0]);
+        EXPECT_EQ(HnpCmdPack(argc, argv), HNP_ERRNO_PACK_ARGV_INVALID);
+        char arg16[] = "6", arg17[] = "0";
+        argv[12] = arg16;
+        argv[14] = arg17;
+        EXPECT_EQ(HnpCmdPack(argc, argv), HNP_ERRNO_PACK_ARGV_INVALID);
+    }
+    { // ok. same output with different jobs
+        char arg13[] = "6", arg15[] = "4", arg16[] = "1";
+        char *argv[] = {arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8, arg9, arg10, arg11, arg12, arg13, arg14,
+            arg15};
+        int argc = sizeof(argv) / sizeof(argv[0]);
+        EXPECT_EQ(HnpCmdPack(argc, argv), 0);
+        EXPECT_EQ(rename("./hnp_out/sample.hnp", "./hnp_out/sample_parallel.hnp"), 0);
+        argv[14] = arg16;
+        EXPECT_EQ(HnpCmdPack(argc, argv), 0);
+
+        char *stream1 = nullptr;
+        char *stream2 = nullptr;
+        int len1 = 0;
+        int len2 = 0;
+        EXPECT_EQ(ReadFileToStream("./hnp_out/sample_parallel.hnp", &stream1, &len1), 0);
+        EXPECT_EQ(ReadFileToStream("./hnp_out/sample.hnp", &stream2, &len2), 0);
+        EXPECT_EQ(len1, len2);
+        if (stream1 != nullptr && stream2 != nullptr && len1 == len2) {
+            EXPECT_EQ(memcmp(stream1, stream2, len1), 0);
+        }
+        free(stream1);
+        free(stream2);
+
+        HnpCfgInfo cfg = {0};
+        EXPECT_EQ(HnpCfgGetFromZip("./hnp_out/sample_parallel.hnp", &cfg), 0);
+        EXPECT_EQ(strcmp(cfg.name, "sample"), 0);
+        free(cfg.links);
+    }
+
+    EXPECT_EQ(HnpDeleteFolder("hnp_sample"), 0);
+    EXPECT_EQ(HnpDeleteFolder("hnp_out"), 0);
+
+    GTEST_LOG_(INFO) << "Hnp_Pack_007 end";
+}
+
 } // namespace OHOS
@@ -124,6 +124,8 @@ typedef enum {
     APPSPAWN_ERROR_UTILS_MEM_FAIL,
     APPSPAWN_ERROR_FILE_RMDIR_FAIL,
     APPSPAWN_NODE_EXIST,
+    APPSPAWN_SPAWN_QUARANTINED,
+    APPSPAWN_SPAWN_DEFERRED,
 } AppSpawnErrorCode;
 
 uint64_t DiffTime(const struct timespec *startTime, const struct timespec *endTime);
@@ -185,6 +187,42 @@ void EnableCache(void);
     HILOG_FATAL(HILOG_MODULE_HIVIEW, "[%{public}s:%{public}d]" fmt,  (APP_FILE_NAME), (__LINE__), ##__VA_ARGS__)
 #endif
 
+typedef enum {
+    APPSPAWN_LOG_RING_DEBUG,
+    APPSPAWN_LOG_RING_INFO,
+} AppSpawnLogRingLevel;
+
+// 日志点的静态描述，格式串即格式id，日志环中只保存参数
+typedef struct {
+    uint32_t level;
+    uint32_t state;
+    uint32_t argTypes;
+    int line;
+    const char *file;
+    const char *fmt;
+} AppSpawnLogSite;
+
+void AppSpawnLogRingWrite(AppSpawnLogSite *site, ...);
+uint32_t AppSpawnLogRingFlush(void);
+void AppSpawnLogRingDump(void);
+int AppSpawnLogRingStart(void);
+void AppSpawnLogRingStop(void);
+void AppSpawnLogRingAfterFork(void);
+
+#define APPSPAWN_LOG_RING_WRITE(logLevel, logFmt, ...) \
+    do { \
+        static AppSpawnLogSite logSite = {(logLevel), 0, 0, __LINE__, __FILE__, logFmt}; \
+        AppSpawnLogRingWrite(&logSite, ##__VA_ARGS__); \
+    } while (0)
+
+// 孵化热路径上的INFO/DEBUG日志写入日志环，由后台线程格式化输出
+#if defined(APPSPAWN_LOG_RING) && !defined(OHOS_LITE)
+#undef APPSPAWN_LOGI
+#undef APPSPAWN_LOGV
+#define APPSPAWN_LOGI(fmt, ...) APPSPAWN_LOG_RING_WRITE(APPSPAWN_LOG_RING_INFO, fmt, ##__VA_ARGS__)
+#define APPSPAWN_LOGV(fmt, ...) APPSPAWN_LOG_RING_WRITE(APPSPAWN_LOG_RING_DEBUG, fmt, ##__VA_ARGS__)
+#endif
+
 #define APPSPAWN_CHECK(retCode, exper, fmt, ...) \
     if (!(retCode)) {                    \
         APPSPAWN_LOGE(fmt, ##__VA_ARGS__);         \
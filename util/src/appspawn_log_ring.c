@@ -0,0 +1,441 @@
+/*
+ * Copyright (c) 2024 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <sys/eventfd.h>
+
+// 本文件的日志直接输出到hilog
+#undef APPSPAWN_LOG_RING
+#include "appspawn_utils.h"
+#include "securec.h"
+
+#define LOG_RING_SIZE 512  // must be power of 2
+#define LOG_RING_ARG_MAX 8
+#define LOG_RING_ARG_BITS 4
+#define LOG_RING_STR_MAX 96
+#define LOG_RING_MSG_MAX 512
+#define LOG_RING_SPEC_MAX 32
+
+typedef enum {
+    LOG_ARG_INT = 1,
+    LOG_ARG_LONG,
+    LOG_ARG_LLONG,
+    LOG_ARG_SIZE,
+    LOG_ARG_PTR,
+    LOG_ARG_STR,
+    LOG_ARG_DOUBLE,
+} LogRingArgType;
+
+typedef enum {
+    LOG_SITE_UNPARSED,
+    LOG_SITE_RING,
+    LOG_SITE_DIRECT,  // 不支持的格式，直接输出
+} LogRingSiteState;
+
+typedef struct {
+    uint64_t seq;  // 写入完成后置为index + 1
+    const AppSpawnLogSite *site;
+    struct timespec time;
+    uint64_t args[LOG_RING_ARG_MAX];  // 字符串参数为strings中的偏移
+    char strings[LOG_RING_STR_MAX];
+} LogRingEntry;
+
+typedef struct {
+    uint64_t writeIndex;
+    uint64_t readIndex;
+    uint64_t dropped;
+    pthread_mutex_t readMutex;  // 刷新线程与dump互斥，写入无锁
+    pthread_t thread;
+    pid_t ownerPid;
+    int eventFd;  // 唤醒刷新线程
+    uint32_t wakeup;  // 已唤醒且未刷新时为1，合并连续写入的唤醒
+    uint32_t started;
+    uint32_t stop;
+    LogRingEntry entries[LOG_RING_SIZE];
+} LogRing;
+
+static LogRing g_logRing = {0, 0, 0, PTHREAD_MUTEX_INITIALIZER, 0, 0, -1};
+
+// 解析hilog格式串，返回参数个数，不支持时返回-1
+static int ParseLogFormat(const char *fmt, uint32_t *argTypes)
+{
+    int count = 0;
+    for (const char *curr = strchr(fmt, '%'); curr != NULL; curr = strchr(curr, '%')) {
+        curr++;
+        if (*curr == '%') {
+            curr++;
+            continue;
+        }
+        if (*curr == '{') {
+            curr = strchr(curr, '}');
+            APPSPAWN_CHECK_ONLY_EXPER(curr != NULL, return -1);
+            curr++;
+        }
+        curr += strspn(curr, "-+ #0123456789.");
+        int longCount = 0;
+        bool sizeType = false;
+        for (; *curr == 'l' || *curr == 'h' || *curr == 'z' || *curr == 't' || *curr == 'j'; curr++) {
+            longCount += (*curr == 'l' || *curr == 'j') ? (*curr == 'j' ? 2 : 1) : 0;  // 2: long long
+            sizeType = sizeType || *curr == 'z' || *curr == 't';
+        }
+        uint32_t type = 0;
+        if (*curr != '\0' && strchr("diuoxXc", *curr) != NULL) {
+            type = sizeType ? LOG_ARG_SIZE : (longCount == 0 ? LOG_ARG_INT :
+                (longCount == 1 ? LOG_ARG_LONG : LOG_ARG_LLONG));
+        } else if (*curr == 's') {
+            type = LOG_ARG_STR;
+        } else if (*curr == 'p') {
+            type = LOG_ARG_PTR;
+        } else if (*curr != '\0' && strchr("fFeEgGaA", *curr) != NULL && longCount == 0) {
+            type = LOG_ARG_DOUBLE;
+        }
+        if (type == 0 || count >= LOG_RING_ARG_MAX) {
+            return -1;
+        }
+        *argTypes |= type << (count * LOG_RING_ARG_BITS);
+        count++;
+    }
+    return count;
+}
+
+static uint32_t GetLogSiteState(AppSpawnLogSite *site)
+{
+    uint32_t state = __atomic_load_n(&site->state, __ATOMIC_ACQUIRE);
+    if (state != LOG_SITE_UNPARSED) {
+        return state;
+    }
+    uint32_t argTypes = 0;
+    state = ParseLogFormat(site->fmt, &argTypes) < 0 ? LOG_SITE_DIRECT : LOG_SITE_RING;
+    __atomic_store_n(&site->argTypes, argTypes, __ATOMIC_RELAXED);
+    __atomic_store_n(&site->state, state, __ATOMIC_RELEASE);
+    return state;
+}
+
+static const char *GetLogFileName(const char *file)
+{
+    const char *name = strrchr(file, '/');
+    return name != NULL ? name + 1 : file;
+}
+
+static void OutputLogMessage(uint32_t level, const char *message)
+{
+    if (level == APPSPAWN_LOG_RING_DEBUG) {
+        HILOG_DEBUG(LOG_CORE, "%{public}s", message);
+    } else {
+        HILOG_INFO(LOG_CORE, "%{public}s", message);
+    }
+}
+
+#if defined(__clang__)
+#    pragma clang diagnostic push
+#    pragma clang diagnostic ignored "-Wformat-nonliteral"
+#elif defined(__GNUC__)
+#    pragma GCC diagnostic push
+#    pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#endif
+
+// 去掉hilog的{public}/{private}，用于snprintf
+static int StripLogFormat(const char *fmt, char *buffer, uint32_t size)
+{
+    uint32_t curr = 0;
+    for (const char *src = fmt; *src != '\0'; src++) {
+        if (curr + 1 >= size) {
+            return -1;
+        }
+        buffer[curr++] = *src;
+        if (*src == '%' && src[1] == '{') {
+            src = strchr(src, '}');
+            APPSPAWN_CHECK_ONLY_EXPER(src != NULL, return -1);
+        }
+    }
+    buffer[curr] = '\0';
+    return 0;
+}
+
+static void OutputLogDirect(const AppSpawnLogSite *site, va_list args)
+{
+    char format[LOG_RING_MSG_MAX] = {0};
+    char message[LOG_RING_MSG_MAX] = {0};
+    APPSPAWN_CHECK_ONLY_EXPER(StripLogFormat(site->fmt, format, sizeof(format)) == 0, return);
+    int len = snprintf_s(message, sizeof(message), sizeof(message) - 1, "[%s:%d]",
+        GetLogFileName(site->file), site->line);
+    APPSPAWN_CHECK_ONLY_EXPER(len > 0, return);
+    (void)vsnprintf_s(message + len, sizeof(message) - len, sizeof(message) - len - 1, format, args);
+    OutputLogMessage(site->level, message);
+}
+
+static int FormatLogArg(char *buffer, uint32_t size, const char *spec, uint32_t type, const LogRingEntry *entry,
+    uint64_t value)
+{
+    double number = 0;
+    switch (type) {
+        case LOG_ARG_INT:
+            return snprintf_s(buffer, size, size - 1, spec, (int)value);
+        case LOG_ARG_LONG:
+            return snprintf_s(buffer, size, size - 1, spec, (long)value);
+        case LOG_ARG_LLONG:
+            return snprintf_s(buffer, size, size - 1, spec, (long long)value);
+        case LOG_ARG_SIZE:
+            return snprintf_s(buffer, size, size - 1, spec, (size_t)value);
+        case LOG_ARG_PTR:
+            return snprintf_s(buffer, size, size - 1, spec, (void *)(uintptr_t)value);
+        case LOG_ARG_STR:
+            return snprintf_s(buffer, size, size - 1, spec, entry->strings + value);
+        case LOG_ARG_DOUBLE:
+            (void)memcpy_s(&number, sizeof(number), &value, sizeof(value));
+            return snprintf_s(buffer, size, size - 1, spec, number);
+        default:
+            return -1;
+    }
+}
+
+static int FormatLogRingEntry(const LogRingEntry *entry, char *buffer, uint32_t size)
+{
+    const AppSpawnLogSite *site = entry->site;
+    int len = snprintf_s(buffer, size, size - 1, "[%s:%d]", GetLogFileName(site->file), site->line);
+    APPSPAWN_CHECK_ONLY_EXPER(len > 0, return -1);
+    uint32_t curr = (uint32_t)len;
+    uint32_t index = 0;
+    const char *fmt = site->fmt;
+    while (*fmt != '\0' && curr + 1 < size) {
+        if (*fmt != '%' || fmt[1] == '%') {
+            buffer[curr++] = *fmt;
+            fmt += (*fmt == '%') ? 2 : 1;  // 2: "%%"
+            continue;
+        }
+        // 取出一个转换说明，如"%{public}d" -> "%d"
+        char spec[LOG_RING_SPEC_MAX] = {'%'};
+        uint32_t specLen = 1;
+        fmt++;
+        if (*fmt == '{') {
+            fmt = strchr(fmt, '}') + 1;
+        }
+        while (*fmt != '\0' && specLen + 1 < sizeof(spec)) {
+            spec[specLen++] = *fmt;
+            if (strchr("diuoxXcspfFeEgGaA", *fmt++) != NULL) {
+                break;
+            }
+        }
+        uint32_t type = (entry->site->argTypes >> (index * LOG_RING_ARG_BITS)) & ((1 << LOG_RING_ARG_BITS) - 1);
+        len = FormatLogArg(buffer + curr, size - curr, spec, type, entry, entry->args[index]);
+        if (len < 0) {
+            break;
+        }
+        curr += (uint32_t)len;
+        index++;
+    }
+    buffer[curr] = '\0';
+    return 0;
+}
+
+#if defined(__clang__)
+#    pragma clang diagnostic pop
+#elif defined(__GNUC__)
+#    pragma GCC diagnostic pop
+#endif
+
+static void SaveLogArgs(LogRingEntry *entry, uint32_t argTypes, va_list args)
+{
+    uint32_t used = 0;
+    entry->strings[LOG_RING_STR_MAX - 1] = '\0';
+    for (uint32_t index = 0; index < LOG_RING_ARG_MAX; index++) {
+        uint32_t type = (argTypes >> (index * LOG_RING_ARG_BITS)) & ((1 << LOG_RING_ARG_BITS) - 1);
+        switch (type) {
+            case LOG_ARG_INT:
+                entry->args[index] = (uint64_t)va_arg(args, int);
+                break;
+            case LOG_ARG_LONG:
+                entry->args[index] = (uint64_t)va_arg(args, long);
+                break;
+            case LOG_ARG_LLONG:
+                entry->args[index] = (uint64_t)va_arg(args, long long);
+                break;
+            case LOG_ARG_SIZE:
+                entry->args[index] = (uint64_t)va_arg(args, size_t);
+                break;
+            case LOG_ARG_PTR:
+                entry->args[index] = (uint64_t)(uintptr_t)va_arg(args, void *);
+                break;
+            case LOG_ARG_DOUBLE: {
+                double number = va_arg(args, double);
+                (void)memcpy_s(&entry->args[index], sizeof(entry->args[index]), &number, sizeof(number));
+                break;
+            }
+            case LOG_ARG_STR: {
+                // 字符串拷贝到日志项中，超长截断
+                const char *str = va_arg(args, const char *);
+                str = str == NULL ? "(null)" : str;
+                uint32_t len = (uint32_t)strnlen(str, LOG_RING_STR_MAX - 1 - used);
+                entry->args[index] = used;
+                (void)memcpy_s(entry->strings + used, LOG_RING_STR_MAX - used, str, len);
+                entry->strings[used + len] = '\0';
+                used += (used + len + 1 < LOG_RING_STR_MAX) ? len + 1 : len;
+                break;
+            }
+            default:
+                return;
+        }
+    }
+}
+
+void AppSpawnLogRingWrite(AppSpawnLogSite *site, ...)
+{
+    va_list args;
+    va_start(args, site);
+    if (GetLogSiteState(site) == LOG_SITE_DIRECT) {
+        OutputLogDirect(site, args);
+        va_end(args);
+        return;
+    }
+    // 多个线程可同时写入，环满时丢弃并计数
+    uint64_t index = __atomic_load_n(&g_logRing.writeIndex, __ATOMIC_RELAXED);
+    do {
+        if (index - __atomic_load_n(&g_logRing.readIndex, __ATOMIC_ACQUIRE) >= LOG_RING_SIZE) {
+            __atomic_fetch_add(&g_logRing.dropped, 1, __ATOMIC_RELAXED);
+            va_end(args);
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&g_logRing.writeIndex, &index, index + 1, true,
+        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    LogRingEntry *entry = &g_logRing.entries[index & (LOG_RING_SIZE - 1)];
+    entry->site = site;
+    (void)clock_gettime(CLOCK_REALTIME, &entry->time);
+    SaveLogArgs(entry, site->argTypes, args);
+    va_end(args);
+    __atomic_store_n(&entry->seq, index + 1, __ATOMIC_RELEASE);
+    // 刷新线程清除wakeup后才读取日志，只有第一个写入者需要唤醒
+    int fd = __atomic_load_n(&g_logRing.eventFd, __ATOMIC_RELAXED);
+    if (fd >= 0 && __atomic_exchange_n(&g_logRing.wakeup, 1, __ATOMIC_ACQ_REL) == 0) {
+        uint64_t value = 1;
+        (void)write(fd, &value, sizeof(value));
+    }
+}
+
+static uint32_t FlushLogRing(bool toDump)
+{
+    pthread_mutex_lock(&g_logRing.readMutex);
+    uint64_t dropped = __atomic_exchange_n(&g_logRing.dropped, 0, __ATOMIC_RELAXED);
+    if (dropped > 0) {
+        APPSPAWN_LOGW("Log ring dropped %{public}" PRIu64 " logs", dropped);
+    }
+    uint32_t count = 0;
+    uint64_t index = __atomic_load_n(&g_logRing.readIndex, __ATOMIC_RELAXED);
+    for (;; index++) {
+        LogRingEntry *entry = &g_logRing.entries[index & (LOG_RING_SIZE - 1)];
+        if (__atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE) != index + 1) {
+            break;
+        }
+        char message[LOG_RING_MSG_MAX] = {0};
+        if (FormatLogRingEntry(entry, message, sizeof(message)) == 0) {
+            OutputLogMessage(entry->site->level, message);
+        }
+        if (toDump) {
+            // dump时带上写入时间
+            char time[32] = {0};  // 32 max time
+            struct tm tm = {0};
+            (void)localtime_r(&entry->time.tv_sec, &tm);
+            (void)strftime(time, sizeof(time), "%H:%M:%S", &tm);
+            AppSpawnDump("%s.%06ld %s\n", time, entry->time.tv_nsec / APPSPAWN_USEC_TO_NSEC, message);
+        }
+        __atomic_store_n(&g_logRing.readIndex, index + 1, __ATOMIC_RELEASE);
+        count++;
+    }
+    pthread_mutex_unlock(&g_logRing.readMutex);
+    return count;
+}
+
+uint32_t AppSpawnLogRingFlush(void)
+{
+    return FlushLogRing(false);
+}
+
+void AppSpawnLogRingDump(void)
+{
+    AppSpawnDump("Log ring:\n");
+    (void)FlushLogRing(true);
+}
+
+static void *LogRingFlushThread(void *arg)
+{
+    // 信号统一由事件循环通过signalfd处理
+    sigset_t mask;
+    sigfillset(&mask);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    // 无日志时阻塞在eventfd上，不周期唤醒
+    while (!__atomic_load_n(&g_logRing.stop, __ATOMIC_ACQUIRE)) {
+        (void)__atomic_exchange_n(&g_logRing.wakeup, 0, __ATOMIC_ACQ_REL);
+        (void)FlushLogRing(false);
+        uint64_t value = 0;
+        ssize_t len = read(g_logRing.eventFd, &value, sizeof(value));
+        APPSPAWN_CHECK(len == (ssize_t)sizeof(value) || errno == EINTR, break,
+            "Failed to wait log ring event %{public}d", errno);
+    }
+    return NULL;
+}
+
+int AppSpawnLogRingStart(void)
+{
+    if (g_logRing.started && g_logRing.ownerPid == getpid()) {
+        return 0;
+    }
+    int fd = eventfd(0, EFD_CLOEXEC);
+    APPSPAWN_CHECK(fd >= 0, return APPSPAWN_SYSTEM_ERROR, "Failed to create log ring event %{public}d", errno);
+    __atomic_store_n(&g_logRing.eventFd, fd, __ATOMIC_RELEASE);
+    __atomic_store_n(&g_logRing.stop, 0, __ATOMIC_RELEASE);
+    int ret = pthread_create(&g_logRing.thread, NULL, LogRingFlushThread, NULL);
+    if (ret != 0) {
+        __atomic_store_n(&g_logRing.eventFd, -1, __ATOMIC_RELEASE);
+        (void)close(fd);
+        APPSPAWN_LOGE("Failed to create log ring thread %{public}d", ret);
+        return APPSPAWN_SYSTEM_ERROR;
+    }
+    g_logRing.ownerPid = getpid();
+    g_logRing.started = 1;
+    return 0;
+}
+
+void AppSpawnLogRingStop(void)
+{
+    if (!g_logRing.started || g_logRing.ownerPid != getpid()) {
+        return;
+    }
+    __atomic_store_n(&g_logRing.stop, 1, __ATOMIC_RELEASE);
+    uint64_t value = 1;
+    (void)write(g_logRing.eventFd, &value, sizeof(value));
+    pthread_join(g_logRing.thread, NULL);
+    int fd = __atomic_exchange_n(&g_logRing.eventFd, -1, __ATOMIC_ACQ_REL);
+    (void)close(fd);
+    g_logRing.started = 0;
+    (void)FlushLogRing(false);
+}
+
+void AppSpawnLogRingAfterFork(void)
+{
+    // 子进程中没有刷新线程，继承的日志由父进程输出
+    pthread_mutex_init(&g_logRing.readMutex, NULL);
+    int fd = __atomic_exchange_n(&g_logRing.eventFd, -1, __ATOMIC_ACQ_REL);
+    if (fd >= 0) {
+        (void)close(fd);
+    }
+    __atomic_store_n(&g_logRing.wakeup, 0, __ATOMIC_RELAXED);
+    g_logRing.started = 0;
+    __atomic_store_n(&g_logRing.dropped, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_logRing.readIndex, __atomic_load_n(&g_logRing.writeIndex, __ATOMIC_ACQUIRE),
+        __ATOMIC_RELEASE);
+}